@@ -0,0 +1,67 @@
+-module(exceptions_bench).
+-export([start/0]).
+
+-define(ROUNDS, 20000).
+-define(DEPTH, 200).
+
+%% Raises from the bottom of a deep stack while a try is active near the
+%% top, and catches both with try and catch, so the cost of a raise
+%% should not depend on the stack depth.
+start() ->
+    T0 = erlang:timestamp(),
+    ?ROUNDS = try_loop(?ROUNDS, 0),
+    T1 = erlang:timestamp(),
+    ?ROUNDS = catch_loop(?ROUNDS, 0),
+    T2 = erlang:timestamp(),
+    ?ROUNDS = nested_loop(?ROUNDS, 0),
+    T3 = erlang:timestamp(),
+    erlang:display({try_ms, elapsed_ms(T0, T1)}),
+    erlang:display({catch_ms, elapsed_ms(T1, T2)}),
+    erlang:display({nested_ms, elapsed_ms(T2, T3)}),
+    ok.
+
+try_loop(0, Acc) ->
+    Acc;
+try_loop(N, Acc) ->
+    try deep(?DEPTH) of
+        _ -> try_loop(N - 1, Acc)
+    catch
+        throw:bottom -> try_loop(N - 1, Acc + 1)
+    end.
+
+catch_loop(0, Acc) ->
+    Acc;
+catch_loop(N, Acc) ->
+    case catch deep(?DEPTH) of
+        bottom -> catch_loop(N - 1, Acc + 1);
+        _ -> catch_loop(N - 1, Acc)
+    end.
+
+%% every frame has its own try, the raise is caught by the innermost one
+nested_loop(0, Acc) ->
+    Acc;
+nested_loop(N, Acc) ->
+    case nested(?DEPTH) of
+        bottom -> nested_loop(N - 1, Acc + 1);
+        _ -> nested_loop(N - 1, Acc)
+    end.
+
+deep(0) ->
+    throw(bottom);
+deep(D) ->
+    id(deep(D - 1)) + 1.
+
+nested(0) ->
+    throw(bottom);
+nested(D) ->
+    try
+        id(nested(D - 1))
+    catch
+        throw:Reason -> Reason
+    end.
+
+id(X) ->
+    X.
+
+elapsed_ms({M0, S0, U0}, {M1, S1, U1}) ->
+    ((M1 - M0) * 1000000 + (S1 - S0)) * 1000 + (U1 - U0) div 1000.
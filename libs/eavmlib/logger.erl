@@ -28,7 +28,7 @@
 %%-----------------------------------------------------------------------------
 -module(logger).
 
--export([start/0, start/1, log/3, get_levels/0, set_levels/1, get_filter/0, set_filter/1, stop/0]).
+-export([start/0, start/1, log/3, allow/2, get_levels/0, set_levels/1, get_filter/0, set_filter/1, stop/0]).
 -export([loop/1, console_log/1]).
 
 -include("estdlib.hrl").
@@ -78,6 +78,8 @@ start(Config0) ->
     Config = fill_defaults(Config0, ?DEFAULT_CONFIG),
     LoggerPid = case whereis(?MODULE) of
         undefined ->
+            ok = ?MODULE:set_allowed_levels(?PROPLISTS:get_value(levels, Config)),
+            ok = ?MODULE:set_allowed_modules(?PROPLISTS:get_value(filter, Config)),
             State = #state{pid=self(), config=Config},
             Pid = spawn(?MODULE, loop, [State]),
             receive
@@ -100,7 +102,8 @@ start(Config0) ->
 stop() ->
     {ok, Pid} = maybe_start(whereis(?MODULE)),
     Pid ! stop,
-    ok.
+    ok = ?MODULE:set_allowed_levels(?PROPLISTS:get_value(levels, ?DEFAULT_CONFIG)),
+    ok = ?MODULE:set_allowed_modules([]).
 
 %%-----------------------------------------------------------------------------
 %% @param   Location the location in the source module
@@ -111,10 +114,30 @@ stop() ->
 %% @end
 %%-----------------------------------------------------------------------------
 -spec log(Location::location(), Level::level(), Msg::term()) -> ok.
-log(Location, Level, Msg) ->
-    {ok, Pid} = maybe_start(whereis(?MODULE)),
-    Pid ! {Location, erlang:universaltime(), self(), Level, Msg},
-    ok.
+log({Module, _Function, _Arity, _Line} = Location, Level, Msg) ->
+    case ?MODULE:allow(Level, Module) of
+        true ->
+            {ok, Pid} = maybe_start(whereis(?MODULE)),
+            Pid ! {Location, erlang:universaltime(), self(), Level, Msg},
+            ok;
+        false ->
+            ok
+    end.
+
+%%-----------------------------------------------------------------------------
+%% @param   Level the level of the log request
+%% @param   Module the module that is logging
+%% @returns true if a log request would be logged, false otherwise.
+%% @doc     Check the current levels and filter without contacting the logger.
+%%
+%%          This function is implemented natively: the logger keeps its
+%%          levels and filter in the VM, so log requests can be dropped
+%%          before they are built.
+%% @end
+%%-----------------------------------------------------------------------------
+-spec allow(Level::level(), Module::module()) -> boolean().
+allow(_Level, _Module) ->
+    throw(nif_error).
 
 %%-----------------------------------------------------------------------------
 %% @param   Levels the list of levels to set
@@ -125,6 +148,7 @@ log(Location, Level, Msg) ->
 -spec set_levels(Levels::[level()]) -> ok.
 set_levels(Levels) ->
     {ok, Pid} = maybe_start(whereis(?MODULE)),
+    ok = ?MODULE:set_allowed_levels(Levels),
     Pid ! {set_levels, Levels},
     ok.
 
@@ -158,6 +182,7 @@ get_levels() ->
 -spec set_filter(Filter::[module()]) -> ok.
 set_filter(Filter) ->
     {ok, Pid} = maybe_start(whereis(?MODULE)),
+    ok = ?MODULE:set_allowed_modules(Filter),
     Pid ! {set_filter, Filter},
     ok.
 
@@ -41,14 +41,15 @@
 -module(avm_gen_server).
 
 -export([start/3, start/4, stop/1, stop/3, call/2, call/3, cast/2, reply/2]).
--export([loop/1]).
+-export([loop/1, wake_hib/1]).
 
 -include("estdlib.hrl").
 
 -record(state, {
     name = undefined :: atom(),
     mod :: module(),
-    mod_state :: term()
+    mod_state :: term(),
+    hibernate_after = infinity :: timeout()
 }).
 
 -include("logger.hrl").
@@ -69,7 +70,7 @@
 %%          newly created process with the process registry.  Subsequent calls
 %%          may use the gen_server name, in lieu of the process id.
 %%
-%%          <em><b>Note.</b>  The Options argument is currently ignored.</em>
+%%          See start/3 for supported options.
 %% @end
 %%-----------------------------------------------------------------------------
 -spec start(ServerName::{local, Name::atom()}, Module::module(), Args::term(), Options::options()) -> {ok, pid()} | {error, Reason::term()}.
@@ -101,7 +102,8 @@ start({local, Name}, Module, Args, Options) when is_atom(Name) ->
 %%
 %%          This function will start a gen_server instance.
 %%
-%%          <em><b>Note.</b>  The Options argument is currently ignored.</em>
+%%          The only supported option is {hibernate_after, Timeout}: the
+%%          gen_server will hibernate after being idle for Timeout milliseconds.
 %% @end
 %%-----------------------------------------------------------------------------
 -spec start(Module::module(), Args::term(), Options::options()) -> {ok, pid()} | {error, Reason::term()}.
@@ -112,7 +114,8 @@ start(Module, Args, Options) ->
             State = #state{
                 name = ?PROPLISTS:get_value(name, Options),
                 mod = Module,
-                mod_state = ModState
+                mod_state = ModState,
+                hibernate_after = ?PROPLISTS:get_value(hibernate_after, Options, infinity)
             },
             ?LOG_DEBUG({spawning_loop, State}),
             Pid = spawn(?MODULE, loop, [State]),
@@ -236,66 +239,99 @@ reply({Pid, Ref} = _Client, Reply) ->
 %%
 
 %% @private
+%% The callee is monitored, so a call to a dead or crashing gen_server
+%% returns as soon as it terminates instead of waiting for the timeout.
 call_internal(Pid, Ref, Msg, Timeout) ->
     ?LOG_DEBUG({call_internal, Pid, Ref, Msg, Timeout}),
+    MonitorRef = erlang:monitor(process, Pid),
     Pid ! Msg,
     ?LOG_DEBUG({waiting, Ref, Timeout}),
     receive
         {Ref, Reply} ->
-        ?LOG_DEBUG({reply, Reply}),
-        Reply
+            ?LOG_DEBUG({reply, Reply}),
+            erlang:demonitor(MonitorRef, [flush]),
+            Reply;
+        {'DOWN', MonitorRef, process, Pid, Reason} ->
+            ?LOG_DEBUG({down, Reason}),
+            {error, Reason}
     after Timeout ->
         %% throw(timeout)
+        erlang:demonitor(MonitorRef, [flush]),
         {error, timeout}
     end.
 
 %% @private
-loop(#state{mod=Mod, mod_state=ModState} = State) ->
+loop(#state{hibernate_after=infinity} = State) ->
     ?LOG_DEBUG({loop, State}),
     receive
-        {'$call', Pid, Ref, Request} ->
-            ?LOG_DEBUG({'$call', Pid, Ref, Request}),
-            case Mod:handle_call(Request, {Pid, Ref}, ModState) of
-                {reply, Reply, NewModState} ->
-                    Pid ! {Ref, Reply},
-                    loop(State#state{mod_state=NewModState});
-                {noreply, NewModState} ->
-                    ?LOG_DEBUG({noreply, NewModState}),
-                    loop(State#state{mod_state=NewModState});
-                {stop, Reason, Reply, NewModState} ->
-                     Pid ! {Ref, Reply},
-                     do_terminate(State, Reason, NewModState);
-                {stop, Reason, NewModState} ->
-                    do_terminate(State, Reason, NewModState);
-                _ ->
-                    do_terminate(State, {error, unexpected_reply}, ModState)
-            end;
-        {'$cast', Request} ->
-            ?LOG_DEBUG({'$cast', Request}),
-            case Mod:handle_cast(Request, ModState) of
-                {noreply, NewModState} ->
-                    loop(State#state{mod_state=NewModState});
-                {stop, Reason, NewModState} ->
-                    do_terminate(State, Reason, NewModState);
-                _ ->
-                    do_terminate(State, {error, unexpected_reply}, ModState)
-            end;
-        {'$stop', Pid, Ref, Reason} ->
-            ?LOG_DEBUG({'$stop', Pid, Ref, Reason}),
-            do_terminate(State, Reason, ModState),
-            Pid ! {Ref, ok};
-        Info ->
-            ?LOG_DEBUG({'Info', Info}),
-            case Mod:handle_info(Info, ModState) of
-                {noreply, NewModState} ->
-                    loop(State#state{mod_state=NewModState});
-                {stop, Reason, NewModState} ->
-                    do_terminate(State, Reason, NewModState);
-                _ ->
-                    do_terminate(State, {error, unexpected_reply}, ModState)
-            end
+        Msg ->
+            handle_msg(Msg, State)
+    end;
+loop(#state{hibernate_after=HibernateAfter} = State) ->
+    ?LOG_DEBUG({loop, State}),
+    receive
+        Msg ->
+            handle_msg(Msg, State)
+    after HibernateAfter ->
+        hibernate(State)
+    end.
+
+%% @private
+wake_hib(State) ->
+    ?LOG_DEBUG({wake_hib, State}),
+    receive
+        Msg ->
+            handle_msg(Msg, State)
     end.
 
+%% @private
+hibernate(State) ->
+    erlang:hibernate(?MODULE, wake_hib, [State]).
+
+%% @private
+handle_msg({'$call', Pid, Ref, Request}, #state{mod=Mod, mod_state=ModState} = State) ->
+    ?LOG_DEBUG({'$call', Pid, Ref, Request}),
+    case Mod:handle_call(Request, {Pid, Ref}, ModState) of
+        {reply, Reply, NewModState} ->
+            Pid ! {Ref, Reply},
+            loop(State#state{mod_state=NewModState});
+        {reply, Reply, NewModState, hibernate} ->
+            Pid ! {Ref, Reply},
+            hibernate(State#state{mod_state=NewModState});
+        {noreply, NewModState} ->
+            ?LOG_DEBUG({noreply, NewModState}),
+            loop(State#state{mod_state=NewModState});
+        {noreply, NewModState, hibernate} ->
+            hibernate(State#state{mod_state=NewModState});
+        {stop, Reason, Reply, NewModState} ->
+             Pid ! {Ref, Reply},
+             do_terminate(State, Reason, NewModState);
+        {stop, Reason, NewModState} ->
+            do_terminate(State, Reason, NewModState);
+        _ ->
+            do_terminate(State, {error, unexpected_reply}, ModState)
+    end;
+handle_msg({'$cast', Request}, #state{mod=Mod, mod_state=ModState} = State) ->
+    ?LOG_DEBUG({'$cast', Request}),
+    handle_noreply(Mod:handle_cast(Request, ModState), State);
+handle_msg({'$stop', Pid, Ref, Reason}, #state{mod_state=ModState} = State) ->
+    ?LOG_DEBUG({'$stop', Pid, Ref, Reason}),
+    do_terminate(State, Reason, ModState),
+    Pid ! {Ref, ok};
+handle_msg(Info, #state{mod=Mod, mod_state=ModState} = State) ->
+    ?LOG_DEBUG({'Info', Info}),
+    handle_noreply(Mod:handle_info(Info, ModState), State).
+
+%% @private
+handle_noreply({noreply, NewModState}, State) ->
+    loop(State#state{mod_state=NewModState});
+handle_noreply({noreply, NewModState, hibernate}, State) ->
+    hibernate(State#state{mod_state=NewModState});
+handle_noreply({stop, Reason, NewModState}, State) ->
+    do_terminate(State, Reason, NewModState);
+handle_noreply(_, #state{mod_state=ModState} = State) ->
+    do_terminate(State, {error, unexpected_reply}, ModState).
+
 %% @private
 do_terminate(#state{mod=Mod, name=Name} = _State, Reason, ModState) ->
     case Name of
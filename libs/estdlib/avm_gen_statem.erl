@@ -33,7 +33,7 @@
 %%     <li>Support only for locally named gen_statem instances</li>
 %%     <li>Support only for state function event handlers</li>
 %%     <li>No support for keeep_state or repeat_state return values from Module:StateName/3 callbacks</li>
-%%     <li>No support for postpone or hibernate state transition actions</li>
+%%     <li>No support for postpone state transition actions</li>
 %%     <li>No support for state enter calls</li>
 %%     <li>No support for multi_call</li>
 %% </ul>
@@ -239,7 +239,13 @@ do_handle_state(EventType, Request, #state{mod=Module, current_state=CurrentStat
         {next_state, NextState, NewData, Actions} ->
             maybe_log_state_transition(CurrentState, NextState),
             handle_actions(Actions, [{current_state, CurrentState}, {next_state, NextState}]),
-            {noreply, State#state{current_state=NextState, data=NewData}};
+            NewState = State#state{current_state=NextState, data=NewData},
+            case ?LISTS:member(hibernate, Actions) of
+                true ->
+                    {noreply, NewState, hibernate};
+                false ->
+                    {noreply, NewState}
+            end;
         {stop, Reason} ->
             {stop, Reason, State};
         {stop, Reason, NewData} ->
@@ -264,7 +270,7 @@ handle_actions([{reply, From, Reply} | T], Context) ->
     handle_actions(T, Context);
 handle_actions([{state_timeout, Timeout, Msg} | T], Context) ->
     ?LOG_DEBUG({handle_actions, state_timeout}),
-    timer_manager:start_timer(Timeout, self(), {state_timeout, ?PROPLISTS:get_value(next_state, Context), Msg}),
+    erlang:start_timer(Timeout, self(), {state_timeout, ?PROPLISTS:get_value(next_state, Context), Msg}),
     handle_actions(T, Context);
 handle_actions([_ | T], Context) ->
     ?LOG_DEBUG({handle_actions, rest, T}),
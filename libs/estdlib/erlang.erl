@@ -1,87 +0,0 @@
-%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-%   Copyright 2018 by Fred Dushin <fred@dushin.net>                       %
-%                                                                         %
-%   This program is free software; you can redistribute it and/or modify  %
-%   it under the terms of the GNU Lesser General Public License as        %
-%   published by the Free Software Foundation; either version 2 of the    %
-%   License, or (at your option) any later version.                       %
-%                                                                         %
-%   This program is distributed in the hope that it will be useful,       %
-%   but WITHOUT ANY WARRANTY; without even the implied warranty of        %
-%   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         %
-%   GNU General Public License for more details.                          %
-%                                                                         %
-%   You should have received a copy of the GNU General Public License     %
-%   along with this program; if not, write to the                         %
-%   Free Software Foundation, Inc.,                                       %
-%   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        %
-%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-
-%%-----------------------------------------------------------------------------
-%% @doc An implementation of the Erlang/OTP erlang module, for functions
-%% that are not already defined as NIFs.
-%% @end
-%%-----------------------------------------------------------------------------
--module(erlang).
-
--export([start_timer/3, start_timer/4, cancel_timer/1, send_after/3]).
-
-
-%%-----------------------------------------------------------------------------
-%% @param   Time time in milliseconds after which to send the timeout message.
-%% @param   Dest Pid or server name to which to send the timeout message.
-%% @param   Msg Message to send to Dest after Time ms.
-%% @returns a reference that can be used to cancel the timer, if desired.
-%% @doc     Start a timer, and send {timeout, TimerRef, Msg} to Dest after
-%%          Time ms, where TimerRef is the reference returned from this function.
-%% @end
-%%-----------------------------------------------------------------------------
--spec start_timer(non_neg_integer(), pid() | atom(), term()) -> reference().
-start_timer(Time, Dest, Msg) ->
-    start_timer(Time, Dest, Msg, []).
-
-
-%%-----------------------------------------------------------------------------
-%% @hidden
-%% @param   Time time in milliseconds after which to send the timeout message.
-%% @param   Dest Pid or server name to which to send the timeout message.
-%% @param   Msg Message to send to Dest after Time ms.
-%% @param   Options options
-%% @returns a reference that can be used to cancel the timer, if desired.
-%% @doc     Start a timer, and send {timeout, TimerRef, Msg} to Dest after
-%%          Time ms, where TimerRef is the reference returned from this function.
-%%
-%%          <em><b>Note.</b>  The Options argument is currently ignored.</em>
-%%-----------------------------------------------------------------------------
--spec start_timer(non_neg_integer(), pid() | atom(), term(), list()) -> reference().
-start_timer(Time, Dest, Msg, _Options) ->
-    timer_manager:start_timer(Time, Dest, Msg).
-
-
-%%-----------------------------------------------------------------------------
-%% @hidden
-%% @param   Time time in milliseconds after which to send the timeout message.
-%% @param   Dest Pid or server name to which to send the timeout message.
-%% @param   Msg Message to send to Dest after Time ms.
-%% @param   Options options
-%% @returns a reference that can be used to cancel the timer, if desired.
-%% @doc     Start a timer, and send {timeout, TimerRef, Msg} to Dest after
-%%          Time ms, where TimerRef is the reference returned from this function.
-%%
-%%          <em><b>Note.</b>  The Options argument is currently ignored.</em>
-%%-----------------------------------------------------------------------------
--spec cancel_timer(TimerRef::reference()) -> ok.
-cancel_timer(TimerRef) ->
-    timer_manager:cancel_timer(TimerRef).
-
-%%-----------------------------------------------------------------------------
-%% @param   Time time in milliseconds after which to send the message.
-%% @param   Dest Pid or server name to which to send the message.
-%% @param   Msg Message to send to Dest after Time ms.
-%% @returns a reference that can be used to cancel the timer, if desired.
-%% @doc     Send Msg to Dest after Time ms.
-%% @end
-%%-----------------------------------------------------------------------------
--spec send_after(non_neg_integer(), pid() | atom(), term()) -> reference().
-send_after(Time, Dest, Msg) ->
-    timer_manager:send_after(Time, Dest, Msg).
@@ -0,0 +1,315 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "base64.h"
+
+#include "utils.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define BASE64_WITH_SSSE3
+    #include <cpuid.h>
+    #include <immintrin.h>
+
+    #define CPUID_1_ECX_SSSE3 (1 << 9)
+#endif
+
+#define BASE64_INVALID -1
+#define BASE64_WHITESPACE -2
+#define BASE64_PAD -3
+
+static const char base64_alphabet[64] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// character to 6 bits value, or one of the negative BASE64_ values
+static const int8_t base64_values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -2, -2, -1, -1, -2, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -3, -1, -1,
+    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+#ifdef BASE64_WITH_SSSE3
+
+static int ssse3_supported()
+{
+    // cpuid is expensive, so it is queried only once, instances on other threads may query it concurrently
+    static int supported = -1;
+
+    int cached = __atomic_load_n(&supported, __ATOMIC_RELAXED);
+    if (UNLIKELY(cached < 0)) {
+        unsigned int eax, ebx, ecx, edx;
+        cached = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & CPUID_1_ECX_SSSE3);
+        __atomic_store_n(&supported, cached, __ATOMIC_RELAXED);
+    }
+
+    return cached;
+}
+
+// Encodes 12 bytes to 16 characters: bytes are spread so each 32 bits lane holds 4 indexes, that are
+// mapped to ASCII adding an offset selected by range. 16 bytes are read, so src must have 4 more bytes.
+__attribute__((target("ssse3")))
+static size_t base64_encode_ssse3(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    size_t done = 0;
+
+    while (len - done >= 16) {
+        __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (src + done)), spread);
+
+        __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+        __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+        __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        __m128i indexes = _mm_or_si128(t1, t3);
+
+        // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+        __m128i range = _mm_subs_epu8(indexes, _mm_set1_epi8(51));
+        __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indexes);
+        range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+        __m128i out = _mm_add_epi8(indexes, _mm_shuffle_epi8(offsets, range));
+
+        _mm_storeu_si128((__m128i *) dst, out);
+        dst += 16;
+        done += 12;
+    }
+
+    return done;
+}
+
+static inline __m128i in_range(__m128i in, char lo, char hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(in, _mm_set1_epi8(hi + 1)));
+}
+
+// Decodes 16 characters to 12 bytes, 16 bytes are written so dst must have 4 more bytes.
+// Stops at the first block that has any character outside the alphabet.
+__attribute__((target("ssse3")))
+static size_t base64_decode_ssse3(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t done = 0;
+
+    while (len - done >= 16) {
+        __m128i in = _mm_loadu_si128((const __m128i *) (src + done));
+
+        __m128i upper = in_range(in, 'A', 'Z');
+        __m128i lower = in_range(in, 'a', 'z');
+        __m128i digit = in_range(in, '0', '9');
+        __m128i plus = _mm_cmpeq_epi8(in, _mm_set1_epi8('+'));
+        __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+
+        __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, plus), slash));
+        if (_mm_movemask_epi8(valid) != 0xFFFF) {
+            break;
+        }
+
+        __m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+        shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+        shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+        shift = _mm_or_si128(shift, _mm_and_si128(plus, _mm_set1_epi8(62 - '+')));
+        shift = _mm_or_si128(shift, _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+        __m128i values = _mm_add_epi8(in, shift);
+
+        // merge 4 x 6 bits values in each 32 bits lane, then keep the 3 bytes of each lane
+        __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128((__m128i *) dst, _mm_shuffle_epi8(merged, pack));
+
+        dst += 12;
+        done += 16;
+    }
+
+    return done;
+}
+
+#endif
+
+void base64_encode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+#ifdef BASE64_WITH_SSSE3
+    if (ssse3_supported()) {
+        size_t done = base64_encode_ssse3(src, len, dst);
+        src += done;
+        dst += done / 3 * 4;
+        len -= done;
+    }
+#endif
+
+    while (len >= 3) {
+        uint32_t v = (src[0] << 16) | (src[1] << 8) | src[2];
+        dst[0] = base64_alphabet[v >> 18];
+        dst[1] = base64_alphabet[(v >> 12) & 0x3F];
+        dst[2] = base64_alphabet[(v >> 6) & 0x3F];
+        dst[3] = base64_alphabet[v & 0x3F];
+        src += 3;
+        dst += 4;
+        len -= 3;
+    }
+
+    if (len > 0) {
+        uint32_t v = (src[0] << 16) | ((len == 2) ? (src[1] << 8) : 0);
+        dst[0] = base64_alphabet[v >> 18];
+        dst[1] = base64_alphabet[(v >> 12) & 0x3F];
+        dst[2] = (len == 2) ? base64_alphabet[(v >> 6) & 0x3F] : '=';
+        dst[3] = '=';
+    }
+}
+
+int base64_decode_strict(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    if ((len % 4) != 0) {
+        return 0;
+    }
+
+#ifdef BASE64_WITH_SSSE3
+    // the last group might be padded, and 4 bytes are written past each decoded block
+    if ((len > 24) && ssse3_supported()) {
+        size_t done = base64_decode_ssse3(src, len - 8, dst);
+        src += done;
+        dst += done / 4 * 3;
+        len -= done;
+    }
+#endif
+
+    while (len > 0) {
+        int a = base64_values[src[0]];
+        int b = base64_values[src[1]];
+        int c = base64_values[src[2]];
+        int d = base64_values[src[3]];
+
+        if (UNLIKELY((a | b | c | d) < 0)) {
+            // only the last group can be padded
+            if ((len != 4) || (a < 0) || (b < 0)) {
+                return 0;
+            }
+            if ((c == BASE64_PAD) && (d == BASE64_PAD)) {
+                dst[0] = (a << 2) | (b >> 4);
+                return 1;
+            } else if ((c >= 0) && (d == BASE64_PAD)) {
+                dst[0] = (a << 2) | (b >> 4);
+                dst[1] = (b << 4) | (c >> 2);
+                return 1;
+            }
+            return 0;
+        }
+
+        uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+        dst[0] = v >> 16;
+        dst[1] = v >> 8;
+        dst[2] = v;
+        src += 4;
+        dst += 3;
+        len -= 4;
+    }
+
+    return 1;
+}
+
+static inline long decoded_size_from_chars(size_t chars)
+{
+    long size = (chars / 4) * 3;
+    switch (chars % 4) {
+        case 2:
+            return size + 1;
+        case 3:
+            return size + 2;
+        default:
+            return size;
+    }
+}
+
+long base64_decoded_size(const uint8_t *src, size_t len, int mime)
+{
+    size_t chars = 0;
+    size_t pad = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        int value = base64_values[src[i]];
+
+        if (value >= 0) {
+            if (pad) {
+                if (!mime) {
+                    return -1;
+                }
+                break;
+            }
+            chars++;
+        } else if (value == BASE64_PAD) {
+            if (mime) {
+                break;
+            }
+            pad++;
+        } else if ((value == BASE64_INVALID) && !mime) {
+            return -1;
+        }
+    }
+
+    if (!mime && (((chars + pad) % 4 != 0) || (pad > 2) || ((chars % 4) == 1))) {
+        return -1;
+    }
+
+    return decoded_size_from_chars(chars);
+}
+
+void base64_decode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    uint32_t v = 0;
+    int chars = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        int value = base64_values[src[i]];
+        if (value == BASE64_PAD) {
+            break;
+        } else if (value < 0) {
+            continue;
+        }
+
+        v = (v << 6) | value;
+        chars++;
+        if (chars == 4) {
+            dst[0] = v >> 16;
+            dst[1] = v >> 8;
+            dst[2] = v;
+            dst += 3;
+            chars = 0;
+            v = 0;
+        }
+    }
+
+    if (chars == 2) {
+        dst[0] = v >> 4;
+    } else if (chars == 3) {
+        dst[0] = v >> 10;
+        dst[1] = v >> 2;
+    }
+}
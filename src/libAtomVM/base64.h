@@ -0,0 +1,87 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file base64.h
+ * @brief Base64 encoding and decoding (RFC 4648).
+ *
+ * @details Output buffers are sized by the caller using base64_encoded_size and base64_decoded_size.
+ *          SSSE3 kernels are used when available on x86-64, otherwise a table based scalar implementation.
+ */
+
+#ifndef _BASE64_H_
+#define _BASE64_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Returns the size of the encoded output
+ *
+ * @param len input length in bytes.
+ * @returns encoded length, padding included.
+ */
+static inline size_t base64_encoded_size(size_t len)
+{
+    return ((len + 2) / 3) * 4;
+}
+
+/**
+ * @brief Encodes bytes to base64
+ *
+ * @param src input bytes.
+ * @param len input length in bytes.
+ * @param dst output buffer, base64_encoded_size(len) bytes long.
+ */
+void base64_encode(const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * @brief Decodes a padded base64 string that has no whitespace
+ *
+ * @details This is the fast path for well formed input. dst must be base64_decoded_size(src, len, 0)
+ *          bytes long, that is len / 4 * 3 minus padding, and len must be a multiple of 4.
+ * @param src base64 encoded data.
+ * @param len encoded data length.
+ * @param dst output buffer.
+ * @returns 1 on success, 0 if src contains any character that is not part of the alphabet or misplaced padding.
+ */
+int base64_decode_strict(const uint8_t *src, size_t len, uint8_t *dst);
+
+/**
+ * @brief Validates base64 data and returns the decoded size
+ *
+ * @details When mime is 0 whitespace is allowed and padding is required, otherwise any character that
+ *          is not part of the alphabet is ignored and decoding stops at the first padding character.
+ * @param src base64 encoded data.
+ * @param len encoded data length.
+ * @param mime 1 to use MIME rules.
+ * @returns the decoded size or -1 if data is not valid.
+ */
+long base64_decoded_size(const uint8_t *src, size_t len, int mime);
+
+/**
+ * @brief Decodes base64 data that has been validated with base64_decoded_size
+ *
+ * @param src base64 encoded data.
+ * @param len encoded data length.
+ * @param dst output buffer, base64_decoded_size(src, len, mime) bytes long.
+ */
+void base64_decode(const uint8_t *src, size_t len, uint8_t *dst);
+
+#endif
@@ -45,7 +45,9 @@ static const char *const true_atom = "\x04" "true";
 static const char *const false_atom = "\x05" "false";
 static const char *const error_atom = "\x05" "error";
 static const char *const badarith_atom = "\x08" "badarith";
+static const char *const overflow_atom = "\x08" "overflow";
 static const char *const badarg_atom = "\x6" "badarg";
+static const char *const undefined_atom = "\x9" "undefined";
 
 
 BifImpl bif_registry_get_handler(AtomString module, AtomString function, int arity)
@@ -61,6 +63,19 @@ BifImpl bif_registry_get_handler(AtomString module, AtomString function, int ari
     return nameAndPtr->function;
 }
 
+enum InlineBif bif_registry_get_inline(AtomString module, AtomString function, int arity)
+{
+    char bifname[MAX_BIF_NAME_LEN];
+
+    atom_write_mfa(bifname, MAX_BIF_NAME_LEN, module, function, arity);
+    const BifNameAndPtr *nameAndPtr = in_word_set(bifname, strlen(bifname));
+    if (!nameAndPtr) {
+        return InlineBifNone;
+    }
+
+    return nameAndPtr->inline_op;
+}
+
 
 term bif_erlang_self_0(Context *ctx)
 {
@@ -194,13 +209,32 @@ term bif_erlang_tuple_size_1(Context *ctx, term arg1)
     return term_from_int32(term_get_tuple_arity(arg1));
 }
 
+term bif_erlang_get_1(Context *ctx, term arg1)
+{
+    term value = dictionary_get(&ctx->dictionary, arg1, ctx->global);
+    if (term_is_invalid_term(value)) {
+        return context_make_atom(ctx, undefined_atom);
+    }
+
+    return value;
+}
+
+// there are no big integers yet: results that do not fit a small integer raise an overflow error
+static term make_small_int(Context *ctx, int64_t value)
+{
+    if (UNLIKELY((value > TERM_MAX_SMALL_INT) || (value < TERM_MIN_SMALL_INT))) {
+        RAISE_ERROR(overflow_atom);
+    }
+
+    return term_from_int64(value);
+}
+
 term bif_erlang_add_2(Context *ctx, int live, term arg1, term arg2)
 {
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1) && term_is_integer(arg2))) {
-        //NEED CHECK OVERFLOW AND BIG INTEGER
-        return term_from_int32(term_to_int32(arg1) + term_to_int32(arg2));
+        return make_small_int(ctx, term_to_int64(arg1) + term_to_int64(arg2));
 
     } else {
         TRACE("error: arg1: %lx, arg2: %lx\n", arg1, arg2);
@@ -213,8 +247,7 @@ term bif_erlang_sub_2(Context *ctx, int live, term arg1, term arg2)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1) && term_is_integer(arg2))) {
-        //NEED CHECK OVERFLOW AND BIG INTEGER
-        return term_from_int32(term_to_int32(arg1) - term_to_int32(arg2));
+        return make_small_int(ctx, term_to_int64(arg1) - term_to_int64(arg2));
 
     } else {
         TRACE("error: arg1: %lx, arg2: %lx\n", arg1, arg2);
@@ -227,8 +260,11 @@ term bif_erlang_mul_2(Context *ctx, int live, term arg1, term arg2)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1) && term_is_integer(arg2))) {
-        //NEED CHECK OVERFLOW AND BIG INTEGER
-        return term_from_int32(term_to_int32(arg1) * term_to_int32(arg2));
+        int64_t result;
+        if (UNLIKELY(__builtin_mul_overflow(term_to_int64(arg1), term_to_int64(arg2), &result))) {
+            RAISE_ERROR(overflow_atom);
+        }
+        return make_small_int(ctx, result);
 
     } else {
         TRACE("error: arg1: %lx, arg2: %lx\n", arg1, arg2);
@@ -241,9 +277,9 @@ term bif_erlang_div_2(Context *ctx, int live, term arg1, term arg2)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1) && term_is_integer(arg2))) {
-        int32_t operand_b = term_to_int32(arg2);
+        int64_t operand_b = term_to_int64(arg2);
         if (operand_b != 0) {
-            return term_from_int32(term_to_int32(arg1) / operand_b);
+            return make_small_int(ctx, term_to_int64(arg1) / operand_b);
 
         } else {
             RAISE_ERROR(badarith_atom);
@@ -260,7 +296,7 @@ term bif_erlang_neg_1(Context *ctx, int live, term arg1)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1))) {
-        return term_from_int32(-term_to_int32(arg1));
+        return make_small_int(ctx, -term_to_int64(arg1));
 
     } else {
         TRACE("error: arg1: %lx\n", arg1);
@@ -273,9 +309,9 @@ term bif_erlang_abs_1(Context *ctx, int live, term arg1)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1))) {
-        int32_t int_val = term_to_int32(arg1);
+        int64_t int_val = term_to_int64(arg1);
         if (int_val < 0) {
-            return term_from_int32(-int_val);
+            return make_small_int(ctx, -int_val);
         } else {
             return arg1;
         }
@@ -291,9 +327,9 @@ term bif_erlang_rem_2(Context *ctx, int live, term arg1, term arg2)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1) && term_is_integer(arg2))) {
-        int32_t operand_b = term_to_int32(arg2);
+        int64_t operand_b = term_to_int64(arg2);
         if (LIKELY(operand_b != 0)) {
-            return term_from_int32(term_to_int32(arg1) % operand_b);
+            return term_from_int64(term_to_int64(arg1) % operand_b);
 
         } else {
             RAISE_ERROR(badarith_atom);
@@ -310,7 +346,7 @@ term bif_erlang_bor_2(Context *ctx, int live, term arg1, term arg2)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1) && term_is_integer(arg2))) {
-        return term_from_int32(term_to_int32(arg1) | term_to_int32(arg2));
+        return term_from_int64(term_to_int64(arg1) | term_to_int64(arg2));
 
     } else {
         RAISE_ERROR(badarith_atom);
@@ -322,7 +358,7 @@ term bif_erlang_band_2(Context *ctx, int live, term arg1, term arg2)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1) && term_is_integer(arg2))) {
-        return term_from_int32(term_to_int32(arg1) & term_to_int32(arg2));
+        return term_from_int64(term_to_int64(arg1) & term_to_int64(arg2));
 
     } else {
         RAISE_ERROR(badarith_atom);
@@ -334,19 +370,36 @@ term bif_erlang_bxor_2(Context *ctx, int live, term arg1, term arg2)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1) && term_is_integer(arg2))) {
-        return term_from_int32(term_to_int32(arg1) ^ term_to_int32(arg2));
+        return term_from_int64(term_to_int64(arg1) ^ term_to_int64(arg2));
 
     } else {
         RAISE_ERROR(badarith_atom);
     }
 }
 
+static term shift_left(Context *ctx, int64_t value, int64_t shift)
+{
+    if (shift < 0) {
+        // arithmetic shift right, shifting out every bit leaves the sign
+        return term_from_int64(value >> ((shift > -64) ? -shift : 63));
+    }
+
+    if (value == 0) {
+        return term_from_int64(0);
+    }
+    if (UNLIKELY((shift >= TERM_BITS - 4) || (value > (TERM_MAX_SMALL_INT >> shift)) || (value < (TERM_MIN_SMALL_INT >> shift)))) {
+        RAISE_ERROR(overflow_atom);
+    }
+
+    return term_from_int64(value * ((int64_t) 1 << shift));
+}
+
 term bif_erlang_bsl_2(Context *ctx, int live, term arg1, term arg2)
 {
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1) && term_is_integer(arg2))) {
-        return term_from_int32(term_to_int32(arg1) << term_to_int32(arg2));
+        return shift_left(ctx, term_to_int64(arg1), term_to_int64(arg2));
 
     } else {
         RAISE_ERROR(badarith_atom);
@@ -358,7 +411,7 @@ term bif_erlang_bsr_2(Context *ctx, int live, term arg1, term arg2)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1) && term_is_integer(arg2))) {
-        return term_from_int32(term_to_int32(arg1) >> term_to_int32(arg2));
+        return shift_left(ctx, term_to_int64(arg1), -term_to_int64(arg2));
 
     } else {
         RAISE_ERROR(badarith_atom);
@@ -370,7 +423,7 @@ term bif_erlang_bnot_1(Context *ctx, int live, term arg1)
     UNUSED(live);
 
     if (LIKELY(term_is_integer(arg1))) {
-        return term_from_int32(~term_to_int32(arg1));
+        return term_from_int64(~term_to_int64(arg1));
 
     } else {
         RAISE_ERROR(badarith_atom);
@@ -505,7 +558,7 @@ term bif_erlang_exactly_not_equal_to_2(Context *ctx, term arg1, term arg2)
 term bif_erlang_greater_than_2(Context *ctx, term arg1, term arg2)
 {
     //TODO: fix this implementation, it needs to cover more types
-    if (term_to_int32(arg1) > term_to_int32(arg2)) {
+    if (term_to_int64(arg1) > term_to_int64(arg2)) {
         return context_make_atom(ctx, true_atom);
     } else {
         return context_make_atom(ctx, false_atom);
@@ -515,7 +568,7 @@ term bif_erlang_greater_than_2(Context *ctx, term arg1, term arg2)
 term bif_erlang_less_than_2(Context *ctx, term arg1, term arg2)
 {
     //TODO: fix this implementation, it needs to cover more types
-    if (term_to_int32(arg1) < term_to_int32(arg2)) {
+    if (term_to_int64(arg1) < term_to_int64(arg2)) {
         return context_make_atom(ctx, true_atom);
     } else {
         return context_make_atom(ctx, false_atom);
@@ -525,7 +578,7 @@ term bif_erlang_less_than_2(Context *ctx, term arg1, term arg2)
 term bif_erlang_less_than_or_equal_2(Context *ctx, term arg1, term arg2)
 {
     //TODO: fix this implementation, it needs to cover more types
-    if (term_to_int32(arg1) <= term_to_int32(arg2)) {
+    if (term_to_int64(arg1) <= term_to_int64(arg2)) {
         return context_make_atom(ctx, true_atom);
     } else {
         return context_make_atom(ctx, false_atom);
@@ -535,7 +588,7 @@ term bif_erlang_less_than_or_equal_2(Context *ctx, term arg1, term arg2)
 term bif_erlang_greater_than_or_equal_2(Context *ctx, term arg1, term arg2)
 {
     //TODO: fix this implementation, it needs to cover more types
-    if (term_to_int32(arg1) >= term_to_int32(arg2)) {
+    if (term_to_int64(arg1) >= term_to_int64(arg2)) {
         return context_make_atom(ctx, true_atom);
     } else {
         return context_make_atom(ctx, false_atom);
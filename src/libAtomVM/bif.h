@@ -32,7 +32,39 @@
 
 #define MAX_BIF_NAME_LEN 260
 
+/**
+ * @brief BIFs that the interpreter executes inline when both operands are small integers.
+ */
+enum InlineBif
+{
+    InlineBifNone = 0,
+    InlineBifAdd,
+    InlineBifSub,
+    InlineBifMul,
+    InlineBifBand,
+    InlineBifBor,
+    InlineBifBsl,
+    InlineBifBsr,
+    InlineBifLessThan,
+    InlineBifLessThanOrEqual,
+    InlineBifGreaterThan,
+    InlineBifGreaterThanOrEqual,
+    InlineBifExactlyEqualTo,
+    InlineBifExactlyNotEqualTo
+};
+
 BifImpl bif_registry_get_handler(AtomString module, AtomString function, int arity);
+
+/**
+ * @brief Gets the inline operation of a BIF
+ *
+ * @details Used by the loader to mark imports that can be executed by bif_inline_2.
+ * @param module the module name.
+ * @param function the function name.
+ * @param arity the function arity.
+ * @returns the InlineBif operation or InlineBifNone.
+ */
+enum InlineBif bif_registry_get_inline(AtomString module, AtomString function, int arity);
 term bif_erlang_self_0(Context *ctx);
 term bif_erlang_byte_size_1(Context *ctx, int live, term arg1);
 term bif_erlang_length_1(Context *ctx, int live, term arg1);
@@ -52,6 +84,8 @@ term bif_erlang_tl_1(Context *ctx, term arg1);
 term bif_erlang_element_2(Context *ctx, term arg1, term arg2);
 term bif_erlang_tuple_size_1(Context *ctx, term arg1);
 
+term bif_erlang_get_1(Context *ctx, term arg1);
+
 term bif_erlang_add_2(Context *ctx, int live, term arg1, term arg2);
 term bif_erlang_sub_2(Context *ctx, int live, term arg1, term arg2);
 term bif_erlang_mul_2(Context *ctx, int live, term arg1, term arg2);
@@ -83,4 +117,107 @@ term bif_erlang_less_than_2(Context *ctx, term arg1, term arg2);
 term bif_erlang_less_than_or_equal_2(Context *ctx, term arg1, term arg2);
 term bif_erlang_greater_than_or_equal_2(Context *ctx, term arg1, term arg2);
 
+/**
+ * @brief Executes an arithmetic or comparison BIF on small integers
+ *
+ * @details Works directly on tagged values: the 4 bits tag of both operands is 0xF, so the sum of a
+ *          tagged value and an untagged one is the tagged sum, and comparing tagged values compares
+ *          the integers. Overflowing the tagged word is overflowing the small integer range.
+ * @param ctx the current context, used to make true and false atoms.
+ * @param op an InlineBif operation.
+ * @param arg1 the first operand.
+ * @param arg2 the second operand.
+ * @returns the result or an invalid term when operands are not small integers or the result does not
+ *          fit a small integer, in that case the C BIF must be called.
+ */
+static inline term bif_inline_2(Context *ctx, enum InlineBif op, term arg1, term arg2)
+{
+    if (UNLIKELY(!term_is_integer(arg1) || !term_is_integer(arg2))) {
+        return term_invalid_term();
+    }
+
+    signed_term a = (signed_term) arg1;
+    signed_term b = (signed_term) arg2;
+    signed_term result;
+
+    switch (op) {
+        case InlineBifAdd:
+            if (UNLIKELY(__builtin_add_overflow(a, b & ~(signed_term) 0xF, &result))) {
+                return term_invalid_term();
+            }
+            return (term) result;
+
+        case InlineBifSub:
+            if (UNLIKELY(__builtin_sub_overflow(a, b & ~(signed_term) 0xF, &result))) {
+                return term_invalid_term();
+            }
+            return (term) result;
+
+        case InlineBifMul:
+            if (UNLIKELY(__builtin_mul_overflow(a & ~(signed_term) 0xF, b >> 4, &result))) {
+                return term_invalid_term();
+            }
+            return ((term) result) | 0xF;
+
+        case InlineBifBand:
+            return arg1 & arg2;
+
+        case InlineBifBor:
+            return arg1 | arg2;
+
+        case InlineBifBsl: {
+            signed_term shift = b >> 4;
+            if (UNLIKELY((shift < 0) || (shift >= TERM_BITS))) {
+                return term_invalid_term();
+            }
+            signed_term tagged = a & ~(signed_term) 0xF;
+            result = (signed_term) (((term) tagged) << shift);
+            if (UNLIKELY((result >> shift) != tagged)) {
+                return term_invalid_term();
+            }
+            return ((term) result) | 0xF;
+        }
+
+        case InlineBifBsr: {
+            signed_term shift = b >> 4;
+            if (UNLIKELY(shift < 0)) {
+                return term_invalid_term();
+            }
+            if (shift >= TERM_BITS) {
+                shift = TERM_BITS - 1;
+            }
+            return ((term) ((a >> 4) >> shift) << 4) | 0xF;
+        }
+
+        case InlineBifLessThan:
+            result = a < b;
+            break;
+
+        case InlineBifLessThanOrEqual:
+            result = a <= b;
+            break;
+
+        case InlineBifGreaterThan:
+            result = a > b;
+            break;
+
+        case InlineBifGreaterThanOrEqual:
+            result = a >= b;
+            break;
+
+        case InlineBifExactlyEqualTo:
+            result = a == b;
+            break;
+
+        case InlineBifExactlyNotEqualTo:
+            result = a != b;
+            break;
+
+        default:
+            return term_invalid_term();
+    }
+
+    return result ? context_make_atom(ctx, "\x04" "true") : context_make_atom(ctx, "\x05" "false");
+}
+
 #endif
@@ -0,0 +1,214 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "bridge.h"
+
+#include "atomshashtable.h"
+#include "context.h"
+#include "externalterm.h"
+#include "mailbox.h"
+#include "sys.h"
+#include "utils.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//#define ENABLE_TRACE
+
+#include "trace.h"
+
+#define VERSION_MAGIC 131
+
+static struct BridgeMessage *bridge_message_new(AtomString name, size_t external_term_size);
+static void bridge_push(GlobalContext *glb, struct BridgeMessage *message);
+static void bridge_deliver(GlobalContext *glb, struct BridgeMessage *message);
+
+struct Bridge *bridge_new()
+{
+    struct Bridge *bridge = malloc(sizeof(struct Bridge));
+    if (IS_NULL_PTR(bridge)) {
+        return NULL;
+    }
+    bridge->instances = NULL;
+    bridge->instances_count = 0;
+
+    return bridge;
+}
+
+void bridge_destroy(struct Bridge *bridge)
+{
+    free(bridge->instances);
+    free(bridge);
+}
+
+int bridge_attach(struct Bridge *bridge, GlobalContext *glb)
+{
+    GlobalContext **instances = realloc(bridge->instances, sizeof(GlobalContext *) * (bridge->instances_count + 1));
+    if (IS_NULL_PTR(instances)) {
+        return -1;
+    }
+    bridge->instances = instances;
+
+    int instance = bridge->instances_count;
+    instances[instance] = glb;
+    bridge->instances_count++;
+
+    glb->bridge = bridge;
+    glb->instance = instance;
+
+    return instance;
+}
+
+enum BridgeSendResult bridge_post(struct Bridge *bridge, int instance, AtomString name, const uint8_t *external_term, size_t size)
+{
+    if (UNLIKELY((instance < 0) || (instance >= bridge->instances_count))) {
+        return BridgeSendBadArg;
+    }
+
+    struct BridgeMessage *message = bridge_message_new(name, size);
+    if (IS_NULL_PTR(message)) {
+        return BridgeSendOutOfMemory;
+    }
+    memcpy(message->data + atom_string_len(name) + 1, external_term, size);
+
+    bridge_push(bridge->instances[instance], message);
+
+    return BridgeSendOk;
+}
+
+enum BridgeSendResult bridge_send(GlobalContext *glb, term destination, term message)
+{
+    if (UNLIKELY(!glb->bridge || !term_is_tuple(destination) || (term_get_tuple_arity(destination) != 2))) {
+        return BridgeSendBadArg;
+    }
+    term name = term_get_tuple_element(destination, 0);
+    term instance = term_get_tuple_element(destination, 1);
+    if (UNLIKELY(!term_is_atom(name) || !term_is_integer(instance))) {
+        return BridgeSendBadArg;
+    }
+
+    struct Bridge *bridge = glb->bridge;
+    int64_t instance_index = term_to_int64(instance);
+    if (UNLIKELY((instance_index < 0) || (instance_index >= bridge->instances_count))) {
+        return BridgeSendBadArg;
+    }
+
+    int external_term_size = externalterm_compute_external_size(message, glb);
+    if (UNLIKELY(external_term_size < 0)) {
+        return BridgeSendBadArg;
+    }
+
+    // serialization needs the sender atoms table, so it is done on the sender thread
+    AtomString name_string = globalcontext_atomstring_from_term(glb, name);
+    struct BridgeMessage *bridge_message = bridge_message_new(name_string, external_term_size);
+    if (IS_NULL_PTR(bridge_message)) {
+        return BridgeSendOutOfMemory;
+    }
+    externalterm_serialize_term(bridge_message->data + atom_string_len(name_string) + 1, message, glb);
+
+    bridge_push(bridge->instances[instance_index], bridge_message);
+
+    return BridgeSendOk;
+}
+
+void bridge_deliver_messages(GlobalContext *glb)
+{
+    struct BridgeMessage *messages = __atomic_exchange_n(&glb->bridge_inbox, NULL, __ATOMIC_ACQUIRE);
+
+    // messages are pushed on top of the inbox, so they are reversed to be delivered in order
+    struct BridgeMessage *ordered = NULL;
+    while (messages) {
+        struct BridgeMessage *next = messages->next;
+        messages->next = ordered;
+        ordered = messages;
+        messages = next;
+    }
+
+    while (ordered) {
+        struct BridgeMessage *next = ordered->next;
+        bridge_deliver(glb, ordered);
+        free(ordered);
+        ordered = next;
+    }
+}
+
+static struct BridgeMessage *bridge_message_new(AtomString name, size_t external_term_size)
+{
+    int name_size = atom_string_len(name) + 1;
+
+    struct BridgeMessage *message = malloc(sizeof(struct BridgeMessage) + name_size + external_term_size);
+    if (IS_NULL_PTR(message)) {
+        fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+        return NULL;
+    }
+    message->size = external_term_size;
+    memcpy(message->data, name, name_size);
+
+    return message;
+}
+
+// the inbox is a lock free stack: any thread pushes a message, the instance thread takes all of them at once
+static void bridge_push(GlobalContext *glb, struct BridgeMessage *message)
+{
+    struct BridgeMessage *head = __atomic_load_n(&glb->bridge_inbox, __ATOMIC_RELAXED);
+    do {
+        message->next = head;
+    } while (!__atomic_compare_exchange_n(&glb->bridge_inbox, &head, message, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    sys_signal(glb);
+}
+
+static void bridge_deliver(GlobalContext *glb, struct BridgeMessage *message)
+{
+    AtomString name = (AtomString) message->data;
+
+    // a name that is not in the atoms table cannot be registered
+    unsigned long atom_index = atomshashtable_get_value(glb->atoms_table, name, ULONG_MAX);
+    if (atom_index == ULONG_MAX) {
+        TRACE("Dropping bridged message: no process is registered with that name.\n");
+        return;
+    }
+    int local_process_id = globalcontext_get_registered_process(glb, atom_index);
+    Context *target = local_process_id ? globalcontext_get_process(glb, local_process_id) : NULL;
+    if (!target) {
+        TRACE("Dropping bridged message: no process is registered with that name.\n");
+        return;
+    }
+
+    // posted messages come from outside of the VM, so they are checked while decoding them to a new message
+    const uint8_t *external_term = message->data + atom_string_len(name) + 1;
+    if (UNLIKELY((message->size < 1) || (external_term[0] != VERSION_MAGIC))) {
+        TRACE("Dropping bridged message: missing version tag.\n");
+        return;
+    }
+    size_t bytes_read;
+    Message *m = mailbox_message_decode(glb, external_term + 1, message->size - 1, &bytes_read, NULL);
+    if (UNLIKELY(IS_NULL_PTR(m))) {
+        TRACE("Dropping bridged message: malformed or unsupported external term.\n");
+        return;
+    }
+    if (UNLIKELY(bytes_read != message->size - 1)) {
+        TRACE("Dropping bridged message: trailing data after the external term.\n");
+        mailbox_message_destroy(m);
+        return;
+    }
+    mailbox_enqueue_message(target, m);
+}
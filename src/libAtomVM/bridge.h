@@ -0,0 +1,131 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file bridge.h
+ * @brief Message bridge between AtomVM instances.
+ *
+ * @details Each GlobalContext is a self contained AtomVM instance that can run on its own thread. A bridge connects
+ *          instances, so a process can send messages to processes registered on other instances: messages are
+ *          serialized using external term format and queued on the target instance, that delivers them on its own
+ *          thread. Instances must be attached before they start running, and destroyed after all of them stopped.
+ */
+
+#ifndef _BRIDGE_H_
+#define _BRIDGE_H_
+
+#include "globalcontext.h"
+#include "term.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct Bridge
+{
+    GlobalContext **instances;
+    int instances_count;
+};
+
+struct BridgeMessage
+{
+    struct BridgeMessage *next;
+    size_t size;
+    // registered name (as AtomString) followed by the message in external term format
+    uint8_t data[];
+};
+
+enum BridgeSendResult
+{
+    BridgeSendOk = 0,
+    BridgeSendBadArg = 1,
+    BridgeSendOutOfMemory = 2
+};
+
+/**
+ * @brief Creates a new bridge.
+ *
+ * @returns a new bridge without any instance, or NULL if memory could not be allocated.
+ */
+struct Bridge *bridge_new();
+
+/**
+ * @brief Destroys a bridge.
+ *
+ * @details Frees bridge memory, attached instances are not destroyed.
+ * @param bridge the bridge that will be destroyed.
+ */
+void bridge_destroy(struct Bridge *bridge);
+
+/**
+ * @brief Attaches an instance to a bridge.
+ *
+ * @details Instances are numbered in attach order, starting from 0. This function is not thread safe, all instances
+ *          must be attached before any of them starts running.
+ * @param bridge the bridge.
+ * @param glb the instance that will be attached.
+ * @returns the instance number, or -1 if memory could not be allocated.
+ */
+int bridge_attach(struct Bridge *bridge, GlobalContext *glb);
+
+/**
+ * @brief Posts a message to a process registered on an instance.
+ *
+ * @details This function can be called from any thread, also from outside of any instance. The message is checked
+ *          when it is delivered, malformed or unsupported messages are dropped.
+ * @param bridge the bridge.
+ * @param instance the target instance number.
+ * @param name the registered name of the target process.
+ * @param external_term the message in external term format, that is copied.
+ * @param size the external term size in bytes.
+ * @returns BridgeSendOk, or BridgeSendBadArg if there is no such instance.
+ */
+enum BridgeSendResult bridge_post(struct Bridge *bridge, int instance, AtomString name, const uint8_t *external_term, size_t size);
+
+/**
+ * @brief Sends a term to a process registered on another instance.
+ *
+ * @details Serializes a message and posts it to {Name, Instance} destination, messages to missing processes are
+ *          silently dropped as messages to dead processes are.
+ * @param glb the sender instance.
+ * @param destination a {Name, Instance} tuple.
+ * @param message the message that will be sent.
+ * @returns BridgeSendOk, or BridgeSendBadArg if the destination is not valid or the message cannot be serialized.
+ */
+enum BridgeSendResult bridge_send(GlobalContext *glb, term destination, term message);
+
+/**
+ * @brief Delivers messages that have been posted to an instance.
+ *
+ * @details Messages are delivered on the thread that runs the instance, this function is called by the scheduler.
+ * @param glb the instance.
+ */
+void bridge_deliver_messages(GlobalContext *glb);
+
+/**
+ * @brief Checks if an instance has pending messages.
+ *
+ * @param glb the instance.
+ * @returns 1 if there is any message that should be delivered, 0 otherwise.
+ */
+static inline int bridge_has_messages(GlobalContext *glb)
+{
+    return __atomic_load_n(&glb->bridge_inbox, __ATOMIC_RELAXED) != NULL;
+}
+
+#endif
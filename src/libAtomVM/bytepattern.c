@@ -0,0 +1,298 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "bytepattern.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "list.h"
+#include "utils.h"
+
+#define BYTEPATTERN_SINGLE_BYTE 1
+#define BYTEPATTERN_BMH 2
+#define BYTEPATTERN_AC 3
+
+#define BMH_HEADER_SIZE 2
+#define AC_HEADER_SIZE 3
+#define AC_STATE_SIZE 257
+#define AC_NO_STATE 0xFFFFFFFF
+
+static void *bytepattern_compile_single_byte(uint8_t byte, size_t *compiled_size)
+{
+    uint32_t *compiled = malloc(2 * sizeof(uint32_t));
+    if (IS_NULL_PTR(compiled)) {
+        return NULL;
+    }
+    compiled[0] = BYTEPATTERN_SINGLE_BYTE;
+    compiled[1] = byte;
+
+    *compiled_size = 2 * sizeof(uint32_t);
+    return compiled;
+}
+
+// compiled layout: kind, needle length, skip table (256 entries), needle bytes
+static void *bytepattern_compile_bmh(const struct BytePatternNeedle *needle, size_t *compiled_size)
+{
+    size_t size = (BMH_HEADER_SIZE + 256) * sizeof(uint32_t) + needle->len;
+    uint32_t *compiled = malloc(size);
+    if (IS_NULL_PTR(compiled)) {
+        return NULL;
+    }
+    compiled[0] = BYTEPATTERN_BMH;
+    compiled[1] = needle->len;
+
+    uint32_t *skip = compiled + BMH_HEADER_SIZE;
+    for (int i = 0; i < 256; i++) {
+        skip[i] = needle->len;
+    }
+    for (size_t i = 0; i < needle->len - 1; i++) {
+        skip[needle->data[i]] = needle->len - 1 - i;
+    }
+    memcpy(skip + 256, needle->data, needle->len);
+
+    *compiled_size = size;
+    return compiled;
+}
+
+// compiled layout: kind, states count, longest needle length, then for each state 256 transitions
+// followed by the length of the longest needle that ends in that state (0 if none)
+static void *bytepattern_compile_ac(const struct BytePatternNeedle needles[], int needles_count, size_t *compiled_size)
+{
+    size_t max_states = 1;
+    size_t max_len = 0;
+    for (int i = 0; i < needles_count; i++) {
+        max_states += needles[i].len;
+        if (needles[i].len > max_len) {
+            max_len = needles[i].len;
+        }
+    }
+
+    uint32_t *compiled = malloc((AC_HEADER_SIZE + max_states * AC_STATE_SIZE) * sizeof(uint32_t));
+    uint32_t *fail = malloc(max_states * sizeof(uint32_t));
+    uint32_t *queue = malloc(max_states * sizeof(uint32_t));
+    if (IS_NULL_PTR(compiled) || IS_NULL_PTR(fail) || IS_NULL_PTR(queue)) {
+        free(compiled);
+        free(fail);
+        free(queue);
+        return NULL;
+    }
+
+    uint32_t *states = compiled + AC_HEADER_SIZE;
+    memset(states, 0xFF, max_states * AC_STATE_SIZE * sizeof(uint32_t));
+    states[256] = 0;
+    uint32_t states_count = 1;
+
+    // build the trie
+    for (int i = 0; i < needles_count; i++) {
+        uint32_t state = 0;
+        for (size_t j = 0; j < needles[i].len; j++) {
+            uint32_t *transition = &states[state * AC_STATE_SIZE + needles[i].data[j]];
+            if (*transition == AC_NO_STATE) {
+                *transition = states_count;
+                states[states_count * AC_STATE_SIZE + 256] = 0;
+                states_count++;
+            }
+            state = *transition;
+        }
+        states[state * AC_STATE_SIZE + 256] = needles[i].len;
+    }
+
+    // turn the trie into a DFA, following failure links in breadth-first order
+    size_t queue_head = 0;
+    size_t queue_tail = 0;
+    for (int c = 0; c < 256; c++) {
+        uint32_t next = states[c];
+        if (next == AC_NO_STATE) {
+            states[c] = 0;
+        } else {
+            fail[next] = 0;
+            queue[queue_tail++] = next;
+        }
+    }
+
+    while (queue_head != queue_tail) {
+        uint32_t state = queue[queue_head++];
+        uint32_t *transitions = &states[state * AC_STATE_SIZE];
+        const uint32_t *fail_transitions = &states[fail[state] * AC_STATE_SIZE];
+
+        if (transitions[256] == 0) {
+            transitions[256] = fail_transitions[256];
+        }
+
+        for (int c = 0; c < 256; c++) {
+            uint32_t next = transitions[c];
+            if (next == AC_NO_STATE) {
+                transitions[c] = fail_transitions[c];
+            } else {
+                fail[next] = fail_transitions[c];
+                queue[queue_tail++] = next;
+            }
+        }
+    }
+
+    free(fail);
+    free(queue);
+
+    compiled[0] = BYTEPATTERN_AC;
+    compiled[1] = states_count;
+    compiled[2] = max_len;
+
+    *compiled_size = (AC_HEADER_SIZE + states_count * AC_STATE_SIZE) * sizeof(uint32_t);
+    return compiled;
+}
+
+void *bytepattern_compile(const struct BytePatternNeedle needles[], int needles_count, size_t *compiled_size)
+{
+    if (needles_count == 1) {
+        if (needles[0].len == 1) {
+            return bytepattern_compile_single_byte(needles[0].data[0], compiled_size);
+        } else {
+            return bytepattern_compile_bmh(&needles[0], compiled_size);
+        }
+    } else {
+        return bytepattern_compile_ac(needles, needles_count, compiled_size);
+    }
+}
+
+static int bytepattern_find_bmh(const uint32_t *compiled, const uint8_t *data, size_t len, size_t *match_pos)
+{
+    size_t needle_len = compiled[1];
+    const uint32_t *skip = compiled + BMH_HEADER_SIZE;
+    const uint8_t *needle = (const uint8_t *) (skip + 256);
+    uint8_t needle_last = needle[needle_len - 1];
+
+    if (needle_len > len) {
+        return 0;
+    }
+
+    size_t i = 0;
+    while (i <= len - needle_len) {
+        uint8_t last = data[i + needle_len - 1];
+        if ((last == needle_last) && (memcmp(data + i, needle, needle_len - 1) == 0)) {
+            *match_pos = i;
+            return 1;
+        }
+        i += skip[last];
+    }
+
+    return 0;
+}
+
+static int bytepattern_find_ac(const uint32_t *compiled, const uint8_t *data, size_t len, size_t *match_pos, size_t *match_len)
+{
+    const uint32_t *states = compiled + AC_HEADER_SIZE;
+    size_t max_len = compiled[2];
+
+    uint32_t state = 0;
+    size_t best_pos = 0;
+    size_t best_len = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        state = states[state * AC_STATE_SIZE + data[i]];
+
+        // longest needle ending here, that is the leftmost match ending here
+        size_t found_len = states[state * AC_STATE_SIZE + 256];
+        if (found_len && (found_len <= i + 1)) {
+            size_t found_pos = i + 1 - found_len;
+            if (!best_len || (found_pos < best_pos) || ((found_pos == best_pos) && (found_len > best_len))) {
+                best_pos = found_pos;
+                best_len = found_len;
+            }
+        }
+
+        // any further match would start after best_pos
+        if (best_len && (i + 1 >= best_pos + max_len)) {
+            break;
+        }
+    }
+
+    if (best_len) {
+        *match_pos = best_pos;
+        *match_len = best_len;
+        return 1;
+    }
+
+    return 0;
+}
+
+int bytepattern_find(const void *compiled, const uint8_t *data, size_t len, size_t *match_pos, size_t *match_len)
+{
+    const uint32_t *compiled_words = (const uint32_t *) compiled;
+
+    switch (compiled_words[0]) {
+        case BYTEPATTERN_SINGLE_BYTE: {
+            const uint8_t *found = memchr(data, compiled_words[1], len);
+            if (found) {
+                *match_pos = found - data;
+                *match_len = 1;
+                return 1;
+            }
+            return 0;
+        }
+
+        case BYTEPATTERN_BMH:
+            *match_len = compiled_words[1];
+            return bytepattern_find_bmh(compiled_words, data, len, match_pos);
+
+        case BYTEPATTERN_AC:
+            return bytepattern_find_ac(compiled_words, data, len, match_pos, match_len);
+
+        default:
+            abort();
+    }
+}
+
+struct CompiledBytePattern *bytepattern_store(Context *ctx, uint64_t ref_ticks, void *compiled)
+{
+    struct CompiledBytePattern *pattern = malloc(sizeof(struct CompiledBytePattern));
+    if (IS_NULL_PTR(pattern)) {
+        return NULL;
+    }
+    pattern->ref_ticks = ref_ticks;
+    pattern->compiled = compiled;
+    list_append(&ctx->compiled_patterns, &pattern->pattern_list_head);
+
+    return pattern;
+}
+
+const void *bytepattern_lookup(Context *ctx, uint64_t ref_ticks)
+{
+    struct ListHead *item;
+    LIST_FOR_EACH(item, &ctx->compiled_patterns) {
+        struct CompiledBytePattern *pattern = GET_LIST_ENTRY(item, struct CompiledBytePattern, pattern_list_head);
+        if (pattern->ref_ticks == ref_ticks) {
+            return pattern->compiled;
+        }
+    }
+
+    return NULL;
+}
+
+void bytepattern_destroy_all(Context *ctx)
+{
+    struct ListHead *item;
+    struct ListHead *tmp;
+    MUTABLE_LIST_FOR_EACH(item, tmp, &ctx->compiled_patterns) {
+        struct CompiledBytePattern *pattern = GET_LIST_ENTRY(item, struct CompiledBytePattern, pattern_list_head);
+        free(pattern->compiled);
+        free(pattern);
+    }
+    list_init(&ctx->compiled_patterns);
+}
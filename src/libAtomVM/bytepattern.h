@@ -0,0 +1,105 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file bytepattern.h
+ * @brief Byte patterns search functions.
+ *
+ * @details Byte patterns are compiled once and then used to search any number of binaries. A single
+ *          byte pattern uses memchr, a single longer pattern uses Boyer-Moore-Horspool, while multiple
+ *          patterns are compiled to an Aho-Corasick automaton.
+ *          Patterns compiled with binary:compile_pattern/1 are owned by the process that compiled them
+ *          and they are identified by a reference, so user code cannot forge or alter their tables.
+ *          They are freed when their owner is destroyed.
+ */
+
+#ifndef _BYTEPATTERN_H_
+#define _BYTEPATTERN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "context.h"
+#include "linkedlist.h"
+
+struct BytePatternNeedle
+{
+    const uint8_t *data;
+    size_t len;
+};
+
+struct CompiledBytePattern
+{
+    struct ListHead pattern_list_head;
+    uint64_t ref_ticks;
+    void *compiled;
+};
+
+/**
+ * @brief Compiles a byte pattern
+ *
+ * @details Compiles one or more needles to a newly allocated buffer, the caller must free it.
+ * @param needles needles that will be searched, they must not be empty.
+ * @param needles_count needles count, it must be greater than 0.
+ * @param compiled_size set to compiled pattern size in bytes.
+ * @returns the compiled pattern or NULL if memory could not be allocated.
+ */
+void *bytepattern_compile(const struct BytePatternNeedle needles[], int needles_count, size_t *compiled_size);
+
+/**
+ * @brief Searches a compiled byte pattern
+ *
+ * @details Finds the leftmost match of any needle in data, when more needles match at the same position the
+ *          longest one is returned.
+ * @param compiled a compiled pattern, it must be 4 bytes aligned.
+ * @param data the buffer that will be searched.
+ * @param len data length in bytes.
+ * @param match_pos set to match position when a match is found.
+ * @param match_len set to match length when a match is found.
+ * @returns 1 if a match has been found, otherwise 0.
+ */
+int bytepattern_find(const void *compiled, const uint8_t *data, size_t len, size_t *match_pos, size_t *match_len);
+
+/**
+ * @brief Stores a compiled pattern in the list of a process
+ *
+ * @param ctx the owner process.
+ * @param ref_ticks the reference that identifies the pattern.
+ * @param compiled a pattern returned by bytepattern_compile, it is freed together with the process.
+ * @returns the stored pattern or NULL on allocation failure, in that case compiled is not taken.
+ */
+struct CompiledBytePattern *bytepattern_store(Context *ctx, uint64_t ref_ticks, void *compiled);
+
+/**
+ * @brief Finds a pattern compiled by a process
+ *
+ * @param ctx the owner process.
+ * @param ref_ticks the reference returned by binary:compile_pattern/1.
+ * @returns the compiled pattern or NULL if the process does not own such pattern.
+ */
+const void *bytepattern_lookup(Context *ctx, uint64_t ref_ticks);
+
+/**
+ * @brief Frees all the patterns compiled by a process.
+ *
+ * @param ctx the process that is going to be destroyed.
+ */
+void bytepattern_destroy_all(Context *ctx);
+
+#endif
@@ -83,9 +83,7 @@ static inline term_ref ccontext_make_term_ref(struct CContext *ccontext, term t)
 {
     Context *ctx = ccontext->ctx;
 
-    if (ctx->heap_ptr > ctx->e - 1) {
-        memory_ensure_free(ctx, 1);
-    }
+    context_ensure_free_stack_and_heap(ctx, 1, 0);
 
     ctx->e--;
     ccontext->terms_count++;
@@ -0,0 +1,58 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file checksum.h
+ * @brief CRC32 and Adler-32 checksums.
+ *
+ * @details Both functions can be called incrementally: the value returned for a chunk is given as
+ *          initial value for the next one. zlib implementation is used when available.
+ */
+
+#ifndef _CHECKSUM_H_
+#define _CHECKSUM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHECKSUM_CRC32_INIT 0
+#define CHECKSUM_ADLER32_INIT 1
+
+/**
+ * @brief Updates a CRC32 checksum
+ *
+ * @details Computes the same CRC32 (ISO 3309) used by zlib and erlang:crc32/1,2.
+ * @param crc the checksum of previous data or CHECKSUM_CRC32_INIT.
+ * @param data the data that will be added to the checksum.
+ * @param len data length in bytes.
+ * @returns the updated checksum.
+ */
+uint32_t checksum_crc32(uint32_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief Updates an Adler-32 checksum
+ *
+ * @param adler the checksum of previous data or CHECKSUM_ADLER32_INIT.
+ * @param data the data that will be added to the checksum.
+ * @param len data length in bytes.
+ * @returns the updated checksum.
+ */
+uint32_t checksum_adler32(uint32_t adler, const uint8_t *data, size_t len);
+
+#endif
@@ -19,14 +19,32 @@
 
 #include "context.h"
 
+#include "bytepattern.h"
 #include "globalcontext.h"
 #include "list.h"
+#include "mailbox.h"
+#include "memory.h"
+#include "valueshashtable.h"
+
+#ifdef WITH_ZLIB
+#include "zlibstream.h"
+#endif
 
 #define IMPL_EXECUTE_LOOP
 #include "opcodesswitch.h"
 #undef IMPL_EXECUTE_LOOP
 
 #define DEFAULT_STACK_SIZE 8
+#define DEFAULT_CATCH_FRAMES 4
+
+static const char *const down_atom = "\x4" "DOWN";
+static const char *const process_atom = "\x7" "process";
+
+struct ExitSignal
+{
+    Context *ctx;
+    struct ListHead *exiting;
+};
 
 Context *context_new(GlobalContext *glb)
 {
@@ -37,15 +55,35 @@ Context *context_new(GlobalContext *glb)
     }
     ctx->cp = 0;
 
-    ctx->heap_start = (term *) calloc(DEFAULT_STACK_SIZE, sizeof(term));
+    ctx->catch_frames = NULL;
+    ctx->catch_frames_count = 0;
+    ctx->catch_frames_size = 0;
+
+    ctx->heap_start = (term *) memory_terms_calloc(DEFAULT_STACK_SIZE, sizeof(term));
     if (IS_NULL_PTR(ctx->heap_start)) {
         fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
         free(ctx);
         return NULL;
     }
+    glb->used_memory += DEFAULT_STACK_SIZE * sizeof(term);
+#ifdef AVM_SEPARATE_STACK
+    ctx->heap_end = ctx->heap_start + DEFAULT_STACK_SIZE;
+    ctx->stack_start = calloc(DEFAULT_STACK_SIZE, sizeof(term));
+    if (IS_NULL_PTR(ctx->stack_start)) {
+        fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+        glb->used_memory -= DEFAULT_STACK_SIZE * sizeof(term);
+        memory_terms_free(ctx->heap_start);
+        free(ctx);
+        return NULL;
+    }
+    glb->used_memory += DEFAULT_STACK_SIZE * sizeof(term);
+    ctx->stack_base = ctx->stack_start + DEFAULT_STACK_SIZE;
+#else
     ctx->stack_base = ctx->heap_start + DEFAULT_STACK_SIZE;
+#endif
     ctx->e = ctx->stack_base;
     ctx->heap_ptr = ctx->heap_start;
+    ctx->deferred_gc = NULL;
 
     ctx->avail_registers = 16;
     context_clean_registers(ctx, 0);
@@ -53,22 +91,51 @@ Context *context_new(GlobalContext *glb)
     list_append(&glb->ready_processes, &ctx->processes_list_head);
 
     ctx->mailbox = NULL;
+    ctx->message_queue_len = 0;
+    ctx->message_queue_size = 0;
+    ctx->message_queue_max_len = 0;
+    ctx->message_queue_max_size = 0;
+    ctx->message_queue_policy = MessageQueueDropNewest;
+    ctx->blocked_senders = NULL;
+    ctx->blocked_on = 0;
+
+    ctx->max_heap_size = 0;
+    ctx->max_heap_size_kill = 1;
+    ctx->max_heap_size_log = 1;
+    ctx->kill_pending = 0;
+
+    dictionary_init(&ctx->dictionary);
+    list_init(&ctx->zlib_streams);
+    list_init(&ctx->compiled_patterns);
 
     ctx->global = glb;
 
     ctx->process_id = globalcontext_get_new_process_id(glb);
     linkedlist_append(&glb->processes_table, &ctx->processes_table_head);
+    if (UNLIKELY(!valueshashtable_insert(glb->processes_ids_table, ctx->process_id, (unsigned long) ctx))) {
+        fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+        abort();
+    }
 
     ctx->native_handler = NULL;
+    ctx->destroy_handler = NULL;
 
     ctx->saved_ip = NULL;
     ctx->jump_to_on_restore = NULL;
 
+    ctx->links = NULL;
+    ctx->monitors = NULL;
+    ctx->monitored_by = NULL;
+
     ctx->leader = 0;
+    ctx->trap_exit = 0;
+    ctx->exiting = 0;
 
     ctx->timeout_at.tv_sec = 0;
     ctx->timeout_at.tv_nsec = 0;
 
+    ctx->exit_reason = term_nil();
+
     #ifdef ENABLE_ADVANCED_TRACE
         ctx->trace_calls = 0;
         ctx->trace_call_args = 0;
@@ -85,7 +152,238 @@ Context *context_new(GlobalContext *glb)
 void context_destroy(Context *ctx)
 {
     linkedlist_remove(&ctx->global->processes_table, &ctx->processes_table_head);
+    valueshashtable_remove(ctx->global->processes_ids_table, ctx->process_id);
+    globalcontext_unregister_process_id(ctx->global, ctx->process_id);
+
+    if (ctx->destroy_handler) {
+        ctx->destroy_handler(ctx);
+    }
 
-    free(ctx->heap_start);
+    mailbox_destroy(ctx);
+    dictionary_destroy(&ctx->dictionary);
+    if (ctx->links) {
+        valueshashtable_destroy(ctx->links);
+    }
+    if (ctx->monitors) {
+        valueshashtable_destroy(ctx->monitors);
+    }
+    if (ctx->monitored_by) {
+        valueshashtable_destroy(ctx->monitored_by);
+    }
+#ifdef WITH_ZLIB
+    zlibstream_destroy_all(ctx);
+#endif
+    bytepattern_destroy_all(ctx);
+    free(ctx->catch_frames);
+    memory_deferred_gc_discard(ctx);
+    ctx->global->used_memory -= (context_memory_size(ctx) + context_stack_memory_size(ctx)) * sizeof(term);
+    memory_terms_free(ctx->heap_start);
+#ifdef AVM_SEPARATE_STACK
+    free(ctx->stack_start);
+#endif
     free(ctx);
 }
+
+static struct ValuesHashTable *get_or_create_table(struct ValuesHashTable **table)
+{
+    if (!*table) {
+        *table = valueshashtable_new();
+    }
+
+    return *table;
+}
+
+int context_link(Context *ctx, Context *other)
+{
+    if (UNLIKELY(!get_or_create_table(&ctx->links) || !get_or_create_table(&other->links))) {
+        return 0;
+    }
+
+    if (UNLIKELY(!valueshashtable_insert(ctx->links, other->process_id, 1))) {
+        return 0;
+    }
+    if (UNLIKELY(!valueshashtable_insert(other->links, ctx->process_id, 1))) {
+        valueshashtable_remove(ctx->links, other->process_id);
+        return 0;
+    }
+
+    return 1;
+}
+
+void context_unlink(Context *ctx, int32_t local_process_id)
+{
+    if (!ctx->links || !valueshashtable_remove(ctx->links, local_process_id)) {
+        return;
+    }
+
+    Context *other = globalcontext_get_process(ctx->global, local_process_id);
+    if (other && other->links) {
+        valueshashtable_remove(other->links, ctx->process_id);
+    }
+}
+
+int context_monitor(Context *ctx, Context *target, uint64_t ref_ticks)
+{
+    if (UNLIKELY(!get_or_create_table(&ctx->monitors) || !get_or_create_table(&target->monitored_by))) {
+        return 0;
+    }
+
+    if (UNLIKELY(!valueshashtable_insert(ctx->monitors, ref_ticks, target->process_id))) {
+        return 0;
+    }
+    if (UNLIKELY(!valueshashtable_insert(target->monitored_by, ref_ticks, ctx->process_id))) {
+        valueshashtable_remove(ctx->monitors, ref_ticks);
+        return 0;
+    }
+
+    return 1;
+}
+
+int context_demonitor(Context *ctx, uint64_t ref_ticks)
+{
+    if (!ctx->monitors || !valueshashtable_has_key(ctx->monitors, ref_ticks)) {
+        return 0;
+    }
+
+    int32_t target_process_id = valueshashtable_get_value(ctx->monitors, ref_ticks, 0);
+    valueshashtable_remove(ctx->monitors, ref_ticks);
+
+    Context *target = globalcontext_get_process(ctx->global, target_process_id);
+    if (target && target->monitored_by) {
+        valueshashtable_remove(target->monitored_by, ref_ticks);
+    }
+
+    return 1;
+}
+
+static void context_kill(Context *ctx, term reason, struct ListHead *exiting)
+{
+    ctx->exiting = 1;
+
+    // reason belongs to the heap of the process that sent the signal
+    memory_ensure_free(ctx, memory_estimate_usage(reason));
+    ctx->exit_reason = memory_copy_term_tree(&ctx->heap_ptr, reason);
+
+    list_remove(&ctx->processes_list_head);
+    list_append(exiting, &ctx->processes_list_head);
+}
+
+static void send_link_exit_signal(unsigned long key, unsigned long value, void *data)
+{
+    UNUSED(value);
+
+    struct ExitSignal *signal = (struct ExitSignal *) data;
+    Context *ctx = signal->ctx;
+
+    // processes that are exiting too cannot be found, so they will not be signaled back
+    Context *linked = globalcontext_get_process(ctx->global, key);
+    if (!linked) {
+        return;
+    }
+    valueshashtable_remove(linked->links, ctx->process_id);
+
+    if (linked->trap_exit) {
+        term exit_message = term_alloc_tuple(3, ctx);
+        term_put_tuple_element(exit_message, 0, context_make_atom(ctx, exit_upper_atom));
+        term_put_tuple_element(exit_message, 1, term_from_local_process_id(ctx->process_id));
+        term_put_tuple_element(exit_message, 2, ctx->exit_reason);
+        mailbox_send(linked, exit_message);
+
+    } else if (ctx->exit_reason != context_make_atom(ctx, normal_atom)) {
+        context_kill(linked, ctx->exit_reason, signal->exiting);
+    }
+}
+
+static void send_down_message(unsigned long key, unsigned long value, void *data)
+{
+    struct ExitSignal *signal = (struct ExitSignal *) data;
+    Context *ctx = signal->ctx;
+
+    Context *monitoring = globalcontext_get_process(ctx->global, value);
+    if (!monitoring) {
+        return;
+    }
+    valueshashtable_remove(monitoring->monitors, key);
+
+    term down_message = term_alloc_tuple(5, ctx);
+    term_put_tuple_element(down_message, 0, context_make_atom(ctx, down_atom));
+    term_put_tuple_element(down_message, 1, term_from_ref_ticks(key, ctx));
+    term_put_tuple_element(down_message, 2, context_make_atom(ctx, process_atom));
+    term_put_tuple_element(down_message, 3, term_from_local_process_id(ctx->process_id));
+    term_put_tuple_element(down_message, 4, ctx->exit_reason);
+    mailbox_send(monitoring, down_message);
+}
+
+static void remove_monitor(unsigned long key, unsigned long value, void *data)
+{
+    struct ExitSignal *signal = (struct ExitSignal *) data;
+
+    Context *monitored = globalcontext_get_process(signal->ctx->global, value);
+    if (monitored) {
+        valueshashtable_remove(monitored->monitored_by, key);
+    }
+}
+
+void context_propagate_exit(Context *ctx, struct ListHead *exiting)
+{
+    struct ValuesHashTable *links = ctx->links;
+    struct ValuesHashTable *monitors = ctx->monitors;
+    struct ValuesHashTable *monitored_by = ctx->monitored_by;
+    ctx->links = NULL;
+    ctx->monitors = NULL;
+    ctx->monitored_by = NULL;
+
+    // messages are built on the heap of the exiting process, so memory is reserved once for all of them
+    // x[0] is left untouched since it holds the return value of the leader
+    unsigned long needed = 0;
+    if (links) {
+        needed += links->count * 4;
+    }
+    if (monitored_by) {
+        needed += monitored_by->count * (6 + TERM_BOXED_REF_SIZE);
+    }
+    if (needed) {
+        ctx->x[1] = ctx->exit_reason;
+        memory_ensure_free(ctx, needed);
+        ctx->exit_reason = ctx->x[1];
+    }
+
+    struct ExitSignal signal;
+    signal.ctx = ctx;
+    signal.exiting = exiting;
+
+    if (links) {
+        valueshashtable_foreach(links, send_link_exit_signal, &signal);
+        valueshashtable_destroy(links);
+    }
+    if (monitored_by) {
+        valueshashtable_foreach(monitored_by, send_down_message, &signal);
+        valueshashtable_destroy(monitored_by);
+    }
+    if (monitors) {
+        valueshashtable_foreach(monitors, remove_monitor, &signal);
+        valueshashtable_destroy(monitors);
+    }
+}
+
+int context_push_catch_frame(Context *ctx, term *catch_slot)
+{
+    if (ctx->catch_frames_count == ctx->catch_frames_size) {
+        int new_size = ctx->catch_frames_size ? ctx->catch_frames_size * 2 : DEFAULT_CATCH_FRAMES;
+        struct CatchFrame *new_frames = realloc(ctx->catch_frames, new_size * sizeof(struct CatchFrame));
+        if (IS_NULL_PTR(new_frames)) {
+            fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+            return 0;
+        }
+        ctx->catch_frames = new_frames;
+        ctx->catch_frames_size = new_size;
+    }
+
+    struct CatchFrame *frame = &ctx->catch_frames[ctx->catch_frames_count];
+    frame->slot_offset = ctx->stack_base - catch_slot;
+    frame->frame_offset = ctx->stack_base - ctx->e;
+    frame->raised = 0;
+    ctx->catch_frames_count++;
+
+    return 1;
+}
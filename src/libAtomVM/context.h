@@ -29,11 +29,14 @@
 
 #include <time.h>
 
+#include "dictionary.h"
 #include "linkedlist.h"
 #include "globalcontext.h"
 #include "term.h"
 
 struct Module;
+struct ValuesHashTable;
+struct DeferredGC;
 
 #ifndef TYPEDEF_MODULE
 #define TYPEDEF_MODULE
@@ -42,6 +45,29 @@ typedef struct Module Module;
 
 typedef void (*native_handler)(Context *ctx);
 
+/**
+ * @brief What happens when a message is sent to a mailbox that is over its limits.
+ */
+enum MessageQueuePolicy
+{
+    MessageQueueDropNewest,
+    MessageQueueDropOldest,
+    MessageQueueBlock
+};
+
+/**
+ * @brief An active catch, pushed by try/2 and catch/2 and popped by try_end/1, try_case/1 and catch_end/1.
+ *
+ * @details Offsets are counted in terms from stack_base, since they must survive garbage collection which
+ *          moves the whole stack.
+ */
+struct CatchFrame
+{
+    unsigned int slot_offset;
+    unsigned int frame_offset;
+    unsigned int raised : 1;
+};
+
 struct Context
 {
     struct ListHead processes_list_head;
@@ -57,8 +83,18 @@ struct Context
     term *heap_ptr;
     term *e;
 
+#ifdef AVM_SEPARATE_STACK
+    // the heap ends at heap_end, the stack has its own memory block that starts at stack_start
+    term *heap_end;
+    term *stack_start;
+#endif
+
     unsigned long cp;
 
+    struct CatchFrame *catch_frames;
+    int catch_frames_count;
+    int catch_frames_size;
+
     //needed for wait and wait_timeout
     Module *saved_module;
     const void *saved_ip;
@@ -66,16 +102,69 @@ struct Context
 
     struct ListHead *mailbox;
 
+    // number and size in bytes of queued messages
+    unsigned long message_queue_len;
+    unsigned long message_queue_size;
+
+    // limits set with process_flag(message_queue_limit, ...), 0 means unlimited
+    unsigned long message_queue_max_len;
+    unsigned long message_queue_max_size;
+    enum MessageQueuePolicy message_queue_policy;
+
+    // processes suspended until this mailbox is back within its limits (pid -> 1)
+    struct ValuesHashTable *blocked_senders;
+    // id of the process whose full mailbox suspended this one, 0 when not blocked
+    int32_t blocked_on;
+
+    // heap size limit in terms set with process_flag(max_heap_size, ...), 0 means unlimited
+    unsigned long max_heap_size;
+
+    // collection in progress, the process is suspended until it completes, see memory_ensure_free_deferred
+    struct DeferredGC *deferred_gc;
+
+    struct Dictionary dictionary;
+
+    // zlib streams opened by this process, see zlibstream.h
+    struct ListHead zlib_streams;
+
+    // patterns compiled by this process with binary:compile_pattern/1, see bytepattern.h
+    struct ListHead compiled_patterns;
+
     GlobalContext *global;
 
     //Ports support
     native_handler native_handler;
+    // releases platform_data (and any pending event listener) when the port is destroyed
+    native_handler destroy_handler;
 
     uint64_t reductions;
     struct timespec timeout_at;
 
+    // set when the process terminates: normal, the reason of an uncaught exception or the
+    // reason received from a linked process
+    term exit_reason;
+
+    // links (pid -> 1), monitors set by this process (ref -> monitored pid) and monitors
+    // set on this process (ref -> monitoring pid), allocated on first use
+    struct ValuesHashTable *links;
+    struct ValuesHashTable *monitors;
+    struct ValuesHashTable *monitored_by;
+
     unsigned int leader : 1;
 
+    // exit signals from linked processes are received as {'EXIT', Pid, Reason} messages
+    unsigned int trap_exit : 1;
+
+    // set once the process is terminating, it cannot be looked up or receive messages anymore
+    unsigned int exiting : 1;
+
+    // what to do when max_heap_size is exceeded
+    unsigned int max_heap_size_kill : 1;
+    unsigned int max_heap_size_log : 1;
+
+    // set when the process exceeded a memory limit, it is killed as soon as it yields
+    unsigned int kill_pending : 1;
+
     #ifdef ENABLE_ADVANCED_TRACE
         unsigned int trace_calls : 1;
         unsigned int trace_call_args : 1;
@@ -104,11 +193,65 @@ Context *context_new(GlobalContext *glb);
 /**
  * @brief Destorys a context
  *
- * @details Frees context resources and memory and removes it from the processes table.
+ * @details Frees context resources and memory and removes it from the processes table: pending messages
+ *          are discarded, registered names are released, links and monitors are freed and ports release their
+ *          platform data.
  * @param c the context that will be destroyed.
  */
 void context_destroy(Context *c);
 
+/**
+ * @brief Links two processes
+ *
+ * @details Links are bidirectional: when any of the two processes terminates, the other one receives an exit signal.
+ * @param ctx a valid context.
+ * @param other the context that will be linked to ctx.
+ * @returns 1 on success, 0 if memory could not be allocated.
+ */
+int context_link(Context *ctx, Context *other);
+
+/**
+ * @brief Removes a link
+ *
+ * @details Removes the link between ctx and the process with the given id, if any.
+ * @param ctx a valid context.
+ * @param local_process_id the id of the linked process.
+ */
+void context_unlink(Context *ctx, int32_t local_process_id);
+
+/**
+ * @brief Monitors a process
+ *
+ * @details ctx will receive a {'DOWN', Ref, process, Pid, Reason} message when target terminates.
+ * @param ctx the monitoring context.
+ * @param target the monitored context.
+ * @param ref_ticks the ticks of the monitor reference.
+ * @returns 1 on success, 0 if memory could not be allocated.
+ */
+int context_monitor(Context *ctx, Context *target, uint64_t ref_ticks);
+
+/**
+ * @brief Removes a monitor
+ *
+ * @details Removes a monitor that has been previously set by ctx.
+ * @param ctx the monitoring context.
+ * @param ref_ticks the ticks of the monitor reference.
+ * @returns 1 if the monitor was active, 0 otherwise.
+ */
+int context_demonitor(Context *ctx, uint64_t ref_ticks);
+
+/**
+ * @brief Sends exit signals to linked and monitoring processes
+ *
+ * @details Called for a terminating context: monitoring processes receive a 'DOWN' message, linked processes
+ *          receive an 'EXIT' message when trapping exits, otherwise they are marked as exiting with the same
+ *          reason (unless it is normal) and they are appended to the exiting list. Links and monitors of ctx
+ *          are released.
+ * @param ctx the terminating context, its exit_reason must be set.
+ * @param exiting the list of terminating contexts, linked with their processes_list_head.
+ */
+void context_propagate_exit(Context *ctx, struct ListHead *exiting);
+
 /**
  * @brief Starts executing a function
  *
@@ -149,25 +292,114 @@ static inline void context_clean_registers(Context *ctx, int live)
 /**
  * @brief Returns available free memory in term units
  *
- * @details Returns the number of terms that can fit either on the stack or on the heap.
+ * @details Returns the number of terms that can fit either on the stack or on the heap, or only on the heap when the
+ *          stack has its own memory block.
  * @param ctx a valid context.
  * @returns available free memory that is avail_size_in_bytes / sizeof(term).
  */
 static inline unsigned long context_avail_free_memory(const Context *ctx)
 {
+#ifdef AVM_SEPARATE_STACK
+    return ctx->heap_end - ctx->heap_ptr;
+#else
     return ctx->e - ctx->heap_ptr;
+#endif
 }
 
 /**
  * @brief Returns context total memory in term units
  *
- * @details Returns the total memory reserved for stack and heap in term units.
+ * @details Returns the total memory reserved for stack and heap in term units, that is the size of the memory block
+ *          that garbage collection replaces: it does not include the stack when it has its own memory block.
  * @param ctx a valid context.
  * @returns total memory that is total_size_in_bytes / sizeof(term).
  */
 static inline unsigned long context_memory_size(const Context *ctx)
 {
+#ifdef AVM_SEPARATE_STACK
+    return ctx->heap_end - ctx->heap_start;
+#else
     return ctx->stack_base - ctx->heap_start;
+#endif
+}
+
+/**
+ * @brief Returns the size of the stack memory block in term units
+ *
+ * @details The stack has its own memory block only when AVM_SEPARATE_STACK is defined, otherwise it is part of the
+ *          heap memory block and 0 is returned.
+ * @param ctx a valid context.
+ * @returns stack memory block size.
+ */
+static inline unsigned long context_stack_memory_size(const Context *ctx)
+{
+#ifdef AVM_SEPARATE_STACK
+    return ctx->stack_base - ctx->stack_start;
+#else
+    UNUSED(ctx);
+    return 0;
+#endif
+}
+
+/**
+ * @brief Makes sure that a new stack frame and heap terms can be allocated
+ *
+ * @details A stack that has its own memory block is grown without collecting the heap, any existing term might be
+ *          invalid after this call.
+ * @param ctx a valid context.
+ * @param stack_need terms that are going to be pushed on the stack.
+ * @param heap_need terms that are going to be allocated on the heap.
+ */
+static inline void context_ensure_free_stack_and_heap(Context *ctx, uint32_t stack_need, uint32_t heap_need)
+{
+#ifdef AVM_SEPARATE_STACK
+    if (UNLIKELY((unsigned long) (ctx->e - ctx->stack_start) < stack_need)) {
+        memory_grow_stack(ctx, stack_need);
+    }
+    if (heap_need && (context_avail_free_memory(ctx) < heap_need)) {
+        memory_ensure_free(ctx, heap_need);
+    }
+#else
+    if ((ctx->heap_ptr + heap_need) > ctx->e - stack_need) {
+        memory_ensure_free(ctx, heap_need + stack_need);
+    }
+#endif
+}
+
+/**
+ * @brief Pushes a new catch frame
+ *
+ * @details Records the y register holding a catch label so exceptions can find it without scanning the stack.
+ * @param ctx a valid context.
+ * @param catch_slot the y register where the catch label has been stored, it must belong to the current frame.
+ * @returns 1 on success, 0 if memory could not be allocated.
+ */
+int context_push_catch_frame(Context *ctx, term *catch_slot);
+
+/**
+ * @brief Pops a catch frame
+ *
+ * @details Removes the catch frame stored in catch_slot, and any stale frame above it, from the catch chain.
+ * @param ctx a valid context.
+ * @param catch_slot the y register that was given to context_push_catch_frame.
+ * @returns 1 if an exception has been raised to the removed frame, otherwise 0.
+ */
+static inline int context_pop_catch_frame(Context *ctx, const term *catch_slot)
+{
+    unsigned int slot_offset = ctx->stack_base - catch_slot;
+
+    // stale frames belong to deeper stack frames, so they have a greater offset
+    while ((ctx->catch_frames_count > 0)
+        && (ctx->catch_frames[ctx->catch_frames_count - 1].slot_offset > slot_offset)) {
+        ctx->catch_frames_count--;
+    }
+    if ((ctx->catch_frames_count > 0)
+        && (ctx->catch_frames[ctx->catch_frames_count - 1].slot_offset == slot_offset)) {
+        ctx->catch_frames_count--;
+        return ctx->catch_frames[ctx->catch_frames_count].raised;
+    }
+
+    return 0;
 }
 
 /**
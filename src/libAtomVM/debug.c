@@ -25,7 +25,7 @@ COLD_FUNC void debug_dump_stack(Context *ctx)
 
     fprintf(stderr, "\n");
     for (unsigned int i = 0; i < stack_size; i++) {
-        fprintf(stderr, "DEBUG: stack: (%i) %lx\n", i, ctx->e[i]);
+        fprintf(stderr, "DEBUG: stack: (%i) %lx\n", i, (unsigned long) ctx->e[i]);
     }
     fprintf(stderr, "DEBUG: \n");
     fprintf(stderr, "DEBUG: e: %li\n", (long) (ctx->stack_base - ctx->e));
@@ -0,0 +1,162 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "dictionary.h"
+
+#include <stdlib.h>
+
+#include "termhash.h"
+#include "utils.h"
+
+#define DICTIONARY_INITIAL_CAPACITY 8
+
+void dictionary_init(struct Dictionary *dict)
+{
+    dict->entries = NULL;
+    dict->capacity = 0;
+    dict->count = 0;
+}
+
+void dictionary_destroy(struct Dictionary *dict)
+{
+    free(dict->entries);
+    dictionary_init(dict);
+}
+
+// capacity is always a power of 2
+static int dictionary_find_slot(const struct Dictionary *dict, term key, uint32_t hash)
+{
+    int mask = dict->capacity - 1;
+    int i = hash & mask;
+
+    while (dictionary_entry_is_used(&dict->entries[i])) {
+        const struct DictionaryEntry *entry = &dict->entries[i];
+        if ((entry->hash == hash) && termhash_equals(entry->key, key)) {
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+static int dictionary_grow(struct Dictionary *dict)
+{
+    int new_capacity = dict->capacity ? dict->capacity * 2 : DICTIONARY_INITIAL_CAPACITY;
+    struct DictionaryEntry *new_entries = malloc(new_capacity * sizeof(struct DictionaryEntry));
+    if (IS_NULL_PTR(new_entries)) {
+        return 0;
+    }
+    for (int i = 0; i < new_capacity; i++) {
+        new_entries[i].key = term_invalid_term();
+    }
+
+    int mask = new_capacity - 1;
+    for (int i = 0; i < dict->capacity; i++) {
+        const struct DictionaryEntry *entry = &dict->entries[i];
+        if (dictionary_entry_is_used(entry)) {
+            int j = entry->hash & mask;
+            while (dictionary_entry_is_used(&new_entries[j])) {
+                j = (j + 1) & mask;
+            }
+            new_entries[j] = *entry;
+        }
+    }
+
+    free(dict->entries);
+    dict->entries = new_entries;
+    dict->capacity = new_capacity;
+
+    return 1;
+}
+
+term dictionary_get(const struct Dictionary *dict, term key, GlobalContext *glb)
+{
+    if (dict->count == 0) {
+        return term_invalid_term();
+    }
+
+    int i = dictionary_find_slot(dict, key, termhash_phash2(key, glb));
+    if (!dictionary_entry_is_used(&dict->entries[i])) {
+        return term_invalid_term();
+    }
+
+    return dict->entries[i].value;
+}
+
+int dictionary_put(struct Dictionary *dict, term key, term value, term *old_value, GlobalContext *glb)
+{
+    // keep load factor below 3/4
+    if ((dict->count + 1) * 4 > dict->capacity * 3) {
+        if (UNLIKELY(!dictionary_grow(dict))) {
+            return 0;
+        }
+    }
+
+    uint32_t hash = termhash_phash2(key, glb);
+    int i = dictionary_find_slot(dict, key, hash);
+    struct DictionaryEntry *entry = &dict->entries[i];
+
+    if (dictionary_entry_is_used(entry)) {
+        *old_value = entry->value;
+    } else {
+        *old_value = term_invalid_term();
+        entry->key = key;
+        entry->hash = hash;
+        dict->count++;
+    }
+    entry->value = value;
+
+    return 1;
+}
+
+term dictionary_erase(struct Dictionary *dict, term key, GlobalContext *glb)
+{
+    if (dict->count == 0) {
+        return term_invalid_term();
+    }
+
+    int i = dictionary_find_slot(dict, key, termhash_phash2(key, glb));
+    if (!dictionary_entry_is_used(&dict->entries[i])) {
+        return term_invalid_term();
+    }
+    term old_value = dict->entries[i].value;
+
+    // backward shift deletion: move back following entries of the same cluster, so no tombstone is needed
+    int mask = dict->capacity - 1;
+    int j = i;
+    while (1) {
+        j = (j + 1) & mask;
+        const struct DictionaryEntry *entry = &dict->entries[j];
+        if (!dictionary_entry_is_used(entry)) {
+            break;
+        }
+        int home = entry->hash & mask;
+        // entry can be moved to i only if its home slot is not in (i, j]
+        int can_move = (i <= j) ? ((home <= i) || (home > j)) : ((home <= i) && (home > j));
+        if (can_move) {
+            dict->entries[i] = *entry;
+            i = j;
+        }
+    }
+    dict->entries[i].key = term_invalid_term();
+    dict->count--;
+
+    return old_value;
+}
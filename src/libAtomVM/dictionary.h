@@ -0,0 +1,111 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file dictionary.h
+ * @brief Process dictionary.
+ *
+ * @details Keys and values are stored in an open addressing (linear probing) table allocated outside
+ *          the process heap. Stored terms are not copied: they live on the process heap and the
+ *          table is used as GC root, so memory_gc updates them when the heap is moved.
+ */
+
+#ifndef _DICTIONARY_H_
+#define _DICTIONARY_H_
+
+#include <stdint.h>
+
+#include "globalcontext.h"
+#include "term.h"
+
+struct DictionaryEntry
+{
+    term key;
+    term value;
+    uint32_t hash;
+};
+
+struct Dictionary
+{
+    struct DictionaryEntry *entries;
+    int capacity;
+    int count;
+};
+
+/**
+ * @brief Initializes an empty dictionary
+ *
+ * @details No memory is allocated until the first key is put.
+ * @param dict the dictionary that will be initialized.
+ */
+void dictionary_init(struct Dictionary *dict);
+
+/**
+ * @brief Frees the memory used by a dictionary
+ *
+ * @details After this function the dictionary is empty and it can be used again.
+ * @param dict the dictionary that will be cleared.
+ */
+void dictionary_destroy(struct Dictionary *dict);
+
+/**
+ * @brief Gets the value associated to a key
+ *
+ * @param dict the dictionary.
+ * @param key the key that will be searched.
+ * @param glb the global context.
+ * @returns the value or term_invalid_term() when the key is not found.
+ */
+term dictionary_get(const struct Dictionary *dict, term key, GlobalContext *glb);
+
+/**
+ * @brief Associates a value to a key
+ *
+ * @param dict the dictionary.
+ * @param key the key, any existing value is replaced.
+ * @param value the value.
+ * @param old_value the replaced value or term_invalid_term() when the key was not found.
+ * @param glb the global context.
+ * @returns 1 on success, 0 if the table could not be grown.
+ */
+int dictionary_put(struct Dictionary *dict, term key, term value, term *old_value, GlobalContext *glb);
+
+/**
+ * @brief Removes a key
+ *
+ * @param dict the dictionary.
+ * @param key the key that will be removed.
+ * @param glb the global context.
+ * @returns the removed value or term_invalid_term() when the key was not found.
+ */
+term dictionary_erase(struct Dictionary *dict, term key, GlobalContext *glb);
+
+/**
+ * @brief Checks if a table slot holds an entry
+ *
+ * @details Used to iterate over all the entries, from 0 to capacity - 1.
+ * @param entry the entry that will be checked.
+ * @returns 1 if entry is used, 0 otherwise.
+ */
+static inline int dictionary_entry_is_used(const struct DictionaryEntry *entry)
+{
+    return !term_is_invalid_term(entry->key);
+}
+
+#endif
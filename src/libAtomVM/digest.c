@@ -0,0 +1,465 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "digest.h"
+
+#include <string.h>
+
+#include "utils.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define DIGEST_WITH_SHA_NI
+    #include <cpuid.h>
+    #include <immintrin.h>
+
+    #define CPUID_1_ECX_SSSE3 (1 << 9)
+    #define CPUID_1_ECX_SSE4_1 (1 << 19)
+    #define CPUID_7_EBX_SHA (1 << 29)
+#endif
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static const uint32_t md5_k[64] = {
+    0xD76AA478, 0xE8C7B756, 0x242070DB, 0xC1BDCEEE,
+    0xF57C0FAF, 0x4787C62A, 0xA8304613, 0xFD469501,
+    0x698098D8, 0x8B44F7AF, 0xFFFF5BB1, 0x895CD7BE,
+    0x6B901122, 0xFD987193, 0xA679438E, 0x49B40821,
+    0xF61E2562, 0xC040B340, 0x265E5A51, 0xE9B6C7AA,
+    0xD62F105D, 0x02441453, 0xD8A1E681, 0xE7D3FBC8,
+    0x21E1CDE6, 0xC33707D6, 0xF4D50D87, 0x455A14ED,
+    0xA9E3E905, 0xFCEFA3F8, 0x676F02D9, 0x8D2A4C8A,
+    0xFFFA3942, 0x8771F681, 0x6D9D6122, 0xFDE5380C,
+    0xA4BEEA44, 0x4BDECFA9, 0xF6BB4B60, 0xBEBFBC70,
+    0x289B7EC6, 0xEAA127FA, 0xD4EF3085, 0x04881D05,
+    0xD9D4D039, 0xE6DB99E5, 0x1FA27CF8, 0xC4AC5665,
+    0xF4292244, 0x432AFF97, 0xAB9423A7, 0xFC93A039,
+    0x655B59C3, 0x8F0CCC92, 0xFFEFF47D, 0x85845DD1,
+    0x6FA87E4F, 0xFE2CE6E0, 0xA3014314, 0x4E0811A1,
+    0xF7537E82, 0xBD3AF235, 0x2AD7D2BB, 0xEB86D391
+};
+
+static const uint32_t sha256_k[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+    0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+    0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+    0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+    0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+    0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static const uint8_t md5_shifts[16] = {
+    7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21
+};
+
+static inline uint32_t load_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline uint32_t load_be32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static inline void store_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static inline void store_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void md5_blocks(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    uint32_t m[16];
+
+    while (blocks--) {
+        for (int i = 0; i < 16; i++) {
+            m[i] = load_le32(data + i * 4);
+        }
+
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+
+        for (int i = 0; i < 64; i++) {
+            uint32_t f;
+            int g;
+            if (i < 16) {
+                f = (b & c) | (~b & d);
+                g = i;
+            } else if (i < 32) {
+                f = (d & b) | (~d & c);
+                g = (5 * i + 1) & 0xF;
+            } else if (i < 48) {
+                f = b ^ c ^ d;
+                g = (3 * i + 5) & 0xF;
+            } else {
+                f = c ^ (b | ~d);
+                g = (7 * i) & 0xF;
+            }
+            f += a + md5_k[i] + m[g];
+            a = d;
+            d = c;
+            c = b;
+            b += ROTL32(f, md5_shifts[((i >> 4) << 2) | (i & 3)]);
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+
+        data += DIGEST_BLOCK_SIZE;
+    }
+}
+
+static void sha1_blocks(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    uint32_t w[80];
+
+    while (blocks--) {
+        for (int i = 0; i < 16; i++) {
+            w[i] = load_be32(data + i * 4);
+        }
+        for (int i = 16; i < 80; i++) {
+            uint32_t t = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+            w[i] = ROTL32(t, 1);
+        }
+
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+
+        for (int i = 0; i < 80; i++) {
+            uint32_t f;
+            uint32_t k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = ROTL32(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = ROTL32(b, 30);
+            b = a;
+            a = t;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+
+        data += DIGEST_BLOCK_SIZE;
+    }
+}
+
+static void sha256_blocks_generic(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    uint32_t w[64];
+
+    while (blocks--) {
+        for (int i = 0; i < 16; i++) {
+            w[i] = load_be32(data + i * 4);
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = ROTR32(w[i - 15], 7) ^ ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = ROTR32(w[i - 2], 17) ^ ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+        uint32_t f = state[5];
+        uint32_t g = state[6];
+        uint32_t h = state[7];
+
+        for (int i = 0; i < 64; i++) {
+            uint32_t s1 = ROTR32(e, 6) ^ ROTR32(e, 11) ^ ROTR32(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + ch + sha256_k[i] + w[i];
+            uint32_t s0 = ROTR32(a, 2) ^ ROTR32(a, 13) ^ ROTR32(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = s0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+
+        data += DIGEST_BLOCK_SIZE;
+    }
+}
+
+#ifdef DIGEST_WITH_SHA_NI
+
+static int sha_ni_supported()
+{
+    // cpuid is expensive, so it is queried only once, instances on other threads may query it concurrently
+    static int supported = -1;
+
+    int cached = __atomic_load_n(&supported, __ATOMIC_RELAXED);
+    if (UNLIKELY(cached < 0)) {
+        unsigned int eax, ebx, ecx, edx;
+        cached = 0;
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)
+                && (ecx & CPUID_1_ECX_SSSE3) && (ecx & CPUID_1_ECX_SSE4_1)
+                && (__get_cpuid_max(0, NULL) >= 7)) {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            cached = (ebx & CPUID_7_EBX_SHA) != 0;
+        }
+        __atomic_store_n(&supported, cached, __ATOMIC_RELAXED);
+    }
+
+    return cached;
+}
+
+// SHA extensions keep the state as ABEF and CDGH vectors and compute 4 rounds for each message vector,
+// msgs holds the last 4 message vectors, that are used to compute the next ones.
+__attribute__((target("sha,sse4.1,ssse3")))
+static void sha256_blocks_sha_ni(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    const __m128i byte_swap_mask = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_loadu_si128((const __m128i *) &state[0]);
+    __m128i state1 = _mm_loadu_si128((const __m128i *) &state[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    while (blocks--) {
+        __m128i abef_save = state0;
+        __m128i cdgh_save = state1;
+        __m128i msgs[4];
+
+        for (int i = 0; i < 4; i++) {
+            msgs[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + i * 16)), byte_swap_mask);
+        }
+
+        for (int i = 0; i < 16; i++) {
+            __m128i current = msgs[i & 3];
+            __m128i msg = _mm_add_epi32(current, _mm_loadu_si128((const __m128i *) &sha256_k[i * 4]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            if ((i >= 3) && (i < 15)) {
+                __m128i next = _mm_add_epi32(msgs[(i + 1) & 3], _mm_alignr_epi8(current, msgs[(i - 1) & 3], 4));
+                msgs[(i + 1) & 3] = _mm_sha256msg2_epu32(next, current);
+            }
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+            if ((i >= 1) && (i < 13)) {
+                msgs[(i - 1) & 3] = _mm_sha256msg1_epu32(msgs[(i - 1) & 3], current);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+
+        data += DIGEST_BLOCK_SIZE;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *) &state[0], state0);
+    _mm_storeu_si128((__m128i *) &state[4], state1);
+}
+
+#endif
+
+static void sha256_blocks(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+#ifdef DIGEST_WITH_SHA_NI
+    if (sha_ni_supported()) {
+        sha256_blocks_sha_ni(state, data, blocks);
+        return;
+    }
+#endif
+
+    sha256_blocks_generic(state, data, blocks);
+}
+
+static void digest_blocks(struct DigestContext *ctx, const uint8_t *data, size_t blocks)
+{
+    switch (ctx->type) {
+        case DigestMD5:
+            md5_blocks(ctx->state, data, blocks);
+            break;
+
+        case DigestSHA1:
+            sha1_blocks(ctx->state, data, blocks);
+            break;
+
+        case DigestSHA256:
+            sha256_blocks(ctx->state, data, blocks);
+            break;
+    }
+}
+
+size_t digest_size(enum DigestType type)
+{
+    switch (type) {
+        case DigestMD5:
+            return 16;
+
+        case DigestSHA1:
+            return 20;
+
+        case DigestSHA256:
+            return 32;
+
+        default:
+            return 0;
+    }
+}
+
+void digest_init(struct DigestContext *ctx, enum DigestType type)
+{
+    static const uint32_t md5_sha1_init[5] = {
+        0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+    };
+    static const uint32_t sha256_init[8] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+    };
+
+    memset(ctx, 0, sizeof(struct DigestContext));
+    ctx->type = type;
+
+    if (type == DigestSHA256) {
+        memcpy(ctx->state, sha256_init, sizeof(sha256_init));
+    } else {
+        memcpy(ctx->state, md5_sha1_init, sizeof(md5_sha1_init));
+    }
+}
+
+int digest_is_valid(const struct DigestContext *ctx)
+{
+    return digest_size(ctx->type) && (ctx->buffer_len < DIGEST_BLOCK_SIZE);
+}
+
+void digest_update(struct DigestContext *ctx, const uint8_t *data, size_t len)
+{
+    ctx->length += len;
+
+    if (ctx->buffer_len) {
+        size_t fill_len = DIGEST_BLOCK_SIZE - ctx->buffer_len;
+        if (len < fill_len) {
+            memcpy(ctx->buffer + ctx->buffer_len, data, len);
+            ctx->buffer_len += len;
+            return;
+        }
+        memcpy(ctx->buffer + ctx->buffer_len, data, fill_len);
+        digest_blocks(ctx, ctx->buffer, 1);
+        ctx->buffer_len = 0;
+        data += fill_len;
+        len -= fill_len;
+    }
+
+    size_t blocks = len / DIGEST_BLOCK_SIZE;
+    if (blocks) {
+        digest_blocks(ctx, data, blocks);
+        data += blocks * DIGEST_BLOCK_SIZE;
+        len -= blocks * DIGEST_BLOCK_SIZE;
+    }
+
+    memcpy(ctx->buffer, data, len);
+    ctx->buffer_len = len;
+}
+
+void digest_final(struct DigestContext *ctx, uint8_t *out)
+{
+    uint64_t bit_length = ctx->length * 8;
+
+    ctx->buffer[ctx->buffer_len++] = 0x80;
+    if (ctx->buffer_len > DIGEST_BLOCK_SIZE - 8) {
+        memset(ctx->buffer + ctx->buffer_len, 0, DIGEST_BLOCK_SIZE - ctx->buffer_len);
+        digest_blocks(ctx, ctx->buffer, 1);
+        ctx->buffer_len = 0;
+    }
+    memset(ctx->buffer + ctx->buffer_len, 0, DIGEST_BLOCK_SIZE - 8 - ctx->buffer_len);
+
+    uint8_t *length_field = ctx->buffer + DIGEST_BLOCK_SIZE - 8;
+    if (ctx->type == DigestMD5) {
+        store_le32(length_field, bit_length);
+        store_le32(length_field + 4, bit_length >> 32);
+    } else {
+        store_be32(length_field, bit_length >> 32);
+        store_be32(length_field + 4, bit_length);
+    }
+    digest_blocks(ctx, ctx->buffer, 1);
+
+    int words = digest_size(ctx->type) / 4;
+    for (int i = 0; i < words; i++) {
+        if (ctx->type == DigestMD5) {
+            store_le32(out + i * 4, ctx->state[i]);
+        } else {
+            store_be32(out + i * 4, ctx->state[i]);
+        }
+    }
+}
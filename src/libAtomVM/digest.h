@@ -0,0 +1,96 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file digest.h
+ * @brief MD5, SHA-1 and SHA-256 message digests.
+ *
+ * @details A DigestContext is a plain struct without pointers, so it can be copied around (e.g. inside
+ *          a binary) and updated any number of times before the digest is finalized.
+ */
+
+#ifndef _DIGEST_H_
+#define _DIGEST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DIGEST_BLOCK_SIZE 64
+#define DIGEST_MAX_SIZE 32
+
+enum DigestType
+{
+    DigestMD5 = 1,
+    DigestSHA1 = 2,
+    DigestSHA256 = 3
+};
+
+struct DigestContext
+{
+    uint64_t length;
+    uint32_t state[8];
+    uint32_t type;
+    uint32_t buffer_len;
+    uint8_t buffer[DIGEST_BLOCK_SIZE];
+};
+
+/**
+ * @brief Gets digest size
+ *
+ * @param type a digest type.
+ * @returns the size in bytes of the digest.
+ */
+size_t digest_size(enum DigestType type);
+
+/**
+ * @brief Initializes a digest context
+ *
+ * @param ctx the context that will be initialized.
+ * @param type the digest type.
+ */
+void digest_init(struct DigestContext *ctx, enum DigestType type);
+
+/**
+ * @brief Checks a digest context
+ *
+ * @details Checks a context that has been copied from an untrusted source, such as a binary.
+ * @param ctx the context that will be checked.
+ * @returns 1 if ctx can be safely updated and finalized, otherwise 0.
+ */
+int digest_is_valid(const struct DigestContext *ctx);
+
+/**
+ * @brief Updates a digest context
+ *
+ * @param ctx an initialized context.
+ * @param data the data that will be hashed.
+ * @param len data length in bytes.
+ */
+void digest_update(struct DigestContext *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief Finalizes a digest
+ *
+ * @details Writes the digest to out, ctx is left in an undefined state.
+ * @param ctx an initialized context.
+ * @param out a buffer that is at least digest_size bytes long.
+ */
+void digest_final(struct DigestContext *ctx, uint8_t *out);
+
+#endif
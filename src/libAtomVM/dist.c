@@ -0,0 +1,1590 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "dist.h"
+
+#include "atomshashtable.h"
+#include "context.h"
+#include "digest.h"
+#include "dist_driver.h"
+#include "externalterm.h"
+#include "interop.h"
+#include "mailbox.h"
+#include "scheduler.h"
+#include "utils.h"
+#include "valueshashtable.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//#define ENABLE_TRACE
+
+#include "trace.h"
+
+#define DFLAG_PUBLISHED 0x1
+#define DFLAG_EXTENDED_REFERENCES 0x4
+#define DFLAG_DIST_MONITOR 0x8
+#define DFLAG_FUN_TAGS 0x10
+#define DFLAG_NEW_FUN_TAGS 0x80
+#define DFLAG_EXTENDED_PIDS_PORTS 0x100
+#define DFLAG_EXPORT_PTR_TAG 0x200
+#define DFLAG_BIT_BINARIES 0x400
+#define DFLAG_NEW_FLOATS 0x800
+#define DFLAG_DIST_HDR_ATOM_CACHE 0x2000
+#define DFLAG_SMALL_ATOM_TAGS 0x4000
+#define DFLAG_UTF8_ATOMS 0x10000
+#define DFLAG_MAP_TAG 0x20000
+#define DFLAG_BIG_CREATION 0x40000
+#define DFLAG_SEND_SENDER 0x80000
+#define DFLAG_HANDSHAKE_23 0x1000000
+#define DFLAG_UNLINK_ID 0x2000000
+#define DFLAG_V4_NC (1ULL << 34)
+
+// terms that cannot be decoded (such as funs and floats) are not a problem: messages containing them are dropped
+#define DIST_LOCAL_FLAGS (DFLAG_PUBLISHED | DFLAG_EXTENDED_REFERENCES | DFLAG_DIST_MONITOR | DFLAG_FUN_TAGS \
+    | DFLAG_NEW_FUN_TAGS | DFLAG_EXTENDED_PIDS_PORTS | DFLAG_EXPORT_PTR_TAG | DFLAG_BIT_BINARIES | DFLAG_NEW_FLOATS \
+    | DFLAG_DIST_HDR_ATOM_CACHE | DFLAG_SMALL_ATOM_TAGS | DFLAG_UTF8_ATOMS | DFLAG_MAP_TAG | DFLAG_BIG_CREATION \
+    | DFLAG_SEND_SENDER | DFLAG_HANDSHAKE_23 | DFLAG_UNLINK_ID | DFLAG_V4_NC)
+
+// the encoder always uses NEW_PID_EXT and NEWER_REFERENCE_EXT
+#define DIST_REQUIRED_FLAGS (DFLAG_EXTENDED_REFERENCES | DFLAG_EXTENDED_PIDS_PORTS | DFLAG_UTF8_ATOMS \
+    | DFLAG_BIG_CREATION | DFLAG_HANDSHAKE_23)
+
+#define DOP_LINK 1
+#define DOP_SEND 2
+#define DOP_EXIT 3
+#define DOP_REG_SEND 6
+#define DOP_SEND_TT 12
+#define DOP_REG_SEND_TT 16
+#define DOP_MONITOR_P 19
+#define DOP_MONITOR_P_EXIT 21
+#define DOP_SEND_SENDER 22
+#define DOP_SEND_SENDER_TT 23
+
+#define VERSION_MAGIC 131
+#define DIST_HEADER 68
+#define PASS_THROUGH 112
+#define SMALL_TUPLE_EXT 104
+
+#define DIST_TICK_INTERVAL_MS 15000
+// connections that did not receive anything for this many ticks are closed
+#define DIST_MAX_SILENT_TICKS 4
+#define DIST_RETRY_INTERVAL_MS 10
+#define DIST_MAX_FRAME_SIZE (64 * 1024 * 1024)
+#define DIST_CHALLENGE_DIGEST_SIZE 16
+#define DIST_MAX_CONTROL_ELEMENTS 5
+
+static const char *const nonode_at_nohost_atom = "\xD" "nonode@nohost";
+static const char *const name_atom = "\x4" "name";
+static const char *const port_atom = "\x4" "port";
+static const char *const cookie_atom = "\x6" "cookie";
+static const char *const nodes_atom = "\x5" "nodes";
+static const char *const noproc_atom = "\x6" "noproc";
+static const char *const noconnection_atom = "\xC" "noconnection";
+static const char *const service_atom = "\x7" "service";
+static const char *const empty_atom = "\x0" "";
+static const char *const localhost_string = "localhost";
+
+static void dist_consume_mailbox(Context *ctx);
+static void dist_destroy(Context *ctx);
+static void dist_timer_callback(void *data);
+static void dist_request_service(struct Dist *dist);
+static uint8_t *dist_connection_reserve(struct DistConnection *connection, size_t size);
+static void dist_flush(struct Dist *dist);
+static struct DistConnection *dist_connection_new(struct Dist *dist, term node);
+static void dist_connection_destroy(struct DistConnection *connection);
+static struct DistConnection *dist_connection_for_node(struct Dist *dist, term node);
+static int dist_connection_send(struct DistConnection *connection, const term control[], int control_len, term message);
+static void dist_connection_handle_handshake(struct DistConnection *connection, const uint8_t *buf, size_t size);
+static void dist_connection_handle_message(struct DistConnection *connection, const uint8_t *buf, size_t size);
+static void dist_proxy_consume_mailbox(Context *ctx);
+static void dist_proxy_destroy(Context *ctx);
+static void dist_terminate_proxies(struct Dist *dist, term node, uint32_t creation);
+
+static inline void write_16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = value >> 8;
+    buf[1] = value;
+}
+
+static inline void write_32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = value >> 24;
+    buf[1] = value >> 16;
+    buf[2] = value >> 8;
+    buf[3] = value;
+}
+
+static inline void write_64(uint8_t *buf, uint64_t value)
+{
+    write_32(buf, value >> 32);
+    write_32(buf + 4, value);
+}
+
+static inline uint16_t read_16(const uint8_t *buf)
+{
+    return (buf[0] << 8) | buf[1];
+}
+
+static inline uint32_t read_32(const uint8_t *buf)
+{
+    return ((uint32_t) buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3];
+}
+
+static inline uint64_t read_64(const uint8_t *buf)
+{
+    return ((uint64_t) read_32(buf) << 32) | read_32(buf + 4);
+}
+
+static uint32_t dist_random(struct Dist *dist)
+{
+    // xorshift64*, challenges only need to be unpredictable enough for a shared secret handshake
+    uint64_t x = dist->random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    dist->random_state = x;
+
+    return (x * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+static term dist_make_atom(GlobalContext *glb, const uint8_t *data, size_t len)
+{
+    if (UNLIKELY(len > 255)) {
+        return term_invalid_term();
+    }
+
+    char *atom = malloc(len + 1);
+    if (IS_NULL_PTR(atom)) {
+        fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+        return term_invalid_term();
+    }
+    atom[0] = len;
+    memcpy(atom + 1, data, len);
+
+    unsigned long atom_index = atomshashtable_get_value(glb->atoms_table, atom, ULONG_MAX);
+    if (atom_index != ULONG_MAX) {
+        free(atom);
+    } else {
+        atom_index = globalcontext_insert_atom(glb, atom);
+    }
+
+    return term_from_atom_index(atom_index);
+}
+
+// node names are name@host, and they are ordered as their text
+static int dist_compare_nodes(GlobalContext *glb, term a, term b)
+{
+    AtomString a_string = globalcontext_atomstring_from_term(glb, a);
+    AtomString b_string = globalcontext_atomstring_from_term(glb, b);
+    int a_len = atom_string_len(a_string);
+    int b_len = atom_string_len(b_string);
+
+    int result = memcmp(atom_string_data(a_string), atom_string_data(b_string), (a_len < b_len) ? a_len : b_len);
+    if (result == 0) {
+        result = a_len - b_len;
+    }
+
+    return result;
+}
+
+static int dist_parse_ipv4(const char *str, size_t len, uint32_t *address)
+{
+    uint32_t result = 0;
+    int parts = 0;
+    size_t i = 0;
+    while (parts < 4) {
+        int digits = 0;
+        uint32_t part = 0;
+        while ((i < len) && (str[i] >= '0') && (str[i] <= '9') && (digits < 3)) {
+            part = part * 10 + (str[i] - '0');
+            digits++;
+            i++;
+        }
+        if (!digits || (part > 255)) {
+            return 0;
+        }
+        result = (result << 8) | part;
+        parts++;
+
+        if (parts < 4) {
+            if ((i >= len) || (str[i] != '.')) {
+                return 0;
+            }
+            i++;
+        }
+    }
+    if (i != len) {
+        return 0;
+    }
+    *address = result;
+
+    return 1;
+}
+
+// without EPMD and DNS, hosts are either localhost or an IPv4 address
+static int dist_node_host_address(GlobalContext *glb, term node, uint32_t *address)
+{
+    AtomString node_string = globalcontext_atomstring_from_term(glb, node);
+    const char *data = atom_string_data(node_string);
+    int len = atom_string_len(node_string);
+
+    const char *at = memchr(data, '@', len);
+    if (!at || (at == data) || (at == data + len - 1)) {
+        return 0;
+    }
+    const char *host = at + 1;
+    size_t host_len = len - (host - data);
+
+    if ((host_len == strlen(localhost_string)) && !memcmp(host, localhost_string, host_len)) {
+        *address = 0x7F000001;
+        return 1;
+    }
+
+    return dist_parse_ipv4(host, host_len, address);
+}
+
+static int dist_parse_port_map(struct Dist *dist, term nodes)
+{
+    GlobalContext *glb = dist->ctx->global;
+
+    int len = 0;
+    term t = nodes;
+    while (term_is_nonempty_list(t)) {
+        len++;
+        t = term_get_list_tail(t);
+    }
+    if (!term_is_nil(t)) {
+        return 0;
+    }
+    if (!len) {
+        return 1;
+    }
+
+    dist->port_map = malloc(sizeof(struct DistNodeAddress) * len);
+    if (IS_NULL_PTR(dist->port_map)) {
+        return 0;
+    }
+
+    t = nodes;
+    while (term_is_nonempty_list(t)) {
+        term entry = term_get_list_head(t);
+        t = term_get_list_tail(t);
+        if (!term_is_tuple(entry) || (term_get_tuple_arity(entry) != 2)) {
+            return 0;
+        }
+        struct DistNodeAddress *node_address = &dist->port_map[dist->port_map_len];
+        node_address->node = term_get_tuple_element(entry, 0);
+        if (!term_is_atom(node_address->node)) {
+            return 0;
+        }
+
+        // either {Node, Port} or {Node, {{A, B, C, D}, Port}}
+        term port = term_get_tuple_element(entry, 1);
+        if (term_is_tuple(port) && (term_get_tuple_arity(port) == 2)) {
+            term address = term_get_tuple_element(port, 0);
+            port = term_get_tuple_element(port, 1);
+            if (!term_is_tuple(address) || (term_get_tuple_arity(address) != 4)) {
+                return 0;
+            }
+            uint32_t ipv4 = 0;
+            for (int i = 0; i < 4; i++) {
+                term part = term_get_tuple_element(address, i);
+                if (!term_is_integer(part) || (term_to_int64(part) < 0) || (term_to_int64(part) > 255)) {
+                    return 0;
+                }
+                ipv4 = (ipv4 << 8) | term_to_int32(part);
+            }
+            node_address->address = ipv4;
+        } else if (!dist_node_host_address(glb, node_address->node, &node_address->address)) {
+            return 0;
+        }
+        if (!term_is_integer(port) || (term_to_int64(port) <= 0) || (term_to_int64(port) > 65535)) {
+            return 0;
+        }
+        node_address->port = term_to_int32(port);
+        dist->port_map_len++;
+    }
+
+    return 1;
+}
+
+static void dist_free(struct Dist *dist)
+{
+    if (dist->proxies_table) {
+        valueshashtable_destroy(dist->proxies_table);
+    }
+    free(dist->port_map);
+    free(dist->cookie);
+    free(dist);
+}
+
+int dist_init(Context *ctx, term opts)
+{
+    GlobalContext *glb = ctx->global;
+    if (UNLIKELY(glb->dist)) {
+        return 0;
+    }
+
+    term name = interop_proplist_get_value(opts, context_make_atom(ctx, name_atom));
+    term port = interop_proplist_get_value(opts, context_make_atom(ctx, port_atom));
+    term cookie = interop_proplist_get_value(opts, context_make_atom(ctx, cookie_atom));
+    term nodes = interop_proplist_get_value(opts, context_make_atom(ctx, nodes_atom));
+    uint32_t address;
+    if (!term_is_atom(name) || !dist_node_host_address(glb, name, &address) || !term_is_atom(cookie)
+            || !term_is_integer(port) || (term_to_int64(port) < 0) || (term_to_int64(port) > 65535)) {
+        return 0;
+    }
+
+    struct Dist *dist = calloc(1, sizeof(struct Dist));
+    if (IS_NULL_PTR(dist)) {
+        return 0;
+    }
+    dist->ctx = ctx;
+    dist->node = name;
+    list_init(&dist->connections);
+    list_init(&dist->proxies);
+
+    AtomString cookie_string = globalcontext_atomstring_from_term(glb, cookie);
+    dist->cookie = malloc(atom_string_len(cookie_string) + 1);
+    dist->proxies_table = valueshashtable_new();
+    if (IS_NULL_PTR(dist->cookie) || IS_NULL_PTR(dist->proxies_table) || !dist_parse_port_map(dist, nodes)) {
+        dist_free(dist);
+        return 0;
+    }
+    atom_string_to_c(cookie_string, dist->cookie, atom_string_len(cookie_string) + 1);
+
+    struct timespec now;
+    sys_time(&now);
+    dist->random_state = ((uint64_t) now.tv_sec * 1000000007ULL) ^ (uint64_t) now.tv_nsec ^ (uintptr_t) dist;
+    if (!dist->random_state) {
+        dist->random_state = 1;
+    }
+    // creations below 4 are used by old nodes
+    do {
+        dist->creation = dist_random(dist);
+    } while (dist->creation < 4);
+
+    if (!dist_driver_listen(dist, term_to_int32(port))) {
+        dist_free(dist);
+        return 0;
+    }
+
+    EventListener *timer = &dist->timer;
+    timer->fd = -1;
+    timer->expires = 1;
+    sys_set_timestamp_from_relative_to_abs(&timer->expiral_timestamp, DIST_TICK_INTERVAL_MS);
+    timer->one_shot = 0;
+    timer->data = dist;
+    timer->handler = dist_timer_callback;
+    linkedlist_append(&glb->listeners, &timer->listeners_list_head);
+
+    ctx->native_handler = dist_consume_mailbox;
+    ctx->destroy_handler = dist_destroy;
+    ctx->platform_data = dist;
+    glb->dist = dist;
+
+    return 1;
+}
+
+static void dist_destroy(Context *ctx)
+{
+    struct Dist *dist = (struct Dist *) ctx->platform_data;
+    GlobalContext *glb = ctx->global;
+
+    struct ListHead *item;
+    struct ListHead *tmp;
+    MUTABLE_LIST_FOR_EACH(item, tmp, &dist->connections) {
+        dist_connection_destroy(GET_LIST_ENTRY(item, struct DistConnection, connections_list_head));
+    }
+    // remote processes cannot be reached anymore
+    while (!list_is_empty(&dist->proxies)) {
+        struct DistProxy *proxy = GET_LIST_ENTRY(list_first(&dist->proxies), struct DistProxy, proxies_list_head);
+        proxy->ctx->exit_reason = context_make_atom(proxy->ctx, noconnection_atom);
+        scheduler_terminate(proxy->ctx);
+    }
+    dist_driver_stop(dist);
+    linkedlist_remove(&glb->listeners, &dist->timer.listeners_list_head);
+
+    glb->dist = NULL;
+    dist_free(dist);
+    ctx->platform_data = NULL;
+}
+
+int dist_local_node(GlobalContext *glb, term *node, uint32_t *creation)
+{
+    struct Dist *dist = glb->dist;
+    if (!dist) {
+        return 0;
+    }
+    *node = dist->node;
+    *creation = dist->creation;
+
+    return 1;
+}
+
+static struct DistProxy *dist_get_proxy(GlobalContext *glb, term pid)
+{
+    Context *target = globalcontext_get_process(glb, term_to_local_process_id(pid));
+    if (target && (target->native_handler == dist_proxy_consume_mailbox)) {
+        return (struct DistProxy *) target->platform_data;
+    }
+
+    return NULL;
+}
+
+term dist_pid_node(GlobalContext *glb, term pid)
+{
+    struct Dist *dist = glb->dist;
+    if (!dist) {
+        return term_from_atom_index(globalcontext_insert_atom(glb, nonode_at_nohost_atom));
+    }
+    struct DistProxy *proxy = dist_get_proxy(glb, pid);
+
+    return proxy ? proxy->pid.node : dist->node;
+}
+
+int dist_pid_to_external(GlobalContext *glb, term pid, struct DistPid *external_pid)
+{
+    struct Dist *dist = glb->dist;
+    if (!dist) {
+        return 0;
+    }
+
+    struct DistProxy *proxy = dist_get_proxy(glb, pid);
+    if (proxy) {
+        *external_pid = proxy->pid;
+    } else {
+        external_pid->node = dist->node;
+        external_pid->id = term_to_local_process_id(pid);
+        external_pid->serial = 0;
+        external_pid->creation = dist->creation;
+    }
+
+    return 1;
+}
+
+static inline unsigned long dist_proxy_key(const struct DistPid *pid)
+{
+    return ((unsigned long) term_to_atom_index(pid->node) << 24) ^ pid->id ^ ((unsigned long) pid->serial << 16);
+}
+
+static inline int dist_pid_equals(const struct DistPid *a, const struct DistPid *b)
+{
+    return (a->node == b->node) && (a->id == b->id) && (a->serial == b->serial) && (a->creation == b->creation);
+}
+
+static struct DistProxy *dist_find_proxy(struct Dist *dist, const struct DistPid *pid)
+{
+    struct DistProxy *proxy = (struct DistProxy *) valueshashtable_get_value(dist->proxies_table, dist_proxy_key(pid), (unsigned long) NULL);
+    if (proxy && dist_pid_equals(&proxy->pid, pid)) {
+        return proxy;
+    }
+
+    // the table keeps a single proxy per key, colliding ones are only in the list
+    if (proxy) {
+        struct ListHead *item;
+        LIST_FOR_EACH(item, &dist->proxies) {
+            proxy = GET_LIST_ENTRY(item, struct DistProxy, proxies_list_head);
+            if (dist_pid_equals(&proxy->pid, pid)) {
+                return proxy;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+term dist_pid_from_external(GlobalContext *glb, const struct DistPid *external_pid)
+{
+    struct Dist *dist = glb->dist;
+
+    if (external_pid->node == dist->node) {
+        // pids of a previous incarnation of this node are never alive
+        if ((external_pid->creation != dist->creation) || external_pid->serial || (external_pid->id > (UINT32_MAX >> 4))) {
+            return term_from_local_process_id(0);
+        }
+        return term_from_local_process_id(external_pid->id);
+    }
+
+    struct DistProxy *proxy = dist_find_proxy(dist, external_pid);
+    if (proxy) {
+        return term_from_local_process_id(proxy->ctx->process_id);
+    }
+
+    proxy = malloc(sizeof(struct DistProxy));
+    if (IS_NULL_PTR(proxy)) {
+        fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+        return term_from_local_process_id(0);
+    }
+    proxy->pid = *external_pid;
+    proxy->ctx = context_new(glb);
+    if (IS_NULL_PTR(proxy->ctx)) {
+        free(proxy);
+        return term_from_local_process_id(0);
+    }
+    proxy->ctx->native_handler = dist_proxy_consume_mailbox;
+    proxy->ctx->destroy_handler = dist_proxy_destroy;
+    proxy->ctx->platform_data = proxy;
+    scheduler_make_waiting(glb, proxy->ctx);
+
+    list_append(&dist->proxies, &proxy->proxies_list_head);
+    unsigned long key = dist_proxy_key(external_pid);
+    if (!valueshashtable_has_key(dist->proxies_table, key)) {
+        valueshashtable_insert(dist->proxies_table, key, (unsigned long) proxy);
+    }
+    TRACE("dist: pid %i is a proxy of remote pid %u.%u\n", proxy->ctx->process_id, external_pid->id, external_pid->serial);
+
+    return term_from_local_process_id(proxy->ctx->process_id);
+}
+
+static void dist_proxy_destroy(Context *ctx)
+{
+    struct DistProxy *proxy = (struct DistProxy *) ctx->platform_data;
+    struct Dist *dist = ctx->global->dist;
+
+    if (dist) {
+        unsigned long key = dist_proxy_key(&proxy->pid);
+        if (valueshashtable_get_value(dist->proxies_table, key, (unsigned long) NULL) == (unsigned long) proxy) {
+            valueshashtable_remove(dist->proxies_table, key);
+        }
+        list_remove(&proxy->proxies_list_head);
+    }
+    free(proxy);
+    ctx->platform_data = NULL;
+}
+
+static void dist_terminate_proxies(struct Dist *dist, term node, uint32_t creation)
+{
+    // exit signals may terminate other proxies as well, so the list is walked again after each one
+    int terminated;
+    do {
+        terminated = 0;
+        struct ListHead *item;
+        LIST_FOR_EACH(item, &dist->proxies) {
+            struct DistProxy *proxy = GET_LIST_ENTRY(item, struct DistProxy, proxies_list_head);
+            if ((proxy->pid.node == node) && (proxy->pid.creation == creation)) {
+                // linked and monitoring processes are notified, as for any other exiting process
+                proxy->ctx->exit_reason = context_make_atom(proxy->ctx, noconnection_atom);
+                scheduler_terminate(proxy->ctx);
+                terminated = 1;
+                break;
+            }
+        }
+    } while (terminated);
+}
+
+static void dist_proxy_consume_mailbox(Context *ctx)
+{
+    struct DistProxy *proxy = (struct DistProxy *) ctx->platform_data;
+    struct Dist *dist = ctx->global->dist;
+
+    while (ctx->mailbox) {
+        Message *message = mailbox_dequeue(ctx);
+
+        struct DistConnection *connection = dist ? dist_connection_for_node(dist, proxy->pid.node) : NULL;
+        if (connection) {
+            term control[3];
+            control[0] = term_from_int32(DOP_SEND);
+            control[1] = context_make_atom(ctx, empty_atom);
+            control[2] = term_from_local_process_id(ctx->process_id);
+            if (!dist_connection_send(connection, control, 3, message->message)) {
+                TRACE("dist: dropping a message that cannot be encoded.\n");
+            }
+        }
+
+        mailbox_message_destroy(message);
+    }
+}
+
+int dist_send_registered(Context *ctx, term destination, term message)
+{
+    GlobalContext *glb = ctx->global;
+    struct Dist *dist = glb->dist;
+
+    term name = term_get_tuple_element(destination, 0);
+    term node = term_get_tuple_element(destination, 1);
+    if (UNLIKELY(!term_is_atom(name))) {
+        return 0;
+    }
+
+    term local_node = dist ? dist->node : term_from_atom_index(globalcontext_insert_atom(glb, nonode_at_nohost_atom));
+    if (node == local_node) {
+        int local_process_id = globalcontext_get_registered_process(glb, term_to_atom_index(name));
+        Context *target = local_process_id ? globalcontext_get_process(glb, local_process_id) : NULL;
+        if (target) {
+            mailbox_send(target, message);
+        }
+        return 1;
+    }
+
+    struct DistConnection *connection = dist ? dist_connection_for_node(dist, node) : NULL;
+    if (!connection) {
+        TRACE("dist: dropping a message to an unknown node.\n");
+        return 1;
+    }
+
+    term control[4];
+    control[0] = term_from_int32(DOP_REG_SEND);
+    control[1] = term_from_local_process_id(ctx->process_id);
+    control[2] = context_make_atom(ctx, empty_atom);
+    control[3] = name;
+
+    return dist_connection_send(connection, control, 4, message);
+}
+
+int dist_connected_nodes_size(GlobalContext *glb)
+{
+    struct Dist *dist = glb->dist;
+    if (!dist) {
+        return 0;
+    }
+
+    int count = 0;
+    struct ListHead *item;
+    LIST_FOR_EACH(item, &dist->connections) {
+        struct DistConnection *connection = GET_LIST_ENTRY(item, struct DistConnection, connections_list_head);
+        if ((connection->state == DistConnectionConnected) && !connection->closing) {
+            count++;
+        }
+    }
+
+    return count * 2;
+}
+
+term dist_connected_nodes(Context *ctx)
+{
+    struct Dist *dist = ctx->global->dist;
+    term nodes = term_nil();
+    if (!dist) {
+        return nodes;
+    }
+
+    struct ListHead *item;
+    LIST_FOR_EACH(item, &dist->connections) {
+        struct DistConnection *connection = GET_LIST_ENTRY(item, struct DistConnection, connections_list_head);
+        if ((connection->state == DistConnectionConnected) && !connection->closing) {
+            nodes = term_list_prepend(connection->node, nodes, ctx);
+        }
+    }
+
+    return nodes;
+}
+
+static void dist_request_service(struct Dist *dist)
+{
+    // the dist port closes connections and writes buffers, outside of event handlers
+    if (!dist->service_requested) {
+        dist->service_requested = 1;
+        mailbox_send(dist->ctx, context_make_atom(dist->ctx, service_atom));
+    }
+}
+
+static void dist_consume_mailbox(Context *ctx)
+{
+    struct Dist *dist = (struct Dist *) ctx->platform_data;
+
+    dist_flush(dist);
+
+    // the port is made waiting after this handler, so requests made while flushing are dropped as well
+    while (ctx->mailbox) {
+        mailbox_message_destroy(mailbox_dequeue(ctx));
+    }
+    dist->service_requested = 0;
+}
+
+static void dist_timer_callback(void *data)
+{
+    EventListener *listener = (EventListener *) data;
+    struct Dist *dist = (struct Dist *) listener->data;
+
+    struct ListHead *item;
+    LIST_FOR_EACH(item, &dist->connections) {
+        struct DistConnection *connection = GET_LIST_ENTRY(item, struct DistConnection, connections_list_head);
+        if (connection->closing) {
+            continue;
+        }
+        // this also covers handshakes that never complete
+        if (++connection->silent_ticks > DIST_MAX_SILENT_TICKS) {
+            TRACE("dist: connection timed out.\n");
+            connection->closing = 1;
+            continue;
+        }
+        // a tick is an empty frame, it is sent only on idle connections
+        if ((connection->state == DistConnectionConnected) && !connection->sent_since_tick) {
+            uint8_t *p = dist_connection_reserve(connection, 4);
+            if (LIKELY(p != NULL)) {
+                memset(p, 0, 4);
+                connection->out_len += 4;
+            }
+        }
+        connection->sent_since_tick = 0;
+    }
+
+    sys_set_timestamp_from_relative_to_abs(&listener->expiral_timestamp, DIST_TICK_INTERVAL_MS);
+    dist_request_service(dist);
+}
+
+static void dist_schedule_retry(struct Dist *dist)
+{
+    struct timespec retry_at;
+    sys_set_timestamp_from_relative_to_abs(&retry_at, DIST_RETRY_INTERVAL_MS);
+    struct timespec *expiral = &dist->timer.expiral_timestamp;
+    if ((retry_at.tv_sec < expiral->tv_sec) || ((retry_at.tv_sec == expiral->tv_sec) && (retry_at.tv_nsec < expiral->tv_nsec))) {
+        // the tick happens a bit earlier, that is harmless
+        *expiral = retry_at;
+    }
+}
+
+static int dist_connection_start(struct Dist *dist, struct DistConnection *connection);
+
+static void dist_flush(struct Dist *dist)
+{
+    int retry = 0;
+
+    struct ListHead *item;
+    struct ListHead *tmp;
+    MUTABLE_LIST_FOR_EACH(item, tmp, &dist->connections) {
+        struct DistConnection *connection = GET_LIST_ENTRY(item, struct DistConnection, connections_list_head);
+
+        if (!connection->closing && !connection->driver_data && !dist_connection_start(dist, connection)) {
+            connection->closing = 1;
+        }
+        if (connection->closing) {
+            dist_connection_destroy(connection);
+            continue;
+        }
+
+        // until the handshake is complete only handshake frames can be written
+        size_t flushable = (connection->state == DistConnectionConnected) ? connection->out_len : connection->out_handshake_len;
+        if (!flushable) {
+            continue;
+        }
+        int written = dist_driver_send(connection, connection->out_buf, flushable);
+        if (written < 0) {
+            TRACE("dist: connection lost while writing.\n");
+            dist_connection_destroy(connection);
+            continue;
+        }
+        memmove(connection->out_buf, connection->out_buf + written, connection->out_len - written);
+        connection->out_len -= written;
+        connection->out_handshake_len -= ((size_t) written < connection->out_handshake_len) ? (size_t) written : connection->out_handshake_len;
+        if ((size_t) written < flushable) {
+            retry = 1;
+        }
+    }
+
+    if (retry) {
+        dist_schedule_retry(dist);
+    }
+}
+
+static uint8_t *dist_connection_reserve(struct DistConnection *connection, size_t size)
+{
+    size_t required = connection->out_len + size;
+    if (required > connection->out_capacity) {
+        size_t capacity = connection->out_capacity ? connection->out_capacity * 2 : 256;
+        while (capacity < required) {
+            capacity *= 2;
+        }
+        uint8_t *out_buf = realloc(connection->out_buf, capacity);
+        if (IS_NULL_PTR(out_buf)) {
+            fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+            return NULL;
+        }
+        connection->out_buf = out_buf;
+        connection->out_capacity = capacity;
+    }
+
+    return connection->out_buf + connection->out_len;
+}
+
+static void dist_connection_queue_handshake(struct DistConnection *connection, const uint8_t *frame, size_t size)
+{
+    // handshake frames are written before any queued message
+    uint8_t *p = dist_connection_reserve(connection, size + 2);
+    if (IS_NULL_PTR(p)) {
+        connection->closing = 1;
+        dist_request_service(connection->dist);
+        return;
+    }
+    uint8_t *dest = connection->out_buf + connection->out_handshake_len;
+    memmove(dest + size + 2, dest, connection->out_len - connection->out_handshake_len);
+    write_16(dest, size);
+    memcpy(dest + 2, frame, size);
+    connection->out_len += size + 2;
+    connection->out_handshake_len += size + 2;
+
+    dist_request_service(connection->dist);
+}
+
+static struct DistConnection *dist_connection_new(struct Dist *dist, term node)
+{
+    struct DistConnection *connection = calloc(1, sizeof(struct DistConnection));
+    if (IS_NULL_PTR(connection)) {
+        fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+        return NULL;
+    }
+    connection->dist = dist;
+    connection->node = node;
+    list_append(&dist->connections, &connection->connections_list_head);
+
+    return connection;
+}
+
+static void dist_connection_destroy(struct DistConnection *connection)
+{
+    struct Dist *dist = connection->dist;
+
+    if (connection->driver_data) {
+        dist_driver_close(connection);
+    }
+    if ((connection->state == DistConnectionConnected) && !connection->superseded) {
+        dist_terminate_proxies(dist, connection->node, connection->creation);
+    }
+    list_remove(&connection->connections_list_head);
+    free(connection->in_buf);
+    free(connection->out_buf);
+    free(connection->in_atom_cache);
+    free(connection->out_atom_cache);
+    free(connection);
+}
+
+static struct DistConnection *dist_find_connection(struct Dist *dist, term node, const struct DistConnection *except)
+{
+    struct ListHead *item;
+    LIST_FOR_EACH(item, &dist->connections) {
+        struct DistConnection *connection = GET_LIST_ENTRY(item, struct DistConnection, connections_list_head);
+        if ((connection != except) && (connection->node == node) && !connection->closing) {
+            return connection;
+        }
+    }
+
+    return NULL;
+}
+
+static int dist_find_address(struct Dist *dist, term node, uint32_t *address, uint16_t *port)
+{
+    for (int i = 0; i < dist->port_map_len; i++) {
+        if (dist->port_map[i].node == node) {
+            *address = dist->port_map[i].address;
+            *port = dist->port_map[i].port;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static struct DistConnection *dist_connection_for_node(struct Dist *dist, term node)
+{
+    struct DistConnection *connection = dist_find_connection(dist, node, NULL);
+    if (connection) {
+        return connection;
+    }
+
+    uint32_t address;
+    uint16_t port;
+    if (!dist_find_address(dist, node, &address, &port)) {
+        return NULL;
+    }
+
+    // the connection is started by the dist port, messages are queued until then
+    connection = dist_connection_new(dist, node);
+    if (IS_NULL_PTR(connection)) {
+        return NULL;
+    }
+    connection->state = DistConnectionAwaitStatus;
+    dist_request_service(dist);
+
+    return connection;
+}
+
+static void dist_connection_send_name(struct DistConnection *connection)
+{
+    struct Dist *dist = connection->dist;
+    AtomString name = globalcontext_atomstring_from_term(dist->ctx->global, dist->node);
+    int name_len = atom_string_len(name);
+
+    uint8_t frame[1 + 8 + 4 + 2 + 255];
+    frame[0] = 'N';
+    write_64(frame + 1, DIST_LOCAL_FLAGS);
+    write_32(frame + 9, dist->creation);
+    write_16(frame + 13, name_len);
+    memcpy(frame + 15, atom_string_data(name), name_len);
+
+    dist_connection_queue_handshake(connection, frame, 15 + name_len);
+}
+
+static int dist_connection_start(struct Dist *dist, struct DistConnection *connection)
+{
+    uint32_t address;
+    uint16_t port;
+    if (!dist_find_address(dist, connection->node, &address, &port) || !dist_driver_connect(connection, address, port)) {
+        TRACE("dist: cannot connect, dropping queued messages.\n");
+        return 0;
+    }
+    dist_connection_send_name(connection);
+
+    return 1;
+}
+
+struct DistConnection *dist_connection_accepted(struct Dist *dist, void *driver_data)
+{
+    struct DistConnection *connection = dist_connection_new(dist, term_invalid_term());
+    if (IS_NULL_PTR(connection)) {
+        return NULL;
+    }
+    connection->state = DistConnectionAwaitName;
+    connection->driver_data = driver_data;
+
+    return connection;
+}
+
+void dist_connection_lost(struct DistConnection *connection)
+{
+    TRACE("dist: connection closed by peer.\n");
+    connection->closing = 1;
+    dist_request_service(connection->dist);
+}
+
+void dist_connection_received(struct DistConnection *connection, const uint8_t *data, size_t len)
+{
+    if (connection->closing) {
+        return;
+    }
+
+    size_t required = connection->in_len + len;
+    if (required > connection->in_capacity) {
+        size_t capacity = connection->in_capacity ? connection->in_capacity * 2 : 256;
+        while (capacity < required) {
+            capacity *= 2;
+        }
+        uint8_t *in_buf = realloc(connection->in_buf, capacity);
+        if (IS_NULL_PTR(in_buf)) {
+            fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+            dist_connection_lost(connection);
+            return;
+        }
+        connection->in_buf = in_buf;
+        connection->in_capacity = capacity;
+    }
+    memcpy(connection->in_buf + connection->in_len, data, len);
+    connection->in_len += len;
+    connection->silent_ticks = 0;
+
+    // handshake frames have a 2 bytes length, frames that follow have a 4 bytes one
+    size_t pos = 0;
+    while (!connection->closing) {
+        size_t available = connection->in_len - pos;
+        const uint8_t *frame = connection->in_buf + pos;
+        if (connection->state != DistConnectionConnected) {
+            if ((available < 2) || (available < 2 + (size_t) read_16(frame))) {
+                break;
+            }
+            size_t size = read_16(frame);
+            pos += 2 + size;
+            dist_connection_handle_handshake(connection, frame + 2, size);
+        } else {
+            if (available < 4) {
+                break;
+            }
+            size_t size = read_32(frame);
+            if (UNLIKELY(size > DIST_MAX_FRAME_SIZE)) {
+                dist_connection_lost(connection);
+                break;
+            }
+            if (available < 4 + size) {
+                break;
+            }
+            pos += 4 + size;
+            if (size) {
+                dist_connection_handle_message(connection, frame + 4, size);
+            }
+        }
+    }
+
+    memmove(connection->in_buf, connection->in_buf + pos, connection->in_len - pos);
+    connection->in_len -= pos;
+}
+
+static void dist_compute_digest(const char *cookie, uint32_t challenge, uint8_t *digest)
+{
+    char challenge_string[11];
+    snprintf(challenge_string, sizeof(challenge_string), "%lu", (unsigned long) challenge);
+
+    struct DigestContext digest_ctx;
+    digest_init(&digest_ctx, DigestMD5);
+    digest_update(&digest_ctx, (const uint8_t *) cookie, strlen(cookie));
+    digest_update(&digest_ctx, (const uint8_t *) challenge_string, strlen(challenge_string));
+    digest_final(&digest_ctx, digest);
+}
+
+static void dist_connection_send_status(struct DistConnection *connection, const char *status)
+{
+    uint8_t frame[32];
+    frame[0] = 's';
+    size_t len = strlen(status);
+    memcpy(frame + 1, status, len);
+
+    dist_connection_queue_handshake(connection, frame, len + 1);
+}
+
+static void dist_connection_abort(struct DistConnection *connection)
+{
+    connection->closing = 1;
+    dist_request_service(connection->dist);
+}
+
+static void dist_connection_up(struct DistConnection *connection)
+{
+    TRACE("dist: connection is up.\n");
+    connection->state = DistConnectionConnected;
+    connection->silent_ticks = 0;
+
+    if (connection->flags & DFLAG_DIST_HDR_ATOM_CACHE) {
+        connection->in_atom_cache = malloc(sizeof(term) * DIST_ATOM_CACHE_SIZE);
+        connection->out_atom_cache = malloc(sizeof(term) * DIST_ATOM_CACHE_SIZE);
+        if (IS_NULL_PTR(connection->in_atom_cache) || IS_NULL_PTR(connection->out_atom_cache)) {
+            fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+            dist_connection_abort(connection);
+            return;
+        }
+        for (int i = 0; i < DIST_ATOM_CACHE_SIZE; i++) {
+            connection->in_atom_cache[i] = term_invalid_term();
+            connection->out_atom_cache[i] = term_invalid_term();
+        }
+    }
+
+    // messages queued while connecting
+    dist_request_service(connection->dist);
+}
+
+static void dist_connection_transfer_queue(struct DistConnection *from, struct DistConnection *to)
+{
+    // queued messages are pass through frames, that are valid on any connection
+    size_t size = from->out_len - from->out_handshake_len;
+    if (!size) {
+        return;
+    }
+    uint8_t *p = dist_connection_reserve(to, size);
+    if (IS_NULL_PTR(p)) {
+        return;
+    }
+    memcpy(p, from->out_buf + from->out_handshake_len, size);
+    to->out_len += size;
+    from->out_len = from->out_handshake_len;
+}
+
+static inline int dist_connection_is_initiator(const struct DistConnection *connection)
+{
+    return (connection->state == DistConnectionAwaitStatus) || (connection->state == DistConnectionAwaitChallenge)
+        || (connection->state == DistConnectionAwaitAck);
+}
+
+static void dist_connection_handle_name(struct DistConnection *connection, term node)
+{
+    struct Dist *dist = connection->dist;
+    GlobalContext *glb = dist->ctx->global;
+
+    connection->node = node;
+    struct DistConnection *other = dist_find_connection(dist, node, connection);
+    if (other && (other->state == DistConnectionConnected)) {
+        // the peer restarted while its previous connection looked alive
+        other->closing = 1;
+    } else if (other && dist_connection_is_initiator(other)) {
+        // simultaneous connect: the node with the greater name keeps its own connection
+        if (dist_compare_nodes(glb, dist->node, node) > 0) {
+            dist_connection_send_status(connection, "nok");
+            connection->node = term_invalid_term();
+            dist_connection_abort(connection);
+            return;
+        }
+        dist_connection_send_status(connection, "ok_simultaneous");
+        dist_connection_transfer_queue(other, connection);
+        other->superseded = 1;
+        other->closing = 1;
+        return;
+    } else if (other) {
+        dist_connection_send_status(connection, "nok");
+        connection->node = term_invalid_term();
+        dist_connection_abort(connection);
+        return;
+    }
+    dist_connection_send_status(connection, "ok");
+}
+
+static void dist_connection_send_challenge(struct DistConnection *connection)
+{
+    struct Dist *dist = connection->dist;
+    AtomString name = globalcontext_atomstring_from_term(dist->ctx->global, dist->node);
+    int name_len = atom_string_len(name);
+
+    connection->challenge = dist_random(dist);
+
+    uint8_t frame[1 + 8 + 4 + 4 + 2 + 255];
+    frame[0] = 'N';
+    write_64(frame + 1, DIST_LOCAL_FLAGS);
+    write_32(frame + 9, connection->challenge);
+    write_32(frame + 13, dist->creation);
+    write_16(frame + 17, name_len);
+    memcpy(frame + 19, atom_string_data(name), name_len);
+
+    dist_connection_queue_handshake(connection, frame, 19 + name_len);
+    connection->state = DistConnectionAwaitReply;
+}
+
+static void dist_connection_handle_handshake(struct DistConnection *connection, const uint8_t *buf, size_t size)
+{
+    struct Dist *dist = connection->dist;
+    GlobalContext *glb = dist->ctx->global;
+
+    if (!size) {
+        dist_connection_abort(connection);
+        return;
+    }
+
+    switch (connection->state) {
+        case DistConnectionAwaitName: {
+            const uint8_t *name;
+            size_t name_len;
+            if ((buf[0] == 'N') && (size >= 15) && (size == (size_t) 15 + read_16(buf + 13))) {
+                connection->flags = read_64(buf + 1);
+                connection->creation = read_32(buf + 9);
+                name = buf + 15;
+                name_len = size - 15;
+            } else if ((buf[0] == 'n') && (size >= 7)) {
+                // old send_name, the creation will be sent with a complement
+                connection->flags = read_32(buf + 3);
+                name = buf + 7;
+                name_len = size - 7;
+            } else {
+                dist_connection_abort(connection);
+                return;
+            }
+            if ((connection->flags & DIST_REQUIRED_FLAGS) != DIST_REQUIRED_FLAGS) {
+                TRACE("dist: peer does not support required flags.\n");
+                dist_connection_send_status(connection, "not_allowed");
+                dist_connection_abort(connection);
+                return;
+            }
+            term node = dist_make_atom(glb, name, name_len);
+            if (term_is_invalid_term(node)) {
+                dist_connection_abort(connection);
+                return;
+            }
+            dist_connection_handle_name(connection, node);
+            if (!connection->closing) {
+                dist_connection_send_challenge(connection);
+            }
+            break;
+        }
+
+        case DistConnectionAwaitReply:
+            if ((buf[0] == 'c') && (size == 9)) {
+                connection->flags |= (uint64_t) read_32(buf + 1) << 32;
+                connection->creation = read_32(buf + 5);
+
+            } else if ((buf[0] == 'r') && (size == 5 + DIST_CHALLENGE_DIGEST_SIZE)) {
+                uint8_t digest[DIST_CHALLENGE_DIGEST_SIZE];
+                dist_compute_digest(dist->cookie, connection->challenge, digest);
+                if (memcmp(digest, buf + 5, DIST_CHALLENGE_DIGEST_SIZE)) {
+                    fprintf(stderr, "dist: connection attempt with a wrong cookie.\n");
+                    dist_connection_abort(connection);
+                    return;
+                }
+                uint8_t ack[1 + DIST_CHALLENGE_DIGEST_SIZE];
+                ack[0] = 'a';
+                dist_compute_digest(dist->cookie, read_32(buf + 1), ack + 1);
+                dist_connection_queue_handshake(connection, ack, sizeof(ack));
+                dist_connection_up(connection);
+
+            } else {
+                dist_connection_abort(connection);
+            }
+            break;
+
+        case DistConnectionAwaitStatus:
+            if ((size == 3) && !memcmp(buf, "sok", 3)) {
+                connection->state = DistConnectionAwaitChallenge;
+            } else if ((size == 16) && !memcmp(buf, "sok_simultaneous", 16)) {
+                connection->state = DistConnectionAwaitChallenge;
+            } else if ((size == 6) && !memcmp(buf, "salive", 6)) {
+                // the peer has a stale connection to this node, that is replaced
+                dist_connection_send_status(connection, "true");
+                connection->state = DistConnectionAwaitChallenge;
+            } else {
+                // nok: the peer connection wins a simultaneous connect, queued messages are moved there
+                struct DistConnection *other = dist_find_connection(dist, connection->node, connection);
+                if (other) {
+                    dist_connection_transfer_queue(connection, other);
+                    connection->superseded = 1;
+                }
+                dist_connection_abort(connection);
+            }
+            break;
+
+        case DistConnectionAwaitChallenge: {
+            if ((buf[0] != 'N') || (size < 19) || (size != (size_t) 19 + read_16(buf + 17))) {
+                dist_connection_abort(connection);
+                return;
+            }
+            connection->flags = read_64(buf + 1);
+            uint32_t challenge = read_32(buf + 9);
+            connection->creation = read_32(buf + 13);
+            if (((connection->flags & DIST_REQUIRED_FLAGS) != DIST_REQUIRED_FLAGS)
+                    || (dist_make_atom(glb, buf + 19, size - 19) != connection->node)) {
+                dist_connection_abort(connection);
+                return;
+            }
+
+            connection->challenge = dist_random(dist);
+            uint8_t reply[1 + 4 + DIST_CHALLENGE_DIGEST_SIZE];
+            reply[0] = 'r';
+            write_32(reply + 1, connection->challenge);
+            dist_compute_digest(dist->cookie, challenge, reply + 5);
+            dist_connection_queue_handshake(connection, reply, sizeof(reply));
+            connection->state = DistConnectionAwaitAck;
+            break;
+        }
+
+        case DistConnectionAwaitAck: {
+            uint8_t digest[DIST_CHALLENGE_DIGEST_SIZE];
+            dist_compute_digest(dist->cookie, connection->challenge, digest);
+            if ((buf[0] != 'a') || (size != 1 + DIST_CHALLENGE_DIGEST_SIZE) || memcmp(digest, buf + 1, DIST_CHALLENGE_DIGEST_SIZE)) {
+                fprintf(stderr, "dist: handshake failed, wrong cookie.\n");
+                dist_connection_abort(connection);
+                return;
+            }
+            dist_connection_up(connection);
+            break;
+        }
+
+        case DistConnectionConnected:
+            break;
+    }
+}
+
+static int dist_atom_cache_index(term atom)
+{
+    return term_to_atom_index(atom) % DIST_ATOM_CACHE_SIZE;
+}
+
+// atoms that are not in the peer cache (or that are evicted by a previous reference of the same message) are sent
+// along with their text
+static size_t dist_header_size(const struct DistConnection *connection, const struct ExternalTermAtomRefs *refs, uint8_t *is_new)
+{
+    GlobalContext *glb = connection->dist->ctx->global;
+
+    if (!refs->count) {
+        return 3;
+    }
+
+    size_t size = 3 + refs->count / 2 + 1;
+    for (int i = 0; i < refs->count; i++) {
+        int cache_index = dist_atom_cache_index(refs->atoms[i]);
+        is_new[i] = connection->out_atom_cache[cache_index] != refs->atoms[i];
+        for (int j = 0; (j < i) && !is_new[i]; j++) {
+            is_new[i] = dist_atom_cache_index(refs->atoms[j]) == cache_index;
+        }
+        size += 1;
+        if (is_new[i]) {
+            size += 1 + atom_string_len(globalcontext_atomstring_from_term(glb, refs->atoms[i]));
+        }
+    }
+
+    return size;
+}
+
+static uint8_t *dist_write_header(struct DistConnection *connection, uint8_t *p, const struct ExternalTermAtomRefs *refs, const uint8_t *is_new)
+{
+    GlobalContext *glb = connection->dist->ctx->global;
+
+    *p++ = VERSION_MAGIC;
+    *p++ = DIST_HEADER;
+    *p++ = refs->count;
+    if (!refs->count) {
+        return p;
+    }
+
+    // a flags nibble for each reference, the last one tells that atoms are short
+    uint8_t *flags = p;
+    int flags_len = refs->count / 2 + 1;
+    memset(flags, 0, flags_len);
+    p += flags_len;
+
+    for (int i = 0; i < refs->count; i++) {
+        int cache_index = dist_atom_cache_index(refs->atoms[i]);
+        uint8_t nibble = (is_new[i] ? 0x8 : 0) | (cache_index >> 8);
+        flags[i / 2] |= (i & 1) ? (nibble << 4) : nibble;
+
+        *p++ = cache_index & 0xFF;
+        if (is_new[i]) {
+            AtomString atom_string = globalcontext_atomstring_from_term(glb, refs->atoms[i]);
+            int len = atom_string_len(atom_string);
+            *p++ = len;
+            memcpy(p, atom_string_data(atom_string), len);
+            p += len;
+            connection->out_atom_cache[cache_index] = refs->atoms[i];
+        }
+    }
+
+    return p;
+}
+
+static int dist_connection_send(struct DistConnection *connection, const term control[], int control_len, term message)
+{
+    GlobalContext *glb = connection->dist->ctx->global;
+
+    // the atom cache is used once connected, messages queued before that are pass through ones
+    struct ExternalTermAtomRefs refs;
+    refs.count = 0;
+    struct ExternalTermAtomRefs *refs_ptr = connection->out_atom_cache ? &refs : NULL;
+
+    // control messages are tuples, their elements are encoded one by one
+    int element_sizes[DIST_MAX_CONTROL_ELEMENTS];
+    size_t control_size = 2;
+    for (int i = 0; i < control_len; i++) {
+        element_sizes[i] = externalterm_encoded_size(control[i], glb, refs_ptr);
+        if (UNLIKELY(element_sizes[i] < 0)) {
+            return 0;
+        }
+        control_size += element_sizes[i];
+    }
+    // some control messages, such as exits, are not followed by a message
+    int has_message = !term_is_invalid_term(message);
+    int message_size = has_message ? externalterm_encoded_size(message, glb, refs_ptr) : 0;
+    if (UNLIKELY(message_size < 0)) {
+        return 0;
+    }
+
+    uint8_t is_new[EXTERNALTERM_MAX_ATOM_REFS];
+    size_t header_size = refs_ptr ? dist_header_size(connection, refs_ptr, is_new) : 2;
+    size_t payload_size = header_size + control_size + ((has_message && !refs_ptr) ? 1 : 0) + message_size;
+
+    uint8_t *p = dist_connection_reserve(connection, 4 + payload_size);
+    if (IS_NULL_PTR(p)) {
+        // as for a message to a dead process, the send itself succeeds
+        return 1;
+    }
+    write_32(p, payload_size);
+    p += 4;
+    if (refs_ptr) {
+        p = dist_write_header(connection, p, refs_ptr, is_new);
+    } else {
+        *p++ = PASS_THROUGH;
+        *p++ = VERSION_MAGIC;
+    }
+
+    *p++ = SMALL_TUPLE_EXT;
+    *p++ = control_len;
+    for (int i = 0; i < control_len; i++) {
+        externalterm_encode(p, control[i], glb, refs_ptr);
+        p += element_sizes[i];
+    }
+    if (has_message) {
+        if (!refs_ptr) {
+            *p++ = VERSION_MAGIC;
+        }
+        externalterm_encode(p, message, glb, refs_ptr);
+    }
+
+    connection->out_len += 4 + payload_size;
+    connection->sent_since_tick = 1;
+    dist_request_service(connection->dist);
+
+    return 1;
+}
+
+static int dist_parse_header(struct DistConnection *connection, const uint8_t *buf, size_t size, struct ExternalTermAtomRefs *refs)
+{
+    GlobalContext *glb = connection->dist->ctx->global;
+
+    int count = buf[2];
+    refs->count = count;
+    if (!count) {
+        return 3;
+    }
+    if (!connection->in_atom_cache) {
+        return -1;
+    }
+
+    size_t flags_len = count / 2 + 1;
+    if (size < 3 + flags_len) {
+        return -1;
+    }
+    const uint8_t *flags = buf + 3;
+    if (((flags[count / 2] >> ((count & 1) ? 4 : 0)) & 0x1) != 0) {
+        TRACE("dist: long atoms are not supported.\n");
+        return -1;
+    }
+
+    size_t pos = 3 + flags_len;
+    for (int i = 0; i < count; i++) {
+        uint8_t nibble = (flags[i / 2] >> ((i & 1) ? 4 : 0)) & 0xF;
+        if (pos >= size) {
+            return -1;
+        }
+        int cache_index = ((nibble & 0x7) << 8) | buf[pos++];
+
+        if (nibble & 0x8) {
+            if ((pos >= size) || (size - pos - 1 < buf[pos])) {
+                return -1;
+            }
+            size_t len = buf[pos++];
+            term atom = dist_make_atom(glb, buf + pos, len);
+            if (term_is_invalid_term(atom)) {
+                return -1;
+            }
+            pos += len;
+            connection->in_atom_cache[cache_index] = atom;
+        } else if (term_is_invalid_term(connection->in_atom_cache[cache_index])) {
+            return -1;
+        }
+        refs->atoms[i] = connection->in_atom_cache[cache_index];
+    }
+
+    return pos;
+}
+
+static Context *dist_find_target(GlobalContext *glb, term target)
+{
+    int local_process_id;
+    if (term_is_pid(target)) {
+        local_process_id = term_to_local_process_id(target);
+    } else if (term_is_atom(target)) {
+        local_process_id = globalcontext_get_registered_process(glb, term_to_atom_index(target));
+    } else {
+        return NULL;
+    }
+
+    return local_process_id ? globalcontext_get_process(glb, local_process_id) : NULL;
+}
+
+static void dist_connection_handle_message(struct DistConnection *connection, const uint8_t *buf, size_t size)
+{
+    struct Dist *dist = connection->dist;
+    GlobalContext *glb = dist->ctx->global;
+
+    struct ExternalTermAtomRefs refs;
+    const struct ExternalTermAtomRefs *refs_ptr;
+    size_t pos;
+    if ((size >= 2) && (buf[0] == PASS_THROUGH) && (buf[1] == VERSION_MAGIC)) {
+        refs_ptr = NULL;
+        pos = 2;
+    } else if ((size >= 3) && (buf[0] == VERSION_MAGIC) && (buf[1] == DIST_HEADER)) {
+        int header_size = dist_parse_header(connection, buf, size, &refs);
+        if (header_size < 0) {
+            TRACE("dist: dropping a message with an invalid header.\n");
+            return;
+        }
+        refs_ptr = &refs;
+        pos = header_size;
+    } else {
+        TRACE("dist: dropping an unknown message.\n");
+        return;
+    }
+
+    // control messages are decoded on the port heap, they are garbage as soon as they have been handled
+    size_t control_size;
+    term control = externalterm_decode(buf + pos, size - pos, &control_size, refs_ptr, dist->ctx);
+    if (term_is_invalid_term(control) || !term_is_tuple(control) || (term_get_tuple_arity(control) < 1)
+            || !term_is_integer(term_get_tuple_element(control, 0))) {
+        TRACE("dist: dropping an invalid control message.\n");
+        return;
+    }
+    pos += control_size;
+    int arity = term_get_tuple_arity(control);
+
+    term to;
+    switch (term_to_int32(term_get_tuple_element(control, 0))) {
+        case DOP_SEND:
+        case DOP_SEND_TT:
+        case DOP_SEND_SENDER:
+        case DOP_SEND_SENDER_TT:
+            if (arity < 3) {
+                return;
+            }
+            to = term_get_tuple_element(control, 2);
+            break;
+
+        case DOP_REG_SEND:
+        case DOP_REG_SEND_TT:
+            if (arity < 4) {
+                return;
+            }
+            to = term_get_tuple_element(control, 3);
+            break;
+
+        case DOP_LINK: {
+            // links to remote processes are not supported, only missing processes are reported
+            if ((arity != 3) || dist_find_target(glb, term_get_tuple_element(control, 2))) {
+                return;
+            }
+            term reply[4];
+            reply[0] = term_from_int32(DOP_EXIT);
+            reply[1] = term_get_tuple_element(control, 2);
+            reply[2] = term_get_tuple_element(control, 1);
+            reply[3] = context_make_atom(dist->ctx, noproc_atom);
+            dist_connection_send(connection, reply, 4, term_invalid_term());
+            return;
+        }
+
+        case DOP_MONITOR_P: {
+            // remote monitors are not supported, only missing processes are reported
+            if ((arity != 4) || dist_find_target(glb, term_get_tuple_element(control, 2))) {
+                return;
+            }
+            term reply[5];
+            reply[0] = term_from_int32(DOP_MONITOR_P_EXIT);
+            reply[1] = term_get_tuple_element(control, 2);
+            reply[2] = term_get_tuple_element(control, 1);
+            reply[3] = term_get_tuple_element(control, 3);
+            reply[4] = context_make_atom(dist->ctx, noproc_atom);
+            dist_connection_send(connection, reply, 5, term_invalid_term());
+            return;
+        }
+
+        default:
+            TRACE("dist: ignoring control message %i.\n", (int) term_to_int32(term_get_tuple_element(control, 0)));
+            return;
+    }
+
+    Context *target = dist_find_target(glb, to);
+    if (!target) {
+        TRACE("dist: dropping a message to a missing process.\n");
+        return;
+    }
+    if (!refs_ptr) {
+        if ((pos >= size) || (buf[pos] != VERSION_MAGIC)) {
+            return;
+        }
+        pos++;
+    }
+
+    // the message is decoded to a new message, so the target heap is not touched
+    Message *m = mailbox_message_decode(glb, buf + pos, size - pos, NULL, refs_ptr);
+    if (IS_NULL_PTR(m)) {
+        TRACE("dist: dropping a message that cannot be decoded.\n");
+        return;
+    }
+    mailbox_enqueue_message(target, m);
+}
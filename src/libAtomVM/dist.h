@@ -0,0 +1,282 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file dist.h
+ * @brief Erlang distribution.
+ *
+ * @details The dist port makes an instance an Erlang node: it performs the distribution handshake with other nodes
+ *          (either AtomVM or BEAM ones), and exchanges messages encoded with external term format, so pids and
+ *          {Name, Node} destinations work across nodes. There is no EPMD, node addresses are given by a static port
+ *          map when the port is opened:
+ *
+ *          open_port({spawn, "dist"}, [{name, 'a@localhost'}, {port, 9100}, {cookie, 'secret'},
+ *                                      {nodes, [{'b@localhost', 9101}, {'c@host', {{10, 0, 0, 2}, 9100}}]}])
+ *
+ *          Remote processes are represented by local proxy processes, that forward every message they receive to the
+ *          remote process. Messages are encoded into per connection buffers, that are flushed once the scheduler has
+ *          nothing else to run, so messages sent in a row share the same write. Sockets are managed by a platform
+ *          specific dist driver, see dist_driver.h.
+ */
+
+#ifndef _DIST_H_
+#define _DIST_H_
+
+#include "globalcontext.h"
+#include "list.h"
+#include "sys.h"
+#include "term.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DIST_ATOM_CACHE_SIZE 2048
+
+struct DistPid
+{
+    term node;
+    uint32_t id;
+    uint32_t serial;
+    uint32_t creation;
+};
+
+struct DistNodeAddress
+{
+    term node;
+    uint32_t address;
+    uint16_t port;
+};
+
+enum DistConnectionState
+{
+    // initiator: name has been sent, waiting for the status
+    DistConnectionAwaitStatus,
+    // initiator: waiting for the challenge
+    DistConnectionAwaitChallenge,
+    // initiator: challenge reply has been sent, waiting for the ack
+    DistConnectionAwaitAck,
+    // acceptor: waiting for the name
+    DistConnectionAwaitName,
+    // acceptor: challenge has been sent, waiting for the reply (and maybe a complement before it)
+    DistConnectionAwaitReply,
+    DistConnectionConnected
+};
+
+struct Dist;
+
+struct DistConnection
+{
+    struct ListHead connections_list_head;
+    struct Dist *dist;
+
+    enum DistConnectionState state;
+    // set when the connection should be closed, it is closed by the dist port outside of any event handler
+    unsigned int closing : 1;
+    // set when a pending initiated connection lost a simultaneous connect
+    unsigned int superseded : 1;
+
+    // peer node, it is an invalid term until the acceptor receives the name
+    term node;
+    uint32_t creation;
+    uint64_t flags;
+    uint32_t challenge;
+
+    uint8_t *in_buf;
+    size_t in_len;
+    size_t in_capacity;
+
+    // encoded frames that have not been written yet, handshake frames come first
+    uint8_t *out_buf;
+    size_t out_len;
+    size_t out_capacity;
+    size_t out_handshake_len;
+
+    // atoms by cache index, allocated once connected if the peer supports the atom cache
+    term *in_atom_cache;
+    term *out_atom_cache;
+
+    // ticks without any received data, and whether anything has been sent since last tick
+    int silent_ticks;
+    int sent_since_tick;
+
+    void *driver_data;
+};
+
+struct DistProxy
+{
+    struct ListHead proxies_list_head;
+    struct DistPid pid;
+    Context *ctx;
+};
+
+struct Dist
+{
+    Context *ctx;
+    term node;
+    uint32_t creation;
+    char *cookie;
+
+    struct DistNodeAddress *port_map;
+    int port_map_len;
+
+    struct ListHead connections;
+    struct ListHead proxies;
+    // (node atom index, id) hash -> DistProxy *, collisions are resolved walking proxies list
+    struct ValuesHashTable *proxies_table;
+
+    uint64_t random_state;
+    EventListener timer;
+    int service_requested;
+
+    void *driver_data;
+};
+
+/**
+ * @brief Initializes the dist port.
+ *
+ * @details Called when a "dist" port is opened: parses options, starts listening and makes the instance a node.
+ * @param ctx the port context.
+ * @param opts the port options.
+ * @returns 1 on success, 0 if the options are not valid, the instance is already a node or the port cannot listen.
+ */
+int dist_init(Context *ctx, term opts);
+
+/**
+ * @brief Checks if the instance is a node.
+ *
+ * @param glb the global context.
+ * @returns 1 if the dist port has been opened, 0 otherwise.
+ */
+static inline int dist_is_alive(GlobalContext *glb)
+{
+    return glb->dist != NULL;
+}
+
+/**
+ * @brief Gets the local node name and creation.
+ *
+ * @param glb the global context.
+ * @param node will be set to the node name atom.
+ * @param creation will be set to the node creation.
+ * @returns 1 if the instance is a node, 0 otherwise.
+ */
+int dist_local_node(GlobalContext *glb, term *node, uint32_t *creation);
+
+/**
+ * @brief Gets the node name of a pid.
+ *
+ * @param glb the global context.
+ * @param pid a local pid, that might be a proxy of a remote one.
+ * @returns the node name atom, nonode@nohost for local pids when the instance is not a node.
+ */
+term dist_pid_node(GlobalContext *glb, term pid);
+
+/**
+ * @brief Converts a pid to its external representation.
+ *
+ * @details Proxies are converted to the remote pid they stand for.
+ * @param glb the global context.
+ * @param pid a local pid.
+ * @param external_pid will be set to the external pid.
+ * @returns 1 on success, 0 if the instance is not a node.
+ */
+int dist_pid_to_external(GlobalContext *glb, term pid, struct DistPid *external_pid);
+
+/**
+ * @brief Converts an external pid to a local pid.
+ *
+ * @details Local node pids are converted to local pids, pids of a previous incarnation of the local node are
+ *          converted to a pid that is never alive, other pids are converted to proxies that are created on demand.
+ * @param glb the global context, the instance must be a node.
+ * @param external_pid the external pid.
+ * @returns a local pid.
+ */
+term dist_pid_from_external(GlobalContext *glb, const struct DistPid *external_pid);
+
+/**
+ * @brief Checks if a send destination is a {Name, Node} tuple.
+ *
+ * @param destination the destination.
+ * @returns 1 if destination is a tuple of 2 elements whose second element is an atom, 0 otherwise.
+ */
+static inline int dist_is_node_destination(term destination)
+{
+    return term_is_tuple(destination) && (term_get_tuple_arity(destination) == 2)
+        && term_is_atom(term_get_tuple_element(destination, 1));
+}
+
+/**
+ * @brief Sends a message to a process registered on a node.
+ *
+ * @details A connection is started if there is none, messages to unknown nodes and to missing processes are dropped.
+ *          The local node is a valid destination, also when the instance is not a node.
+ * @param ctx the sender.
+ * @param destination a {Name, Node} tuple.
+ * @param message the message.
+ * @returns 1 on success, 0 if name is not an atom or the message cannot be encoded.
+ */
+int dist_send_registered(Context *ctx, term destination, term message);
+
+/**
+ * @brief Gets connected nodes.
+ *
+ * @details Builds a list of connected node names, that is allocated on ctx heap.
+ * @param ctx the context that owns the memory that will be allocated.
+ * @returns a list of atoms.
+ */
+term dist_connected_nodes(Context *ctx);
+
+/**
+ * @brief Gets the size of connected nodes list.
+ *
+ * @param glb the global context.
+ * @returns the memory in terms required by dist_connected_nodes.
+ */
+int dist_connected_nodes_size(GlobalContext *glb);
+
+/**
+ * @brief Creates a connection for an accepted socket.
+ *
+ * @details Called by the dist driver.
+ * @param dist the dist.
+ * @param driver_data driver data of the connection.
+ * @returns the new connection, or NULL if memory could not be allocated.
+ */
+struct DistConnection *dist_connection_accepted(struct Dist *dist, void *driver_data);
+
+/**
+ * @brief Handles data received from a connection.
+ *
+ * @details Called by the dist driver from an event handler.
+ * @param connection the connection.
+ * @param data received bytes.
+ * @param len received bytes count.
+ */
+void dist_connection_received(struct DistConnection *connection, const uint8_t *data, size_t len);
+
+/**
+ * @brief Handles a connection that has been closed by the peer.
+ *
+ * @details Called by the dist driver from an event handler, the connection is destroyed later by the dist port.
+ *          The driver should not report any other event for this connection.
+ * @param connection the connection.
+ */
+void dist_connection_lost(struct DistConnection *connection);
+
+#endif
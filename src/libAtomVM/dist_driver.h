@@ -0,0 +1,81 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file dist_driver.h
+ * @brief Platform specific sockets used by Erlang distribution.
+ *
+ * @details Each platform implements these functions, they are called by dist.c. Sockets must not block once they
+ *          are connected: received data is reported with dist_connection_received from an event handler.
+ */
+
+#ifndef _DIST_DRIVER_H_
+#define _DIST_DRIVER_H_
+
+#include "dist.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Starts listening for connections.
+ *
+ * @details Accepted connections are reported with dist_connection_accepted.
+ * @param dist the dist, driver_data will be set.
+ * @param port the TCP port.
+ * @returns 1 on success, 0 otherwise.
+ */
+int dist_driver_listen(struct Dist *dist, uint16_t port);
+
+/**
+ * @brief Stops listening for connections.
+ *
+ * @param dist the dist.
+ */
+void dist_driver_stop(struct Dist *dist);
+
+/**
+ * @brief Connects to a node.
+ *
+ * @param connection the connection, driver_data will be set.
+ * @param address the IPv4 address in host byte order.
+ * @param port the TCP port.
+ * @returns 1 on success, 0 otherwise.
+ */
+int dist_driver_connect(struct DistConnection *connection, uint32_t address, uint16_t port);
+
+/**
+ * @brief Writes data to a connection.
+ *
+ * @param connection the connection.
+ * @param data the data that will be written.
+ * @param len data length.
+ * @returns the number of bytes that have been written, that might be less than len, or -1 on error.
+ */
+int dist_driver_send(struct DistConnection *connection, const uint8_t *data, size_t len);
+
+/**
+ * @brief Closes a connection.
+ *
+ * @details Releases driver_data, no event will be reported for this connection after this call.
+ * @param connection the connection.
+ */
+void dist_driver_close(struct DistConnection *connection);
+
+#endif
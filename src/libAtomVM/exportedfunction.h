@@ -44,7 +44,9 @@ enum FunctionType
     InvalidFunctionType = 0,
     NIFFunctionType = 2,
     UnresolvedFunctionCall = 3,
-    ModuleFunction = 4
+    ModuleFunction = 4,
+    // a NIF that replaces the process continuation instead of returning a value (erlang:hibernate/3)
+    HibernateNIFFunctionType = 5
 };
 
 struct ExportedFunction
@@ -19,28 +19,49 @@
 
 #include "externalterm.h"
 
+#include "atomshashtable.h"
 #include "context.h"
+#include "dist.h"
 
+#include <limits.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "utils.h"
 
 #define EXTERNAL_TERM_TAG 131
+#define NEW_PID_EXT 88
+#define NEWER_REFERENCE_EXT 90
+#define ATOM_CACHE_REF 82
 #define SMALL_INTEGER_EXT 97
 #define INTEGER_EXT 98
 #define ATOM_EXT 100
+#define PID_EXT 103
 #define SMALL_TUPLE_EXT 104
+#define LARGE_TUPLE_EXT 105
 #define NIL_EXT 106
 #define STRING_EXT 107
 #define LIST_EXT 108
 #define BINARY_EXT 109
+#define SMALL_BIG_EXT 110
+#define NEW_REFERENCE_EXT 114
+#define SMALL_ATOM_EXT 115
+#define ATOM_UTF8_EXT 118
+#define SMALL_ATOM_UTF8_EXT 119
 
-static term parse_external_terms(const uint8_t *external_term_buf, int *eterm_size, Context *ctx);
-static int calculate_heap_usage(const uint8_t *external_term_buf, int *eterm_size, Context *ctx);
+// nesting is handled with recursion, so it is limited when decoding untrusted data
+#define MAX_NESTING_DEPTH 1024
 
-term externalterm_to_term(const void *external_term, Context *ctx)
+// local refs are encoded with the 18 bits first id used by BEAM
+#define REF_FIRST_ID_BITS 18
+
+static term parse_external_terms(const uint8_t *external_term_buf, int *eterm_size, Context *ctx, int copy, const struct ExternalTermAtomRefs *refs);
+static int calculate_heap_usage(const uint8_t *external_term_buf, size_t buf_size, int *eterm_size, const struct ExternalTermAtomRefs *refs, GlobalContext *glb, int depth);
+static int serialize_term(uint8_t *buf, term t, GlobalContext *glb, struct ExternalTermAtomRefs *refs);
+
+term externalterm_to_term(const void *external_term, Context *ctx, int copy)
 {
     const uint8_t *external_term_buf = (const uint8_t *) external_term;
 
@@ -50,13 +71,358 @@ term externalterm_to_term(const void *external_term, Context *ctx)
     }
 
     int eterm_size;
-    int heap_usage = calculate_heap_usage(external_term_buf + 1, &eterm_size, ctx);
+    int heap_usage = calculate_heap_usage(external_term_buf + 1, SIZE_MAX, &eterm_size, NULL, ctx->global, 0);
+    if (UNLIKELY(heap_usage < 0)) {
+        fprintf(stderr, "Unsupported external term.\n");
+        abort();
+    }
+    memory_ensure_free(ctx, heap_usage);
+
+    return parse_external_terms(external_term_buf + 1, &eterm_size, ctx, copy, NULL);
+}
+
+term externalterm_decode(const uint8_t *buf, size_t size, size_t *bytes_read, const struct ExternalTermAtomRefs *refs, Context *ctx)
+{
+    int eterm_size;
+    int heap_usage = calculate_heap_usage(buf, size, &eterm_size, refs, ctx->global, 0);
+    if (heap_usage < 0) {
+        return term_invalid_term();
+    }
     memory_ensure_free(ctx, heap_usage);
 
-    return parse_external_terms(external_term_buf + 1, &eterm_size, ctx);
+    term t = parse_external_terms(buf, &eterm_size, ctx, 1, refs);
+    if (bytes_read) {
+        *bytes_read = eterm_size;
+    }
+
+    return t;
+}
+
+int externalterm_decoded_size(const uint8_t *buf, size_t size, const struct ExternalTermAtomRefs *refs, GlobalContext *glb)
+{
+    int eterm_size;
+    return calculate_heap_usage(buf, size, &eterm_size, refs, glb, 0);
+}
+
+term externalterm_decode_to_heap(const uint8_t *buf, size_t *bytes_read, const struct ExternalTermAtomRefs *refs, GlobalContext *glb, term **heap, int heap_size)
+{
+    // terms are allocated from a context that owns only the destination buffer, that fits the whole term so it is
+    // never garbage collected
+    Context heap_ctx;
+    memset(&heap_ctx, 0, sizeof(Context));
+    heap_ctx.global = glb;
+    heap_ctx.heap_start = *heap;
+    heap_ctx.heap_ptr = *heap;
+    heap_ctx.e = *heap + heap_size;
+    heap_ctx.stack_base = *heap + heap_size;
+#ifdef AVM_SEPARATE_STACK
+    heap_ctx.heap_end = *heap + heap_size;
+#endif
+
+    int eterm_size;
+    term t = parse_external_terms(buf, &eterm_size, &heap_ctx, 1, refs);
+    *heap = heap_ctx.heap_ptr;
+    if (bytes_read) {
+        *bytes_read = eterm_size;
+    }
+
+    return t;
+}
+
+int externalterm_compute_external_size(term t, GlobalContext *glb)
+{
+    int size = serialize_term(NULL, t, glb, NULL);
+    if (size < 0) {
+        return -1;
+    }
+
+    return size + 1;
+}
+
+void externalterm_serialize_term(uint8_t *buf, term t, GlobalContext *glb)
+{
+    buf[0] = EXTERNAL_TERM_TAG;
+    serialize_term(buf + 1, t, glb, NULL);
+}
+
+int externalterm_encoded_size(term t, GlobalContext *glb, struct ExternalTermAtomRefs *refs)
+{
+    return serialize_term(NULL, t, glb, refs);
+}
+
+void externalterm_encode(uint8_t *buf, term t, GlobalContext *glb, struct ExternalTermAtomRefs *refs)
+{
+    serialize_term(buf, t, glb, refs);
+}
+
+static int atom_index_from_external_atom(const uint8_t *atom_data, int atom_len, GlobalContext *glb, int copy)
+{
+    // external atoms are always preceded by their length, whose low byte is the AtomString length
+    AtomString atom_string = (AtomString) (atom_data - 1);
+    if (copy) {
+        unsigned long atom_index = atomshashtable_get_value(glb->atoms_table, atom_string, ULONG_MAX);
+        if (atom_index != ULONG_MAX) {
+            return atom_index;
+        }
+
+        char *atom_copy = malloc(atom_len + 1);
+        if (IS_NULL_PTR(atom_copy)) {
+            fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+            abort();
+        }
+        memcpy(atom_copy, atom_string, atom_len + 1);
+        atom_string = atom_copy;
+    }
+
+    return globalcontext_insert_atom(glb, atom_string);
+}
+
+static inline void write_16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = value >> 8;
+    buf[1] = value;
+}
+
+static inline void write_32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = value >> 24;
+    buf[1] = value >> 16;
+    buf[2] = value >> 8;
+    buf[3] = value;
+}
+
+static int serialize_atom(uint8_t *buf, term t, GlobalContext *glb, struct ExternalTermAtomRefs *refs)
+{
+    if (refs) {
+        // atoms are collected while computing the size, and they are found again while serializing
+        for (int i = 0; i < refs->count; i++) {
+            if (refs->atoms[i] == t) {
+                if (buf) {
+                    buf[0] = ATOM_CACHE_REF;
+                    buf[1] = i;
+                }
+                return 2;
+            }
+        }
+        if (!buf && (refs->count < EXTERNALTERM_MAX_ATOM_REFS)) {
+            refs->atoms[refs->count] = t;
+            refs->count++;
+            return 2;
+        }
+    }
+
+    AtomString atom_string = globalcontext_atomstring_from_term(glb, t);
+    int atom_len = atom_string_len(atom_string);
+    if (buf) {
+        buf[0] = ATOM_EXT;
+        write_16(buf + 1, atom_len);
+        memcpy(buf + 3, atom_string_data(atom_string), atom_len);
+    }
+    return 3 + atom_len;
+}
+
+// when buf is NULL only the size is computed, so both passes share the same code
+static int serialize_term(uint8_t *buf, term t, GlobalContext *glb, struct ExternalTermAtomRefs *refs)
+{
+    if (term_is_integer(t)) {
+        int64_t value = term_to_int64(t);
+        if ((value >= 0) && (value <= 255)) {
+            if (buf) {
+                buf[0] = SMALL_INTEGER_EXT;
+                buf[1] = value;
+            }
+            return 2;
+
+        } else if ((value >= INT32_MIN) && (value <= INT32_MAX)) {
+            if (buf) {
+                buf[0] = INTEGER_EXT;
+                write_32(buf + 1, value);
+            }
+            return 5;
+        }
+
+        // SMALL_BIG_EXT has a sign byte followed by the little endian magnitude
+        uint64_t magnitude = (value < 0) ? -((uint64_t) value) : (uint64_t) value;
+        int digits = 0;
+        for (uint64_t m = magnitude; m; m >>= 8) {
+            if (buf) {
+                buf[3 + digits] = m & 0xFF;
+            }
+            digits++;
+        }
+        if (buf) {
+            buf[0] = SMALL_BIG_EXT;
+            buf[1] = digits;
+            buf[2] = value < 0;
+        }
+        return 3 + digits;
+
+    } else if (term_is_atom(t)) {
+        return serialize_atom(buf, t, glb, refs);
+
+    } else if (term_is_nil(t)) {
+        if (buf) {
+            buf[0] = NIL_EXT;
+        }
+        return 1;
+
+    } else if (term_is_pid(t)) {
+        struct DistPid external_pid;
+        if (!dist_pid_to_external(glb, t, &external_pid)) {
+            return -1;
+        }
+        if (buf) {
+            buf[0] = NEW_PID_EXT;
+        }
+        int node_size = serialize_atom(buf ? buf + 1 : NULL, external_pid.node, glb, refs);
+        if (buf) {
+            write_32(buf + 1 + node_size, external_pid.id);
+            write_32(buf + 5 + node_size, external_pid.serial);
+            write_32(buf + 9 + node_size, external_pid.creation);
+        }
+        return 13 + node_size;
+
+    } else if (term_is_reference(t)) {
+        term node;
+        uint32_t creation;
+        uint32_t ids[TERM_EXTERNAL_REF_MAX_IDS];
+        int ids_count;
+        if (term_is_external_reference(t)) {
+            node = term_get_external_ref_node(t, &creation);
+            ids_count = term_get_external_ref_ids(t, ids);
+        } else {
+            if (!dist_local_node(glb, &node, &creation)) {
+                return -1;
+            }
+            uint64_t ref_ticks = term_to_ref_ticks(t);
+            ids[0] = ref_ticks & ((1 << REF_FIRST_ID_BITS) - 1);
+            ids[1] = (ref_ticks >> REF_FIRST_ID_BITS) & 0xFFFFFFFF;
+            ids[2] = ref_ticks >> (REF_FIRST_ID_BITS + 32);
+            ids_count = 3;
+        }
+        if (buf) {
+            buf[0] = NEWER_REFERENCE_EXT;
+            write_16(buf + 1, ids_count);
+        }
+        int node_size = serialize_atom(buf ? buf + 3 : NULL, node, glb, refs);
+        if (buf) {
+            write_32(buf + 3 + node_size, creation);
+            for (int i = 0; i < ids_count; i++) {
+                write_32(buf + 7 + node_size + i * 4, ids[i]);
+            }
+        }
+        return 7 + node_size + ids_count * 4;
+
+    } else if (term_is_tuple(t)) {
+        int arity = term_get_tuple_arity(t);
+        int buf_pos;
+        if (arity <= 255) {
+            if (buf) {
+                buf[0] = SMALL_TUPLE_EXT;
+                buf[1] = arity;
+            }
+            buf_pos = 2;
+        } else {
+            if (buf) {
+                buf[0] = LARGE_TUPLE_EXT;
+                write_32(buf + 1, arity);
+            }
+            buf_pos = 5;
+        }
+
+        for (int i = 0; i < arity; i++) {
+            int element_size = serialize_term(buf ? buf + buf_pos : NULL, term_get_tuple_element(t, i), glb, refs);
+            if (element_size < 0) {
+                return -1;
+            }
+            buf_pos += element_size;
+        }
+
+        return buf_pos;
+
+    } else if (term_is_nonempty_list(t)) {
+        uint32_t list_len = 0;
+        int is_string = 1;
+        term tail = t;
+        while (term_is_nonempty_list(tail)) {
+            term head = term_get_list_head(tail);
+            if (!term_is_integer(head) || (term_to_int64(head) < 0) || (term_to_int64(head) > 255)) {
+                is_string = 0;
+            }
+            list_len++;
+            tail = term_get_list_tail(tail);
+        }
+
+        if (is_string && term_is_nil(tail) && (list_len <= UINT16_MAX)) {
+            if (buf) {
+                buf[0] = STRING_EXT;
+                write_16(buf + 1, list_len);
+                int buf_pos = 3;
+                for (term l = t; !term_is_nil(l); l = term_get_list_tail(l)) {
+                    buf[buf_pos++] = term_to_int32(term_get_list_head(l));
+                }
+            }
+            return 3 + list_len;
+        }
+
+        if (buf) {
+            buf[0] = LIST_EXT;
+            write_32(buf + 1, list_len);
+        }
+
+        int buf_pos = 5;
+        term l = t;
+        for (; term_is_nonempty_list(l); l = term_get_list_tail(l)) {
+            int item_size = serialize_term(buf ? buf + buf_pos : NULL, term_get_list_head(l), glb, refs);
+            if (item_size < 0) {
+                return -1;
+            }
+            buf_pos += item_size;
+        }
+        int tail_size = serialize_term(buf ? buf + buf_pos : NULL, l, glb, refs);
+        if (tail_size < 0) {
+            return -1;
+        }
+
+        return buf_pos + tail_size;
+
+    } else if (term_is_binary(t)) {
+        uint32_t binary_size = term_binary_size(t);
+        if (buf) {
+            buf[0] = BINARY_EXT;
+            write_32(buf + 1, binary_size);
+            memcpy(buf + 5, term_binary_data(t), binary_size);
+        }
+        return 5 + binary_size;
+
+    } else {
+        return -1;
+    }
+}
+
+// atom tags differ only in the size of their length, that always precedes the atom text
+static inline int external_atom_length_size(uint8_t tag)
+{
+    return ((tag == SMALL_ATOM_EXT) || (tag == SMALL_ATOM_UTF8_EXT)) ? 1 : 2;
 }
 
-static term parse_external_terms(const uint8_t *external_term_buf, int *eterm_size, Context *ctx)
+static term parse_atom(const uint8_t *external_term_buf, int *eterm_size, Context *ctx, int copy, const struct ExternalTermAtomRefs *refs)
+{
+    if (external_term_buf[0] == ATOM_CACHE_REF) {
+        *eterm_size = 2;
+        return refs->atoms[external_term_buf[1]];
+    }
+
+    int length_size = external_atom_length_size(external_term_buf[0]);
+    uint16_t atom_len = (length_size == 1) ? external_term_buf[1] : READ_16_UNALIGNED(external_term_buf + 1);
+
+    int global_atom_id = atom_index_from_external_atom(external_term_buf + 1 + length_size, atom_len, ctx->global, copy);
+
+    *eterm_size = 1 + length_size + atom_len;
+    return term_from_atom_index(global_atom_id);
+}
+
+static term parse_external_terms(const uint8_t *external_term_buf, int *eterm_size, Context *ctx, int copy, const struct ExternalTermAtomRefs *refs)
 {
     switch (external_term_buf[0]) {
         case SMALL_INTEGER_EXT: {
@@ -71,24 +437,85 @@ static term parse_external_terms(const uint8_t *external_term_buf, int *eterm_si
             return term_from_int32(value);
         }
 
-        case ATOM_EXT: {
-            uint16_t atom_len = READ_16_UNALIGNED(external_term_buf + 1);
+        case SMALL_BIG_EXT: {
+            int digits = external_term_buf[1];
+            uint64_t magnitude = 0;
+            for (int i = digits - 1; i >= 0; i--) {
+                magnitude = (magnitude << 8) | external_term_buf[3 + i];
+            }
 
-            int global_atom_id = globalcontext_insert_atom(ctx->global, (AtomString) (external_term_buf + 2));
+            *eterm_size = 3 + digits;
+            return term_from_int64(external_term_buf[2] ? -((int64_t) magnitude) : (int64_t) magnitude);
+        }
 
-            *eterm_size = 3 + atom_len;
-            return term_from_atom_index(global_atom_id);
+        case ATOM_CACHE_REF:
+        case ATOM_EXT:
+        case SMALL_ATOM_EXT:
+        case ATOM_UTF8_EXT:
+        case SMALL_ATOM_UTF8_EXT: {
+            return parse_atom(external_term_buf, eterm_size, ctx, copy, refs);
         }
 
-        case SMALL_TUPLE_EXT: {
-            uint8_t arity = external_term_buf[1];
-            term tuple = term_alloc_tuple(arity, ctx);
+        case PID_EXT:
+        case NEW_PID_EXT: {
+            struct DistPid external_pid;
+            int node_size;
+            external_pid.node = parse_atom(external_term_buf + 1, &node_size, ctx, copy, refs);
+            external_pid.id = READ_32_UNALIGNED(external_term_buf + 1 + node_size);
+            external_pid.serial = READ_32_UNALIGNED(external_term_buf + 5 + node_size);
+            if (external_term_buf[0] == PID_EXT) {
+                external_pid.creation = external_term_buf[9 + node_size];
+                *eterm_size = 10 + node_size;
+            } else {
+                external_pid.creation = READ_32_UNALIGNED(external_term_buf + 9 + node_size);
+                *eterm_size = 13 + node_size;
+            }
+
+            return dist_pid_from_external(ctx->global, &external_pid);
+        }
 
-            int buf_pos = 2;
+        case NEW_REFERENCE_EXT:
+        case NEWER_REFERENCE_EXT: {
+            uint16_t ids_count = READ_16_UNALIGNED(external_term_buf + 1);
+            int node_size;
+            term node = parse_atom(external_term_buf + 3, &node_size, ctx, copy, refs);
+            int creation_size = (external_term_buf[0] == NEW_REFERENCE_EXT) ? 1 : 4;
+            uint32_t creation = (creation_size == 1) ? external_term_buf[3 + node_size] : READ_32_UNALIGNED(external_term_buf + 3 + node_size);
+
+            uint32_t ids[TERM_EXTERNAL_REF_MAX_IDS];
+            const uint8_t *ids_buf = external_term_buf + 3 + node_size + creation_size;
+            for (int i = 0; i < ids_count; i++) {
+                ids[i] = READ_32_UNALIGNED(ids_buf + i * 4);
+            }
+            *eterm_size = 3 + node_size + creation_size + ids_count * 4;
+
+            term local_node;
+            uint32_t local_creation;
+            if ((ids_count == 3) && dist_local_node(ctx->global, &local_node, &local_creation)
+                    && (node == local_node) && (creation == local_creation)) {
+                uint64_t ref_ticks = ((uint64_t) ids[2] << (REF_FIRST_ID_BITS + 32)) | ((uint64_t) ids[1] << REF_FIRST_ID_BITS) | ids[0];
+                return term_from_ref_ticks(ref_ticks, ctx);
+            }
 
-            for (int i = 0; i < arity; i++) {
+            return term_from_external_ref(node, creation, ids, ids_count, ctx);
+        }
+
+        case SMALL_TUPLE_EXT:
+        case LARGE_TUPLE_EXT: {
+            int buf_pos;
+            uint32_t arity;
+            if (external_term_buf[0] == SMALL_TUPLE_EXT) {
+                arity = external_term_buf[1];
+                buf_pos = 2;
+            } else {
+                arity = READ_32_UNALIGNED(external_term_buf + 1);
+                buf_pos = 5;
+            }
+            term tuple = term_alloc_tuple(arity, ctx);
+
+            for (uint32_t i = 0; i < arity; i++) {
                 int element_size;
-                term put_value = parse_external_terms(external_term_buf + buf_pos, &element_size, ctx);
+                term put_value = parse_external_terms(external_term_buf + buf_pos, &element_size, ctx, copy, refs);
                 term_put_tuple_element(tuple, i, put_value);
 
                 buf_pos += element_size;
@@ -119,7 +546,7 @@ static term parse_external_terms(const uint8_t *external_term_buf, int *eterm_si
 
             for (unsigned int i = 0; i < list_len; i++) {
                 int item_size;
-                term head = parse_external_terms(external_term_buf + buf_pos, &item_size, ctx);
+                term head = parse_external_terms(external_term_buf + buf_pos, &item_size, ctx, copy, refs);
 
                 term *new_list_item = term_list_alloc(ctx);
 
@@ -135,20 +562,17 @@ static term parse_external_terms(const uint8_t *external_term_buf, int *eterm_si
                 buf_pos += item_size;
             }
 
+            int tail_size;
+            term tail = parse_external_terms(external_term_buf + buf_pos, &tail_size, ctx, copy, refs);
             if (prev_term) {
-                int tail_size;
-                term tail = parse_external_terms(external_term_buf + buf_pos, &tail_size, ctx);
-                if (tail != term_nil()) {
-                    //TODO: add support for imporper lists
-                    abort();
-                }
-
-                prev_term[0] = term_nil();
-                buf_pos += tail_size;
+                prev_term[0] = tail;
+            } else {
+                list_begin = tail;
             }
+            buf_pos += tail_size;
 
-             *eterm_size = buf_pos;
-             return list_begin;
+            *eterm_size = buf_pos;
+            return list_begin;
         }
 
         case BINARY_EXT: {
@@ -163,34 +587,153 @@ static term parse_external_terms(const uint8_t *external_term_buf, int *eterm_si
     }
 }
 
-static int calculate_heap_usage(const uint8_t *external_term_buf, int *eterm_size, Context *ctx)
+// returns the size of an atom, or -1 if it is truncated or it cannot be an AtomString
+static int calculate_atom_size(const uint8_t *external_term_buf, size_t buf_size, const struct ExternalTermAtomRefs *refs)
+{
+    if (buf_size < 2) {
+        return -1;
+    }
+
+    switch (external_term_buf[0]) {
+        case ATOM_CACHE_REF:
+            return (refs && (external_term_buf[1] < refs->count)) ? 2 : -1;
+
+        case ATOM_EXT:
+        case SMALL_ATOM_EXT:
+        case ATOM_UTF8_EXT:
+        case SMALL_ATOM_UTF8_EXT: {
+            int length_size = external_atom_length_size(external_term_buf[0]);
+            if (buf_size < (size_t) (1 + length_size)) {
+                return -1;
+            }
+            uint16_t atom_len = (length_size == 1) ? external_term_buf[1] : READ_16_UNALIGNED(external_term_buf + 1);
+            if ((atom_len > 255) || (buf_size < (size_t) (1 + length_size + atom_len))) {
+                return -1;
+            }
+            return 1 + length_size + atom_len;
+        }
+
+        default:
+            return -1;
+    }
+}
+
+// checks that the external term is complete and supported, returns the heap usage or -1
+static int calculate_heap_usage(const uint8_t *external_term_buf, size_t buf_size, int *eterm_size, const struct ExternalTermAtomRefs *refs, GlobalContext *glb, int depth)
 {
+    if ((buf_size < 1) || (depth > MAX_NESTING_DEPTH)) {
+        return -1;
+    }
+
     switch (external_term_buf[0]) {
         case SMALL_INTEGER_EXT: {
+            if (buf_size < 2) {
+                return -1;
+            }
             *eterm_size = 2;
             return 0;
         }
 
         case INTEGER_EXT: {
+            if (buf_size < 5) {
+                return -1;
+            }
+            int64_t value = (int32_t) READ_32_UNALIGNED(external_term_buf + 1);
+            if ((value > TERM_MAX_SMALL_INT) || (value < TERM_MIN_SMALL_INT)) {
+                return -1;
+            }
             *eterm_size = 5;
             return 0;
         }
 
-        case ATOM_EXT: {
-            uint16_t atom_len = READ_16_UNALIGNED(external_term_buf + 1);
-            *eterm_size = 3 + atom_len;
+        case SMALL_BIG_EXT: {
+            if ((buf_size < 3) || (buf_size < (size_t) (3 + external_term_buf[1]))) {
+                return -1;
+            }
+            int digits = external_term_buf[1];
+            if (digits > 8) {
+                return -1;
+            }
+            uint64_t magnitude = 0;
+            for (int i = digits - 1; i >= 0; i--) {
+                magnitude = (magnitude << 8) | external_term_buf[3 + i];
+            }
+            // only small integers are supported
+            if ((magnitude > (uint64_t) TERM_MAX_SMALL_INT) && !(external_term_buf[2] && (magnitude == (uint64_t) TERM_MAX_SMALL_INT + 1))) {
+                return -1;
+            }
+            *eterm_size = 3 + digits;
             return 0;
         }
 
-        case SMALL_TUPLE_EXT: {
-            uint8_t arity = external_term_buf[1];
+        case ATOM_CACHE_REF:
+        case ATOM_EXT:
+        case SMALL_ATOM_EXT:
+        case ATOM_UTF8_EXT:
+        case SMALL_ATOM_UTF8_EXT: {
+            int atom_size = calculate_atom_size(external_term_buf, buf_size, refs);
+            if (atom_size < 0) {
+                return -1;
+            }
+            *eterm_size = atom_size;
+            return 0;
+        }
 
-            int heap_usage = 1;
-            int buf_pos = 2;
+        case PID_EXT:
+        case NEW_PID_EXT: {
+            int node_size = calculate_atom_size(external_term_buf + 1, buf_size - 1, refs);
+            int pid_size = (external_term_buf[0] == PID_EXT) ? 10 : 13;
+            // pids can be decoded only when this node is alive
+            if ((node_size < 0) || (buf_size < (size_t) (pid_size + node_size)) || !dist_is_alive(glb)) {
+                return -1;
+            }
+            *eterm_size = pid_size + node_size;
+            return 0;
+        }
+
+        case NEW_REFERENCE_EXT:
+        case NEWER_REFERENCE_EXT: {
+            if (buf_size < 3) {
+                return -1;
+            }
+            uint16_t ids_count = READ_16_UNALIGNED(external_term_buf + 1);
+            int node_size = calculate_atom_size(external_term_buf + 3, buf_size - 3, refs);
+            int creation_size = (external_term_buf[0] == NEW_REFERENCE_EXT) ? 1 : 4;
+            if ((ids_count < 1) || (ids_count > TERM_EXTERNAL_REF_MAX_IDS) || (node_size < 0)
+                    || (buf_size < (size_t) (3 + node_size + creation_size + ids_count * 4))) {
+                return -1;
+            }
+            *eterm_size = 3 + node_size + creation_size + ids_count * 4;
+            // refs created by this node are decoded as local refs, that are smaller
+            return term_external_ref_size(ids_count);
+        }
 
-            for (int i = 0; i < arity; i++) {
+        case SMALL_TUPLE_EXT:
+        case LARGE_TUPLE_EXT: {
+            size_t buf_pos;
+            uint32_t arity;
+            if (external_term_buf[0] == SMALL_TUPLE_EXT) {
+                if (buf_size < 2) {
+                    return -1;
+                }
+                arity = external_term_buf[1];
+                buf_pos = 2;
+            } else {
+                if (buf_size < 5) {
+                    return -1;
+                }
+                arity = READ_32_UNALIGNED(external_term_buf + 1);
+                buf_pos = 5;
+            }
+
+            int heap_usage = 1;
+            for (uint32_t i = 0; i < arity; i++) {
                 int element_size;
-                heap_usage += calculate_heap_usage(external_term_buf + buf_pos, &element_size, ctx) + 1;
+                int element_usage = calculate_heap_usage(external_term_buf + buf_pos, buf_size - buf_pos, &element_size, refs, glb, depth + 1);
+                if (element_usage < 0) {
+                    return -1;
+                }
+                heap_usage += element_usage + 1;
 
                 buf_pos += element_size;
             }
@@ -205,26 +748,43 @@ static int calculate_heap_usage(const uint8_t *external_term_buf, int *eterm_siz
         }
 
         case STRING_EXT: {
+            if (buf_size < 3) {
+                return -1;
+            }
             uint16_t string_size = READ_16_UNALIGNED(external_term_buf + 1);
+            if (buf_size < (size_t) (3 + string_size)) {
+                return -1;
+            }
             *eterm_size = 3 + string_size;
             return string_size * 2;
         }
 
         case LIST_EXT: {
+            if (buf_size < 5) {
+                return -1;
+            }
             uint32_t list_len = READ_32_UNALIGNED(external_term_buf + 1);
 
-            int buf_pos = 5;
+            size_t buf_pos = 5;
             int heap_usage = 0;
 
             for (unsigned int i = 0; i < list_len; i++) {
                 int item_size;
-                heap_usage += calculate_heap_usage(external_term_buf + buf_pos, &item_size, ctx) + 2;
+                int item_usage = calculate_heap_usage(external_term_buf + buf_pos, buf_size - buf_pos, &item_size, refs, glb, depth + 1);
+                if (item_usage < 0) {
+                    return -1;
+                }
+                heap_usage += item_usage + 2;
 
                 buf_pos += item_size;
             }
 
             int tail_size;
-            heap_usage += calculate_heap_usage(external_term_buf + buf_pos, &tail_size, ctx);
+            int tail_usage = calculate_heap_usage(external_term_buf + buf_pos, buf_size - buf_pos, &tail_size, refs, glb, depth + 1);
+            if (tail_usage < 0) {
+                return -1;
+            }
+            heap_usage += tail_usage;
             buf_pos += tail_size;
 
             *eterm_size = buf_pos;
@@ -232,22 +792,19 @@ static int calculate_heap_usage(const uint8_t *external_term_buf, int *eterm_siz
         }
 
         case BINARY_EXT: {
+            if (buf_size < 5) {
+                return -1;
+            }
             uint32_t binary_size = READ_32_UNALIGNED(external_term_buf + 1);
+            if ((buf_size - 5 < binary_size) || (binary_size > INT_MAX / 2)) {
+                return -1;
+            }
             *eterm_size = 5 + binary_size;
 
-            #if TERM_BYTES == 4
-                int size_in_terms = ((binary_size + 4 - 1) >> 2);
-            #elif TERM_BYTES == 8
-                int size_in_terms = ((binary_size + 8 - 1) >> 3);
-            #else
-                #error
-            #endif
-
-            return 2 + size_in_terms;
+            return 2 + term_binary_data_size_in_terms(binary_size);
         }
 
         default:
-            fprintf(stderr, "Unknown term type: %i\n", (int) external_term_buf[0]);
-            abort();
+            return -1;
     }
 }
@@ -19,24 +19,129 @@
 
 /**
  * @file externalterm.h
- * @brief External term deserialization functions
+ * @brief External term serialization and deserialization functions
  *
- * @details This header provides external term deserialization functions.
+ * @details This header provides external term serialization and deserialization functions.
  */
 
 #ifndef _EXTERNALTERM_H_
 #define _EXTERNALTERM_H_
 
+#include "globalcontext.h"
 #include "term.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
+#define EXTERNALTERM_MAX_ATOM_REFS 255
+
+/**
+ * @brief Atoms referenced by index from a distribution message.
+ *
+ * @details Distribution messages list the atoms they use in their header, and terms refer to them with
+ *          ATOM_CACHE_REF, see dist.c.
+ */
+struct ExternalTermAtomRefs
+{
+    int count;
+    term atoms[EXTERNALTERM_MAX_ATOM_REFS];
+};
+
 /**
  * @brief Gets a term from external term data.
  *
- * @details Deserialize an external term from external format and returns a term.
+ * @details Deserialize an external term from external format and returns a term. External term data is trusted,
+ *          use externalterm_decode for data that comes from outside of the VM.
  * @param external_term the external term that will be deserialized.
  * @param ctx the context that owns the memory that will be allocated.
+ * @param copy when set new atoms are copied, so external_term can be freed once the term has been created,
+ *        otherwise atoms refer to external_term, that must be kept, as it happens for module literals.
  * @returns a term.
  */
-term externalterm_to_term(const void *external_term, Context *ctx);
+term externalterm_to_term(const void *external_term, Context *ctx, int copy);
+
+/**
+ * @brief Decodes an untrusted term.
+ *
+ * @details Decodes a term without the version tag, checking that it is complete and supported before allocating
+ *          anything. New atoms are copied. Pids can be decoded only when the node is alive.
+ * @param buf the encoded term.
+ * @param size the size of buf, the term might be followed by other data.
+ * @param bytes_read will be set to the size of the encoded term, it can be NULL.
+ * @param refs the atoms referenced by the enclosing distribution message, or NULL.
+ * @param ctx the context that owns the memory that will be allocated.
+ * @returns the decoded term, or an invalid term if buf is malformed or the term is not supported.
+ */
+term externalterm_decode(const uint8_t *buf, size_t size, size_t *bytes_read, const struct ExternalTermAtomRefs *refs, Context *ctx);
+
+/**
+ * @brief Computes the memory needed to decode an untrusted term.
+ *
+ * @details Checks a term without the version tag as externalterm_decode does, without allocating anything.
+ * @param buf the encoded term.
+ * @param size the size of buf, the term might be followed by other data.
+ * @param refs the atoms referenced by the enclosing distribution message, or NULL.
+ * @param glb the global context that owns the term atoms.
+ * @returns the size in term units of the decoded term, or -1 if buf is malformed or the term is not supported.
+ */
+int externalterm_decoded_size(const uint8_t *buf, size_t size, const struct ExternalTermAtomRefs *refs, GlobalContext *glb);
+
+/**
+ * @brief Decodes a term to a buffer that is not owned by any process.
+ *
+ * @details Decodes a term that has been checked with externalterm_decoded_size, such as a message that is going to
+ *          be enqueued. New atoms are copied.
+ * @param buf the encoded term.
+ * @param bytes_read will be set to the size of the encoded term, it can be NULL.
+ * @param refs the same atoms that have been used with externalterm_decoded_size, or NULL.
+ * @param glb the global context that owns the term atoms.
+ * @param heap pointer to the destination buffer, it is moved after the decoded term.
+ * @param heap_size the value returned by externalterm_decoded_size.
+ * @returns the decoded term.
+ */
+term externalterm_decode_to_heap(const uint8_t *buf, size_t *bytes_read, const struct ExternalTermAtomRefs *refs, GlobalContext *glb, term **heap, int heap_size);
+
+/**
+ * @brief Computes the size of a term in external term format.
+ *
+ * @details Integers that do not fit a term, funs and binaries with a bit size are not supported. Pids and local
+ *          references are supported only when the node is alive.
+ * @param t the term that will be serialized.
+ * @param glb the global context that owns the term atoms.
+ * @returns the size in bytes of the serialized term, or -1 if the term cannot be serialized.
+ */
+int externalterm_compute_external_size(term t, GlobalContext *glb);
+
+/**
+ * @brief Serializes a term to external term format.
+ *
+ * @details Writes a term that is supported by externalterm_compute_external_size to a buffer.
+ * @param buf the destination buffer, that is at least externalterm_compute_external_size bytes long.
+ * @param t the term that will be serialized.
+ * @param glb the global context that owns the term atoms.
+ */
+void externalterm_serialize_term(uint8_t *buf, term t, GlobalContext *glb);
+
+/**
+ * @brief Computes the size of an encoded term without the version tag.
+ *
+ * @details When refs is not NULL, atoms that are not already there are appended to it (as long as there is room)
+ *          and they will be encoded as references.
+ * @param t the term that will be encoded.
+ * @param glb the global context that owns the term atoms.
+ * @param refs atoms referenced by the message, or NULL.
+ * @returns the size in bytes of the encoded term, or -1 if the term cannot be encoded.
+ */
+int externalterm_encoded_size(term t, GlobalContext *glb, struct ExternalTermAtomRefs *refs);
+
+/**
+ * @brief Encodes a term without the version tag.
+ *
+ * @param buf the destination buffer, that is at least externalterm_encoded_size bytes long.
+ * @param t the term that will be encoded.
+ * @param glb the global context that owns the term atoms.
+ * @param refs the same atoms that have been used with externalterm_encoded_size, or NULL.
+ */
+void externalterm_encode(uint8_t *buf, term t, GlobalContext *glb, struct ExternalTermAtomRefs *refs);
 
 #endif
@@ -0,0 +1,720 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "format.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atom.h"
+#include "globalcontext.h"
+#include "interop.h"
+#include "module.h"
+#include "tempstack.h"
+#include "utils.h"
+#include "valueshashtable.h"
+
+#define FORMAT_BUFFER_INITIAL_SIZE 64
+#define FORMAT_INTEGER_MAX_DIGITS 68
+
+enum FormatPrintAction
+{
+    PrintTerm = 0,
+    PrintListTail,
+    PrintChar
+};
+
+static const char *const reserved_words[] = {
+    "after", "and", "andalso", "band", "begin", "bnot", "bor", "bsl", "bsr", "bxor", "case", "catch",
+    "cond", "div", "end", "fun", "if", "let", "not", "of", "or", "orelse", "receive", "rem", "try",
+    "when", "xor", NULL
+};
+
+void format_buffer_init(struct FormatBuffer *buf)
+{
+    buf->data = NULL;
+    buf->len = 0;
+    buf->size = 0;
+    buf->out_of_memory = 0;
+}
+
+void format_buffer_destroy(struct FormatBuffer *buf)
+{
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = 0;
+    buf->size = 0;
+}
+
+// Makes room for len more bytes and returns a pointer to them, or NULL when out of memory.
+static char *format_buffer_reserve(struct FormatBuffer *buf, size_t len)
+{
+    if (UNLIKELY(buf->out_of_memory)) {
+        return NULL;
+    }
+
+    if (buf->size - buf->len < len) {
+        size_t new_size = buf->size ? buf->size : FORMAT_BUFFER_INITIAL_SIZE;
+        while (new_size - buf->len < len) {
+            new_size *= 2;
+        }
+        char *new_data = realloc(buf->data, new_size);
+        if (IS_NULL_PTR(new_data)) {
+            buf->out_of_memory = 1;
+            return NULL;
+        }
+        buf->data = new_data;
+        buf->size = new_size;
+    }
+
+    return buf->data + buf->len;
+}
+
+void format_buffer_append(struct FormatBuffer *buf, const char *data, size_t len)
+{
+    char *p = format_buffer_reserve(buf, len);
+    if (LIKELY(p != NULL)) {
+        memcpy(p, data, len);
+        buf->len += len;
+    }
+}
+
+static inline void format_buffer_append_char(struct FormatBuffer *buf, char c)
+{
+    format_buffer_append(buf, &c, 1);
+}
+
+static void format_buffer_append_repeated(struct FormatBuffer *buf, char c, size_t count)
+{
+    char *p = format_buffer_reserve(buf, count);
+    if (LIKELY(p != NULL)) {
+        memset(p, c, count);
+        buf->len += count;
+    }
+}
+
+static void format_buffer_append_integer(struct FormatBuffer *buf, int64_t value, int base)
+{
+    char digits[FORMAT_INTEGER_MAX_DIGITS];
+    char *p = digits + sizeof(digits);
+
+    // work on the negative value, so the most negative integer doesn't overflow
+    int negative = value < 0;
+    if (!negative) {
+        value = -value;
+    }
+    do {
+        int digit = -(value % base);
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        value /= base;
+    } while (value != 0);
+    if (negative) {
+        *--p = '-';
+    }
+
+    format_buffer_append(buf, p, digits + sizeof(digits) - p);
+}
+
+static inline int format_is_string_char(int64_t c)
+{
+    return ((c >= 32) && (c <= 126)) || ((c >= '\b') && (c <= '\r')) || (c == 27);
+}
+
+static void format_append_escaped(struct FormatBuffer *buf, char c, char quote)
+{
+    char escaped[2] = { '\\', c };
+
+    switch (c) {
+        case '\b':
+            escaped[1] = 'b';
+            break;
+        case '\t':
+            escaped[1] = 't';
+            break;
+        case '\n':
+            escaped[1] = 'n';
+            break;
+        case '\v':
+            escaped[1] = 'v';
+            break;
+        case '\f':
+            escaped[1] = 'f';
+            break;
+        case '\r':
+            escaped[1] = 'r';
+            break;
+        case 27:
+            escaped[1] = 'e';
+            break;
+        default:
+            if ((c != quote) && (c != '\\')) {
+                format_buffer_append_char(buf, c);
+                return;
+            }
+    }
+
+    format_buffer_append(buf, escaped, 2);
+}
+
+static int format_is_printable_list(term t)
+{
+    while (term_is_nonempty_list(t)) {
+        term head = term_get_list_head(t);
+        if (!term_is_integer(head) || !format_is_string_char(term_to_int64(head))) {
+            return 0;
+        }
+        t = term_get_list_tail(t);
+    }
+
+    return term_is_nil(t);
+}
+
+static int format_is_printable_binary(const char *data, int len)
+{
+    if (len == 0) {
+        return 0;
+    }
+    for (int i = 0; i < len; i++) {
+        if (!format_is_string_char((uint8_t) data[i])) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int format_atom_needs_quotes(const char *data, size_t len)
+{
+    if ((len == 0) || (data[0] < 'a') || (data[0] > 'z')) {
+        return 1;
+    }
+    for (size_t i = 1; i < len; i++) {
+        char c = data[i];
+        if (!(((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) || (c == '_') || (c == '@'))) {
+            return 1;
+        }
+    }
+    for (int i = 0; reserved_words[i]; i++) {
+        if ((strlen(reserved_words[i]) == len) && !memcmp(reserved_words[i], data, len)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void format_atom(struct FormatBuffer *buf, term t, const Context *ctx)
+{
+    int atom_index = term_to_atom_index(t);
+    AtomString atom_string = (AtomString) valueshashtable_get_value(ctx->global->atoms_ids_table, atom_index, (unsigned long) NULL);
+    const char *data = (const char *) atom_string_data(atom_string);
+    size_t len = atom_string_len(atom_string);
+
+    if (!format_atom_needs_quotes(data, len)) {
+        format_buffer_append(buf, data, len);
+        return;
+    }
+
+    format_buffer_append_char(buf, '\'');
+    for (size_t i = 0; i < len; i++) {
+        format_append_escaped(buf, data[i], '\'');
+    }
+    format_buffer_append_char(buf, '\'');
+}
+
+static void format_binary(struct FormatBuffer *buf, term t, int pretty)
+{
+    int len = term_binary_size(t);
+    const char *data = term_binary_data(t);
+
+    format_buffer_append(buf, "<<", 2);
+    if (pretty && format_is_printable_binary(data, len)) {
+        format_buffer_append_char(buf, '"');
+        for (int i = 0; i < len; i++) {
+            format_append_escaped(buf, data[i], '"');
+        }
+        format_buffer_append_char(buf, '"');
+    } else {
+        for (int i = 0; i < len; i++) {
+            if (i != 0) {
+                format_buffer_append_char(buf, ',');
+            }
+            format_buffer_append_integer(buf, (uint8_t) data[i], 10);
+        }
+    }
+    format_buffer_append(buf, ">>", 2);
+}
+
+static inline void format_push_action(struct TempStack *temp_stack, term t, enum FormatPrintAction action)
+{
+    temp_stack_push(temp_stack, t);
+    temp_stack_push(temp_stack, term_from_int32(action));
+}
+
+void format_term(struct FormatBuffer *buf, term t, const Context *ctx, int pretty)
+{
+    struct TempStack temp_stack;
+    temp_stack_init(&temp_stack);
+
+    enum FormatPrintAction action = PrintTerm;
+
+    while (1) {
+        if (action == PrintChar) {
+            format_buffer_append_char(buf, term_to_int32(t));
+
+        } else if (action == PrintListTail) {
+            if (term_is_nonempty_list(t)) {
+                format_buffer_append_char(buf, ',');
+                format_push_action(&temp_stack, term_get_list_tail(t), PrintListTail);
+                t = term_get_list_head(t);
+                action = PrintTerm;
+                continue;
+
+            } else if (term_is_nil(t)) {
+                format_buffer_append_char(buf, ']');
+
+            } else {
+                format_buffer_append_char(buf, '|');
+                format_push_action(&temp_stack, term_from_int32(']'), PrintChar);
+                action = PrintTerm;
+                continue;
+            }
+
+        } else if (term_is_atom(t)) {
+            format_atom(buf, t, ctx);
+
+        } else if (term_is_integer(t)) {
+            format_buffer_append_integer(buf, term_to_int64(t), 10);
+
+        } else if (term_is_nil(t)) {
+            format_buffer_append(buf, "[]", 2);
+
+        } else if (term_is_nonempty_list(t)) {
+            if (pretty && format_is_printable_list(t)) {
+                format_buffer_append_char(buf, '"');
+                while (!term_is_nil(t)) {
+                    format_append_escaped(buf, term_to_int64(term_get_list_head(t)), '"');
+                    t = term_get_list_tail(t);
+                }
+                format_buffer_append_char(buf, '"');
+
+            } else {
+                format_buffer_append_char(buf, '[');
+                format_push_action(&temp_stack, term_get_list_tail(t), PrintListTail);
+                t = term_get_list_head(t);
+                continue;
+            }
+
+        } else if (term_is_pid(t)) {
+            char pid_buf[24];
+            int len = snprintf(pid_buf, sizeof(pid_buf), "<0.%i.0>", term_to_local_process_id(t));
+            format_buffer_append(buf, pid_buf, len);
+
+        } else if (term_is_tuple(t)) {
+            int tuple_size = term_get_tuple_arity(t);
+            format_buffer_append_char(buf, '{');
+            if (tuple_size == 0) {
+                format_buffer_append_char(buf, '}');
+            } else {
+                format_push_action(&temp_stack, term_from_int32('}'), PrintChar);
+                for (int i = tuple_size - 1; i > 0; i--) {
+                    format_push_action(&temp_stack, term_get_tuple_element(t, i), PrintTerm);
+                    format_push_action(&temp_stack, term_from_int32(','), PrintChar);
+                }
+                t = term_get_tuple_element(t, 0);
+                continue;
+            }
+
+        } else if (term_is_binary(t)) {
+            format_binary(buf, t, pretty);
+
+        } else if (term_is_reference(t)) {
+            char ref_buf[40];
+            int len = snprintf(ref_buf, sizeof(ref_buf), "#Ref<0.0.0.%llu>", (unsigned long long) term_to_ref_ticks(t));
+            format_buffer_append(buf, ref_buf, len);
+
+        } else if (term_is_function(t)) {
+            const term *boxed_value = term_to_const_term_ptr(t);
+#ifdef AVM_COMPACT_TERMS
+            int module_index = boxed_value[1];
+            int fun_index = boxed_value[2];
+#else
+            const Module *fun_module = (const Module *) boxed_value[1];
+            int module_index = fun_module->module_index;
+            int fun_index = (const struct ModuleFun *) boxed_value[2] - fun_module->funs;
+#endif
+            char fun_buf[40];
+            // module name and uniq are not available, module index and fun index are used instead
+            int len = snprintf(fun_buf, sizeof(fun_buf), "#Fun<%i.%i>", module_index, fun_index);
+            format_buffer_append(buf, fun_buf, len);
+        }
+
+        if (temp_stack_is_empty(&temp_stack)) {
+            break;
+        }
+        action = term_to_int32(temp_stack_pop(&temp_stack));
+        t = temp_stack_pop(&temp_stack);
+    }
+
+    temp_stack_destory(&temp_stack);
+}
+
+struct FormatSpec
+{
+    int width;
+    int precision;
+    char pad;
+    int left_adjust;
+    int no_strings;
+};
+
+// Pads the text written since start to the field width, or replaces it with '*' when it doesn't fit.
+static void format_adjust(struct FormatBuffer *buf, size_t start, const struct FormatSpec *spec, int overflow_stars)
+{
+    if (spec->width < 0) {
+        return;
+    }
+
+    size_t width = spec->width;
+    size_t len = buf->len - start;
+    if (len > width) {
+        if (overflow_stars) {
+            buf->len = start;
+            format_buffer_append_repeated(buf, '*', width);
+        }
+        return;
+    }
+
+    size_t pad_len = width - len;
+    format_buffer_append_repeated(buf, spec->pad, pad_len);
+    if (!spec->left_adjust && !buf->out_of_memory) {
+        memmove(buf->data + start + pad_len, buf->data + start, len);
+        memset(buf->data + start, spec->pad, pad_len);
+    }
+}
+
+static enum FormatResult format_string_arg(struct FormatBuffer *buf, term arg, const Context *ctx)
+{
+    if (term_is_atom(arg)) {
+        int atom_index = term_to_atom_index(arg);
+        AtomString atom_string = (AtomString) valueshashtable_get_value(ctx->global->atoms_ids_table, atom_index, (unsigned long) NULL);
+        format_buffer_append(buf, (const char *) atom_string_data(atom_string), atom_string_len(atom_string));
+
+    } else if (term_is_binary(arg)) {
+        format_buffer_append(buf, term_binary_data(arg), term_binary_size(arg));
+
+    } else if (term_is_list(arg)) {
+        int ok;
+        unsigned long len = interop_chardata_utf8_size(arg, &ok);
+        if (UNLIKELY(!ok)) {
+            return FormatBadArg;
+        }
+        char *p = format_buffer_reserve(buf, len);
+        if (IS_NULL_PTR(p)) {
+            return FormatOutOfMemory;
+        }
+        interop_write_chardata_utf8(arg, p);
+        buf->len += len;
+
+    } else {
+        return FormatBadArg;
+    }
+
+    return FormatOk;
+}
+
+static enum FormatResult format_char_arg(struct FormatBuffer *buf, term arg, int count)
+{
+    if (UNLIKELY(!term_is_integer(arg))) {
+        return FormatBadArg;
+    }
+    int64_t c = term_to_int64(arg);
+    if (UNLIKELY((c < 0) || (c > 0x10FFFF))) {
+        return FormatBadArg;
+    }
+
+    char encoded[4];
+    size_t encoded_len;
+    if (c < 0x80) {
+        format_buffer_append_repeated(buf, c, count);
+        return FormatOk;
+    } else if (c < 0x800) {
+        encoded[0] = 0xC0 | (c >> 6);
+        encoded[1] = 0x80 | (c & 0x3F);
+        encoded_len = 2;
+    } else if (c < 0x10000) {
+        encoded[0] = 0xE0 | (c >> 12);
+        encoded[1] = 0x80 | ((c >> 6) & 0x3F);
+        encoded[2] = 0x80 | (c & 0x3F);
+        encoded_len = 3;
+    } else {
+        encoded[0] = 0xF0 | (c >> 18);
+        encoded[1] = 0x80 | ((c >> 12) & 0x3F);
+        encoded[2] = 0x80 | ((c >> 6) & 0x3F);
+        encoded[3] = 0x80 | (c & 0x3F);
+        encoded_len = 4;
+    }
+    for (int i = 0; i < count; i++) {
+        format_buffer_append(buf, encoded, encoded_len);
+    }
+
+    return FormatOk;
+}
+
+// Reads a decimal number or a * argument, returns -1 when neither is present.
+static enum FormatResult format_parse_number(const char **format, const char *end, term *args, int *number)
+{
+    const char *p = *format;
+    *number = -1;
+
+    if ((p < end) && (*p == '*')) {
+        if (UNLIKELY(!term_is_nonempty_list(*args) || !term_is_integer(term_get_list_head(*args)))) {
+            return FormatBadArg;
+        }
+        *number = term_to_int32(term_get_list_head(*args));
+        *args = term_get_list_tail(*args);
+        *format = p + 1;
+        return FormatOk;
+    }
+
+    if ((p < end) && (*p >= '0') && (*p <= '9')) {
+        int value = 0;
+        while ((p < end) && (*p >= '0') && (*p <= '9')) {
+            value = value * 10 + (*p - '0');
+            if (UNLIKELY(value > 0xFFFFFF)) {
+                return FormatBadArg;
+            }
+            p++;
+        }
+        *number = value;
+    }
+
+    *format = p;
+    return FormatOk;
+}
+
+static enum FormatResult format_parse_spec(const char **format, const char *end, term *args, struct FormatSpec *spec)
+{
+    const char *p = *format;
+
+    spec->left_adjust = 0;
+    spec->pad = ' ';
+    spec->precision = -1;
+    spec->no_strings = 0;
+
+    if ((p < end) && (*p == '-')) {
+        spec->left_adjust = 1;
+        p++;
+    }
+    if (UNLIKELY(format_parse_number(&p, end, args, &spec->width) != FormatOk)) {
+        return FormatBadArg;
+    }
+    if (spec->width < -1) {
+        spec->left_adjust = 1;
+        spec->width = -spec->width;
+    }
+
+    if ((p < end) && (*p == '.')) {
+        p++;
+        if (UNLIKELY(format_parse_number(&p, end, args, &spec->precision) != FormatOk)) {
+            return FormatBadArg;
+        }
+        if ((p < end) && (*p == '.')) {
+            p++;
+            if ((p < end) && (*p == '*')) {
+                if (UNLIKELY(!term_is_nonempty_list(*args) || !term_is_integer(term_get_list_head(*args)))) {
+                    return FormatBadArg;
+                }
+                spec->pad = term_to_int32(term_get_list_head(*args));
+                *args = term_get_list_tail(*args);
+                p++;
+            } else if (p < end) {
+                spec->pad = *p++;
+            }
+        }
+    }
+
+    while ((p < end) && ((*p == 't') || (*p == 'l'))) {
+        if (*p == 'l') {
+            spec->no_strings = 1;
+        }
+        p++;
+    }
+
+    if (UNLIKELY(p == end)) {
+        return FormatBadArg;
+    }
+
+    *format = p;
+    return FormatOk;
+}
+
+static enum FormatResult format_control(struct FormatBuffer *buf, char control, const struct FormatSpec *spec, term *args, const Context *ctx)
+{
+    if (control == '~') {
+        format_buffer_append_char(buf, '~');
+        return FormatOk;
+    } else if (control == 'n') {
+        format_buffer_append_char(buf, '\n');
+        return FormatOk;
+    }
+
+    if (UNLIKELY(!term_is_nonempty_list(*args))) {
+        return FormatBadArg;
+    }
+    term arg = term_get_list_head(*args);
+    *args = term_get_list_tail(*args);
+
+    size_t start = buf->len;
+
+    switch (control) {
+        case 'i':
+            return FormatOk;
+
+        case 'w':
+            format_term(buf, arg, ctx, 0);
+            format_adjust(buf, start, spec, 1);
+            return FormatOk;
+
+        case 'p':
+            // the field width of ~p is the line length, terms are always printed on a single line
+            format_term(buf, arg, ctx, !spec->no_strings);
+            return FormatOk;
+
+        case 's': {
+            enum FormatResult result = format_string_arg(buf, arg, ctx);
+            if (UNLIKELY(result != FormatOk)) {
+                return result;
+            }
+            int precision = spec->precision >= 0 ? spec->precision : spec->width;
+            if ((precision >= 0) && (buf->len - start > (size_t) precision)) {
+                buf->len = start + precision;
+            }
+            format_adjust(buf, start, spec, 0);
+            return FormatOk;
+        }
+
+        case 'c': {
+            int count = spec->precision >= 0 ? spec->precision : (spec->width >= 0 ? spec->width : 1);
+            enum FormatResult result = format_char_arg(buf, arg, count);
+            if (UNLIKELY(result != FormatOk)) {
+                return result;
+            }
+            format_adjust(buf, start, spec, 0);
+            return FormatOk;
+        }
+
+        case 'B': {
+            int base = spec->precision >= 0 ? spec->precision : 10;
+            if (UNLIKELY(!term_is_integer(arg) || (base < 2) || (base > 36))) {
+                return FormatBadArg;
+            }
+            format_buffer_append_integer(buf, term_to_int64(arg), base);
+            format_adjust(buf, start, spec, 1);
+            return FormatOk;
+        }
+
+        case 'f': {
+            // there are no float terms, integers are printed with zero decimals
+            int precision = spec->precision >= 0 ? spec->precision : 6;
+            if (UNLIKELY(!term_is_integer(arg) || (precision < 1))) {
+                return FormatBadArg;
+            }
+            format_buffer_append_integer(buf, term_to_int64(arg), 10);
+            format_buffer_append_char(buf, '.');
+            format_buffer_append_repeated(buf, '0', precision);
+            format_adjust(buf, start, spec, 1);
+            return FormatOk;
+        }
+
+        default:
+            return FormatBadArg;
+    }
+}
+
+enum FormatResult format_io_lib(struct FormatBuffer *buf, term format, term args, const Context *ctx)
+{
+    const char *format_data;
+    size_t format_len;
+    char *format_copy = NULL;
+
+    if (term_is_binary(format)) {
+        format_data = term_binary_data(format);
+        format_len = term_binary_size(format);
+
+    } else if (term_is_atom(format)) {
+        int atom_index = term_to_atom_index(format);
+        AtomString atom_string = (AtomString) valueshashtable_get_value(ctx->global->atoms_ids_table, atom_index, (unsigned long) NULL);
+        format_data = (const char *) atom_string_data(atom_string);
+        format_len = atom_string_len(atom_string);
+
+    } else if (term_is_list(format)) {
+        int ok;
+        format_len = interop_chardata_utf8_size(format, &ok);
+        if (UNLIKELY(!ok)) {
+            return FormatBadArg;
+        }
+        format_copy = malloc(format_len + 1);
+        if (IS_NULL_PTR(format_copy)) {
+            return FormatOutOfMemory;
+        }
+        interop_write_chardata_utf8(format, format_copy);
+        format_data = format_copy;
+
+    } else {
+        return FormatBadArg;
+    }
+
+    enum FormatResult result = FormatOk;
+    const char *p = format_data;
+    const char *end = format_data + format_len;
+
+    while (p < end) {
+        const char *tilde = memchr(p, '~', end - p);
+        if (tilde == NULL) {
+            format_buffer_append(buf, p, end - p);
+            break;
+        }
+        format_buffer_append(buf, p, tilde - p);
+        p = tilde + 1;
+
+        struct FormatSpec spec;
+        result = format_parse_spec(&p, end, &args, &spec);
+        if (UNLIKELY(result != FormatOk)) {
+            break;
+        }
+        result = format_control(buf, *p++, &spec, &args, ctx);
+        if (UNLIKELY(result != FormatOk)) {
+            break;
+        }
+    }
+
+    free(format_copy);
+
+    if ((result == FormatOk) && !term_is_nil(args)) {
+        result = FormatBadArg;
+    }
+    if ((result == FormatOk) && buf->out_of_memory) {
+        result = FormatOutOfMemory;
+    }
+
+    return result;
+}
@@ -0,0 +1,103 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file format.h
+ * @brief Term printing and io_lib:format style string formatting.
+ *
+ * @details Output is appended to a growable buffer, so callers can either write it to a stream or
+ *          copy it to the heap once the final size is known. The same term printer is used by
+ *          term_display and by the ~p and ~w control sequences.
+ */
+
+#ifndef _FORMAT_H_
+#define _FORMAT_H_
+
+#include <stddef.h>
+
+#include "context.h"
+#include "term.h"
+
+enum FormatResult
+{
+    FormatOk = 0,
+    FormatBadArg,
+    FormatOutOfMemory
+};
+
+struct FormatBuffer
+{
+    char *data;
+    size_t len;
+    size_t size;
+    int out_of_memory;
+};
+
+/**
+ * @brief Initializes an empty format buffer
+ *
+ * @param buf the buffer that will be initialized, no memory is allocated until something is appended.
+ */
+void format_buffer_init(struct FormatBuffer *buf);
+
+/**
+ * @brief Frees the memory used by a format buffer
+ *
+ * @param buf the buffer that will be destroyed.
+ */
+void format_buffer_destroy(struct FormatBuffer *buf);
+
+/**
+ * @brief Appends bytes to a format buffer
+ *
+ * @details The buffer grows geometrically. When an allocation fails the out_of_memory flag is set and
+ *          any further append is ignored.
+ * @param buf the buffer that will be appended to.
+ * @param data the bytes that will be appended.
+ * @param len the number of bytes.
+ */
+void format_buffer_append(struct FormatBuffer *buf, const char *data, size_t len);
+
+/**
+ * @brief Appends a term using the Erlang term syntax
+ *
+ * @details Deep terms are walked without recursion.
+ * @param buf the buffer that will be appended to.
+ * @param t the term that will be printed.
+ * @param ctx the context used to resolve atom names.
+ * @param pretty when non zero printable lists and binaries are printed as strings (like ~p),
+ *        otherwise they are printed as lists of integers (like ~w).
+ */
+void format_term(struct FormatBuffer *buf, term t, const Context *ctx, int pretty);
+
+/**
+ * @brief Formats a list of terms using an io_lib:format/2 format string
+ *
+ * @details Supported control sequences are ~p ~w ~s ~B ~f ~c ~n ~i and ~~, with field width,
+ *          precision, padding character and * arguments. Since there are no float terms, ~f
+ *          accepts integers and prints them with the requested number of (zero) decimals.
+ * @param buf the buffer that will be appended to.
+ * @param format the format string: a character list, a binary or an atom.
+ * @param args the list of arguments.
+ * @param ctx the context used to resolve atom names.
+ * @returns FormatOk, FormatBadArg when the format does not match the arguments or FormatOutOfMemory.
+ */
+enum FormatResult format_io_lib(struct FormatBuffer *buf, term format, term args, const Context *ctx);
+
+#endif
@@ -23,7 +23,9 @@
 #include "globalcontext.h"
 
 #include "atomshashtable.h"
+#include "bridge.h"
 #include "list.h"
+#include "mailbox.h"
 #include "utils.h"
 #include "valueshashtable.h"
 #include "sys.h"
@@ -45,6 +47,7 @@ GlobalContext *globalcontext_new()
     }
     list_init(&glb->ready_processes);
     list_init(&glb->waiting_processes);
+    list_init(&glb->deferred_gcs);
     glb->listeners = NULL;
     glb->processes_table = NULL;
     glb->registered_processes = NULL;
@@ -62,12 +65,20 @@ GlobalContext *globalcontext_new()
         free(glb);
         return NULL;
     }
+    glb->processes_ids_table = valueshashtable_new();
+    if (IS_NULL_PTR(glb->processes_ids_table)) {
+        valueshashtable_destroy(glb->atoms_ids_table);
+        free(glb->atoms_table);
+        free(glb);
+        return NULL;
+    }
 
     glb->modules_by_index = NULL;
     glb->loaded_modules_count = 0;
     glb->modules_table = atomshashtable_new();
     if (IS_NULL_PTR(glb->modules_table)) {
-        free(glb->atoms_ids_table);
+        valueshashtable_destroy(glb->processes_ids_table);
+        valueshashtable_destroy(glb->atoms_ids_table);
         free(glb->atoms_table);
         free(glb);
         return NULL;
@@ -75,31 +86,69 @@ GlobalContext *globalcontext_new()
 
     glb->next_timeout_at.tv_sec = 0;
     glb->next_timeout_at.tv_nsec = 0;
+    timerqueue_init(&glb->timers);
 
     glb->ref_ticks = 0;
 
+    glb->used_memory = 0;
+    glb->memory_budget = 0;
+    glb->memory_soft_watermark = 0;
+    glb->memory_relief_level = 0;
+    glb->memory_shrink_pending = 0;
+
+    glb->logger_levels = LOGGER_DEFAULT_LEVELS;
+    glb->logger_filter = NULL;
+    glb->logger_filter_len = 0;
+
+    glb->bridge = NULL;
+    glb->instance = 0;
+    glb->bridge_inbox = NULL;
+    glb->dist = NULL;
+
+    if (UNLIKELY(!sys_init_platform(glb))) {
+        free(glb->modules_table);
+        valueshashtable_destroy(glb->processes_ids_table);
+        valueshashtable_destroy(glb->atoms_ids_table);
+        free(glb->atoms_table);
+        free(glb);
+        return NULL;
+    }
+
     return glb;
 }
 
 COLD_FUNC void globalcontext_destroy(GlobalContext *glb)
 {
+    struct Timer *timer;
+    while ((timer = timerqueue_peek(&glb->timers))) {
+        timerqueue_remove(&glb->timers, timer);
+        mailbox_message_destroy(timer->data);
+        free(timer);
+    }
+    timerqueue_destroy(&glb->timers);
+
+    free(glb->logger_filter);
+    valueshashtable_destroy(glb->processes_ids_table);
+
+    struct BridgeMessage *message = glb->bridge_inbox;
+    while (message) {
+        struct BridgeMessage *next = message->next;
+        free(message);
+        message = next;
+    }
+    sys_free_platform(glb);
+
     free(glb);
 }
 
 Context *globalcontext_get_process(GlobalContext *glb, int32_t process_id)
 {
-    Context *processes = GET_LIST_ENTRY(glb->processes_table, Context, processes_table_head);
-
-    Context *p = processes;
-    do {
-        if (p->process_id == process_id) {
-            return p;
-        }
-
-        p = GET_LIST_ENTRY(p->processes_table_head.next, Context, processes_table_head);
-    } while (processes != p);
+    Context *p = (Context *) valueshashtable_get_value(glb->processes_ids_table, process_id, (unsigned long) NULL);
+    if (p && p->exiting) {
+        return NULL;
+    }
 
-    return NULL;
+    return p;
 }
 
 int32_t globalcontext_get_new_process_id(GlobalContext *glb)
@@ -142,6 +191,46 @@ int globalcontext_get_registered_process(GlobalContext *glb, int atom_index)
     return 0;
 }
 
+int globalcontext_unregister_process(GlobalContext *glb, int atom_index)
+{
+    struct ListHead *item = glb->registered_processes;
+    while (item) {
+        struct RegisteredProcess *p = GET_LIST_ENTRY(item, struct RegisteredProcess, registered_processes_list_head);
+        if (p->atom_index == atom_index) {
+            linkedlist_remove(&glb->registered_processes, item);
+            free(p);
+            return 1;
+        }
+
+        item = item->next;
+        if (item == glb->registered_processes) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+void globalcontext_unregister_process_id(GlobalContext *glb, int local_process_id)
+{
+    struct ListHead *item = glb->registered_processes;
+    while (item) {
+        struct RegisteredProcess *p = GET_LIST_ENTRY(item, struct RegisteredProcess, registered_processes_list_head);
+        struct ListHead *next = item->next;
+        int last = (next == glb->registered_processes);
+
+        if (p->local_process_id == local_process_id) {
+            linkedlist_remove(&glb->registered_processes, item);
+            free(p);
+        }
+
+        if (last || !glb->registered_processes) {
+            break;
+        }
+        item = next;
+    }
+}
+
 int globalcontext_insert_atom(GlobalContext *glb, AtomString atom_string)
 {
     struct AtomsHashTable *htable = glb->atoms_table;
@@ -33,6 +33,7 @@
 #include "atom.h"
 #include "term.h"
 #include "linkedlist.h"
+#include "timerqueue.h"
 
 struct Context;
 
@@ -50,12 +51,26 @@ typedef struct Module Module;
 
 struct Module;
 
+struct Bridge;
+struct BridgeMessage;
+struct Dist;
+
+#define LOGGER_LEVEL_DEBUG 1
+#define LOGGER_LEVEL_INFO 2
+#define LOGGER_LEVEL_WARNING 4
+#define LOGGER_LEVEL_ERROR 8
+#define LOGGER_DEFAULT_LEVELS (LOGGER_LEVEL_INFO | LOGGER_LEVEL_WARNING | LOGGER_LEVEL_ERROR)
+
 typedef struct
 {
     struct ListHead ready_processes;
     struct ListHead waiting_processes;
+    // deferred collections in progress, their slices are run by the scheduler in turn
+    struct ListHead deferred_gcs;
     struct ListHead *listeners;
     struct ListHead *processes_table;
+    // local process id -> Context *, for O(1) process lookups
+    struct ValuesHashTable *processes_ids_table;
     struct ListHead *registered_processes;
 
     int32_t last_process_id;
@@ -70,9 +85,36 @@ typedef struct
     const void *avmpack_platform_data;
 
     struct timespec next_timeout_at;
+    struct TimerQueue timers;
 
     uint64_t ref_ticks;
 
+    // bytes used by process heaps and queued messages, and their limit set with
+    // erlang:system_flag(memory_budget, ...), 0 means unlimited
+    size_t used_memory;
+    size_t memory_budget;
+    // idle processes are shrunk when used memory exceeds erlang:system_flag(memory_soft_watermark, ...),
+    // 0 means never, and again only once it exceeds memory_relief_level, see memory_check_pressure
+    size_t memory_soft_watermark;
+    size_t memory_relief_level;
+    // set by allocations, the scheduler shrinks idle processes until it is cleared, see memory_check_pressure
+    int memory_shrink_pending;
+
+    // logger levels bitmap and modules filter, they are read by callers before building a log request
+    uint32_t logger_levels;
+    term *logger_filter;
+    int logger_filter_len;
+
+    // bridge this instance is attached to, and messages posted by other instances, see bridge.h
+    struct Bridge *bridge;
+    int instance;
+    struct BridgeMessage *bridge_inbox;
+
+    // set once the dist port has been opened and this instance is a node, see dist.h
+    struct Dist *dist;
+
+    void *platform_data;
+
 } GlobalContext;
 
 /**
@@ -97,7 +139,7 @@ void globalcontext_destroy(GlobalContext *glb);
  * @details Retrieves from the process table the context with the given local process id.
  * @param glb the global context (that owns the process table).
  * @param process_id the local process id.
- * @returns a Context * with the requested local process id.
+ * @returns a Context * with the requested local process id, NULL if the process does not exist or it is exiting.
  */
 Context *globalcontext_get_process(GlobalContext *glb, int32_t process_id);
 
@@ -130,6 +172,25 @@ void globalcontext_register_process(GlobalContext *glb, int atom_index, int loca
  */
 int globalcontext_get_registered_process(GlobalContext *glb, int atom_index);
 
+/**
+ * @brief Unregister a process name
+ *
+ * @details Removes the registration of a name, if any.
+ * @param glb the global context.
+ * @param atom_index the atom table index of the registered name.
+ * @returns 1 if the name was registered, otherwise 0.
+ */
+int globalcontext_unregister_process(GlobalContext *glb, int atom_index);
+
+/**
+ * @brief Unregister all names of a process
+ *
+ * @details Removes every name registered for a process, called when the process is destroyed.
+ * @param glb the global context.
+ * @param local_process_id the local process id.
+ */
+void globalcontext_unregister_process_id(GlobalContext *glb, int local_process_id);
+
 /**
  * @brief Inserts an atom into the global atoms table
  *
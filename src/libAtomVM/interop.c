@@ -19,6 +19,20 @@
 
 #include "interop.h"
 
+#include "tempstack.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define ASCII_WORD_MASK ((~0UL / 0xFF) * 0x80)
+
+enum IOListEncoding
+{
+    IOListBytes,
+    IOListUTF8
+};
+
 char *interop_term_to_string(term t)
 {
     if (term_is_nonempty_list(t)) {
@@ -77,7 +91,31 @@ char *interop_list_to_string(term list)
     return str;
 }
 
+char *interop_iolist_to_string(term list)
+{
+    int ok;
+    unsigned long len = interop_iolist_size(list, &ok);
+    if (UNLIKELY(!ok)) {
+        return NULL;
+    }
+
+    char *str = malloc(len + 1);
+    if (IS_NULL_PTR(str)) {
+        return NULL;
+    }
+
+    interop_write_iolist(list, str);
+    str[len] = 0;
+
+    return str;
+}
+
 term interop_proplist_get_value(term list, term key)
+{
+    return interop_proplist_get_value_default(list, key, term_nil());
+}
+
+term interop_proplist_get_value_default(term list, term key, term default_value)
 {
     term t = list;
 
@@ -92,5 +130,305 @@ term interop_proplist_get_value(term list, term key)
         t = *t_ptr;
     }
 
-    return term_nil();
+    return default_value;
+}
+
+static inline int utf8_encoded_len(int64_t c)
+{
+    if (c < 0) {
+        return 0;
+    } else if (c < 0x80) {
+        return 1;
+    } else if (c < 0x800) {
+        return 2;
+    } else if ((c >= 0xD800) && (c <= 0xDFFF)) {
+        return 0;
+    } else if (c < 0x10000) {
+        return 3;
+    } else if (c <= 0x10FFFF) {
+        return 4;
+    } else {
+        return 0;
+    }
+}
+
+static inline void utf8_encode(int32_t c, uint8_t *p)
+{
+    if (c < 0x80) {
+        p[0] = c;
+    } else if (c < 0x800) {
+        p[0] = 0xC0 | (c >> 6);
+        p[1] = 0x80 | (c & 0x3F);
+    } else if (c < 0x10000) {
+        p[0] = 0xE0 | (c >> 12);
+        p[1] = 0x80 | ((c >> 6) & 0x3F);
+        p[2] = 0x80 | (c & 0x3F);
+    } else {
+        p[0] = 0xF0 | (c >> 18);
+        p[1] = 0x80 | ((c >> 12) & 0x3F);
+        p[2] = 0x80 | ((c >> 6) & 0x3F);
+        p[3] = 0x80 | (c & 0x3F);
+    }
+}
+
+int interop_utf8_validate(const uint8_t *buf, unsigned long len)
+{
+    unsigned long i = 0;
+
+    while (i < len) {
+        // ASCII fast path, 16 or sizeof(long) bytes at a time
+#ifdef __SSE2__
+        while ((i + 16 <= len) && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (buf + i)))) {
+            i += 16;
+        }
+#endif
+        while (i + sizeof(unsigned long) <= len) {
+            unsigned long word;
+            memcpy(&word, buf + i, sizeof(unsigned long));
+            if (word & ASCII_WORD_MASK) {
+                break;
+            }
+            i += sizeof(unsigned long);
+        }
+        if (i >= len) {
+            break;
+        }
+
+        uint8_t c = buf[i];
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+
+        unsigned int continuation_bytes;
+        uint32_t codepoint;
+        uint32_t min_codepoint;
+        if ((c & 0xE0) == 0xC0) {
+            continuation_bytes = 1;
+            codepoint = c & 0x1F;
+            min_codepoint = 0x80;
+        } else if ((c & 0xF0) == 0xE0) {
+            continuation_bytes = 2;
+            codepoint = c & 0x0F;
+            min_codepoint = 0x800;
+        } else if ((c & 0xF8) == 0xF0) {
+            continuation_bytes = 3;
+            codepoint = c & 0x07;
+            min_codepoint = 0x10000;
+        } else {
+            return 0;
+        }
+
+        if (UNLIKELY(len - i <= continuation_bytes)) {
+            return 0;
+        }
+        for (unsigned int j = 1; j <= continuation_bytes; j++) {
+            uint8_t next = buf[i + j];
+            if (UNLIKELY((next & 0xC0) != 0x80)) {
+                return 0;
+            }
+            codepoint = (codepoint << 6) | (next & 0x3F);
+        }
+        if (UNLIKELY((codepoint < min_codepoint) || (codepoint > 0x10FFFF)
+                || ((codepoint >= 0xD800) && (codepoint <= 0xDFFF)))) {
+            return 0;
+        }
+
+        i += continuation_bytes + 1;
+    }
+
+    return 1;
+}
+
+static inline int iolist_walk_binary(term binary, enum IOListEncoding encoding, uint8_t *out, unsigned long *acc)
+{
+    unsigned long len = term_binary_size(binary);
+    const uint8_t *data = (const uint8_t *) term_binary_data(binary);
+
+    if (out) {
+        memcpy(out + *acc, data, len);
+    } else if ((encoding == IOListUTF8) && UNLIKELY(!interop_utf8_validate(data, len))) {
+        return 0;
+    }
+    *acc += len;
+
+    return 1;
+}
+
+// Walks an iolist (or chardata when encoding is IOListUTF8) without recursion, when out is NULL
+// it just computes the size and validates t, otherwise it writes t to out.
+static int iolist_walk(struct TempStack *temp_stack, term t, enum IOListEncoding encoding, uint8_t *out, unsigned long *size)
+{
+    unsigned long acc = 0;
+
+    temp_stack_push(temp_stack, t);
+
+    while (!temp_stack_is_empty(temp_stack)) {
+        t = temp_stack_pop(temp_stack);
+
+        while (term_is_nonempty_list(t)) {
+            term *list_ptr = term_get_list_ptr(t);
+            term head = list_ptr[1];
+            t = list_ptr[0];
+
+            if (term_is_integer(head)) {
+                int64_t c = term_to_int64(head);
+                if (encoding == IOListBytes) {
+                    if (UNLIKELY((c < 0) || (c > 255))) {
+                        return 0;
+                    }
+                    if (out) {
+                        out[acc] = c;
+                    }
+                    acc++;
+
+                } else {
+                    int len = utf8_encoded_len(c);
+                    if (UNLIKELY(!len)) {
+                        return 0;
+                    }
+                    if (out) {
+                        utf8_encode(c, out + acc);
+                    }
+                    acc += len;
+                }
+
+            } else if (term_is_binary(head)) {
+                if (UNLIKELY(!iolist_walk_binary(head, encoding, out, &acc))) {
+                    return 0;
+                }
+
+            } else if (term_is_list(head)) {
+                temp_stack_push(temp_stack, t);
+                t = head;
+
+            } else {
+                return 0;
+            }
+        }
+
+        if (term_is_binary(t)) {
+            if (UNLIKELY(!iolist_walk_binary(t, encoding, out, &acc))) {
+                return 0;
+            }
+        } else if (UNLIKELY(!term_is_nil(t))) {
+            return 0;
+        }
+    }
+
+    *size = acc;
+    return 1;
+}
+
+static int iolist_walk_all(term t, enum IOListEncoding encoding, uint8_t *out, unsigned long *size)
+{
+    struct TempStack temp_stack;
+    temp_stack_init(&temp_stack);
+
+    int ok = iolist_walk(&temp_stack, t, encoding, out, size);
+
+    temp_stack_destory(&temp_stack);
+
+    return ok;
+}
+
+unsigned long interop_iolist_size(term t, int *ok)
+{
+    unsigned long size = 0;
+    *ok = iolist_walk_all(t, IOListBytes, NULL, &size);
+
+    return size;
+}
+
+int interop_write_iolist(term t, char *p)
+{
+    unsigned long size;
+    return iolist_walk_all(t, IOListBytes, (uint8_t *) p, &size);
+}
+
+unsigned long interop_chardata_utf8_size(term t, int *ok)
+{
+    unsigned long size = 0;
+    *ok = iolist_walk_all(t, IOListUTF8, NULL, &size);
+
+    return size;
+}
+
+int interop_write_chardata_utf8(term t, char *p)
+{
+    unsigned long size;
+    return iolist_walk_all(t, IOListUTF8, (uint8_t *) p, &size);
+}
+
+#define IOLIST_CHUNK_BUF_SIZE 64
+
+// Walks an iolist calling callback for each binary, bytes found in lists are collected in a small
+// buffer, so an iolist can be processed incrementally without flattening it.
+int interop_iolist_foreach_chunk(term t, interop_chunk_callback callback, void *accum)
+{
+    uint8_t buf[IOLIST_CHUNK_BUF_SIZE];
+    unsigned long buf_len = 0;
+    int ok = 1;
+
+    struct TempStack temp_stack;
+    temp_stack_init(&temp_stack);
+    temp_stack_push(&temp_stack, t);
+
+    while (!temp_stack_is_empty(&temp_stack)) {
+        t = temp_stack_pop(&temp_stack);
+
+        while (term_is_nonempty_list(t)) {
+            term *list_ptr = term_get_list_ptr(t);
+            term head = list_ptr[1];
+            t = list_ptr[0];
+
+            if (term_is_integer(head)) {
+                int64_t c = term_to_int64(head);
+                if (UNLIKELY((c < 0) || (c > 255))) {
+                    ok = 0;
+                    break;
+                }
+                buf[buf_len++] = c;
+                if (buf_len == IOLIST_CHUNK_BUF_SIZE) {
+                    callback(buf, buf_len, accum);
+                    buf_len = 0;
+                }
+
+            } else if (term_is_binary(head)) {
+                if (buf_len) {
+                    callback(buf, buf_len, accum);
+                    buf_len = 0;
+                }
+                callback((const uint8_t *) term_binary_data(head), term_binary_size(head), accum);
+
+            } else if (term_is_list(head)) {
+                temp_stack_push(&temp_stack, t);
+                t = head;
+
+            } else {
+                ok = 0;
+                break;
+            }
+        }
+
+        if (!ok) {
+            break;
+        } else if (term_is_binary(t)) {
+            if (buf_len) {
+                callback(buf, buf_len, accum);
+                buf_len = 0;
+            }
+            callback((const uint8_t *) term_binary_data(t), term_binary_size(t), accum);
+        } else if (UNLIKELY(!term_is_nil(t))) {
+            ok = 0;
+        }
+    }
+
+    if (ok && buf_len) {
+        callback(buf, buf_len, accum);
+    }
+
+    temp_stack_destory(&temp_stack);
+
+    return ok;
 }
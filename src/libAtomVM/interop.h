@@ -25,6 +25,17 @@
 char *interop_term_to_string(term t);
 char *interop_binary_to_string(term binary);
 char *interop_list_to_string(term list);
+char *interop_iolist_to_string(term list);
 term interop_proplist_get_value(term list, term key);
+term interop_proplist_get_value_default(term list, term key, term default_value);
+
+typedef void (*interop_chunk_callback)(const uint8_t *data, unsigned long len, void *accum);
+
+unsigned long interop_iolist_size(term t, int *ok);
+int interop_write_iolist(term t, char *p);
+unsigned long interop_chardata_utf8_size(term t, int *ok);
+int interop_write_chardata_utf8(term t, char *p);
+int interop_utf8_validate(const uint8_t *buf, unsigned long len);
+int interop_iolist_foreach_chunk(term t, interop_chunk_callback callback, void *accum);
 
 #endif
@@ -0,0 +1,758 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "json.h"
+
+#include <string.h>
+
+#include "globalcontext.h"
+#include "tempstack.h"
+#include "utils.h"
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+#define JSON_INITIAL_FRAMES 8
+
+static const char *const true_atom = "\x4" "true";
+static const char *const false_atom = "\x5" "false";
+static const char *const null_atom = "\x4" "null";
+
+enum JsonContainer
+{
+    JsonArray,
+    JsonObject
+};
+
+enum JsonParserState
+{
+    JsonExpectValue,
+    JsonExpectValueOrClose,
+    JsonExpectKey,
+    JsonExpectKeyOrClose,
+    JsonExpectColon,
+    JsonExpectCommaOrClose
+};
+
+struct JsonFrame
+{
+    enum JsonContainer type;
+    unsigned long count;
+};
+
+struct JsonParser
+{
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+
+    // terms are built only when ctx is set, otherwise the required heap size is computed
+    Context *ctx;
+    unsigned long heap_size;
+    struct TempStack values;
+
+    struct JsonFrame *frames;
+    int frames_count;
+    int frames_size;
+};
+
+struct JsonWriter
+{
+    // bytes are only counted when out is NULL
+    uint8_t *out;
+    size_t len;
+    Context *ctx;
+};
+
+// returns the length of the leading run of bytes that need no escaping: anything but '"', '\' and control characters
+static size_t json_plain_length(const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+
+    while (len - i >= 16) {
+        __m128i in = _mm_loadu_si128((const __m128i *) (data + i));
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(in, quote), _mm_cmpeq_epi8(in, backslash));
+        // in < 0x20 (unsigned) when max(in, 0x20) != in
+        __m128i plain = _mm_cmpeq_epi8(_mm_max_epu8(in, space), in);
+        int mask = _mm_movemask_epi8(_mm_andnot_si128(special, plain)) ^ 0xFFFF;
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+        i += 16;
+    }
+#endif
+
+    while ((i < len) && (data[i] != '"') && (data[i] != '\\') && (data[i] >= 0x20)) {
+        i++;
+    }
+
+    return i;
+}
+
+static void json_skip_whitespace(struct JsonParser *p)
+{
+    while (p->pos < p->len) {
+        uint8_t c = p->data[p->pos];
+        if ((c != ' ') && (c != '\t') && (c != '\n') && (c != '\r')) {
+            break;
+        }
+        p->pos++;
+    }
+}
+
+static int json_hex_value(const uint8_t *data, uint32_t *value)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        uint8_t c = data[i];
+        v <<= 4;
+        if ((c >= '0') && (c <= '9')) {
+            v |= c - '0';
+        } else if ((c >= 'a') && (c <= 'f')) {
+            v |= c - 'a' + 10;
+        } else if ((c >= 'A') && (c <= 'F')) {
+            v |= c - 'A' + 10;
+        } else {
+            return 0;
+        }
+    }
+    *value = v;
+
+    return 1;
+}
+
+static size_t json_put_utf8(uint32_t code_point, uint8_t *out)
+{
+    if (code_point < 0x80) {
+        if (out) {
+            out[0] = code_point;
+        }
+        return 1;
+    } else if (code_point < 0x800) {
+        if (out) {
+            out[0] = 0xC0 | (code_point >> 6);
+            out[1] = 0x80 | (code_point & 0x3F);
+        }
+        return 2;
+    } else if (code_point < 0x10000) {
+        if (out) {
+            out[0] = 0xE0 | (code_point >> 12);
+            out[1] = 0x80 | ((code_point >> 6) & 0x3F);
+            out[2] = 0x80 | (code_point & 0x3F);
+        }
+        return 3;
+    } else {
+        if (out) {
+            out[0] = 0xF0 | (code_point >> 18);
+            out[1] = 0x80 | ((code_point >> 12) & 0x3F);
+            out[2] = 0x80 | ((code_point >> 6) & 0x3F);
+            out[3] = 0x80 | (code_point & 0x3F);
+        }
+        return 4;
+    }
+}
+
+// scans a string starting at its opening quote, unescaped bytes are written to out unless it is NULL
+static enum JsonResult json_scan_string(struct JsonParser *p, size_t *pos, size_t *out_len, uint8_t *out)
+{
+    const uint8_t *data = p->data;
+    size_t len = p->len;
+    size_t i = *pos + 1;
+    size_t written = 0;
+
+    while (1) {
+        size_t plain = json_plain_length(data + i, len - i);
+        if (out) {
+            memcpy(out + written, data + i, plain);
+        }
+        i += plain;
+        written += plain;
+
+        if (UNLIKELY(i == len)) {
+            return JsonSyntaxError;
+        }
+
+        uint8_t c = data[i];
+        if (c == '"') {
+            break;
+        } else if (c != '\\') {
+            // unescaped control character
+            return JsonSyntaxError;
+        }
+
+        if (UNLIKELY(i + 1 == len)) {
+            return JsonSyntaxError;
+        }
+        uint8_t escaped;
+        switch (data[i + 1]) {
+            case '"': escaped = '"'; break;
+            case '\\': escaped = '\\'; break;
+            case '/': escaped = '/'; break;
+            case 'b': escaped = '\b'; break;
+            case 'f': escaped = '\f'; break;
+            case 'n': escaped = '\n'; break;
+            case 'r': escaped = '\r'; break;
+            case 't': escaped = '\t'; break;
+
+            case 'u': {
+                uint32_t code_point;
+                if (UNLIKELY((len - i < 6) || !json_hex_value(data + i + 2, &code_point))) {
+                    return JsonSyntaxError;
+                }
+                i += 6;
+                if ((code_point >= 0xD800) && (code_point <= 0xDBFF)) {
+                    uint32_t low;
+                    if (UNLIKELY((len - i < 6) || (data[i] != '\\') || (data[i + 1] != 'u')
+                            || !json_hex_value(data + i + 2, &low) || (low < 0xDC00) || (low > 0xDFFF))) {
+                        return JsonSyntaxError;
+                    }
+                    i += 6;
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                } else if (UNLIKELY((code_point >= 0xDC00) && (code_point <= 0xDFFF))) {
+                    return JsonSyntaxError;
+                }
+                written += json_put_utf8(code_point, out ? out + written : NULL);
+                continue;
+            }
+
+            default:
+                return JsonSyntaxError;
+        }
+        if (out) {
+            out[written] = escaped;
+        }
+        written++;
+        i += 2;
+    }
+
+    *pos = i + 1;
+    *out_len = written;
+
+    return JsonOk;
+}
+
+static enum JsonResult json_parse_string(struct JsonParser *p)
+{
+    size_t end = p->pos;
+    size_t len;
+    enum JsonResult result = json_scan_string(p, &end, &len, NULL);
+    if (UNLIKELY(result != JsonOk)) {
+        return result;
+    }
+
+    if (p->ctx) {
+        term binary = term_create_uninitialized_binary(len, p->ctx);
+        size_t pos = p->pos;
+        json_scan_string(p, &pos, &len, (uint8_t *) term_binary_data(binary));
+        temp_stack_push(&p->values, binary);
+    } else {
+        p->heap_size += term_binary_data_size_in_terms(len) + 2;
+    }
+    p->pos = end;
+
+    return JsonOk;
+}
+
+static enum JsonResult json_parse_number(struct JsonParser *p)
+{
+    const uint8_t *data = p->data;
+    size_t i = p->pos;
+    int negative = 0;
+
+    if (data[i] == '-') {
+        negative = 1;
+        i++;
+    }
+    if (UNLIKELY((i == p->len) || (data[i] < '0') || (data[i] > '9'))) {
+        return JsonSyntaxError;
+    }
+
+    int64_t value = 0;
+    if (data[i] == '0') {
+        i++;
+    } else {
+        while ((i < p->len) && (data[i] >= '0') && (data[i] <= '9')) {
+            int digit = data[i] - '0';
+            if (UNLIKELY(value > (TERM_MAX_SMALL_INT - digit) / 10)) {
+                return JsonOverflow;
+            }
+            value = value * 10 + digit;
+            i++;
+        }
+    }
+
+    if ((i < p->len) && ((data[i] == '.') || (data[i] == 'e') || (data[i] == 'E'))) {
+        return JsonUnsupportedNumber;
+    }
+
+    if (p->ctx) {
+        temp_stack_push(&p->values, term_from_int64(negative ? -value : value));
+    }
+    p->pos = i;
+
+    return JsonOk;
+}
+
+static enum JsonResult json_parse_literal(struct JsonParser *p)
+{
+    static const char *const literals[3] = { "true", "false", "null" };
+    const char *const atoms[3] = { true_atom, false_atom, null_atom };
+
+    for (int i = 0; i < 3; i++) {
+        size_t literal_len = strlen(literals[i]);
+        if ((p->len - p->pos >= literal_len) && !memcmp(p->data + p->pos, literals[i], literal_len)) {
+            if (p->ctx) {
+                temp_stack_push(&p->values, context_make_atom(p->ctx, atoms[i]));
+            }
+            p->pos += literal_len;
+            return JsonOk;
+        }
+    }
+
+    return JsonSyntaxError;
+}
+
+static enum JsonResult json_open(struct JsonParser *p, enum JsonContainer type)
+{
+    if (p->frames_count == p->frames_size) {
+        int new_size = p->frames_size ? p->frames_size * 2 : JSON_INITIAL_FRAMES;
+        struct JsonFrame *new_frames = realloc(p->frames, new_size * sizeof(struct JsonFrame));
+        if (IS_NULL_PTR(new_frames)) {
+            return JsonOutOfMemory;
+        }
+        p->frames = new_frames;
+        p->frames_size = new_size;
+    }
+
+    struct JsonFrame *frame = &p->frames[p->frames_count];
+    frame->type = type;
+    frame->count = 0;
+    p->frames_count++;
+    p->pos++;
+
+    if (type == JsonObject) {
+        // {Proplist}
+        p->heap_size += 2;
+    }
+
+    return JsonOk;
+}
+
+static void json_close(struct JsonParser *p)
+{
+    p->frames_count--;
+    p->pos++;
+
+    if (p->ctx) {
+        const struct JsonFrame *frame = &p->frames[p->frames_count];
+        term list = term_nil();
+        for (unsigned long i = 0; i < frame->count; i++) {
+            list = term_list_prepend(temp_stack_pop(&p->values), list, p->ctx);
+        }
+        if (frame->type == JsonObject) {
+            term object = term_alloc_tuple(1, p->ctx);
+            term_put_tuple_element(object, 0, list);
+            list = object;
+        }
+        temp_stack_push(&p->values, list);
+    }
+}
+
+// a value has been parsed, it is added to the enclosing container
+static void json_add_value(struct JsonParser *p)
+{
+    struct JsonFrame *frame = &p->frames[p->frames_count - 1];
+    frame->count++;
+
+    if (frame->type == JsonArray) {
+        p->heap_size += 2;
+    } else {
+        // list cell and {Key, Value}
+        p->heap_size += 2 + 3;
+        if (p->ctx) {
+            term pair = term_alloc_tuple(2, p->ctx);
+            term_put_tuple_element(pair, 1, temp_stack_pop(&p->values));
+            term_put_tuple_element(pair, 0, temp_stack_pop(&p->values));
+            temp_stack_push(&p->values, pair);
+        }
+    }
+}
+
+static enum JsonResult json_parse(struct JsonParser *p)
+{
+    enum JsonParserState state = JsonExpectValue;
+
+    while (1) {
+        json_skip_whitespace(p);
+        if (UNLIKELY(p->pos == p->len)) {
+            return JsonSyntaxError;
+        }
+        uint8_t c = p->data[p->pos];
+        enum JsonResult result = JsonOk;
+        int value_completed = 0;
+
+        switch (state) {
+            case JsonExpectKeyOrClose:
+                if (c == '}') {
+                    json_close(p);
+                    value_completed = 1;
+                    break;
+                }
+                // fall through
+
+            case JsonExpectKey:
+                if (UNLIKELY(c != '"')) {
+                    return JsonSyntaxError;
+                }
+                result = json_parse_string(p);
+                state = JsonExpectColon;
+                break;
+
+            case JsonExpectColon:
+                if (UNLIKELY(c != ':')) {
+                    return JsonSyntaxError;
+                }
+                p->pos++;
+                state = JsonExpectValue;
+                break;
+
+            case JsonExpectValueOrClose:
+                if (c == ']') {
+                    json_close(p);
+                    value_completed = 1;
+                    break;
+                }
+                // fall through
+
+            case JsonExpectValue:
+                if (c == '[') {
+                    result = json_open(p, JsonArray);
+                    state = JsonExpectValueOrClose;
+                } else if (c == '{') {
+                    result = json_open(p, JsonObject);
+                    state = JsonExpectKeyOrClose;
+                } else {
+                    if (c == '"') {
+                        result = json_parse_string(p);
+                    } else if ((c == '-') || ((c >= '0') && (c <= '9'))) {
+                        result = json_parse_number(p);
+                    } else {
+                        result = json_parse_literal(p);
+                    }
+                    value_completed = 1;
+                }
+                break;
+
+            case JsonExpectCommaOrClose: {
+                enum JsonContainer type = p->frames[p->frames_count - 1].type;
+                if (c == ',') {
+                    p->pos++;
+                    state = (type == JsonArray) ? JsonExpectValue : JsonExpectKey;
+                } else if (c == ((type == JsonArray) ? ']' : '}')) {
+                    json_close(p);
+                    value_completed = 1;
+                } else {
+                    return JsonSyntaxError;
+                }
+                break;
+            }
+        }
+
+        if (UNLIKELY(result != JsonOk)) {
+            return result;
+        }
+
+        if (value_completed) {
+            if (p->frames_count == 0) {
+                json_skip_whitespace(p);
+                return (p->pos == p->len) ? JsonOk : JsonSyntaxError;
+            }
+            json_add_value(p);
+            state = JsonExpectCommaOrClose;
+        }
+    }
+}
+
+static void json_parser_init(struct JsonParser *p, Context *ctx, term json)
+{
+    p->data = (const uint8_t *) term_binary_data(json);
+    p->len = term_binary_size(json);
+    p->pos = 0;
+    p->ctx = ctx;
+    p->heap_size = 0;
+    temp_stack_init(&p->values);
+    p->frames = NULL;
+    p->frames_count = 0;
+    p->frames_size = 0;
+}
+
+static void json_parser_destroy(struct JsonParser *p)
+{
+    temp_stack_destory(&p->values);
+    free(p->frames);
+}
+
+enum JsonResult json_decode(Context *ctx, term *json, term *result)
+{
+    if (!term_is_binary(*json)) {
+        return JsonBadArg;
+    }
+
+    struct JsonParser p;
+    json_parser_init(&p, NULL, *json);
+    enum JsonResult parse_result = json_parse(&p);
+    unsigned long heap_size = p.heap_size;
+    json_parser_destroy(&p);
+    if (parse_result != JsonOk) {
+        return parse_result;
+    }
+
+    memory_ensure_free(ctx, heap_size);
+
+    // GC might have moved the binary, input is known to be valid now
+    json_parser_init(&p, ctx, *json);
+    parse_result = json_parse(&p);
+    if (LIKELY(parse_result == JsonOk)) {
+        *result = temp_stack_pop(&p.values);
+    }
+    json_parser_destroy(&p);
+
+    return parse_result;
+}
+
+static void json_write(struct JsonWriter *w, const void *data, size_t len)
+{
+    if (w->out) {
+        memcpy(w->out + w->len, data, len);
+    }
+    w->len += len;
+}
+
+static void json_write_char(struct JsonWriter *w, char c)
+{
+    if (w->out) {
+        w->out[w->len] = c;
+    }
+    w->len++;
+}
+
+static void json_write_string(struct JsonWriter *w, const uint8_t *data, size_t len)
+{
+    static const char hex_digits[16] = "0123456789abcdef";
+
+    json_write_char(w, '"');
+    size_t i = 0;
+    while (1) {
+        size_t plain = json_plain_length(data + i, len - i);
+        json_write(w, data + i, plain);
+        i += plain;
+        if (i == len) {
+            break;
+        }
+
+        uint8_t c = data[i];
+        char escaped[6] = { '\\', c, 0, 0, 0, 0 };
+        int escaped_len = 2;
+        switch (c) {
+            case '"':
+            case '\\':
+                break;
+            case '\b': escaped[1] = 'b'; break;
+            case '\f': escaped[1] = 'f'; break;
+            case '\n': escaped[1] = 'n'; break;
+            case '\r': escaped[1] = 'r'; break;
+            case '\t': escaped[1] = 't'; break;
+            default:
+                escaped[1] = 'u';
+                escaped[2] = '0';
+                escaped[3] = '0';
+                escaped[4] = hex_digits[c >> 4];
+                escaped[5] = hex_digits[c & 0xF];
+                escaped_len = 6;
+                break;
+        }
+        json_write(w, escaped, escaped_len);
+        i++;
+    }
+    json_write_char(w, '"');
+}
+
+static void json_write_integer(struct JsonWriter *w, int64_t value)
+{
+    char buf[24];
+    int pos = sizeof(buf);
+    uint64_t magnitude = (value < 0) ? -(uint64_t) value : (uint64_t) value;
+
+    do {
+        buf[--pos] = '0' + (magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) {
+        buf[--pos] = '-';
+    }
+
+    json_write(w, buf + pos, sizeof(buf) - pos);
+}
+
+static void json_write_atom_string(struct JsonWriter *w, term t)
+{
+    AtomString atom_string = globalcontext_atomstring_from_term(w->ctx->global, t);
+    json_write_string(w, atom_string_data(atom_string), atom_string_len(atom_string));
+}
+
+static int json_write_key(struct JsonWriter *w, term key)
+{
+    if (term_is_binary(key)) {
+        json_write_string(w, (const uint8_t *) term_binary_data(key), term_binary_size(key));
+    } else if (term_is_atom(key)) {
+        json_write_atom_string(w, key);
+    } else {
+        return 0;
+    }
+    json_write_char(w, ':');
+
+    return 1;
+}
+
+static int json_is_object(term t)
+{
+    return term_is_tuple(t) && (term_get_tuple_arity(t) == 1) && term_is_list(term_get_tuple_element(t, 0));
+}
+
+// containers are kept on the stack as the remaining elements followed by one of these
+#define JSON_ARRAY_FIRST term_from_int32(0)
+#define JSON_ARRAY_NEXT term_from_int32(1)
+#define JSON_OBJECT_FIRST term_from_int32(2)
+#define JSON_OBJECT_NEXT term_from_int32(3)
+
+static enum JsonResult json_write_term(struct JsonWriter *w, term t)
+{
+    Context *ctx = w->ctx;
+    enum JsonResult result = JsonOk;
+
+    struct TempStack temp_stack;
+    temp_stack_init(&temp_stack);
+
+    while (1) {
+        if (term_is_list(t)) {
+            json_write_char(w, '[');
+            temp_stack_push(&temp_stack, t);
+            temp_stack_push(&temp_stack, JSON_ARRAY_FIRST);
+
+        } else if (json_is_object(t)) {
+            json_write_char(w, '{');
+            temp_stack_push(&temp_stack, term_get_tuple_element(t, 0));
+            temp_stack_push(&temp_stack, JSON_OBJECT_FIRST);
+
+        } else if (term_is_integer(t)) {
+            json_write_integer(w, term_to_int64(t));
+
+        } else if (term_is_binary(t)) {
+            json_write_string(w, (const uint8_t *) term_binary_data(t), term_binary_size(t));
+
+        } else if (term_is_atom(t)) {
+            if (t == context_make_atom(ctx, true_atom)) {
+                json_write(w, "true", 4);
+            } else if (t == context_make_atom(ctx, false_atom)) {
+                json_write(w, "false", 5);
+            } else if (t == context_make_atom(ctx, null_atom)) {
+                json_write(w, "null", 4);
+            } else {
+                json_write_atom_string(w, t);
+            }
+
+        } else {
+            result = JsonBadArg;
+            break;
+        }
+
+        // write separators and closing brackets until next value is found
+        int found = 0;
+        while (!found && !temp_stack_is_empty(&temp_stack)) {
+            term kind = temp_stack_pop(&temp_stack);
+            term rest = temp_stack_pop(&temp_stack);
+            int is_object = (kind == JSON_OBJECT_FIRST) || (kind == JSON_OBJECT_NEXT);
+
+            if (term_is_nil(rest)) {
+                json_write_char(w, is_object ? '}' : ']');
+                continue;
+            } else if (UNLIKELY(!term_is_nonempty_list(rest))) {
+                result = JsonBadArg;
+                break;
+            }
+
+            if ((kind == JSON_ARRAY_NEXT) || (kind == JSON_OBJECT_NEXT)) {
+                json_write_char(w, ',');
+            }
+            temp_stack_push(&temp_stack, term_get_list_tail(rest));
+            temp_stack_push(&temp_stack, is_object ? JSON_OBJECT_NEXT : JSON_ARRAY_NEXT);
+
+            t = term_get_list_head(rest);
+            if (is_object) {
+                if (UNLIKELY(!term_is_tuple(t) || (term_get_tuple_arity(t) != 2)
+                        || !json_write_key(w, term_get_tuple_element(t, 0)))) {
+                    result = JsonBadArg;
+                    break;
+                }
+                t = term_get_tuple_element(t, 1);
+            }
+            found = 1;
+        }
+
+        if ((result != JsonOk) || !found) {
+            break;
+        }
+    }
+
+    temp_stack_destory(&temp_stack);
+
+    return result;
+}
+
+enum JsonResult json_encode(Context *ctx, term *value, term *result)
+{
+    struct JsonWriter w = {
+        .out = NULL,
+        .len = 0,
+        .ctx = ctx
+    };
+
+    enum JsonResult write_result = json_write_term(&w, *value);
+    if (write_result != JsonOk) {
+        return write_result;
+    }
+
+    size_t len = w.len;
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(len) + 2);
+    term binary = term_create_uninitialized_binary(len, ctx);
+
+    // GC might have moved the term, it has already been validated
+    w.out = (uint8_t *) term_binary_data(binary);
+    w.len = 0;
+    json_write_term(&w, *value);
+    *result = binary;
+
+    return JsonOk;
+}
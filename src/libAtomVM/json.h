@@ -0,0 +1,70 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file json.h
+ * @brief JSON encoding and decoding.
+ *
+ * @details JSON objects are represented as {[{Key, Value}]}, arrays as lists, strings as binaries and
+ *          true, false and null as atoms. Object keys are decoded as binaries, and they can be either
+ *          binaries or atoms when encoding. Floats are not supported, since there is no float term.
+ *          Both directions run two passes: the first one validates input and computes the exact
+ *          size of the output, the second one writes it without further checks.
+ */
+
+#ifndef _JSON_H_
+#define _JSON_H_
+
+#include "context.h"
+#include "term.h"
+
+enum JsonResult
+{
+    JsonOk = 0,
+    JsonBadArg,
+    JsonSyntaxError,
+    JsonUnsupportedNumber,
+    JsonOverflow,
+    JsonOutOfMemory
+};
+
+/**
+ * @brief Decodes a JSON document
+ *
+ * @details The document must hold exactly one value, surrounded by optional whitespace.
+ * @param ctx the context that owns the memory that will be allocated.
+ * @param json a pointer to the binary that will be decoded. It must be a GC root (such as an x
+ *        register), since the heap is grown before building the result.
+ * @param result the decoded term, set only when JsonOk is returned.
+ * @returns JsonOk or an error.
+ */
+enum JsonResult json_decode(Context *ctx, term *json, term *result);
+
+/**
+ * @brief Encodes a term to a JSON binary
+ *
+ * @param ctx the context that owns the memory that will be allocated.
+ * @param value a pointer to the term that will be encoded. It must be a GC root (such as an x
+ *        register), since the heap is grown before building the result.
+ * @param result the encoded binary, set only when JsonOk is returned.
+ * @returns JsonOk or an error.
+ */
+enum JsonResult json_encode(Context *ctx, term *value, term *result);
+
+#endif
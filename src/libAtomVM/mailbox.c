@@ -21,6 +21,7 @@
 #include "memory.h"
 #include "scheduler.h"
 #include "trace.h"
+#include "valueshashtable.h"
 
 #define ADDITIONAL_PROCESSING_MEMORY_SIZE 4
 
@@ -29,37 +30,217 @@ static inline term *mailbox_message_memory(Message *msg)
     return &msg->message + 1;
 }
 
-void mailbox_send(Context *c, term t)
+static inline unsigned long mailbox_message_size(const Message *msg)
 {
-    TRACE("Sending 0x%lx to pid %i\n", t, c->process_id);
+    return sizeof(Message) + msg->msg_memory_size * sizeof(term);
+}
+
+static int mailbox_exceeds_limits(const Context *c, unsigned long len, unsigned long size)
+{
+    return (c->message_queue_max_len && (len > c->message_queue_max_len))
+        || (c->message_queue_max_size && (size > c->message_queue_max_size));
+}
+
+static void mailbox_release_blocked_sender(unsigned long key, unsigned long value, void *data)
+{
+    UNUSED(value);
+
+    Context *c = (Context *) data;
+    Context *sender = globalcontext_get_process(c->global, key);
+    if (sender && (sender->blocked_on == c->process_id)) {
+        sender->blocked_on = 0;
+        scheduler_make_ready(c->global, sender);
+    }
+}
+
+static void mailbox_release_blocked_senders(Context *c)
+{
+    struct ValuesHashTable *blocked_senders = c->blocked_senders;
+    c->blocked_senders = NULL;
 
+    valueshashtable_foreach(blocked_senders, mailbox_release_blocked_sender, c);
+    valueshashtable_destroy(blocked_senders);
+}
+
+// every message leaves the mailbox through here, so accounting is kept in sync
+static void mailbox_unlink_message(Context *c, Message *m)
+{
+    linkedlist_remove(&c->mailbox, &m->mailbox_list_head);
+
+    unsigned long size = mailbox_message_size(m);
+    c->message_queue_len--;
+    c->message_queue_size -= size;
+    c->global->used_memory -= size;
+
+    if (c->blocked_senders && !mailbox_exceeds_limits(c, c->message_queue_len, c->message_queue_size)) {
+        mailbox_release_blocked_senders(c);
+    }
+}
+
+Message *mailbox_message_create(term t)
+{
     unsigned long estimated_mem_usage = memory_estimate_usage(t);
 
-    Message *m = malloc(sizeof(Message) + estimated_mem_usage * sizeof(term));
+    Message *m = memory_terms_alloc(sizeof(Message) + estimated_mem_usage * sizeof(term));
     if (IS_NULL_PTR(m)) {
         fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
-        return;
+        return NULL;
     }
 
     term *heap_pos = mailbox_message_memory(m);
     m->message = memory_copy_term_tree(&heap_pos, t);
     m->msg_memory_size = estimated_mem_usage;
 
+    return m;
+}
+
+Message *mailbox_message_move(Context *ctx, term t)
+{
+    unsigned long size = memory_movable_size(ctx, t);
+    if (!size) {
+        return mailbox_message_create(t);
+    }
+
+    unsigned long estimated_mem_usage = memory_estimate_usage(t);
+
+    Message *m = memory_terms_alloc(sizeof(Message) + estimated_mem_usage * sizeof(term));
+    if (IS_NULL_PTR(m)) {
+        fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+        return NULL;
+    }
+
+    TRACE("Releasing %lu terms of pid %i heap\n", size, ctx->process_id);
+    term *heap_pos = mailbox_message_memory(m);
+    m->message = memory_move_term_tree(ctx, t, &heap_pos, size);
+    m->msg_memory_size = estimated_mem_usage;
+
+    return m;
+}
+
+Message *mailbox_message_decode(GlobalContext *glb, const uint8_t *buf, size_t size, size_t *bytes_read, const struct ExternalTermAtomRefs *refs)
+{
+    int heap_usage = externalterm_decoded_size(buf, size, refs, glb);
+    if (heap_usage < 0) {
+        return NULL;
+    }
+
+    Message *m = memory_terms_alloc(sizeof(Message) + heap_usage * sizeof(term));
+    if (IS_NULL_PTR(m)) {
+        fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+        return NULL;
+    }
+
+    term *heap_pos = mailbox_message_memory(m);
+    m->message = externalterm_decode_to_heap(buf, bytes_read, refs, glb, &heap_pos, heap_usage);
+    m->msg_memory_size = heap_usage;
+
+    return m;
+}
+
+void mailbox_message_destroy(Message *m)
+{
+    memory_terms_free(m);
+}
+
+void mailbox_enqueue_message(Context *c, Message *m)
+{
+    // messages sent to a terminating process are dropped, as if it was already dead
+    if (UNLIKELY(c->exiting)) {
+        mailbox_message_destroy(m);
+        return;
+    }
+
+    GlobalContext *glb = c->global;
+    unsigned long size = mailbox_message_size(m);
+
+    // an overloaded receiver loses messages instead of exhausting memory
+    if (UNLIKELY(!memory_check_pressure(c, size))) {
+        TRACE("Dropping message to pid %i: memory budget exceeded.\n", c->process_id);
+        mailbox_message_destroy(m);
+        return;
+    }
+
+    if (UNLIKELY(mailbox_exceeds_limits(c, c->message_queue_len + 1, c->message_queue_size + size))) {
+        switch (c->message_queue_policy) {
+            case MessageQueueDropNewest:
+                mailbox_message_destroy(m);
+                return;
+
+            case MessageQueueDropOldest:
+                while (c->mailbox && mailbox_exceeds_limits(c, c->message_queue_len + 1, c->message_queue_size + size)) {
+                    Message *oldest = GET_LIST_ENTRY(c->mailbox, Message, mailbox_list_head);
+                    mailbox_unlink_message(c, oldest);
+                    mailbox_message_destroy(oldest);
+                }
+                if (mailbox_exceeds_limits(c, 1, size)) {
+                    mailbox_message_destroy(m);
+                    return;
+                }
+                break;
+
+            case MessageQueueBlock:
+                // the message is queued anyway, the sender is suspended by mailbox_block_sender
+                break;
+        }
+    }
+
     linkedlist_append(&c->mailbox, &m->mailbox_list_head);
+    c->message_queue_len++;
+    c->message_queue_size += size;
+    glb->used_memory += size;
+
+    // a blocked sender is resumed only when the mailbox that blocked it is drained
+    if (c->blocked_on) {
+        return;
+    }
 
     if (c->jump_to_on_restore) {
         c->saved_ip = c->jump_to_on_restore;
         c->jump_to_on_restore = NULL;
     }
-    scheduler_make_ready(c->global, c);
+    scheduler_make_ready(glb, c);
+}
+
+int mailbox_block_sender(Context *c, Context *sender)
+{
+    // a blocked process cannot drain its own mailbox, so it never blocks others
+    if ((c->message_queue_policy != MessageQueueBlock) || (c == sender) || c->blocked_on
+            || !mailbox_exceeds_limits(c, c->message_queue_len, c->message_queue_size)) {
+        return 0;
+    }
+
+    if (!c->blocked_senders) {
+        c->blocked_senders = valueshashtable_new();
+        if (IS_NULL_PTR(c->blocked_senders)) {
+            return 0;
+        }
+    }
+    if (UNLIKELY(!valueshashtable_insert(c->blocked_senders, sender->process_id, 1))) {
+        return 0;
+    }
+    sender->blocked_on = c->process_id;
+
+    return 1;
+}
+
+void mailbox_send(Context *c, term t)
+{
+    TRACE("Sending 0x%lx to pid %i\n", t, c->process_id);
+
+    Message *m = mailbox_message_create(t);
+    if (IS_NULL_PTR(m)) {
+        return;
+    }
+
+    mailbox_enqueue_message(c, m);
 }
 
 term mailbox_receive(Context *c)
 {
     Message *m = GET_LIST_ENTRY(c->mailbox, Message, mailbox_list_head);
-    linkedlist_remove(&c->mailbox, &m->mailbox_list_head);
+    mailbox_unlink_message(c, m);
 
-    if (c->e - c->heap_ptr < m->msg_memory_size) {
+    if (context_avail_free_memory(c) < (unsigned long) m->msg_memory_size) {
         //ADDITIONAL_PROCESSING_MEMORY_SIZE: ensure some additional memory for message processing, so there is
         //no need to run GC again.
         if (UNLIKELY(memory_gc(c, context_memory_size(c) + m->msg_memory_size + ADDITIONAL_PROCESSING_MEMORY_SIZE) != MEMORY_GC_OK)) {
@@ -69,7 +250,7 @@ term mailbox_receive(Context *c)
 
     term rt = memory_copy_term_tree(&c->heap_ptr, m->message);
 
-    free(m);
+    mailbox_message_destroy(m);
 
     TRACE("Pid %i is receiving 0x%lx.\n", c->process_id, rt);
 
@@ -79,7 +260,7 @@ term mailbox_receive(Context *c)
 Message *mailbox_dequeue(Context *c)
 {
     Message *m = GET_LIST_ENTRY(c->mailbox, Message, mailbox_list_head);
-    linkedlist_remove(&c->mailbox, &m->mailbox_list_head);
+    mailbox_unlink_message(c, m);
 
     TRACE("Pid %i is dequeueing 0x%lx.\n", c->process_id, m->message);
 
@@ -92,7 +273,7 @@ term mailbox_peek(Context *c)
 
     TRACE("Pid %i is peeking 0x%lx.\n", c->process_id, m->message);
 
-    if (c->e - c->heap_ptr < m->msg_memory_size) {
+    if (context_avail_free_memory(c) < (unsigned long) m->msg_memory_size) {
         //ADDITIONAL_PROCESSING_MEMORY_SIZE: ensure some additional memory for message processing, so there is
         //no need to run GC again.
         if (UNLIKELY(memory_gc(c, context_memory_size(c) + m->msg_memory_size + ADDITIONAL_PROCESSING_MEMORY_SIZE) != MEMORY_GC_OK)) {
@@ -113,9 +294,28 @@ void mailbox_remove(Context *c)
     }
 
     Message *m = GET_LIST_ENTRY(c->mailbox, Message, mailbox_list_head);
-    linkedlist_remove(&c->mailbox, &m->mailbox_list_head);
+    mailbox_unlink_message(c, m);
 
     TRACE("Pid %i is removing a message.\n", c->process_id);
 
-    free(m);
+    mailbox_message_destroy(m);
+}
+
+void mailbox_remove_message(Context *c, Message *m)
+{
+    mailbox_unlink_message(c, m);
+    mailbox_message_destroy(m);
+}
+
+void mailbox_destroy(Context *c)
+{
+    while (c->mailbox) {
+        Message *m = GET_LIST_ENTRY(c->mailbox, Message, mailbox_list_head);
+        mailbox_unlink_message(c, m);
+        mailbox_message_destroy(m);
+    }
+
+    if (c->blocked_senders) {
+        mailbox_release_blocked_senders(c);
+    }
 }
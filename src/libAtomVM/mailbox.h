@@ -30,6 +30,7 @@
 #include "linkedlist.h"
 #include "term.h"
 #include "context.h"
+#include "externalterm.h"
 
 typedef struct
 {
@@ -38,6 +39,70 @@ typedef struct
     term message;
 } Message;
 
+/**
+ * @brief Creates a message from a term.
+ *
+ * @details Copies a term to a newly allocated message, that can be enqueued later on any mailbox.
+ * @param t the term that will be copied.
+ * @returns the new message or NULL if memory could not be allocated, the caller must destroy it if it is not enqueued.
+ */
+Message *mailbox_message_create(term t);
+
+/**
+ * @brief Creates a message from a term that will not be used anymore.
+ *
+ * @details The term is copied as mailbox_message_create does. When it has been allocated on top of the sender heap
+ *          and it is not referenced from the stack or the process dictionary, its heap memory is also given back to
+ *          the sender instead of waiting for the next garbage collection. x registers referring to it are cleared,
+ *          so this must not be used when they are still live.
+ * @param ctx the sender context, that owns the term.
+ * @param t the term that will be moved or copied.
+ * @returns the new message or NULL if memory could not be allocated, the caller must destroy it if it is not enqueued.
+ */
+Message *mailbox_message_move(Context *ctx, term t);
+
+/**
+ * @brief Creates a message from an untrusted encoded term.
+ *
+ * @details Decodes a term without the version tag, as externalterm_decode does, to a newly allocated message, so no
+ *          process heap is used.
+ * @param glb the global context that owns the term atoms.
+ * @param buf the encoded term.
+ * @param size the size of buf, the term might be followed by other data.
+ * @param bytes_read will be set to the size of the encoded term, it can be NULL.
+ * @param refs the atoms referenced by the enclosing distribution message, or NULL.
+ * @returns the new message or NULL if buf is malformed or memory could not be allocated, the caller must destroy it if it is not enqueued.
+ */
+Message *mailbox_message_decode(GlobalContext *glb, const uint8_t *buf, size_t size, size_t *bytes_read, const struct ExternalTermAtomRefs *refs);
+
+/**
+ * @brief Frees a message.
+ *
+ * @details Frees a message that has not been enqueued, or that has been dequeued with mailbox_dequeue.
+ * @param m the message that will be freed.
+ */
+void mailbox_message_destroy(Message *m);
+
+/**
+ * @brief Enqueues a message to a certain mailbox.
+ *
+ * @details Appends a message that has been created with mailbox_message_create to a process or port mailbox,
+ *          the mailbox takes ownership of the message.
+ * @param c the process context.
+ * @param m the message that will be enqueued.
+ */
+void mailbox_enqueue_message(Context *c, Message *m);
+
+/**
+ * @brief Suspends a sender when the receiver mailbox is full.
+ * @details When the receiver mailbox is over its limits and its policy is MessageQueueBlock, the sender is
+ *          recorded and it will be made ready again once the receiver drains its mailbox.
+ * @param c the receiver context, a message has just been enqueued to it.
+ * @param sender the sender context.
+ * @returns 1 if the sender must wait, 0 otherwise.
+ */
+int mailbox_block_sender(Context *c, Context *sender);
+
 /**
  * @brief Sends a message to a certain mailbox.
  *
@@ -61,7 +126,7 @@ term mailbox_receive(Context *c);
  *
  * @details Dequeue a message that has been previously queued on a certain process or driver mailbox.
  * @param c the process or driver context.
- * @returns dequeued message, the caller must free() the message.
+ * @returns dequeued message, the caller must destroy the message with mailbox_message_destroy.
  */
 Message *mailbox_dequeue(Context *c);
 
@@ -82,4 +147,21 @@ term mailbox_peek(Context *c);
  */
 void mailbox_remove(Context *c);
 
+/**
+ * @brief Removes a given message from a mailbox.
+ *
+ * @details Unlinks and frees a message that is queued anywhere on a certain process mailbox.
+ * @param c the process context.
+ * @param m the message that will be removed.
+ */
+void mailbox_remove_message(Context *c, Message *m);
+
+/**
+ * @brief Frees all messages still queued on a mailbox.
+ *
+ * @details Discards every pending message, used when a process or driver is destroyed.
+ * @param c the process or driver context.
+ */
+void mailbox_destroy(Context *c);
+
 #endif
@@ -17,28 +17,42 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
  ***************************************************************************/
 
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef AVM_COMPACT_TERMS
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
 #include "context.h"
 #include "debug.h"
+#include "list.h"
 #include "memory.h"
+#include "scheduler.h"
+#include "tempstack.h"
 
 //#define ENABLE_TRACE
 
 #include "trace.h"
 
-#define MIN_FREE_SPACE_SIZE 8
-
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
-static void memory_scan_and_copy(term *mem_start, const term *mem_end, term **new_heap_pos, int move);
+static term *memory_scan_and_copy(term *mem_start, const term *mem_end, term **new_heap_pos, int move);
 static term memory_shallow_copy_term(term t, term **new_heap, int move);
+static void memory_check_limits(Context *ctx, unsigned long old_size, unsigned long new_size);
+static enum MemoryGCResult memory_gc_begin(Context *ctx, int new_size, term **old_heap, unsigned long *old_size);
+static void memory_deferred_gc_run(Context *ctx, unsigned long max_scan);
+#ifdef AVM_SEPARATE_STACK
+static enum MemoryGCResult memory_resize_stack(Context *ctx, unsigned long new_size);
+#endif
 
 HOT_FUNC term *memory_heap_alloc(Context *c, uint32_t size)
 {
     term *allocated = c->heap_ptr;
-    if (c->heap_ptr + size > c->e) {
+    if (context_avail_free_memory(c) < size) {
         TRACE("GC is needed.\n");
         memory_ensure_free(c, size);
         allocated = c->heap_ptr;
@@ -67,32 +81,204 @@ void memory_ensure_free(Context *c, uint32_t size)
     }
 }
 
+// Counts the heap terms that a collection would copy: roots are the same of memory_gc_begin, and terms that are
+// reachable more than once are counted once thanks to a mark bit for each heap term.
+static unsigned long memory_live_heap_size(Context *ctx)
+{
+    const term *heap_start = ctx->heap_start;
+    unsigned long heap_size = ctx->heap_ptr - ctx->heap_start;
+    uint8_t *marks = calloc(heap_size / 8 + 1, sizeof(uint8_t));
+    if (IS_NULL_PTR(marks)) {
+        return heap_size;
+    }
+
+    struct TempStack temp_stack;
+    temp_stack_init(&temp_stack);
+    for (int i = 0; i < ctx->avail_registers; i++) {
+        temp_stack_push(&temp_stack, ctx->x[i]);
+    }
+    for (const term *stack = ctx->e; stack < ctx->stack_base; stack++) {
+        temp_stack_push(&temp_stack, *stack);
+    }
+    for (int i = 0; i < ctx->dictionary.capacity; i++) {
+        const struct DictionaryEntry *entry = &ctx->dictionary.entries[i];
+        if (dictionary_entry_is_used(entry)) {
+            temp_stack_push(&temp_stack, entry->key);
+            temp_stack_push(&temp_stack, entry->value);
+        }
+    }
+
+    unsigned long live_size = 0;
+    while (!temp_stack_is_empty(&temp_stack)) {
+        term t = temp_stack_pop(&temp_stack);
+        // CPs and catch labels are found only on stack
+        if (term_is_cp(t) || term_is_catch_label(t) || (!term_is_nonempty_list(t) && !term_is_boxed(t))) {
+            continue;
+        }
+
+        const term *ptr = term_to_const_term_ptr(t);
+        if ((ptr >= heap_start) && (ptr < ctx->heap_ptr)) {
+            unsigned long index = ptr - heap_start;
+            if (marks[index / 8] & (1 << (index % 8))) {
+                continue;
+            }
+            marks[index / 8] |= 1 << (index % 8);
+        }
+
+        if (term_is_nonempty_list(t)) {
+            live_size += 2;
+            temp_stack_push(&temp_stack, ptr[0]);
+            temp_stack_push(&temp_stack, ptr[1]);
+            continue;
+        }
+
+        int size = term_get_size_from_boxed_header(ptr[0]);
+        live_size += size + 1;
+        switch (ptr[0] & TERM_BOXED_TAG_MASK) {
+            case TERM_BOXED_TUPLE:
+                for (int i = 1; i <= size; i++) {
+                    temp_stack_push(&temp_stack, ptr[i]);
+                }
+                break;
+
+            case TERM_BOXED_FUN:
+                // module and fun table entry are not terms
+                for (int i = 3; i <= size; i++) {
+                    temp_stack_push(&temp_stack, ptr[i]);
+                }
+                break;
+
+            case TERM_BOXED_SUB_BINARY:
+                temp_stack_push(&temp_stack, ptr[3]);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    temp_stack_destory(&temp_stack);
+    free(marks);
+
+    return live_size;
+}
+
 void memory_gc_and_shrink(Context *c)
 {
-    if (context_avail_free_memory(c) >= MIN_FREE_SPACE_SIZE * 2) {
-        if (UNLIKELY(memory_gc(c, context_memory_size(c) - context_avail_free_memory(c) / 2) != MEMORY_GC_OK)) {
+    while (c->deferred_gc) {
+        memory_deferred_gc_run(c, ULONG_MAX);
+    }
+
+    // live terms are counted first, so a single collection moves them to a memory block that fits them exactly
+    unsigned long live_size = memory_live_heap_size(c);
+#ifndef AVM_SEPARATE_STACK
+    live_size += c->stack_base - c->e;
+#endif
+    live_size = MAX(live_size, MIN_FREE_SPACE_SIZE);
+    if (context_memory_size(c) > live_size) {
+        if (UNLIKELY(memory_gc(c, live_size) != MEMORY_GC_OK)) {
+            fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+            return;
+        }
+    }
+
+#ifdef AVM_SEPARATE_STACK
+    unsigned long stack_size = MAX((unsigned long) (c->stack_base - c->e), MIN_FREE_SPACE_SIZE);
+    if (context_stack_memory_size(c) > stack_size) {
+        if (UNLIKELY(memory_resize_stack(c, stack_size) != MEMORY_GC_OK)) {
             fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
         }
     }
+#endif
 }
 
+#ifdef AVM_SEPARATE_STACK
+
+// The stack is moved to the top of a new memory block, catch frames and term references are relative to its ends.
+static enum MemoryGCResult memory_resize_stack(Context *ctx, unsigned long new_size)
+{
+    unsigned long old_size = context_stack_memory_size(ctx);
+    unsigned long stack_size = ctx->stack_base - ctx->e;
+
+    memory_check_limits(ctx, context_memory_size(ctx) + old_size, context_memory_size(ctx) + new_size);
+
+    term *new_stack = calloc(new_size, sizeof(term));
+    if (IS_NULL_PTR(new_stack)) {
+        return MEMORY_GC_ERROR_FAILED_ALLOCATION;
+    }
+    memcpy(new_stack + new_size - stack_size, ctx->e, stack_size * sizeof(term));
+    free(ctx->stack_start);
+
+    ctx->global->used_memory -= old_size * sizeof(term);
+    ctx->global->used_memory += new_size * sizeof(term);
+
+    ctx->stack_start = new_stack;
+    ctx->stack_base = new_stack + new_size;
+    ctx->e = ctx->stack_base - stack_size;
+
+    return MEMORY_GC_OK;
+}
+
+void memory_grow_stack(Context *ctx, uint32_t size)
+{
+    unsigned long stack_size = ctx->stack_base - ctx->e;
+    unsigned long new_size = MAX(context_stack_memory_size(ctx) * 2, stack_size + size);
+
+    TRACE("Growing stack to %lu terms, heap is left untouched.\n", new_size);
+    if (UNLIKELY(memory_resize_stack(ctx, new_size) != MEMORY_GC_OK)) {
+        //TODO: handle this more gracefully
+        fprintf(stderr, "Unable to allocate memory for stack\n");
+        abort();
+    }
+}
+
+#else
+
 static inline void push_to_stack(term **stack, term value)
 {
     *stack = (*stack) - 1;
     **stack = value;
 }
 
-enum MemoryGCResult memory_gc(Context *ctx, int new_size)
+#endif
+
+// Limits are enforced when the heap or the stack grows, sizes are the total memory of the process: the allocation is
+// still satisfied, so callers never see a failure, but the process is flagged and it will be killed as soon as it yields.
+static void memory_check_limits(Context *ctx, unsigned long old_size, unsigned long new_size)
 {
-    TRACE("Going to perform gc\n");
-    term *new_heap = calloc(new_size, sizeof(term));
+    if ((new_size <= old_size) || ctx->kill_pending) {
+        return;
+    }
+
+    if (ctx->max_heap_size && (new_size > ctx->max_heap_size)) {
+        if (ctx->max_heap_size_log) {
+            fprintf(stderr, "Process <0.%i.0> exceeded its max_heap_size: %lu words.\n", ctx->process_id, new_size);
+        }
+        if (ctx->max_heap_size_kill) {
+            ctx->kill_pending = 1;
+        }
+        return;
+    }
+
+    if (!memory_check_pressure(ctx, (new_size - old_size) * sizeof(term))) {
+        fprintf(stderr, "Process <0.%i.0> exceeded the memory budget, it will be killed.\n", ctx->process_id);
+        ctx->kill_pending = 1;
+    }
+}
+
+// Copies roots to a new memory block, that becomes the process heap: terms that are referenced by roots are copied but
+// not scanned yet, so the caller must scan the new heap up to heap_ptr and then free the old memory block.
+static enum MemoryGCResult memory_gc_begin(Context *ctx, int new_size, term **old_heap, unsigned long *old_size)
+{
+    unsigned long stack_memory_size = context_stack_memory_size(ctx);
+    memory_check_limits(ctx, context_memory_size(ctx) + stack_memory_size, new_size + stack_memory_size);
+
+    term *new_heap = memory_terms_calloc(new_size, sizeof(term));
     if (IS_NULL_PTR(new_heap)) {
         return MEMORY_GC_ERROR_FAILED_ALLOCATION;
     }
-    term *new_stack = new_heap + new_size;
 
     term *heap_ptr = new_heap;
-    term *stack_ptr = new_stack;
 
     TRACE("- Running copy GC on registers\n");
     for (int i = 0; i < ctx->avail_registers; i++) {
@@ -100,6 +286,15 @@ enum MemoryGCResult memory_gc(Context *ctx, int new_size)
         ctx->x[i] = new_root;
     }
 
+#ifdef AVM_SEPARATE_STACK
+    TRACE("- Running copy GC on stack in place (stack size: %i)\n", (int) (ctx->stack_base - ctx->e));
+    for (term *stack = ctx->e; stack < ctx->stack_base; stack++) {
+        *stack = memory_shallow_copy_term(*stack, &heap_ptr, 1);
+    }
+    // popped frames still refer to the old heap, and new frames are not always initialized
+    memset(ctx->stack_start, 0, (ctx->e - ctx->stack_start) * sizeof(term));
+#else
+    term *stack_ptr = new_heap + new_size;
     term *stack = ctx->e;
     int stack_size = ctx->stack_base - ctx->e;
     TRACE("- Running copy GC on stack (stack size: %i)\n", stack_size);
@@ -107,28 +302,175 @@ enum MemoryGCResult memory_gc(Context *ctx, int new_size)
         term new_root = memory_shallow_copy_term(stack[i], &heap_ptr, 1);
         push_to_stack(&stack_ptr, new_root);
     }
+#endif
+
+    TRACE("- Running copy GC on process dictionary\n");
+    for (int i = 0; i < ctx->dictionary.capacity; i++) {
+        struct DictionaryEntry *entry = &ctx->dictionary.entries[i];
+        if (dictionary_entry_is_used(entry)) {
+            entry->key = memory_shallow_copy_term(entry->key, &heap_ptr, 1);
+            entry->value = memory_shallow_copy_term(entry->value, &heap_ptr, 1);
+        }
+    }
 
-    term *temp_start = new_heap;
-    term *temp_end = heap_ptr;
-    do {
-        term *next_end = temp_end;
-        memory_scan_and_copy(temp_start, temp_end, &next_end, 1);
-        temp_start = temp_end;
-        temp_end = next_end;
-    } while (temp_start != temp_end);
-
-    heap_ptr = temp_end;
-
-    free(ctx->heap_start);
+    // both memory blocks are accounted until the old one is freed
+    ctx->global->used_memory += new_size * sizeof(term);
+    *old_heap = ctx->heap_start;
+    *old_size = context_memory_size(ctx);
 
     ctx->heap_start = new_heap;
-    ctx->stack_base = ctx->heap_start + new_size;
     ctx->heap_ptr = heap_ptr;
+#ifdef AVM_SEPARATE_STACK
+    ctx->heap_end = new_heap + new_size;
+#else
+    ctx->stack_base = ctx->heap_start + new_size;
     ctx->e = stack_ptr;
+#endif
 
     return MEMORY_GC_OK;
 }
 
+int memory_check_pressure(Context *ctx, size_t size)
+{
+    GlobalContext *glb = ctx->global;
+    size_t needed = glb->used_memory + size;
+
+    int over_budget = glb->memory_budget && (needed > glb->memory_budget);
+    int over_soft_watermark = glb->memory_soft_watermark && (needed > glb->memory_soft_watermark);
+    if (LIKELY(!over_budget && !over_soft_watermark)) {
+        glb->memory_relief_level = 0;
+        return 1;
+    }
+
+    // other processes are not collected while allocating, the scheduler shrinks them later on.
+    // Processes that cannot be shrunk anymore are not walked again on each allocation.
+    if (needed > glb->memory_relief_level) {
+        glb->memory_shrink_pending = 1;
+    }
+
+    return !over_budget;
+}
+
+enum MemoryGCResult memory_gc(Context *ctx, int new_size)
+{
+    TRACE("Going to perform gc\n");
+
+    // an exit signal may reach a process that is being collected
+    while (ctx->deferred_gc) {
+        memory_deferred_gc_run(ctx, ULONG_MAX);
+    }
+
+    term *old_heap;
+    unsigned long old_size;
+    enum MemoryGCResult result = memory_gc_begin(ctx, new_size, &old_heap, &old_size);
+    if (UNLIKELY(result != MEMORY_GC_OK)) {
+        return result;
+    }
+
+    term *scan = ctx->heap_start;
+    while (scan < ctx->heap_ptr) {
+        scan = memory_scan_and_copy(scan, ctx->heap_ptr, &ctx->heap_ptr, 1);
+    }
+
+    ctx->global->used_memory -= old_size * sizeof(term);
+    memory_terms_free(old_heap);
+
+    return MEMORY_GC_OK;
+}
+
+int memory_ensure_free_deferred(Context *c, uint32_t size)
+{
+    unsigned long memory_size = context_memory_size(c);
+    if (memory_size < MEMORY_DEFERRED_GC_MIN_HEAP_SIZE) {
+        memory_ensure_free(c, size);
+        return 0;
+    }
+
+    struct DeferredGC *gc = malloc(sizeof(struct DeferredGC));
+    if (IS_NULL_PTR(gc)) {
+        memory_ensure_free(c, size);
+        return 0;
+    }
+
+    // same sizes as memory_ensure_free: the heap grows only if live terms leave too little free memory, and that
+    // is known only once the collection completes
+    unsigned long new_size = (memory_size > size) ? memory_size : MAX(memory_size * 2, memory_size + size);
+    if (UNLIKELY(memory_gc_begin(c, new_size, &gc->old_heap, &gc->old_size) != MEMORY_GC_OK)) {
+        free(gc);
+        memory_ensure_free(c, size);
+        return 0;
+    }
+    gc->ctx = c;
+    gc->scan = c->heap_start;
+    gc->min_free = size;
+    // the process is suspended just to wait for its own collection
+    gc->ready = 1;
+
+    c->deferred_gc = gc;
+    list_append(&c->global->deferred_gcs, &gc->deferred_gcs_list_head);
+
+    return 1;
+}
+
+static void memory_deferred_gc_run(Context *ctx, unsigned long max_scan)
+{
+    struct DeferredGC *gc = ctx->deferred_gc;
+
+    // a slice ends on a term boundary, so it may scan a few terms more than max_scan
+    term *scan_end = ctx->heap_ptr;
+    if ((unsigned long) (scan_end - gc->scan) > max_scan) {
+        scan_end = gc->scan + max_scan;
+    }
+    gc->scan = memory_scan_and_copy(gc->scan, scan_end, &ctx->heap_ptr, 1);
+    if (gc->scan < ctx->heap_ptr) {
+        return;
+    }
+
+    ctx->global->used_memory -= gc->old_size * sizeof(term);
+    memory_terms_free(gc->old_heap);
+
+    unsigned long memory_size = context_memory_size(ctx);
+    if (context_avail_free_memory(ctx) < gc->min_free + MIN_FREE_SPACE_SIZE) {
+        // live terms do not leave enough free memory: they are collected again to a larger memory block
+        unsigned long new_size = MAX(memory_size * 2, memory_size + gc->min_free);
+        if (LIKELY(memory_gc_begin(ctx, new_size, &gc->old_heap, &gc->old_size) == MEMORY_GC_OK)) {
+            gc->scan = ctx->heap_start;
+            return;
+        }
+    }
+
+    list_remove(&gc->deferred_gcs_list_head);
+    ctx->deferred_gc = NULL;
+    if (context_avail_free_memory(ctx) < gc->min_free + MIN_FREE_SPACE_SIZE) {
+        memory_ensure_free(ctx, gc->min_free);
+    }
+    int ready = gc->ready;
+    free(gc);
+
+    // exit signals complete the collection of processes they kill, that must not run anymore
+    if (ready && !ctx->exiting) {
+        scheduler_make_ready(ctx->global, ctx);
+    }
+}
+
+void memory_deferred_gc_slice(Context *ctx)
+{
+    memory_deferred_gc_run(ctx, MEMORY_DEFERRED_GC_SLICE_SIZE);
+}
+
+void memory_deferred_gc_discard(Context *ctx)
+{
+    struct DeferredGC *gc = ctx->deferred_gc;
+    if (!gc) {
+        return;
+    }
+
+    list_remove(&gc->deferred_gcs_list_head);
+    ctx->deferred_gc = NULL;
+    ctx->global->used_memory -= gc->old_size * sizeof(term);
+    memory_terms_free(gc->old_heap);
+    free(gc);
+}
 
 static inline int memory_is_moved_marker(term *t)
 {
@@ -167,62 +509,6 @@ term memory_copy_term_tree(term **new_heap, term t)
     return copied_term;
 }
 
-struct TempStack
-{
-    term *stack_end;
-    term *stack_pos;
-    int size;
-};
-
-static inline void temp_stack_init(struct TempStack *temp_stack)
-{
-    temp_stack->size = 8;
-    temp_stack->stack_end = ((term *) malloc(temp_stack->size * sizeof(term))) + temp_stack->size;
-    temp_stack->stack_pos = temp_stack->stack_end;
-}
-
-static inline void temp_stack_destory(struct TempStack *temp_stack)
-{
-    free(temp_stack->stack_end - temp_stack->size);
-}
-
-static void temp_stack_grow(struct TempStack *temp_stack)
-{
-    int old_used_size = temp_stack->stack_end - temp_stack->stack_pos;
-    int new_size = temp_stack->size * 2;
-    term *new_stack_end = ((term *) malloc(new_size * sizeof(term))) + new_size;
-    term *new_stack_pos = new_stack_end - old_used_size;
-    memcpy(new_stack_pos, temp_stack->stack_pos, old_used_size * sizeof(term));
-
-    free(temp_stack->stack_end - temp_stack->size);
-    temp_stack->stack_end = new_stack_end;
-    temp_stack->stack_pos = new_stack_pos;
-    temp_stack->size = new_size;
-}
-
-static inline int temp_stack_is_empty(const struct TempStack *temp_stack)
-{
-    return temp_stack->stack_end == temp_stack->stack_pos;
-}
-
-static inline void temp_stack_push(struct TempStack *temp_stack, term value)
-{
-    if (temp_stack->stack_end - temp_stack->stack_pos == temp_stack->size - 1) {
-        temp_stack_grow(temp_stack);
-    }
-
-    temp_stack->stack_pos--;
-    *temp_stack->stack_pos = value;
-}
-
-static inline term temp_stack_pop(struct TempStack *temp_stack)
-{
-    term value = *temp_stack->stack_pos;
-    temp_stack->stack_pos++;
-
-    return value;
-}
-
 unsigned long memory_estimate_usage(term t)
 {
     unsigned long acc = 0;
@@ -264,16 +550,20 @@ unsigned long memory_estimate_usage(term t)
                 t = term_nil();
             }
 
+        } else if (term_is_sub_binary(t)) {
+            acc += term_boxed_size(t) + 1;
+            t = term_to_const_term_ptr(t)[3];
+
         } else if (term_is_boxed(t)) {
             acc += term_boxed_size(t) + 1;
             t = temp_stack_pop(&temp_stack);
 
         } else {
-            fprintf(stderr, "bug: found unknown term type: 0x%lx\n", t);
+            fprintf(stderr, "bug: found unknown term type: 0x%lx\n", (unsigned long) t);
             if (term_is_boxed(t)) {
                 const term *boxed_value = term_to_const_term_ptr(t);
                 int boxed_size = term_boxed_size(t) + 1;
-                fprintf(stderr, "boxed header: 0x%lx, size: %i\n", boxed_value[0], boxed_size);
+                fprintf(stderr, "boxed header: 0x%lx, size: %i\n", (unsigned long) boxed_value[0], boxed_size);
             }
             abort();
         }
@@ -284,7 +574,112 @@ unsigned long memory_estimate_usage(term t)
     return acc;
 }
 
-static void memory_scan_and_copy(term *mem_start, const term *mem_end, term **new_heap_pos, int move)
+static inline int memory_points_to(term t, const term *start, const term *end)
+{
+    if (!term_is_nonempty_list(t) && !term_is_boxed(t)) {
+        return 0;
+    }
+    const term *ptr = term_to_const_term_ptr(t);
+
+    return (ptr >= start) && (ptr < end);
+}
+
+unsigned long memory_movable_size(Context *ctx, term t)
+{
+    if (!term_is_nonempty_list(t) && !term_is_boxed(t)) {
+        return 0;
+    }
+
+    term *region_start = ctx->heap_ptr;
+
+    struct TempStack temp_stack;
+    temp_stack_init(&temp_stack);
+
+    temp_stack_push(&temp_stack, t);
+
+    while (!temp_stack_is_empty(&temp_stack)) {
+        // terms outside of the heap are literals, they are never released so they can be shared
+        if (!memory_points_to(t, ctx->heap_start, ctx->heap_ptr)) {
+            t = temp_stack_pop(&temp_stack);
+            continue;
+        }
+
+        term *ptr = term_to_term_ptr(t);
+        if (ptr < region_start) {
+            region_start = ptr;
+        }
+
+        if (term_is_nonempty_list(t)) {
+            temp_stack_push(&temp_stack, term_get_list_tail(t));
+            t = term_get_list_head(t);
+
+        } else if (term_is_tuple(t)) {
+            int tuple_size = term_get_tuple_arity(t);
+            for (int i = 0; i < tuple_size; i++) {
+                temp_stack_push(&temp_stack, term_get_tuple_element(t, i));
+            }
+            t = temp_stack_pop(&temp_stack);
+
+        } else if ((ptr[0] & TERM_BOXED_TAG_MASK) == TERM_BOXED_FUN) {
+            int fun_size = term_boxed_size(t);
+            for (int i = 3; i <= fun_size; i++) {
+                temp_stack_push(&temp_stack, ptr[i]);
+            }
+            t = temp_stack_pop(&temp_stack);
+
+        } else if (term_is_sub_binary(t)) {
+            t = ptr[3];
+
+        } else {
+            t = temp_stack_pop(&temp_stack);
+        }
+    }
+
+    temp_stack_destory(&temp_stack);
+
+    // everything above the oldest cell of the term is either part of it or garbage, unless a root refers to it.
+    // x registers are not checked: the caller must not use them anymore, memory_move_term_tree clears them
+    for (term *stack = ctx->e; stack < ctx->stack_base; stack++) {
+        if (!term_is_catch_label(*stack) && memory_points_to(*stack, region_start, ctx->heap_ptr)) {
+            return 0;
+        }
+    }
+
+    for (int i = 0; i < ctx->dictionary.capacity; i++) {
+        struct DictionaryEntry *entry = &ctx->dictionary.entries[i];
+        if (dictionary_entry_is_used(entry)
+                && (memory_points_to(entry->key, region_start, ctx->heap_ptr)
+                    || memory_points_to(entry->value, region_start, ctx->heap_ptr))) {
+            return 0;
+        }
+    }
+
+    return ctx->heap_ptr - region_start;
+}
+
+term memory_move_term_tree(Context *ctx, term t, term **new_heap, unsigned long size)
+{
+    term *region_start = ctx->heap_ptr - size;
+    term *region_end = ctx->heap_ptr;
+
+    // only the term tree is copied, garbage in the released region is just dropped
+    term moved_term = memory_copy_term_tree(new_heap, t);
+
+    for (int i = 0; i < ctx->avail_registers; i++) {
+        if (memory_points_to(ctx->x[i], region_start, region_end)) {
+            ctx->x[i] = term_nil();
+        }
+    }
+
+    // released memory is cleared, so the heap is left as if it had never been used
+    memset(region_start, 0, size * sizeof(term));
+    ctx->heap_ptr = region_start;
+
+    return moved_term;
+}
+
+// Returns where the scan stopped: the first term boundary at or after mem_end.
+static term *memory_scan_and_copy(term *mem_start, const term *mem_end, term **new_heap_pos, int move)
 {
     term *ptr = mem_start;
     term *new_heap = *new_heap_pos;
@@ -331,7 +726,7 @@ static void memory_scan_and_copy(term *mem_start, const term *mem_end, term **ne
                     int fun_size = term_get_size_from_boxed_header(t);
                     TRACE("- Found fun, size: %i.\n", fun_size);
 
-                    // first term is the boxed header, followed by module and fun index.
+                    // first term is the boxed header, followed by module and fun table entry.
 
                     for (int i = 3; i <= fun_size; i++) {
                         TRACE("-- Frozen: %lx\n", ptr[i]);
@@ -344,8 +739,13 @@ static void memory_scan_and_copy(term *mem_start, const term *mem_end, term **ne
                     TRACE("- Found binary.\n");
                     break;
 
+                case TERM_BOXED_SUB_BINARY:
+                    TRACE("- Found sub-binary.\n");
+                    ptr[3] = memory_shallow_copy_term(ptr[3], &new_heap, move);
+                    break;
+
                 default:
-                    fprintf(stderr, "- Found unknown boxed type: %lx\n", (t >> 2) & 0xF);
+                    fprintf(stderr, "- Found unknown boxed type: %lx\n", (unsigned long) ((t >> 2) & 0xF));
                     abort();
             }
 
@@ -362,12 +762,14 @@ static void memory_scan_and_copy(term *mem_start, const term *mem_end, term **ne
             ptr++;
 
         } else {
-            fprintf(stderr, "bug: found unknown term type: 0x%lx\n", t);
+            fprintf(stderr, "bug: found unknown term type: 0x%lx\n", (unsigned long) t);
             abort();
         }
     }
 
     *new_heap_pos = new_heap;
+
+    return ptr;
 }
 
 HOT_FUNC static term memory_shallow_copy_term(term t, term **new_heap, int move)
@@ -406,7 +808,7 @@ HOT_FUNC static term memory_shallow_copy_term(term t, term **new_heap, int move)
         }
         *new_heap += boxed_size;
 
-        term new_term = ((term) dest) | TERM_BOXED_VALUE_TAG;
+        term new_term = term_from_term_ptr(dest) | TERM_BOXED_VALUE_TAG;
 
         if (move) {
             memory_replace_with_moved_marker(boxed_value, new_term);
@@ -426,7 +828,7 @@ HOT_FUNC static term memory_shallow_copy_term(term t, term **new_heap, int move)
         dest[1] = list_ptr[1];
         *new_heap += 2;
 
-        term new_term = ((term) dest) | 0x1;
+        term new_term = term_from_term_ptr(dest) | 0x1;
 
         if (move) {
             memory_replace_with_moved_marker(list_ptr, new_term);
@@ -435,7 +837,235 @@ HOT_FUNC static term memory_shallow_copy_term(term t, term **new_heap, int move)
         return new_term;
 
     } else {
-        fprintf(stderr, "Unexpected term. Term is: %lx\n", t);
+        fprintf(stderr, "Unexpected term. Term is: %lx\n", (unsigned long) t);
         abort();
     }
 }
+
+#ifdef AVM_COMPACT_TERMS
+
+// Compact terms are 32 bits offsets from memory_terms_base, so everything terms can point to is allocated from a
+// single region that is reserved once and committed page by page by the operating system. The allocator keeps
+// boundary tags so free blocks are coalesced, and segregated free lists (one for each power of 2) for a fast first fit.
+
+// the end of the region must fit a term too
+#define TERMS_REGION_SIZE 0xFFFF0000UL
+#define TERMS_BLOCK_HEADER_SIZE 8
+#define TERMS_MIN_BLOCK_SIZE 16
+#define TERMS_BLOCK_USED 0x1
+#define TERMS_FREE_LISTS 32
+// pages of free blocks at least this large are given back to the operating system
+#define TERMS_RELEASE_THRESHOLD (256 * 1024)
+
+struct TermsBlock
+{
+    // size in bytes including this header, TERMS_BLOCK_USED is set when the block is allocated
+    uint32_t size;
+    // size of the previous block, 0 for the first one
+    uint32_t prev_size;
+    // free blocks only: offsets of the next and previous blocks on the same free list, 0 ends the list
+    uint32_t next_free;
+    uint32_t prev_free;
+};
+
+char *memory_terms_base;
+
+static char terms_lock;
+static uintptr_t terms_page_size;
+// offset of the first byte that has never been allocated, and offset of the block that ends there
+static uint32_t terms_top;
+static uint32_t terms_last_block;
+static uint32_t terms_free_lists[TERMS_FREE_LISTS];
+
+static inline struct TermsBlock *terms_block(uint32_t offset)
+{
+    return (struct TermsBlock *) (memory_terms_base + offset);
+}
+
+static inline int terms_free_list_index(uint32_t size)
+{
+    return 31 - __builtin_clz(size);
+}
+
+static void terms_free_list_insert(uint32_t offset, uint32_t size)
+{
+    struct TermsBlock *block = terms_block(offset);
+    block->size = size;
+    block->prev_free = 0;
+
+    int index = terms_free_list_index(size);
+    block->next_free = terms_free_lists[index];
+    if (block->next_free) {
+        terms_block(block->next_free)->prev_free = offset;
+    }
+    terms_free_lists[index] = offset;
+}
+
+static void terms_free_list_remove(uint32_t offset)
+{
+    struct TermsBlock *block = terms_block(offset);
+
+    if (block->prev_free) {
+        terms_block(block->prev_free)->next_free = block->next_free;
+    } else {
+        terms_free_lists[terms_free_list_index(block->size)] = block->next_free;
+    }
+    if (block->next_free) {
+        terms_block(block->next_free)->prev_free = block->prev_free;
+    }
+}
+
+// first fit on the list of the size, any block of a larger list fits
+static uint32_t terms_find_free(uint32_t size)
+{
+    int index = terms_free_list_index(size);
+    for (uint32_t offset = terms_free_lists[index]; offset; offset = terms_block(offset)->next_free) {
+        if (terms_block(offset)->size >= size) {
+            return offset;
+        }
+    }
+    for (index++; index < TERMS_FREE_LISTS; index++) {
+        if (terms_free_lists[index]) {
+            return terms_free_lists[index];
+        }
+    }
+
+    return 0;
+}
+
+static void terms_release_pages(uint32_t start, uint32_t end)
+{
+    uintptr_t page_start = ((uintptr_t) start + terms_page_size - 1) & ~(terms_page_size - 1);
+    uintptr_t page_end = (uintptr_t) end & ~(terms_page_size - 1);
+    if (page_start < page_end) {
+        madvise(memory_terms_base + page_start, page_end - page_start, MADV_DONTNEED);
+    }
+}
+
+static inline void terms_lock_acquire()
+{
+    while (__atomic_test_and_set(&terms_lock, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+static inline void terms_lock_release()
+{
+    __atomic_clear(&terms_lock, __ATOMIC_RELEASE);
+}
+
+void *memory_terms_alloc(size_t size)
+{
+    if (UNLIKELY(size > TERMS_REGION_SIZE)) {
+        return NULL;
+    }
+    uint32_t block_size = (size + TERMS_BLOCK_HEADER_SIZE + 7) & ~7UL;
+    if (block_size < TERMS_MIN_BLOCK_SIZE) {
+        block_size = TERMS_MIN_BLOCK_SIZE;
+    }
+
+    terms_lock_acquire();
+
+    if (UNLIKELY(!memory_terms_base)) {
+        void *region = mmap(NULL, TERMS_REGION_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (region == MAP_FAILED) {
+            terms_lock_release();
+            return NULL;
+        }
+        terms_page_size = sysconf(_SC_PAGESIZE);
+        // offset 0 is never used, so a term pointing to the heap is never an invalid term
+        terms_top = TERMS_BLOCK_HEADER_SIZE;
+        memory_terms_base = region;
+    }
+
+    uint32_t offset = terms_find_free(block_size);
+    struct TermsBlock *block;
+    if (offset) {
+        terms_free_list_remove(offset);
+        block = terms_block(offset);
+
+        uint32_t remaining = block->size - block_size;
+        if (remaining >= TERMS_MIN_BLOCK_SIZE) {
+            uint32_t remaining_offset = offset + block_size;
+            terms_block(remaining_offset)->prev_size = block_size;
+            terms_free_list_insert(remaining_offset, remaining);
+            // free blocks never end at the top, they are given back to it
+            terms_block(remaining_offset + remaining)->prev_size = remaining;
+        } else {
+            block_size = block->size;
+        }
+
+    } else {
+        if (UNLIKELY((uint64_t) terms_top + block_size > TERMS_REGION_SIZE)) {
+            terms_lock_release();
+            return NULL;
+        }
+        offset = terms_top;
+        block = terms_block(offset);
+        block->prev_size = terms_last_block ? (terms_block(terms_last_block)->size & ~TERMS_BLOCK_USED) : 0;
+        terms_top += block_size;
+        terms_last_block = offset;
+    }
+    block->size = block_size | TERMS_BLOCK_USED;
+
+    terms_lock_release();
+
+    return ((char *) block) + TERMS_BLOCK_HEADER_SIZE;
+}
+
+void *memory_terms_calloc(size_t count, size_t size)
+{
+    if (UNLIKELY(size && (count > TERMS_REGION_SIZE / size))) {
+        return NULL;
+    }
+
+    void *ptr = memory_terms_alloc(count * size);
+    if (LIKELY(ptr != NULL)) {
+        memset(ptr, 0, count * size);
+    }
+
+    return ptr;
+}
+
+void memory_terms_free(void *ptr)
+{
+    if (IS_NULL_PTR(ptr)) {
+        return;
+    }
+
+    terms_lock_acquire();
+
+    uint32_t offset = ((char *) ptr - TERMS_BLOCK_HEADER_SIZE) - memory_terms_base;
+    uint32_t size = terms_block(offset)->size & ~TERMS_BLOCK_USED;
+    uint32_t prev_size = terms_block(offset)->prev_size;
+
+    uint32_t next_offset = offset + size;
+    if ((next_offset < terms_top) && !(terms_block(next_offset)->size & TERMS_BLOCK_USED)) {
+        terms_free_list_remove(next_offset);
+        size += terms_block(next_offset)->size;
+    }
+
+    if (prev_size && !(terms_block(offset - prev_size)->size & TERMS_BLOCK_USED)) {
+        offset -= prev_size;
+        terms_free_list_remove(offset);
+        size += prev_size;
+        prev_size = terms_block(offset)->prev_size;
+    }
+
+    if (offset + size == terms_top) {
+        // the previous block is in use, it is the new last block
+        terms_release_pages(offset, terms_top);
+        terms_top = offset;
+        terms_last_block = prev_size ? offset - prev_size : 0;
+
+    } else {
+        terms_free_list_insert(offset, size);
+        terms_block(offset + size)->prev_size = size;
+        if (size >= TERMS_RELEASE_THRESHOLD) {
+            terms_release_pages(offset + sizeof(struct TermsBlock), offset + size);
+        }
+    }
+
+    terms_lock_release();
+}
+
+#endif
@@ -20,13 +20,31 @@
 #ifndef _MEMORY_H_
 #define _MEMORY_H_
 
+#include "linkedlist.h"
 #include "term_typedef.h"
 #include "utils.h"
 
 #include <stdint.h>
+#include <stdlib.h>
 
 #define HEAP_NEED_GC_SHRINK_THRESHOLD_COEFF 64
 
+// free memory left by a collection at least, a process shrunk with memory_gc_and_shrink does not have more
+#define MIN_FREE_SPACE_SIZE 8
+
+// heaps of at least this many terms are collected by the scheduler when their process can be suspended
+#ifndef MEMORY_DEFERRED_GC_MIN_HEAP_SIZE
+    #define MEMORY_DEFERRED_GC_MIN_HEAP_SIZE 32768
+#endif
+
+// a soft watermark pass runs again only once used memory grew by 1/MEMORY_RELIEF_STEP_COEFF of the watermark
+#define MEMORY_RELIEF_STEP_COEFF 8
+
+// terms that are scanned by each deferred collection slice
+#ifndef MEMORY_DEFERRED_GC_SLICE_SIZE
+    #define MEMORY_DEFERRED_GC_SLICE_SIZE 16384
+#endif
+
 #ifndef TYPEDEF_CONTEXT
 #define TYPEDEF_CONTEXT
 typedef struct Context Context;
@@ -38,6 +56,87 @@ enum MemoryGCResult
     MEMORY_GC_ERROR_FAILED_ALLOCATION = 1
 };
 
+/**
+ * @brief A collection that is performed in slices while its process is suspended.
+ *
+ * @details Roots are copied when the collection starts and the new memory block becomes the process heap, then the
+ *          scheduler scans it a slice at a time between other processes time slices. The process does not run until
+ *          the collection completes, so no barrier is needed: nobody else reads its heap.
+ */
+struct DeferredGC
+{
+    struct ListHead deferred_gcs_list_head;
+    Context *ctx;
+
+    // previous memory block, that is freed once all live terms have been copied
+    term *old_heap;
+    unsigned long old_size;
+
+    // terms before scan have already been scanned, the collection completes when scan reaches heap_ptr
+    term *scan;
+
+    // free memory the process needs when it is resumed
+    uint32_t min_free;
+
+    // the process is made ready once the collection completes, wake-ups that happen meanwhile set it
+    int ready;
+};
+
+#ifdef AVM_COMPACT_TERMS
+
+/**
+ * @brief base address of term memory
+ *
+ * @details compact terms store pointers as 32 bits offsets from this address, so all the memory that is pointed by terms (process heaps and messages) is allocated from a single reserved region by memory_terms_alloc.
+ */
+extern char *memory_terms_base;
+
+/**
+ * @brief allocates memory that can be pointed by terms
+ *
+ * @details allocates a memory block from the region that starts at memory_terms_base, it is safe to call it from any thread.
+ * @param size the size of the memory block in bytes.
+ * @returns a pointer to the memory block aligned to 8 bytes, or NULL if the region is exhausted.
+ */
+MALLOC_LIKE void *memory_terms_alloc(size_t size);
+
+/**
+ * @brief allocates zeroed memory that can be pointed by terms
+ *
+ * @details same as memory_terms_alloc, but the memory block is cleared as calloc does.
+ * @param count the number of elements.
+ * @param size the size of each element in bytes.
+ * @returns a pointer to the memory block aligned to 8 bytes, or NULL if the region is exhausted.
+ */
+MALLOC_LIKE void *memory_terms_calloc(size_t count, size_t size);
+
+/**
+ * @brief frees memory allocated with memory_terms_alloc
+ *
+ * @details blocks are coalesced with free neighbours, and large free blocks are given back to the operating system.
+ * @param ptr the memory block, it can be NULL.
+ */
+void memory_terms_free(void *ptr);
+
+#else
+
+static inline void *memory_terms_alloc(size_t size)
+{
+    return malloc(size);
+}
+
+static inline void *memory_terms_calloc(size_t count, size_t size)
+{
+    return calloc(count, size);
+}
+
+static inline void memory_terms_free(void *ptr)
+{
+    free(ptr);
+}
+
+#endif
+
 /**
  * @brief allocates space for a certain ammount of terms on the heap
  *
@@ -51,7 +150,7 @@ MALLOC_LIKE term *memory_heap_alloc(Context *ctx, uint32_t size);
 /**
  * @brief allocates a new memory block and executes garbage collection
  *
- * @details allocates a new memory block (that can have new size) and executes garbage collection, any existing term might be invalid after this call.
+ * @details allocates a new memory block (that can have new size) and executes garbage collection, any existing term might be invalid after this call. A deferred collection in progress is completed first.
  * @param ctx the context that owns the memory block.
  * @param new_size the size of the new memory block in term units.
  * @returns MEMORY_GC_OK when successful.
@@ -77,14 +176,67 @@ term memory_copy_term_tree(term **new_heap, term t);
  */
 void memory_ensure_free(Context *ctx, uint32_t size);
 
+/**
+ * @brief makes sure that the given context has given free memory, deferring the collection of large heaps
+ *
+ * @details same as memory_ensure_free, but when the heap is larger than MEMORY_DEFERRED_GC_MIN_HEAP_SIZE the
+ *          collection is deferred to the scheduler, and the process must be suspended until the scheduler completes
+ *          it. The collection pause of the process is not shorter, but other processes run between its slices. Once resumed at least size terms are available. Registers that are not live must be cleaned before.
+ * @param ctx the target context, it must be the running process.
+ * @param size needed available memory.
+ * @returns 1 if a deferred collection has been started, 0 if memory has been made available synchronously.
+ */
+int memory_ensure_free_deferred(Context *ctx, uint32_t size);
+
+/**
+ * @brief runs a slice of a deferred collection
+ *
+ * @details scans at most MEMORY_DEFERRED_GC_SLICE_SIZE terms, when the collection completes the process is made ready if it has been woken up.
+ * @param ctx a context that has a deferred collection in progress.
+ */
+void memory_deferred_gc_slice(Context *ctx);
+
+/**
+ * @brief discards a deferred collection
+ *
+ * @details releases the previous memory block of a process that is going to be destroyed, its heap must not be used anymore.
+ * @param ctx the context, it may not have any collection in progress.
+ */
+void memory_deferred_gc_discard(Context *ctx);
+
+#ifdef AVM_SEPARATE_STACK
+
+/**
+ * @brief grows the stack memory block
+ *
+ * @details the stack is moved to a larger memory block, at least twice as large, without collecting the heap.
+ * @param ctx the context that owns the stack.
+ * @param size terms that are going to be pushed on the stack.
+ */
+void memory_grow_stack(Context *ctx, uint32_t size);
+
+#endif
+
 /**
  * @brief runs a garbage collection and shrinks used memory
  *
- * @details runs a garbage collection and shrinks used memory, a new heap will be allocted, any existing term might be invalid after this call.
+ * @details runs a garbage collection and shrinks used memory to the live size of heap and stack, so no free memory is left: live terms are counted first, so they are copied only once. A new heap will be allocted, any existing term might be invalid after this call. A stack that has its own memory block is shrunk as well.
  * @param ctx the context on which the garbage collection will be performed.
  */
 void memory_gc_and_shrink(Context *ctx);
 
+/**
+ * @brief checks global memory pressure before an allocation
+ *
+ * @details when used memory exceeds the soft watermark, or when it would exceed the memory budget (that is the hard
+ *          watermark) after the allocation, the scheduler is asked to shrink idle processes with
+ *          memory_gc_and_shrink, largest first. No process is collected here.
+ * @param ctx the context that is going to allocate memory or to receive a message.
+ * @param size the size in bytes of the allocation.
+ * @returns 1 if the allocation fits the memory budget, 0 if it should be refused.
+ */
+int memory_check_pressure(Context *ctx, size_t size);
+
 /**
  * @brief calculates term memory usage
  *
@@ -94,4 +246,26 @@ void memory_gc_and_shrink(Context *ctx);
  */
 unsigned long memory_estimate_usage(term t);
 
+/**
+ * @brief checks if the heap memory of a term can be given back once the term has been copied
+ *
+ * @details the heap region that starts at the oldest cell of the term and ends at the top of the heap can be released when neither the stack nor the process dictionary refer to it, such region holds the term and garbage only. x registers are not checked, so the caller must not use them anymore.
+ * @param ctx the context that owns the heap.
+ * @param t the term that should be moved.
+ * @returns the size in term units of the heap region that can be released, 0 when the term must be copied.
+ */
+unsigned long memory_movable_size(Context *ctx, term t);
+
+/**
+ * @brief moves a term out of a process heap
+ *
+ * @details copies the term tree as memory_copy_term_tree does, then releases the heap region found by memory_movable_size, x registers referring to it are cleared.
+ * @param ctx the context that owns the heap.
+ * @param t the term that will be moved.
+ * @param new_heap pointer to the destination, that must fit memory_estimate_usage terms, it is moved after the copied term.
+ * @param size the value returned by memory_movable_size.
+ * @returns the moved term, that is stored on the destination buffer.
+ */
+term memory_move_term_tree(Context *ctx, term t, term **new_heap, unsigned long size);
+
 #endif
@@ -43,6 +43,8 @@
 static void const* *module_build_literals_table(const void *literalsBuf);
 static void module_add_label(Module *mod, int index, void *ptr);
 static enum ModuleLoadResult module_build_imported_functions_table(Module *this_module, uint8_t *table_data);
+static enum ModuleLoadResult module_build_funs_table(Module *this_module, const uint8_t *table_data, unsigned long table_size);
+static enum ModuleLoadResult module_resolve_funs_entries(Module *this_module);
 static void module_add_label(Module *mod, int index, void *ptr);
 
 #define IMPL_CODE_LOADER 1
@@ -89,6 +91,11 @@ static enum ModuleLoadResult module_build_imported_functions_table(Module *this_
         fprintf(stderr, "Cannot allocate memory while loading module (line: %i).\n", __LINE__);
         return MODULE_ERROR_FAILED_ALLOCATION;
     }
+    this_module->inline_bifs = calloc(functions_count, sizeof(uint8_t));
+    if (IS_NULL_PTR(this_module->inline_bifs)) {
+        fprintf(stderr, "Cannot allocate memory while loading module (line: %i).\n", __LINE__);
+        return MODULE_ERROR_FAILED_ALLOCATION;
+    }
 
     for (int i = 0; i < functions_count; i++) {
         int local_module_atom_index = READ_32_ALIGNED(table_data + i * 12 + 12);
@@ -101,6 +108,7 @@ static enum ModuleLoadResult module_build_imported_functions_table(Module *this_
 
         if (bif_handler) {
             this_module->imported_funcs[i].bif = bif_handler;
+            this_module->inline_bifs[i] = bif_registry_get_inline(module_atom, function_atom, arity);
         } else {
             this_module->imported_funcs[i].func = &nifs_get(module_atom, function_atom, arity)->base;
         }
@@ -123,6 +131,62 @@ static enum ModuleLoadResult module_build_imported_functions_table(Module *this_
     return MODULE_LOAD_OK;
 }
 
+static enum ModuleLoadResult module_build_funs_table(Module *this_module, const uint8_t *table_data, unsigned long table_size)
+{
+    if (!table_data) {
+        this_module->funs = NULL;
+        this_module->funs_count = 0;
+        return MODULE_LOAD_OK;
+    }
+
+    if (UNLIKELY(table_size < 4)) {
+        fprintf(stderr, "Invalid FunT chunk.\n");
+        return MODULE_ERROR_INVALID;
+    }
+    uint32_t funs_count = READ_32_ALIGNED(table_data + 8);
+    if (UNLIKELY(funs_count > (table_size - 4) / 24)) {
+        fprintf(stderr, "Invalid FunT chunk.\n");
+        return MODULE_ERROR_INVALID;
+    }
+    uint32_t labels_count = ENDIAN_SWAP_32(this_module->code->labels);
+
+    this_module->funs = calloc(funs_count, sizeof(struct ModuleFun));
+    if (IS_NULL_PTR(this_module->funs) && funs_count) {
+        fprintf(stderr, "Cannot allocate memory while loading module (line: %i).\n", __LINE__);
+        return MODULE_ERROR_FAILED_ALLOCATION;
+    }
+    this_module->funs_count = funs_count;
+
+    for (uint32_t i = 0; i < funs_count; i++) {
+        // fun atom index
+        this_module->funs[i].arity = READ_32_ALIGNED(table_data + i * 24 + 4 + 12);
+        this_module->funs[i].label = READ_32_ALIGNED(table_data + i * 24 + 8 + 12);
+        if (UNLIKELY((this_module->funs[i].label == 0) || (this_module->funs[i].label >= labels_count))) {
+            fprintf(stderr, "Invalid label %u for fun %u.\n", (unsigned) this_module->funs[i].label, (unsigned) i);
+            return MODULE_ERROR_INVALID;
+        }
+        // index
+        this_module->funs[i].n_freeze = READ_32_ALIGNED(table_data + i * 24 + 16 + 12);
+        // ouniq
+    }
+
+    return MODULE_LOAD_OK;
+}
+
+static enum ModuleLoadResult module_resolve_funs_entries(Module *this_module)
+{
+    for (uint32_t i = 0; i < this_module->funs_count; i++) {
+        // labels have been checked against the labels count, but the code might not define them
+        this_module->funs[i].entry = this_module->labels[this_module->funs[i].label];
+        if (UNLIKELY(!this_module->funs[i].entry)) {
+            fprintf(stderr, "Undefined label %u for fun %u.\n", (unsigned) this_module->funs[i].label, (unsigned) i);
+            return MODULE_ERROR_INVALID;
+        }
+    }
+
+    return MODULE_LOAD_OK;
+}
+
 #ifdef ENABLE_ADVANCED_TRACE
 void module_get_imported_function_module_and_name(const Module *this_module, int index, AtomString *module_atom, AtomString *function_atom)
 {
@@ -196,6 +260,10 @@ Module *module_new_from_iff_binary(GlobalContext *global, const void *iff_binary
     mod->export_table = beam_file + offsets[EXPT];
     mod->atom_table = beam_file + offsets[AT8U];
     mod->fun_table = beam_file + offsets[FUNT];
+    if (UNLIKELY(module_build_funs_table(mod, offsets[FUNT] ? beam_file + offsets[FUNT] : NULL, sizes[FUNT]) != MODULE_LOAD_OK)) {
+        module_destroy(mod);
+        return NULL;
+    }
     mod->labels = calloc(ENDIAN_SWAP_32(mod->code->labels), sizeof(void *));
     if (IS_NULL_PTR(mod->labels)) {
         module_destroy(mod);
@@ -230,6 +298,10 @@ Module *module_new_from_iff_binary(GlobalContext *global, const void *iff_binary
     }
 
     mod->end_instruction_ii = read_core_chunk(mod);
+    if (UNLIKELY(module_resolve_funs_entries(mod) != MODULE_LOAD_OK)) {
+        module_destroy(mod);
+        return NULL;
+    }
 
     return mod;
 }
@@ -238,6 +310,8 @@ COLD_FUNC void module_destroy(Module *module)
 {
     free(module->labels);
     free(module->imported_funcs);
+    free(module->inline_bifs);
+    free(module->funs);
     free(module->literals_table);
     if (module->free_literals_data) {
         free(module->literals_data);
@@ -304,7 +378,7 @@ static void const* *module_build_literals_table(const void *literalsBuf)
 
 term module_load_literal(Module *mod, int index, Context *ctx)
 {
-    return externalterm_to_term(mod->literals_table[index], ctx);
+    return externalterm_to_term(mod->literals_table[index], ctx, 0);
 }
 
 const struct ExportedFunction *module_resolve_function(Module *mod, int import_table_index)
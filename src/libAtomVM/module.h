@@ -49,6 +49,20 @@ typedef struct
 
 struct ExportedFunction;
 
+/**
+ * @brief A FunT entry, decoded once at load time.
+ *
+ * @details Fun terms point directly to their ModuleFun, so calling a fun does not require parsing
+ *          the FunT chunk nor looking up the label.
+ */
+struct ModuleFun
+{
+    const void *entry;
+    uint32_t label;
+    uint32_t arity;
+    uint32_t n_freeze;
+};
+
 struct Module
 {
     GlobalContext *global;
@@ -61,8 +75,12 @@ struct Module
     void *export_table;
     void *atom_table;
     void *fun_table;
+    struct ModuleFun *funs;
+    uint32_t funs_count;
 
     union imported_func *imported_funcs;
+    // enum InlineBif of each import, set for arithmetic and comparison BIFs
+    uint8_t *inline_bifs;
     void *local_labels;
 
     void **labels;
@@ -89,7 +107,8 @@ typedef struct Module Module;
 enum ModuleLoadResult
 {
     MODULE_LOAD_OK = 0,
-    MODULE_ERROR_FAILED_ALLOCATION = 1
+    MODULE_ERROR_FAILED_ALLOCATION = 1,
+    MODULE_ERROR_INVALID = 2
 };
 
 #ifdef ENABLE_ADVANCED_TRACE
@@ -191,40 +210,21 @@ static inline term module_address(unsigned int module_index, unsigned int instru
     return (term) ((module_index << 24) | (instruction_index << 2));
 }
 
-static inline uint32_t module_get_fun_freeze(const Module *this_module, int fun_index)
-{
-    const uint8_t *table_data = (const uint8_t *) this_module->fun_table;
-    int funs_count = READ_32_ALIGNED(table_data + 8);
-
-    if (UNLIKELY(fun_index >= funs_count)) {
-        abort();
-    }
-
-    // fun atom index
-    // arity
-    // label
-    // index
-    uint32_t n_freeze = READ_32_ALIGNED(table_data + fun_index * 24 + 16 + 12);
-    // ouniq
-
-    return n_freeze;
-}
-
-static inline void module_get_fun(const Module *this_module, int fun_index, uint32_t *label, uint32_t *arity, uint32_t *n_freeze)
+/**
+ * @brief Gets a decoded fun table entry
+ *
+ * @details Returns the fun table entry for the given fun index, entries are decoded when the module is loaded.
+ * @param this_module the module the fun belongs to.
+ * @param fun_index the index of the fun in the FunT chunk.
+ * @return the fun table entry.
+ */
+static inline const struct ModuleFun *module_get_fun_entry(const Module *this_module, uint32_t fun_index)
 {
-    const uint8_t *table_data = (const uint8_t *) this_module->fun_table;
-    int funs_count = READ_32_ALIGNED(table_data + 8);
-
-    if (UNLIKELY(fun_index >= funs_count)) {
+    if (UNLIKELY(fun_index >= this_module->funs_count)) {
         abort();
     }
 
-    // fun atom index
-    *arity = READ_32_ALIGNED(table_data + fun_index * 24 + 4 + 12);
-    *label = READ_32_ALIGNED(table_data + fun_index * 24 + 8 + 12);
-    // index
-    *n_freeze = READ_32_ALIGNED(table_data + fun_index * 24 + 16 + 12);
-    // ouniq
+    return &this_module->funs[fun_index];
 }
 
 #endif
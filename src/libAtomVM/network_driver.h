@@ -24,7 +24,7 @@
 #include "ccontext.h"
 #include "term.h"
 
-void network_driver_setup(CContext *cc, term pid, term_ref ref, term config);
+void network_driver_setup(CContext *cc, term_ref pid, term_ref ref, term config);
 term_ref network_driver_ifconfig(CContext *cc);
 
 #endif
@@ -20,9 +20,19 @@
 #include "nifs.h"
 
 #include "atomshashtable.h"
+#include "base64.h"
+#include "bridge.h"
+#include "bytepattern.h"
+#include "checksum.h"
 #include "context.h"
 #include "ccontext.h"
+#include "digest.h"
+#include "dist.h"
+#include "externalterm.h"
+#include "globalcontext.h"
 #include "interop.h"
+#include "format.h"
+#include "json.h"
 #include "mailbox.h"
 #include "module.h"
 #include "port.h"
@@ -30,6 +40,11 @@
 #include "term.h"
 #include "utils.h"
 #include "sys.h"
+#include "termhash.h"
+
+#ifdef WITH_ZLIB
+#include "zlibstream.h"
+#endif
 
 #include <stdio.h>
 #include <string.h>
@@ -57,12 +72,68 @@ static const char *const false_atom = "\x5" "false";
 static const char *const badarg_atom = "\x6" "badarg";
 static const char *const overflow_atom = "\x8" "overflow";
 static const char *const system_limit_atom = "\xC" "system_limit";
+static const char *const out_of_memory_atom = "\xD" "out_of_memory";
+static const char *const nomatch_atom = "\x7" "nomatch";
+static const char *const bm_atom = "\x2" "bm";
+static const char *const ac_atom = "\x2" "ac";
+static const char *const global_atom = "\x6" "global";
+static const char *const trim_atom = "\x4" "trim";
+static const char *const trim_all_atom = "\x8" "trim_all";
+static const char *const scope_atom = "\x5" "scope";
+static const char *const insert_replaced_atom = "\xF" "insert_replaced";
+static const char *const md5_atom = "\x3" "md5";
+static const char *const sha_atom = "\x3" "sha";
+static const char *const sha256_atom = "\x6" "sha256";
+static const char *const timeout_atom = "\x7" "timeout";
+static const char *const debug_atom = "\x5" "debug";
+static const char *const info_atom = "\x4" "info";
+static const char *const warning_atom = "\x7" "warning";
+static const char *const ok_atom = "\x2" "ok";
+static const char *const exit_atom = "\x4" "exit";
+static const char *const trap_exit_atom = "\x9" "trap_exit";
+static const char *const noproc_atom = "\x6" "noproc";
+static const char *const process_atom = "\x7" "process";
+static const char *const down_atom = "\x4" "DOWN";
+static const char *const max_heap_size_atom = "\xD" "max_heap_size";
+static const char *const size_atom = "\x4" "size";
+static const char *const kill_atom = "\x4" "kill";
+static const char *const error_logger_atom = "\xC" "error_logger";
+static const char *const message_queue_limit_atom = "\x13" "message_queue_limit";
+static const char *const messages_atom = "\x8" "messages";
+static const char *const bytes_atom = "\x5" "bytes";
+static const char *const policy_atom = "\x6" "policy";
+static const char *const drop_newest_atom = "\xB" "drop_newest";
+static const char *const drop_oldest_atom = "\xB" "drop_oldest";
+static const char *const block_atom = "\x5" "block";
+static const char *const infinity_atom = "\x8" "infinity";
+static const char *const memory_budget_atom = "\xD" "memory_budget";
+static const char *const memory_soft_watermark_atom = "\x15" "memory_soft_watermark";
+static const char *const heap_size_atom = "\x9" "heap_size";
+static const char *const stack_size_atom = "\xA" "stack_size";
+static const char *const nonode_at_nohost_atom = "\xD" "nonode@nohost";
+static const char *const total_heap_size_atom = "\xF" "total_heap_size";
+static const char *const memory_atom = "\x6" "memory";
+static const char *const message_queue_len_atom = "\x11" "message_queue_len";
+static const char *const move_atom = "\x4" "move";
+static const char *const noconnect_atom = "\x9" "noconnect";
+static const char *const nosuspend_atom = "\x9" "nosuspend";
 static const char *const puts_a = "\x4" "puts";
 static const char *const flush_a = "\x5" "flush";
 
-#ifdef ENABLE_ADVANCED_TRACE
-static const char *const ok_atom = "\x2" "ok";
+#ifdef WITH_ZLIB
+static const char *const data_error_atom = "\xA" "data_error";
+static const char *const none_atom = "\x4" "none";
+static const char *const sync_atom = "\x4" "sync";
+static const char *const full_atom = "\x4" "full";
+static const char *const finish_atom = "\x6" "finish";
+static const char *const default_atom = "\x7" "default";
+static const char *const best_speed_atom = "\xA" "best_speed";
+static const char *const best_compression_atom = "\x10" "best_compression";
+#else
+static const char *const undef_atom = "\x5" "undef";
+#endif
 
+#ifdef ENABLE_ADVANCED_TRACE
 static const char *const trace_calls_atom = "\xB" "trace_calls";
 static const char *const trace_call_args_atom = "\xF" "trace_call_args";
 static const char *const trace_returns_atom = "\xD" "trace_returns";
@@ -94,15 +165,89 @@ static term nif_erlang_list_to_existing_atom_1(Context *ctx, int argc, term argv
 static term nif_erlang_open_port_2(Context *ctx, int argc, term argv[]);
 static term nif_erlang_register_2(Context *ctx, int argc, term argv[]);
 static term nif_erlang_send_2(Context *ctx, int argc, term argv[]);
+static term nif_erlang_send_3(Context *ctx, int argc, term argv[]);
+static term nif_erlang_node_0(Context *ctx, int argc, term argv[]);
+static term nif_erlang_node_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_nodes_0(Context *ctx, int argc, term argv[]);
+static term nif_erlang_term_to_binary_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_binary_to_term_1(Context *ctx, int argc, term argv[]);
 static term nif_erlang_setelement_3(Context *ctx, int argc, term argv[]);
 static term nif_erlang_spawn_3(Context *ctx, int argc, term argv[]);
+static term nif_erlang_hibernate_3(Context *ctx, int argc, term argv[]);
+static term nif_erlang_process_info_2(Context *ctx, int argc, term argv[]);
 static term nif_erlang_whereis_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_unregister_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_exit_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_link_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_unlink_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_spawn_link_3(Context *ctx, int argc, term argv[]);
+static term nif_erlang_monitor_2(Context *ctx, int argc, term argv[]);
+static term nif_erlang_demonitor(Context *ctx, int argc, term argv[]);
+static term nif_erlang_process_flag_2(Context *ctx, int argc, term argv[]);
+static term nif_erlang_system_flag_2(Context *ctx, int argc, term argv[]);
 static term nif_erlang_system_time_1(Context *ctx, int argc, term argv[]);
 static term nif_erlang_tuple_to_list_1(Context *ctx, int argc, term argv[]);
 static term nif_erlang_universaltime_0(Context *ctx, int argc, term argv[]);
 static term nif_erlang_timestamp_0(Context *ctx, int argc, term argv[]);
 static term nif_erts_debug_flat_size(Context *ctx, int argc, term argv[]);
 static term nifs_erlang_process_flag(Context *ctx, int argc, term argv[]);
+static term nif_erlang_iolist_size_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_iolist_to_binary_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_list_to_binary_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_binary_to_list_1(Context *ctx, int argc, term argv[]);
+static term nif_unicode_characters_to_binary_1(Context *ctx, int argc, term argv[]);
+static term nif_binary_match(Context *ctx, int argc, term argv[]);
+static term nif_binary_matches(Context *ctx, int argc, term argv[]);
+static term nif_binary_split(Context *ctx, int argc, term argv[]);
+static term nif_binary_replace(Context *ctx, int argc, term argv[]);
+static term nif_binary_part(Context *ctx, int argc, term argv[]);
+static term nif_binary_copy(Context *ctx, int argc, term argv[]);
+static term nif_binary_at(Context *ctx, int argc, term argv[]);
+static term nif_binary_compile_pattern(Context *ctx, int argc, term argv[]);
+static term nif_erlang_crc32(Context *ctx, int argc, term argv[]);
+static term nif_erlang_adler32(Context *ctx, int argc, term argv[]);
+static term nif_crypto_hash_2(Context *ctx, int argc, term argv[]);
+static term nif_crypto_hash_init_1(Context *ctx, int argc, term argv[]);
+static term nif_crypto_hash_update_2(Context *ctx, int argc, term argv[]);
+static term nif_crypto_hash_final_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_send_after_3(Context *ctx, int argc, term argv[]);
+static term nif_erlang_start_timer(Context *ctx, int argc, term argv[]);
+static term nif_erlang_cancel_timer_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_read_timer_1(Context *ctx, int argc, term argv[]);
+static term nif_logger_allow_2(Context *ctx, int argc, term argv[]);
+static term nif_logger_set_allowed_levels_1(Context *ctx, int argc, term argv[]);
+static term nif_logger_set_allowed_modules_1(Context *ctx, int argc, term argv[]);
+static term nif_erlang_phash2(Context *ctx, int argc, term argv[]);
+static term nif_erlang_put_2(Context *ctx, int argc, term argv[]);
+static term nif_erlang_get(Context *ctx, int argc, term argv[]);
+static term nif_erlang_erase(Context *ctx, int argc, term argv[]);
+static term nif_erlang_get_keys(Context *ctx, int argc, term argv[]);
+static term nif_base64_encode_1(Context *ctx, int argc, term argv[]);
+static term nif_base64_encode_to_string_1(Context *ctx, int argc, term argv[]);
+static term nif_base64_decode_1(Context *ctx, int argc, term argv[]);
+static term nif_base64_mime_decode_1(Context *ctx, int argc, term argv[]);
+static term nif_json_decode_1(Context *ctx, int argc, term argv[]);
+static term nif_json_encode_1(Context *ctx, int argc, term argv[]);
+static term nif_io_lib_format_2(Context *ctx, int argc, term argv[]);
+static term nif_io_format(Context *ctx, int argc, term argv[]);
+#ifdef WITH_ZLIB
+static term nif_zlib_compress_1(Context *ctx, int argc, term argv[]);
+static term nif_zlib_uncompress_1(Context *ctx, int argc, term argv[]);
+static term nif_zlib_gzip_1(Context *ctx, int argc, term argv[]);
+static term nif_zlib_gunzip_1(Context *ctx, int argc, term argv[]);
+static term nif_zlib_open_0(Context *ctx, int argc, term argv[]);
+static term nif_zlib_close_1(Context *ctx, int argc, term argv[]);
+static term nif_zlib_deflate_init(Context *ctx, int argc, term argv[]);
+static term nif_zlib_deflate(Context *ctx, int argc, term argv[]);
+static term nif_zlib_deflate_end_1(Context *ctx, int argc, term argv[]);
+static term nif_zlib_inflate_init(Context *ctx, int argc, term argv[]);
+static term nif_zlib_inflate_2(Context *ctx, int argc, term argv[]);
+static term nif_zlib_inflate_end_1(Context *ctx, int argc, term argv[]);
+    #define ZLIB_NIF(nif) nif
+#else
+static term nif_zlib_not_available(Context *ctx, int argc, term argv[]);
+    #define ZLIB_NIF(nif) nif_zlib_not_available
+#endif
 
 static const struct Nif make_ref_nif =
 {
@@ -200,12 +345,60 @@ static const struct Nif spawn_nif =
     .nif_ptr = nif_erlang_spawn_3
 };
 
+static const struct Nif hibernate_nif =
+{
+    .base.type = HibernateNIFFunctionType,
+    .nif_ptr = nif_erlang_hibernate_3
+};
+
+static const struct Nif process_info_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_process_info_2
+};
+
 static const struct Nif send_nif =
 {
     .base.type = NIFFunctionType,
     .nif_ptr = nif_erlang_send_2
 };
 
+static const struct Nif send_3_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_send_3
+};
+
+static const struct Nif node_0_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_node_0
+};
+
+static const struct Nif node_1_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_node_1
+};
+
+static const struct Nif nodes_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_nodes_0
+};
+
+static const struct Nif term_to_binary_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_term_to_binary_1
+};
+
+static const struct Nif binary_to_term_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_binary_to_term_1
+};
+
 static const struct Nif setelement_nif =
 {
     .base.type = NIFFunctionType,
@@ -218,6 +411,60 @@ static const struct Nif whereis_nif =
     .nif_ptr = nif_erlang_whereis_1
 };
 
+static const struct Nif unregister_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_unregister_1
+};
+
+static const struct Nif exit_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_exit_1
+};
+
+static const struct Nif link_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_link_1
+};
+
+static const struct Nif unlink_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_unlink_1
+};
+
+static const struct Nif spawn_link_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_spawn_link_3
+};
+
+static const struct Nif monitor_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_monitor_2
+};
+
+static const struct Nif demonitor_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_demonitor
+};
+
+static const struct Nif process_flag_2_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_process_flag_2
+};
+
+static const struct Nif system_flag_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_system_flag_2
+};
+
 static const struct Nif concat_nif =
 {
     .base.type = NIFFunctionType,
@@ -260,816 +507,3343 @@ static const struct Nif process_flag_nif =
     .nif_ptr = nifs_erlang_process_flag
 };
 
-//Ignore warning caused by gperf generated code
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
-#pragma GCC diagnostic ignored "-Wunused-parameter"
-#include "nifs_hash.h"
-#pragma GCC diagnostic pop
+static const struct Nif iolist_size_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_iolist_size_1
+};
 
+static const struct Nif iolist_to_binary_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_iolist_to_binary_1
+};
 
-const struct Nif *nifs_get(AtomString module, AtomString function, int arity)
+static const struct Nif list_to_binary_nif =
 {
-    char nifname[MAX_NIF_NAME_LEN];
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_list_to_binary_1
+};
 
-    int module_name_len = atom_string_len(module);
-    memcpy(nifname, atom_string_data(module), module_name_len);
+static const struct Nif binary_to_list_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_binary_to_list_1
+};
 
-    nifname[module_name_len] = ':';
+static const struct Nif characters_to_binary_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_unicode_characters_to_binary_1
+};
 
-    int function_name_len = atom_string_len(function);
-    if (UNLIKELY((arity > 9) || (module_name_len + function_name_len + 4 > MAX_NIF_NAME_LEN))) {
-        abort();
-    }
-    memcpy(nifname + module_name_len + 1, atom_string_data(function), function_name_len);
+static const struct Nif binary_match_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_binary_match
+};
 
-    //TODO: handle NIFs with more than 9 parameters
-    nifname[module_name_len + function_name_len + 1] = '/';
-    nifname[module_name_len + function_name_len + 2] = '0' + arity;
-    nifname[module_name_len + function_name_len + 3] = 0;
+static const struct Nif binary_matches_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_binary_matches
+};
 
-    const NifNameAndNifPtr *nameAndPtr = nif_in_word_set(nifname, strlen(nifname));
-    if (!nameAndPtr) {
-        return NULL;
-    }
+static const struct Nif binary_split_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_binary_split
+};
 
-    return nameAndPtr->nif;
-}
+static const struct Nif binary_replace_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_binary_replace
+};
 
-static term nif_erlang_open_port_2(Context *ctx, int argc, term argv[])
+static const struct Nif binary_part_nif =
 {
-    UNUSED(argc);
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_binary_part
+};
 
-    term port_name_tuple = argv[0];
-    VALIDATE_VALUE(port_name_tuple, term_is_tuple);
-    term opts = argv[1];
-    VALIDATE_VALUE(opts, term_is_list);
+static const struct Nif binary_copy_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_binary_copy
+};
 
-    if (UNLIKELY(term_get_tuple_arity(port_name_tuple) != 2)) {
-        RAISE_ERROR(badarg_atom);
-    }
+static const struct Nif binary_at_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_binary_at
+};
 
-    term t = term_get_tuple_element(port_name_tuple, 1);
-    //TODO: validate port name
-    char *driver_name = interop_term_to_string(t);
-    if (IS_NULL_PTR(driver_name)) {
-        //TODO: handle atoms here
-        RAISE_ERROR(badarg_atom);
-    }
+static const struct Nif binary_compile_pattern_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_binary_compile_pattern
+};
 
-    Context *new_ctx = NULL;
+static const struct Nif crc32_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_crc32
+};
 
-    if (!strcmp("echo", driver_name)) {
-        new_ctx = context_new(ctx->global);
-        new_ctx->native_handler = process_echo_mailbox;
+static const struct Nif adler32_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_adler32
+};
 
-    } else if (!strcmp("console", driver_name)) {
-        new_ctx = context_new(ctx->global);
-        new_ctx->native_handler = process_console_mailbox;
-    }
+static const struct Nif crypto_hash_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_crypto_hash_2
+};
 
-    if (!new_ctx) {
-        new_ctx = sys_create_port(ctx->global, driver_name, opts);
-    }
+static const struct Nif crypto_hash_init_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_crypto_hash_init_1
+};
 
-    free(driver_name);
+static const struct Nif crypto_hash_update_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_crypto_hash_update_2
+};
 
-    if (!new_ctx) {
-        RAISE_ERROR(badarg_atom);
-    } else {
-        scheduler_make_waiting(ctx->global, new_ctx);
-        return term_from_local_process_id(new_ctx->process_id);
+static const struct Nif crypto_hash_final_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_crypto_hash_final_1
+};
 
-    }
-}
+static const struct Nif send_after_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_send_after_3
+};
 
-static term nif_erlang_register_2(Context *ctx, int argc, term argv[])
+static const struct Nif start_timer_nif =
 {
-    UNUSED(argc);
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_start_timer
+};
 
-    term reg_name_term = argv[0];
-    VALIDATE_VALUE(reg_name_term, term_is_atom);
-    term pid_or_port_term = argv[1];
-    VALIDATE_VALUE(pid_or_port_term, term_is_pid);
+static const struct Nif cancel_timer_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_cancel_timer_1
+};
 
-    int atom_index = term_to_atom_index(reg_name_term);
-    int pid = term_to_local_process_id(pid_or_port_term);
+static const struct Nif read_timer_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_read_timer_1
+};
 
-    // TODO: pid must be existing, not already registered.
-    // TODO: reg_name_term must not be the atom undefined and not already registered.
+static const struct Nif logger_allow_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_logger_allow_2
+};
 
-    globalcontext_register_process(ctx->global, atom_index, pid);
+static const struct Nif logger_set_allowed_levels_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_logger_set_allowed_levels_1
+};
 
-    return term_nil();
-}
+static const struct Nif logger_set_allowed_modules_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_logger_set_allowed_modules_1
+};
 
-static term nif_erlang_whereis_1(Context *ctx, int argc, term argv[])
+static const struct Nif phash2_nif =
 {
-    UNUSED(argc);
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_phash2
+};
 
-    term reg_name_term = argv[0];
-    VALIDATE_VALUE(reg_name_term, term_is_atom);
+static const struct Nif put_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_put_2
+};
 
-    int atom_index = term_to_atom_index(reg_name_term);
+static const struct Nif get_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_get
+};
 
-    int local_process_id = globalcontext_get_registered_process(ctx->global, atom_index);
-    if (local_process_id) {
-        return term_from_local_process_id(local_process_id);
-    } else {
-        int undefined_index = globalcontext_insert_atom(ctx->global, undefined_atom);
-        return term_from_atom_index(undefined_index);
-    }
-}
+static const struct Nif erase_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_erase
+};
 
-static void process_echo_mailbox(Context *ctx)
+static const struct Nif get_keys_nif =
 {
-    Message *msg = mailbox_dequeue(ctx);
-    term pid = term_get_tuple_element(msg->message, 0);
-    term val = term_get_tuple_element(msg->message, 1);
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_erlang_get_keys
+};
+
+static const struct Nif base64_encode_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_base64_encode_1
+};
+
+static const struct Nif base64_encode_to_string_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_base64_encode_to_string_1
+};
+
+static const struct Nif base64_decode_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_base64_decode_1
+};
+
+static const struct Nif base64_mime_decode_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_base64_mime_decode_1
+};
+
+static const struct Nif json_decode_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_json_decode_1
+};
+
+static const struct Nif json_encode_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_json_encode_1
+};
+
+static const struct Nif io_lib_format_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_io_lib_format_2
+};
+
+static const struct Nif io_format_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = nif_io_format
+};
+
+static const struct Nif zlib_compress_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_compress_1)
+};
+
+static const struct Nif zlib_uncompress_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_uncompress_1)
+};
+
+static const struct Nif zlib_gzip_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_gzip_1)
+};
+
+static const struct Nif zlib_gunzip_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_gunzip_1)
+};
+
+static const struct Nif zlib_open_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_open_0)
+};
+
+static const struct Nif zlib_close_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_close_1)
+};
+
+static const struct Nif zlib_deflate_init_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_deflate_init)
+};
+
+static const struct Nif zlib_deflate_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_deflate)
+};
+
+static const struct Nif zlib_deflate_end_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_deflate_end_1)
+};
+
+static const struct Nif zlib_inflate_init_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_inflate_init)
+};
+
+static const struct Nif zlib_inflate_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_inflate_2)
+};
+
+static const struct Nif zlib_inflate_end_nif =
+{
+    .base.type = NIFFunctionType,
+    .nif_ptr = ZLIB_NIF(nif_zlib_inflate_end_1)
+};
+
+//Ignore warning caused by gperf generated code
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include "nifs_hash.h"
+#pragma GCC diagnostic pop
+
+
+const struct Nif *nifs_get(AtomString module, AtomString function, int arity)
+{
+    char nifname[MAX_NIF_NAME_LEN];
+
+    int module_name_len = atom_string_len(module);
+    memcpy(nifname, atom_string_data(module), module_name_len);
+
+    nifname[module_name_len] = ':';
+
+    int function_name_len = atom_string_len(function);
+    if (UNLIKELY((arity > 9) || (module_name_len + function_name_len + 4 > MAX_NIF_NAME_LEN))) {
+        abort();
+    }
+    memcpy(nifname + module_name_len + 1, atom_string_data(function), function_name_len);
+
+    //TODO: handle NIFs with more than 9 parameters
+    nifname[module_name_len + function_name_len + 1] = '/';
+    nifname[module_name_len + function_name_len + 2] = '0' + arity;
+    nifname[module_name_len + function_name_len + 3] = 0;
+
+    const NifNameAndNifPtr *nameAndPtr = nif_in_word_set(nifname, strlen(nifname));
+    if (!nameAndPtr) {
+        return NULL;
+    }
+
+    return nameAndPtr->nif;
+}
+
+static term nif_erlang_open_port_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term port_name_tuple = argv[0];
+    VALIDATE_VALUE(port_name_tuple, term_is_tuple);
+    term opts = argv[1];
+    VALIDATE_VALUE(opts, term_is_list);
+
+    if (UNLIKELY(term_get_tuple_arity(port_name_tuple) != 2)) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    term t = term_get_tuple_element(port_name_tuple, 1);
+    //TODO: validate port name
+    char *driver_name = interop_term_to_string(t);
+    if (IS_NULL_PTR(driver_name)) {
+        //TODO: handle atoms here
+        RAISE_ERROR(badarg_atom);
+    }
+
+    Context *new_ctx = NULL;
+
+    if (!strcmp("echo", driver_name)) {
+        new_ctx = context_new(ctx->global);
+        new_ctx->native_handler = process_echo_mailbox;
+
+    } else if (!strcmp("console", driver_name)) {
+        new_ctx = context_new(ctx->global);
+        new_ctx->native_handler = process_console_mailbox;
+    }
+
+    if (!new_ctx) {
+        new_ctx = sys_create_port(ctx->global, driver_name, opts);
+    }
+
+    free(driver_name);
+
+    if (!new_ctx) {
+        RAISE_ERROR(badarg_atom);
+    } else {
+        scheduler_make_waiting(ctx->global, new_ctx);
+        return term_from_local_process_id(new_ctx->process_id);
+
+    }
+}
+
+static term nif_erlang_register_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term reg_name_term = argv[0];
+    VALIDATE_VALUE(reg_name_term, term_is_atom);
+    term pid_or_port_term = argv[1];
+    VALIDATE_VALUE(pid_or_port_term, term_is_pid);
+
+    int atom_index = term_to_atom_index(reg_name_term);
+    int pid = term_to_local_process_id(pid_or_port_term);
+
+    // TODO: pid must be existing, not already registered.
+    // TODO: reg_name_term must not be the atom undefined and not already registered.
+
+    globalcontext_register_process(ctx->global, atom_index, pid);
+
+    return term_nil();
+}
+
+static term nif_erlang_whereis_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term reg_name_term = argv[0];
+    VALIDATE_VALUE(reg_name_term, term_is_atom);
+
+    int atom_index = term_to_atom_index(reg_name_term);
+
+    int local_process_id = globalcontext_get_registered_process(ctx->global, atom_index);
+    if (local_process_id) {
+        return term_from_local_process_id(local_process_id);
+    } else {
+        int undefined_index = globalcontext_insert_atom(ctx->global, undefined_atom);
+        return term_from_atom_index(undefined_index);
+    }
+}
+
+static term nif_erlang_unregister_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term reg_name_term = argv[0];
+    VALIDATE_VALUE(reg_name_term, term_is_atom);
+
+    if (!globalcontext_unregister_process(ctx->global, term_to_atom_index(reg_name_term))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    return term_from_atom_index(globalcontext_insert_atom(ctx->global, true_atom));
+}
+
+static term nif_erlang_exit_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    // argv may alias the x registers: read the reason before setting the exception class
+    term reason = argv[0];
+    ctx->x[0] = context_make_atom(ctx, exit_atom);
+    ctx->x[1] = reason;
+    return term_invalid_term();
+}
+
+static term nif_erlang_link_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term pid_term = argv[0];
+    VALIDATE_VALUE(pid_term, term_is_pid);
+
+    int local_process_id = term_to_local_process_id(pid_term);
+    if (local_process_id != ctx->process_id) {
+        Context *target = globalcontext_get_process(ctx->global, local_process_id);
+        if (!target) {
+            RAISE_ERROR(noproc_atom);
+        }
+        if (UNLIKELY(!context_link(ctx, target))) {
+            RAISE_ERROR(out_of_memory_atom);
+        }
+    }
+
+    return context_make_atom(ctx, true_atom);
+}
+
+static term nif_erlang_unlink_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term pid_term = argv[0];
+    VALIDATE_VALUE(pid_term, term_is_pid);
+
+    context_unlink(ctx, term_to_local_process_id(pid_term));
+
+    return context_make_atom(ctx, true_atom);
+}
+
+static term nif_erlang_spawn_link_3(Context *ctx, int argc, term argv[])
+{
+    term pid_term = nif_erlang_spawn_3(ctx, argc, argv);
+    if (term_is_pid(pid_term)) {
+        Context *new_ctx = globalcontext_get_process(ctx->global, term_to_local_process_id(pid_term));
+        if (UNLIKELY(!context_link(ctx, new_ctx))) {
+            RAISE_ERROR(out_of_memory_atom);
+        }
+    }
+
+    return pid_term;
+}
+
+static term nif_erlang_monitor_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term object_type = argv[0];
+    term target_term = argv[1];
+    if (UNLIKELY(object_type != context_make_atom(ctx, process_atom))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    int local_process_id;
+    if (term_is_pid(target_term)) {
+        local_process_id = term_to_local_process_id(target_term);
+    } else if (term_is_atom(target_term)) {
+        local_process_id = globalcontext_get_registered_process(ctx->global, term_to_atom_index(target_term));
+    } else {
+        RAISE_ERROR(badarg_atom);
+    }
+    Context *target = local_process_id ? globalcontext_get_process(ctx->global, local_process_id) : NULL;
+
+    // room for the reference and for a 'DOWN' message
+    memory_ensure_free(ctx, TERM_BOXED_REF_SIZE + 6);
+    uint64_t ref_ticks = globalcontext_get_ref_ticks(ctx->global);
+    term ref = term_from_ref_ticks(ref_ticks, ctx);
+
+    // monitoring a process that does not exist triggers the monitor immediately
+    if (!target) {
+        term down_message = term_alloc_tuple(5, ctx);
+        term_put_tuple_element(down_message, 0, context_make_atom(ctx, down_atom));
+        term_put_tuple_element(down_message, 1, ref);
+        term_put_tuple_element(down_message, 2, object_type);
+        term_put_tuple_element(down_message, 3, target_term);
+        term_put_tuple_element(down_message, 4, context_make_atom(ctx, noproc_atom));
+        mailbox_send(ctx, down_message);
+
+    } else if (UNLIKELY(!context_monitor(ctx, target, ref_ticks))) {
+        RAISE_ERROR(out_of_memory_atom);
+    }
+
+    return ref;
+}
+
+// a triggered monitor has only one 'DOWN' message, that may be still in the mailbox
+static void flush_down_message(Context *ctx, uint64_t ref_ticks)
+{
+    if (!ctx->mailbox) {
+        return;
+    }
+
+    term down = context_make_atom(ctx, down_atom);
+    struct ListHead *item = ctx->mailbox;
+    do {
+        Message *m = GET_LIST_ENTRY(item, Message, mailbox_list_head);
+        term msg = m->message;
+        if (term_is_tuple(msg) && (term_get_tuple_arity(msg) == 5) && (term_get_tuple_element(msg, 0) == down)) {
+            term ref = term_get_tuple_element(msg, 1);
+            if (term_is_reference(ref) && (term_to_ref_ticks(ref) == ref_ticks)) {
+                mailbox_remove_message(ctx, m);
+                return;
+            }
+        }
+        item = item->next;
+    } while (item != ctx->mailbox);
+}
+
+static term nif_erlang_demonitor(Context *ctx, int argc, term argv[])
+{
+    term ref = argv[0];
+    VALIDATE_VALUE(ref, term_is_reference);
+
+    int flush = 0;
+    int info = 0;
+    if (argc == 2) {
+        term options = argv[1];
+        while (term_is_nonempty_list(options)) {
+            term option = term_get_list_head(options);
+            if (option == context_make_atom(ctx, flush_a)) {
+                flush = 1;
+            } else if (option == context_make_atom(ctx, info_atom)) {
+                info = 1;
+            } else {
+                RAISE_ERROR(badarg_atom);
+            }
+            options = term_get_list_tail(options);
+        }
+        if (UNLIKELY(!term_is_nil(options))) {
+            RAISE_ERROR(badarg_atom);
+        }
+    }
+
+    uint64_t ref_ticks = term_to_ref_ticks(ref);
+    int removed = context_demonitor(ctx, ref_ticks);
+    if (flush) {
+        flush_down_message(ctx, ref_ticks);
+    }
+
+    if (info && !removed) {
+        return context_make_atom(ctx, false_atom);
+    }
+    return context_make_atom(ctx, true_atom);
+}
+
+// options are given as a proplist of {Key, Value} tuples, with atom keys
+static int is_options_list(term options)
+{
+    while (term_is_nonempty_list(options)) {
+        term option = term_get_list_head(options);
+        if (!term_is_tuple(option) || (term_get_tuple_arity(option) != 2) || !term_is_atom(term_get_tuple_element(option, 0))) {
+            return 0;
+        }
+        options = term_get_list_tail(options);
+    }
+
+    return term_is_nil(options);
+}
+
+static term set_max_heap_size(Context *ctx, term value)
+{
+    term true_term = context_make_atom(ctx, true_atom);
+    term false_term = context_make_atom(ctx, false_atom);
+
+    term size = value;
+    term kill = true_term;
+    term log = true_term;
+    if (term_is_list(value)) {
+        if (UNLIKELY(!is_options_list(value))) {
+            RAISE_ERROR(badarg_atom);
+        }
+        size = interop_proplist_get_value(value, context_make_atom(ctx, size_atom));
+        kill = interop_proplist_get_value_default(value, context_make_atom(ctx, kill_atom), true_term);
+        log = interop_proplist_get_value_default(value, context_make_atom(ctx, error_logger_atom), true_term);
+    }
+    if (UNLIKELY(!term_is_integer(size) || (term_to_int64(size) < 0)
+            || ((kill != true_term) && (kill != false_term)) || ((log != true_term) && (log != false_term)))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    unsigned long old_size = ctx->max_heap_size;
+    ctx->max_heap_size = term_to_int64(size);
+    ctx->max_heap_size_kill = (kill == true_term);
+    ctx->max_heap_size_log = (log == true_term);
+
+    return term_from_int64(old_size);
+}
+
+static term make_message_queue_limit(Context *ctx)
+{
+    if (!ctx->message_queue_max_len && !ctx->message_queue_max_size) {
+        return context_make_atom(ctx, infinity_atom);
+    }
+
+    const char *policy;
+    switch (ctx->message_queue_policy) {
+        case MessageQueueDropOldest:
+            policy = drop_oldest_atom;
+            break;
+        case MessageQueueBlock:
+            policy = block_atom;
+            break;
+        default:
+            policy = drop_newest_atom;
+            break;
+    }
+
+    memory_ensure_free(ctx, 3 * (3 + 2));
+    term messages = term_alloc_tuple(2, ctx);
+    term_put_tuple_element(messages, 0, context_make_atom(ctx, messages_atom));
+    term_put_tuple_element(messages, 1, term_from_int64(ctx->message_queue_max_len));
+    term bytes = term_alloc_tuple(2, ctx);
+    term_put_tuple_element(bytes, 0, context_make_atom(ctx, bytes_atom));
+    term_put_tuple_element(bytes, 1, term_from_int64(ctx->message_queue_max_size));
+    term policy_tuple = term_alloc_tuple(2, ctx);
+    term_put_tuple_element(policy_tuple, 0, context_make_atom(ctx, policy_atom));
+    term_put_tuple_element(policy_tuple, 1, context_make_atom(ctx, policy));
+
+    term result = term_list_prepend(policy_tuple, term_nil(), ctx);
+    result = term_list_prepend(bytes, result, ctx);
+    return term_list_prepend(messages, result, ctx);
+}
+
+static term set_message_queue_limit(Context *ctx, term value)
+{
+    term zero = term_from_int32(0);
+    term max_len = zero;
+    term max_size = zero;
+    term policy = context_make_atom(ctx, drop_newest_atom);
+    if (value != context_make_atom(ctx, infinity_atom)) {
+        if (UNLIKELY(!is_options_list(value))) {
+            RAISE_ERROR(badarg_atom);
+        }
+        max_len = interop_proplist_get_value_default(value, context_make_atom(ctx, messages_atom), zero);
+        max_size = interop_proplist_get_value_default(value, context_make_atom(ctx, bytes_atom), zero);
+        policy = interop_proplist_get_value_default(value, context_make_atom(ctx, policy_atom), policy);
+    }
+    if (UNLIKELY(!term_is_integer(max_len) || (term_to_int64(max_len) < 0)
+            || !term_is_integer(max_size) || (term_to_int64(max_size) < 0))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    enum MessageQueuePolicy queue_policy;
+    if (policy == context_make_atom(ctx, drop_newest_atom)) {
+        queue_policy = MessageQueueDropNewest;
+    } else if (policy == context_make_atom(ctx, drop_oldest_atom)) {
+        queue_policy = MessageQueueDropOldest;
+    } else if (policy == context_make_atom(ctx, block_atom)) {
+        queue_policy = MessageQueueBlock;
+    } else {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    term old_value = make_message_queue_limit(ctx);
+    ctx->message_queue_max_len = term_to_int64(max_len);
+    ctx->message_queue_max_size = term_to_int64(max_size);
+    ctx->message_queue_policy = queue_policy;
+
+    return old_value;
+}
+
+static term nif_erlang_process_flag_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term flag = argv[0];
+    term value = argv[1];
+
+    if (flag == context_make_atom(ctx, max_heap_size_atom)) {
+        return set_max_heap_size(ctx, value);
+    } else if (flag == context_make_atom(ctx, message_queue_limit_atom)) {
+        return set_message_queue_limit(ctx, value);
+    }
+
+    term true_term = context_make_atom(ctx, true_atom);
+    term false_term = context_make_atom(ctx, false_atom);
+
+    if (UNLIKELY((flag != context_make_atom(ctx, trap_exit_atom)) || ((value != true_term) && (value != false_term)))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    term old_value = ctx->trap_exit ? true_term : false_term;
+    ctx->trap_exit = (value == true_term);
+
+    return old_value;
+}
+
+static term nif_erlang_system_flag_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term flag = argv[0];
+    term value = argv[1];
+    term infinity = context_make_atom(ctx, infinity_atom);
+    GlobalContext *glb = ctx->global;
+
+    // the memory budget is the hard watermark: allocations over it are refused
+    size_t *limit;
+    if (flag == context_make_atom(ctx, memory_budget_atom)) {
+        limit = &glb->memory_budget;
+    } else if (flag == context_make_atom(ctx, memory_soft_watermark_atom)) {
+        limit = &glb->memory_soft_watermark;
+    } else {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    if (UNLIKELY((value != infinity) && (!term_is_integer(value) || (term_to_int64(value) <= 0)))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    term old_value = *limit ? term_from_int64(*limit) : infinity;
+    *limit = (value == infinity) ? 0 : term_to_int64(value);
+    glb->memory_relief_level = 0;
+
+    return old_value;
+}
+
+static void process_echo_mailbox(Context *ctx)
+{
+    Message *msg = mailbox_dequeue(ctx);
+    term pid = term_get_tuple_element(msg->message, 0);
+    term val = term_get_tuple_element(msg->message, 1);
+
+    int local_process_id = term_to_local_process_id(pid);
+    Context *target = globalcontext_get_process(ctx->global, local_process_id);
+    mailbox_send(target, val);
+
+    mailbox_message_destroy(msg);
+}
+
+static void process_console_mailbox(Context *ctx)
+{
+    Message *message = mailbox_dequeue(ctx);
+    term msg = message->message;
+
+    if (port_is_standard_port_command(msg)) {
+        CContext ccontext;
+        CContext *cc = &ccontext;
+        ccontext_init(cc, ctx);
+
+        term_ref pid = ccontext_make_term_ref(cc, term_get_tuple_element(msg, 0));
+        term_ref ref = ccontext_make_term_ref(cc, term_get_tuple_element(msg, 1));
+        term cmd = term_get_tuple_element(msg, 2);
+
+        if (term_is_atom(cmd) && cmd == context_make_atom(ctx, flush_a)) {
+            fflush(stdout);
+            port_send_reply(cc, pid, ref, port_make_ok_atom(cc));
+        } else if (term_is_tuple(cmd) && term_get_tuple_arity(cmd) == 2) {
+            term cmd_name = term_get_tuple_element(cmd, 0);
+            if (cmd_name == context_make_atom(ctx, puts_a)) {
+                char *str = interop_term_to_string(term_get_tuple_element(cmd, 1));
+                if (IS_NULL_PTR(str)) {
+                    term_ref error = port_create_error_tuple(cc, "Unable to convert term to string");
+                    port_send_reply(cc, pid, ref, error);
+                } else {
+                    printf("%s", str);
+                    port_send_reply(cc, pid, ref, port_make_ok_atom(cc));
+                }
+                free(str);
+            } else {
+                term_ref error = port_create_error_tuple(cc, "Expected puts command");
+                port_send_reply(cc, pid, ref, error);
+            }
+        } else {
+            port_send_reply(cc, pid, ref, port_create_error_tuple(cc, "unrecognized command"));
+        }
+
+        ccontext_release_all_refs(cc);
+    } else {
+        fprintf(stderr, "WARNING: Invalid port command.  Unable to send reply");
+    }
+
+    mailbox_message_destroy(message);
+}
+
+static term nif_erlang_spawn_3(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term module_term = argv[0];
+    term function_term = argv[1];
+    term args_term = argv[2];
+    VALIDATE_VALUE(module_term, term_is_atom);
+    VALIDATE_VALUE(function_term, term_is_atom);
+    VALIDATE_VALUE(args_term, term_is_list);
+
+    Context *new_ctx = context_new(ctx->global);
+
+    AtomString module_string = globalcontext_atomstring_from_term(ctx->global, argv[0]);
+    AtomString function_string = globalcontext_atomstring_from_term(ctx->global, argv[1]);
+
+    Module *found_module = globalcontext_get_module(ctx->global, module_string);
+    if (UNLIKELY(!found_module)) {
+        int undefined_index = globalcontext_insert_atom(ctx->global, undefined_atom);
+        if (undefined_index < 0) {
+            abort();
+        }
+        return term_from_atom_index(undefined_index);
+    }
+
+    int label = module_search_exported_function(found_module, function_string, term_list_length(argv[2]));
+    //TODO: fail here if no function has been found
+    new_ctx->saved_module = found_module;
+    new_ctx->saved_ip = found_module->labels[label];
+    new_ctx->cp = module_address(found_module->module_index, found_module->end_instruction_ii);
+
+    //TODO: check available registers count
+    int reg_index = 0;
+    term t = argv[2];
+    memory_ensure_free(new_ctx, memory_estimate_usage(t));
+    while (!term_is_nil(t)) {
+        term *t_ptr = term_get_list_ptr(t);
+        new_ctx->x[reg_index] = memory_copy_term_tree(&new_ctx->heap_ptr, t_ptr[1]);
+        t = *t_ptr;
+        reg_index++;
+    }
+
+    return term_from_local_process_id(new_ctx->process_id);
+}
+
+static term nif_erlang_hibernate_3(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    VALIDATE_VALUE(argv[0], term_is_atom);
+    VALIDATE_VALUE(argv[1], term_is_atom);
+    VALIDATE_VALUE(argv[2], term_is_list);
+
+    int args_count = 0;
+    term args[16];
+    term t = argv[2];
+    while (term_is_nonempty_list(t)) {
+        if (UNLIKELY(args_count == ctx->avail_registers)) {
+            RAISE_ERROR(badarg_atom);
+        }
+        args[args_count++] = term_get_list_head(t);
+        t = term_get_list_tail(t);
+    }
+    if (UNLIKELY(!term_is_nil(t))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    AtomString module_string = globalcontext_atomstring_from_term(ctx->global, argv[0]);
+    AtomString function_string = globalcontext_atomstring_from_term(ctx->global, argv[1]);
+    Module *found_module = globalcontext_get_module(ctx->global, module_string);
+    if (UNLIKELY(!found_module)) {
+        RAISE_ERROR(badarg_atom);
+    }
+    int label = module_search_exported_function(found_module, function_string, args_count);
+    if (UNLIKELY(!label)) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    // the call stack is discarded: the process will return to the continuation it has been started with,
+    // that is saved by the outermost stack frame, if any
+    for (int i = 0; i < args_count; i++) {
+        ctx->x[i] = args[i];
+    }
+    context_clean_registers(ctx, args_count);
+    if (ctx->e != ctx->stack_base) {
+        ctx->cp = ctx->stack_base[-1];
+        ctx->e = ctx->stack_base;
+    }
+    free(ctx->catch_frames);
+    ctx->catch_frames = NULL;
+    ctx->catch_frames_count = 0;
+    ctx->catch_frames_size = 0;
+    ctx->timeout_at.tv_sec = 0;
+    ctx->timeout_at.tv_nsec = 0;
+
+    memory_gc_and_shrink(ctx);
+
+    ctx->saved_module = found_module;
+    ctx->saved_ip = found_module->labels[label];
+    ctx->jump_to_on_restore = NULL;
+
+    // the execute loop suspends the process until a message is received, see HIBERNATE
+    return context_make_atom(ctx, ok_atom);
+}
+
+static term nif_erlang_process_info_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    VALIDATE_VALUE(argv[0], term_is_pid);
+    VALIDATE_VALUE(argv[1], term_is_atom);
+
+    int local_process_id = term_to_local_process_id(argv[0]);
+    Context *target = globalcontext_get_process(ctx->global, local_process_id);
+    if (!target) {
+        return context_make_atom(ctx, undefined_atom);
+    }
+
+    term key = argv[1];
+    int64_t value;
+    if (key == context_make_atom(ctx, heap_size_atom)) {
+        value = target->heap_ptr - target->heap_start;
+    } else if (key == context_make_atom(ctx, stack_size_atom)) {
+        value = target->stack_base - target->e;
+    } else if (key == context_make_atom(ctx, total_heap_size_atom)) {
+        value = context_memory_size(target) + context_stack_memory_size(target);
+    } else if (key == context_make_atom(ctx, memory_atom)) {
+        value = sizeof(Context) + (context_memory_size(target) + context_stack_memory_size(target)) * sizeof(term)
+            + target->message_queue_size;
+    } else if (key == context_make_atom(ctx, message_queue_len_atom)) {
+        value = target->message_queue_len;
+    } else {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    memory_ensure_free(ctx, 3);
+    term result = term_alloc_tuple(2, ctx);
+    term_put_tuple_element(result, 0, argv[1]);
+    term_put_tuple_element(result, 1, term_from_int64(value));
+
+    return result;
+}
+
+static term nif_erlang_send_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term pid_term = argv[0];
+    // {Name, Node} destinations are processes registered on a node, {Name, Instance} on another instance
+    if (dist_is_node_destination(pid_term)) {
+        if (UNLIKELY(!dist_send_registered(ctx, pid_term, argv[1]))) {
+            RAISE_ERROR(badarg_atom);
+        }
+        return argv[1];
+    }
+    if (term_is_tuple(pid_term)) {
+        if (UNLIKELY(bridge_send(ctx->global, pid_term, argv[1]) == BridgeSendBadArg)) {
+            RAISE_ERROR(badarg_atom);
+        }
+        return argv[1];
+    }
+    VALIDATE_VALUE(pid_term, term_is_pid);
+
+    int local_process_id = term_to_local_process_id(pid_term);
+    Context *target = globalcontext_get_process(ctx->global, local_process_id);
+    if (target) {
+        mailbox_send(target, argv[1]);
+    }
+
+    return argv[1];
+}
+
+// move is not an OTP option: the caller promises that the message is not used anymore after the call,
+// so its heap memory is given back to the caller as soon as it has been copied to the message
+static term nif_erlang_send_3(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    int move = 0;
+    term options = argv[2];
+    while (term_is_nonempty_list(options)) {
+        term option = term_get_list_head(options);
+        if (option == context_make_atom(ctx, move_atom)) {
+            move = 1;
+        } else if ((option != context_make_atom(ctx, noconnect_atom)) && (option != context_make_atom(ctx, nosuspend_atom))) {
+            RAISE_ERROR(badarg_atom);
+        }
+        options = term_get_list_tail(options);
+    }
+    VALIDATE_VALUE(options, term_is_nil);
+
+    if (!move || !term_is_pid(argv[0])) {
+        term result = nif_erlang_send_2(ctx, 2, argv);
+        if (UNLIKELY(term_is_invalid_term(result))) {
+            return result;
+        }
+        return context_make_atom(ctx, ok_atom);
+    }
+
+    int local_process_id = term_to_local_process_id(argv[0]);
+    Context *target = globalcontext_get_process(ctx->global, local_process_id);
+    if (target) {
+        // x registers, arguments included, are not live after a call
+        Message *m = mailbox_message_move(ctx, argv[1]);
+        if (LIKELY(m != NULL)) {
+            mailbox_enqueue_message(target, m);
+        }
+    }
+
+    return context_make_atom(ctx, ok_atom);
+}
+
+static term nif_erlang_node_0(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    term node;
+    uint32_t creation;
+    if (!dist_local_node(ctx->global, &node, &creation)) {
+        return context_make_atom(ctx, nonode_at_nohost_atom);
+    }
+
+    return node;
+}
+
+static term nif_erlang_node_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term t = argv[0];
+    if (term_is_pid(t)) {
+        return dist_pid_node(ctx->global, t);
+
+    } else if (term_is_external_reference(t)) {
+        uint32_t creation;
+        return term_get_external_ref_node(t, &creation);
+
+    } else if (term_is_reference(t)) {
+        return nif_erlang_node_0(ctx, 0, argv);
+
+    } else {
+        RAISE_ERROR(badarg_atom);
+    }
+}
+
+static term nif_erlang_nodes_0(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    memory_ensure_free(ctx, dist_connected_nodes_size(ctx->global));
+
+    return dist_connected_nodes(ctx);
+}
+
+static term nif_erlang_term_to_binary_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    int size = externalterm_compute_external_size(argv[0], ctx->global);
+    if (UNLIKELY(size < 0)) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(size) + 2);
+
+    // GC might have changed all pointers
+    term binary = term_create_uninitialized_binary(size, ctx);
+    externalterm_serialize_term((uint8_t *) term_binary_data(binary), argv[0], ctx->global);
+
+    return binary;
+}
+
+static term nif_erlang_binary_to_term_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term binary = argv[0];
+    VALIDATE_VALUE(binary, term_is_binary);
+
+    unsigned long size = term_binary_size(binary);
+    const uint8_t *data = (const uint8_t *) term_binary_data(binary);
+    if (UNLIKELY((size < 1) || (data[0] != 131))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    // decoding might run the GC that moves the binary, so it is decoded from a copy
+    uint8_t *buf = malloc(size - 1);
+    if (IS_NULL_PTR(buf)) {
+        RAISE_ERROR(out_of_memory_atom);
+    }
+    memcpy(buf, data + 1, size - 1);
+    term t = externalterm_decode(buf, size - 1, NULL, NULL, ctx);
+    free(buf);
+
+    if (UNLIKELY(term_is_invalid_term(t))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    return t;
+}
+
+static term nif_erlang_is_process_alive_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    int local_process_id = term_to_local_process_id(argv[0]);
+    Context *target = globalcontext_get_process(ctx->global, local_process_id);
+    if (target) {
+        int true_i = globalcontext_insert_atom(ctx->global, true_atom);
+        return term_from_atom_index(true_i);
+    } else {
+        int false_i = globalcontext_insert_atom(ctx->global, false_atom);
+        return term_from_atom_index(false_i);
+    }
+}
+
+static term nif_erlang_concat_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term prepend_list = argv[0];
+
+    if (UNLIKELY(!term_is_nonempty_list(prepend_list))) {
+        if (term_is_nil(prepend_list)) {
+            return argv[1];
+
+        } else {
+            RAISE_ERROR(badarg_atom);
+        }
+    }
+
+    int len = term_list_length(prepend_list);
+    memory_ensure_free(ctx, len * 2);
+
+    // GC might have changed all pointers
+    prepend_list = argv[0];
+    term append_list = argv[1];
+
+    term t = prepend_list;
+    term list_begin = term_nil();
+    term *prev_term = NULL;
+
+    // TODO: handle impropers list
+    while (!term_is_nil(t)) {
+        term head = term_get_list_head(t);
+
+        term *new_list_item = term_list_alloc(ctx);
+
+        if (prev_term) {
+            prev_term[0] = term_list_from_list_ptr(new_list_item);
+        } else {
+            list_begin = term_list_from_list_ptr(new_list_item);
+        }
+
+        prev_term = new_list_item;
+        new_list_item[1] = head;
+
+        t = term_get_list_tail(t);
+    }
+
+    if (prev_term) {
+        prev_term[0] = append_list;
+    }
+
+    return list_begin;
+}
+
+term nif_erlang_make_ref_0(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    uint64_t ref_ticks = globalcontext_get_ref_ticks(ctx->global);
+
+    return term_from_ref_ticks(ref_ticks, ctx);
+}
+
+term nif_erlang_system_time_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(ctx);
+    UNUSED(argc);
+
+    struct timespec ts;
+    sys_time(&ts);
+
+    term minute_atom = context_make_atom(ctx, "\x6" "minute");
+    if (argv[0] == minute_atom) {
+        // FIXME: This is not standard, however we cannot hold seconds since 1970 in just 27 bits.
+        return term_from_int32(ts.tv_sec / 60);
+
+    } else {
+        RAISE_ERROR(badarg_atom);
+    }
+}
+
+term nif_erlang_universaltime_0(Context *ctx, int argc, term argv[])
+{
+    UNUSED(ctx);
+    UNUSED(argc);
+    UNUSED(argv);
+
+    // 4 = size of date/time tuple, 3 size of date time tuple
+    memory_ensure_free(ctx, 3 + 4 + 4);
+    term date_tuple = term_alloc_tuple(3, ctx);
+    term time_tuple = term_alloc_tuple(3, ctx);
+    term date_time_tuple = term_alloc_tuple(2, ctx);
+
+    struct timespec ts;
+    sys_time(&ts);
+
+    struct tm broken_down_time;
+    gmtime_r(&ts.tv_sec, &broken_down_time);
+
+    term_put_tuple_element(date_tuple, 0, term_from_int32(1900 + broken_down_time.tm_year));
+    term_put_tuple_element(date_tuple, 1, term_from_int32(broken_down_time.tm_mon + 1));
+    term_put_tuple_element(date_tuple, 2, term_from_int32(broken_down_time.tm_mday));
+
+    term_put_tuple_element(time_tuple, 0, term_from_int32(broken_down_time.tm_hour));
+    term_put_tuple_element(time_tuple, 1, term_from_int32(broken_down_time.tm_min));
+    term_put_tuple_element(time_tuple, 2, term_from_int32(broken_down_time.tm_sec));
+
+    term_put_tuple_element(date_time_tuple, 0, date_tuple);
+    term_put_tuple_element(date_time_tuple, 1, time_tuple);
+
+    return date_time_tuple;
+}
+
+term nif_erlang_timestamp_0(Context *ctx, int argc, term argv[])
+{
+    UNUSED(ctx);
+    UNUSED(argc);
+    UNUSED(argv);
+
+    memory_ensure_free(ctx, 4);
+    term timestamp_tuple = term_alloc_tuple(3, ctx);
+
+    struct timespec ts;
+    sys_time(&ts);
+
+    term_put_tuple_element(timestamp_tuple, 0, term_from_int32(ts.tv_sec / 1000000));
+    term_put_tuple_element(timestamp_tuple, 1, term_from_int32(ts.tv_sec % 1000000));
+    term_put_tuple_element(timestamp_tuple, 2, term_from_int32(ts.tv_nsec / 1000));
+
+    return timestamp_tuple;
+}
+
+static term nif_erlang_make_tuple_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    VALIDATE_VALUE(argv[0], term_is_integer);
+
+    int count_elem = term_to_int32(argv[0]);
+
+    if (UNLIKELY(count_elem < 0)) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    memory_ensure_free(ctx, count_elem + 1);
+    term new_tuple = term_alloc_tuple(count_elem, ctx);
+
+    term element = argv[1];
+
+    for (int i = 0; i < count_elem; i++) {
+        term_put_tuple_element(new_tuple, i, element);
+    }
+
+    return new_tuple;
+}
+
+static term nif_erlang_insert_element_3(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    VALIDATE_VALUE(argv[0], term_is_integer);
+    VALIDATE_VALUE(argv[1], term_is_tuple);
+
+    // indexes are 1 based
+    int insert_index = term_to_int32(argv[0]) - 1;
+
+    int old_tuple_size = term_get_tuple_arity(argv[1]);
+
+    if (UNLIKELY((insert_index > old_tuple_size) || (insert_index < 0))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    int new_tuple_size = old_tuple_size + 1;
+    memory_ensure_free(ctx, new_tuple_size + 1);
+    term new_tuple = term_alloc_tuple(new_tuple_size, ctx);
+
+    term old_tuple = argv[1];
+    term new_element = argv[2];
+
+    int src_elements_shift = 0;
+    for (int i = 0; i < new_tuple_size; i++) {
+        if (i == insert_index) {
+            src_elements_shift = 1;
+            term_put_tuple_element(new_tuple, i, new_element);
+        } else {
+            term_put_tuple_element(new_tuple, i, term_get_tuple_element(old_tuple, i - src_elements_shift));
+        }
+    }
+
+    return new_tuple;
+}
+
+
+static term nif_erlang_delete_element_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    VALIDATE_VALUE(argv[0], term_is_integer);
+    VALIDATE_VALUE(argv[1], term_is_tuple);
+
+    // indexes are 1 based
+    int delete_index = term_to_int32(argv[0]) - 1;
+
+    int old_tuple_size = term_get_tuple_arity(argv[1]);
+
+    if (UNLIKELY((delete_index > old_tuple_size) || (delete_index < 0))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    int new_tuple_size = old_tuple_size - 1;
+    memory_ensure_free(ctx, new_tuple_size + 1);
+    term new_tuple = term_alloc_tuple(new_tuple_size, ctx);
+
+    term old_tuple = argv[1];
+
+    int src_elements_shift = 0;
+    for (int i = 0; i < new_tuple_size; i++) {
+        if (i == delete_index) {
+            src_elements_shift = 1;
+        }
+        term_put_tuple_element(new_tuple, i, term_get_tuple_element(old_tuple, i + src_elements_shift));
+    }
+
+    return new_tuple;
+}
+
+static term nif_erlang_setelement_3(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    VALIDATE_VALUE(argv[0], term_is_integer);
+    VALIDATE_VALUE(argv[1], term_is_tuple);
+
+    // indexes are 1 based
+    int replace_index = term_to_int32(argv[0]) - 1;
+
+    int tuple_size = term_get_tuple_arity(argv[1]);
+
+    if (UNLIKELY((replace_index >= tuple_size) || (replace_index < 0))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    memory_ensure_free(ctx, tuple_size + 1);
+    term new_tuple = term_alloc_tuple(tuple_size, ctx);
+
+    term old_tuple = argv[1];
+    for (int i = 0; i < tuple_size; i++) {
+        term_put_tuple_element(new_tuple, i, term_get_tuple_element(old_tuple, i));
+    }
+
+    term value = argv[2];
+    term_put_tuple_element(new_tuple, replace_index, value);
+
+    return new_tuple;
+}
+
+static term nif_erlang_tuple_to_list_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    VALIDATE_VALUE(argv[0], term_is_tuple);
+
+    int tuple_size = term_get_tuple_arity(argv[0]);
+
+    memory_ensure_free(ctx, tuple_size * 2);
+
+    term tuple = argv[0];
+    term prev = term_nil();
+
+    for (int i = tuple_size - 1; i >= 0; i--) {
+        prev = term_list_prepend(term_get_tuple_element(tuple, i), prev, ctx);
+    }
+
+    return prev;
+}
+
+static term nif_erlang_binary_to_atom_2(Context *ctx, int argc, term argv[])
+{
+    return binary_to_atom(ctx, argc, argv, 1);
+}
+
+static term nif_erlang_binary_to_existing_atom_2(Context *ctx, int argc, term argv[])
+{
+    return binary_to_atom(ctx, argc, argv, 0);
+}
+
+static term binary_to_atom(Context *ctx, int argc, term argv[], int create_new)
+{
+    UNUSED(argc);
+
+    term a_binary = argv[0];
+    VALIDATE_VALUE(a_binary, term_is_binary);
+
+    if (UNLIKELY(argv[1] != context_make_atom(ctx, latin1_atom))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    char *atom_string = interop_binary_to_string(a_binary);
+    if (IS_NULL_PTR(atom_string)) {
+        fprintf(stderr, "Failed to alloc temporary string\n");
+        abort();
+    }
+    int atom_string_len = strlen(atom_string);
+    if (UNLIKELY(atom_string_len > 255)) {
+        free(atom_string);
+        RAISE_ERROR(system_limit_atom);
+    }
+
+    AtomString atom = malloc(atom_string_len + 1);
+    ((uint8_t *) atom)[0] = atom_string_len;
+    memcpy(((char *) atom) + 1, atom_string, atom_string_len);
+
+    unsigned long global_atom_index = atomshashtable_get_value(ctx->global->atoms_table, atom, ULONG_MAX);
+    int has_atom = (global_atom_index != ULONG_MAX);
+
+    if (create_new || has_atom) {
+        if (!has_atom) {
+            global_atom_index = globalcontext_insert_atom(ctx->global, atom);
+        } else {
+            free((void *) atom);
+        }
+        return term_from_atom_index(global_atom_index);
+
+    } else {
+        free((void *) atom);
+        RAISE_ERROR(badarg_atom);
+    }
+}
+
+term nif_erlang_list_to_atom_1(Context *ctx, int argc, term argv[])
+{
+    return list_to_atom(ctx, argc, argv, 1);
+}
+
+term nif_erlang_list_to_existing_atom_1(Context *ctx, int argc, term argv[])
+{
+    return list_to_atom(ctx, argc, argv, 0);
+}
+
+term list_to_atom(Context *ctx, int argc, term argv[], int create_new)
+{
+    UNUSED(argc);
+
+    term a_list = argv[0];
+    VALIDATE_VALUE(a_list, term_is_list);
+
+    char *atom_string = interop_list_to_string(a_list);
+    if (IS_NULL_PTR(atom_string)) {
+        fprintf(stderr, "Failed to alloc temporary string\n");
+        abort();
+    }
+    int atom_string_len = strlen(atom_string);
+    if (UNLIKELY(atom_string_len > 255)) {
+        free(atom_string);
+        RAISE_ERROR(system_limit_atom);
+    }
+
+    AtomString atom = malloc(atom_string_len + 1);
+    ((uint8_t *) atom)[0] = atom_string_len;
+    memcpy(((char *) atom) + 1, atom_string, atom_string_len);
+
+    unsigned long global_atom_index = atomshashtable_get_value(ctx->global->atoms_table, atom, ULONG_MAX);
+    int has_atom = (global_atom_index != ULONG_MAX);
+
+    if (create_new || has_atom) {
+        if (!has_atom) {
+            global_atom_index = globalcontext_insert_atom(ctx->global, atom);
+        } else {
+            free((void *) atom);
+        }
+        return term_from_atom_index(global_atom_index);
+
+    } else {
+        free((void *) atom);
+        RAISE_ERROR(badarg_atom);
+    }
+}
+
+static term nif_erlang_atom_to_list_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term atom_term = argv[0];
+    VALIDATE_VALUE(atom_term, term_is_atom);
+
+    int atom_index = term_to_atom_index(atom_term);
+    AtomString atom_string = (AtomString) valueshashtable_get_value(ctx->global->atoms_ids_table, atom_index, (unsigned long) NULL);
+
+    int atom_len = atom_string_len(atom_string);
+
+    memory_ensure_free(ctx, atom_len * 2);
+
+    term prev = term_nil();
+    for (int i = atom_len - 1; i >= 0; i--) {
+        char c = ((const char *) atom_string_data(atom_string))[i];
+        prev = term_list_prepend(term_from_int11(c), prev, ctx);
+    }
+
+    return prev;
+}
+
+static term nif_erlang_integer_to_list_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term value = argv[0];
+    VALIDATE_VALUE(value, term_is_integer);
+
+    int32_t int_value = term_to_int32(value);
+    char integer_string[24];
+
+    snprintf(integer_string, 24, "%i", int_value);
+    int integer_string_len = strlen(integer_string);
+
+    memory_ensure_free(ctx, integer_string_len * 2);
+
+    term prev = term_nil();
+    for (int i = integer_string_len - 1; i >= 0; i--) {
+        prev = term_list_prepend(term_from_int11(integer_string[i]), prev, ctx);
+    }
+
+    return prev;
+}
+
+static term nif_erlang_list_to_integer_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    term t = argv[0];
+    int32_t acc = 0;
+    int digits = 0;
+
+    VALIDATE_VALUE(t, term_is_nonempty_list);
+
+    int negative = 0;
+    term first_digit = term_get_list_head(t);
+    if (first_digit == term_from_int11('-')) {
+        negative = 1;
+        t = term_get_list_tail(t);
+    } else if (first_digit == term_from_int11('+')) {
+        t = term_get_list_tail(t);
+    }
+
+    while (!term_is_nil(t)) {
+        term head = term_get_list_head(t);
+
+        VALIDATE_VALUE(head, term_is_integer);
+
+        int32_t c = term_to_int32(head);
+
+        if (UNLIKELY((c < '0') || (c > '9'))) {
+            RAISE_ERROR(badarg_atom);
+        }
+
+        if (acc > INT32_MAX / 10) {
+            // overflow error is not standard, but we need it since we are running on an embedded device
+            RAISE_ERROR(overflow_atom);
+        }
+
+        acc = (acc * 10) + (c - '0');
+        digits++;
+        t = term_get_list_tail(t);
+    }
+
+    if (negative) {
+        acc = -acc;
+    }
+
+    if (UNLIKELY(digits == 0)) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    return term_from_int32(acc);
+}
+
+static term nif_erlang_display_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(ctx);
+    UNUSED(argc);
+
+    term_display(argv[0], ctx);
+    printf("\n");
+
+    return term_nil();
+}
+
+static term nifs_erlang_process_flag(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+#ifdef ENABLE_ADVANCED_TRACE
+    term pid = argv[0];
+    term flag = argv[1];
+    term value = argv[2];
 
     int local_process_id = term_to_local_process_id(pid);
     Context *target = globalcontext_get_process(ctx->global, local_process_id);
-    mailbox_send(target, val);
 
-    free(msg);
+    term true_term = context_make_atom(ctx, true_atom);
+    term false_term = context_make_atom(ctx, false_atom);
+    term ok_term = context_make_atom(ctx, ok_atom);
+
+    if (flag == context_make_atom(target, trace_calls_atom)) {
+        if (value == true_term) {
+            target->trace_calls = 1;
+            return ok_term;
+        } else if (value == false_term) {
+            target->trace_calls = 0;
+            return ok_term;
+        }
+    } else if (flag == context_make_atom(target, trace_call_args_atom)) {
+        if (value == true_term) {
+            target->trace_call_args = 1;
+            return ok_term;
+        } else if (value == false_term) {
+            target->trace_call_args = 0;
+            return ok_term;
+        }
+    } else if (flag == context_make_atom(target, trace_returns_atom)) {
+        if (value == true_term) {
+            target->trace_returns = 1;
+            return ok_term;
+        } else if (value == false_term) {
+            target->trace_returns = 0;
+            return ok_term;
+        }
+    } else if (flag == context_make_atom(target, trace_send_atom)) {
+        if (value == true_term) {
+            target->trace_send = 1;
+            return ok_term;
+        } else if (value == false_term) {
+            target->trace_send = 0;
+            return ok_term;
+        }
+    } else if (flag == context_make_atom(target, trace_receive_atom)) {
+        if (value == true_term) {
+            target->trace_receive = 1;
+            return ok_term;
+        } else if (value == false_term) {
+            target->trace_receive = 0;
+            return ok_term;
+        }
+    }
+#else
+    UNUSED(ctx);
+    UNUSED(argv);
+#endif
+
+    RAISE_ERROR(badarg_atom);
+}
+
+static term nif_erts_debug_flat_size(Context *ctx, int argc, term argv[])
+{
+    UNUSED(ctx);
+    UNUSED(argc);
+
+    unsigned long terms_count;
+
+    terms_count = memory_estimate_usage(argv[0]);
+
+    return term_from_int32(terms_count);
+}
+
+static term nif_erlang_iolist_size_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    int ok;
+    unsigned long size = interop_iolist_size(argv[0], &ok);
+
+    if (UNLIKELY(!ok)) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    return term_from_int32(size);
+}
+
+static term nif_erlang_iolist_to_binary_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    int ok;
+    unsigned long size = interop_iolist_size(argv[0], &ok);
+
+    if (UNLIKELY(!ok)) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(size) + 2);
+
+    // GC might have changed all pointers
+    term binary = term_create_uninitialized_binary(size, ctx);
+    interop_write_iolist(argv[0], (char *) term_binary_data(binary));
+
+    return binary;
+}
+
+static term nif_erlang_list_to_binary_1(Context *ctx, int argc, term argv[])
+{
+    VALIDATE_VALUE(argv[0], term_is_list);
+
+    return nif_erlang_iolist_to_binary_1(ctx, argc, argv);
+}
+
+static term nif_erlang_binary_to_list_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    VALIDATE_VALUE(argv[0], term_is_binary);
+
+    int len = term_binary_size(argv[0]);
+    if (len == 0) {
+        return term_nil();
+    }
+
+    memory_ensure_free(ctx, len * 2);
+
+    // GC might have changed all pointers
+    const uint8_t *data = (const uint8_t *) term_binary_data(argv[0]);
+
+    // cells are allocated contiguously so this loop can be easily vectorized by the compiler
+    term *list_cells = memory_heap_alloc(ctx, len * 2);
+    for (int i = 0; i < len; i++) {
+        list_cells[i * 2] = term_list_from_list_ptr(&list_cells[(i + 1) * 2]);
+        list_cells[i * 2 + 1] = term_from_int11(data[i]);
+    }
+    list_cells[(len - 1) * 2] = term_nil();
+
+    return term_list_from_list_ptr(list_cells);
+}
+
+static term nif_unicode_characters_to_binary_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    int ok;
+    unsigned long size = interop_chardata_utf8_size(argv[0], &ok);
+
+    if (UNLIKELY(!ok)) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(size) + 2);
+
+    // GC might have changed all pointers
+    term binary = term_create_uninitialized_binary(size, ctx);
+    interop_write_chardata_utf8(argv[0], (char *) term_binary_data(binary));
+
+    return binary;
+}
+
+struct BinarySearchOptions
+{
+    size_t scope_start;
+    size_t scope_end;
+    term insert_replaced;
+    unsigned int global : 1;
+    unsigned int trim : 1;
+    unsigned int trim_all : 1;
+};
+
+static int binary_get_part(term pos_term, term len_term, size_t subject_size, size_t *part_start, size_t *part_len)
+{
+    if (UNLIKELY(!term_is_integer(pos_term) || !term_is_integer(len_term))) {
+        return 0;
+    }
+
+    int64_t pos = term_to_int64(pos_term);
+    int64_t len = term_to_int64(len_term);
+    if (len < 0) {
+        pos += len;
+        len = -len;
+    }
+    // both are small integers, so their sum cannot overflow
+    if (UNLIKELY((pos < 0) || ((uint64_t) (pos + len) > subject_size))) {
+        return 0;
+    }
+
+    *part_start = pos;
+    *part_len = len;
+
+    return 1;
+}
+
+static int binary_parse_search_options(Context *ctx, term options, size_t subject_size, struct BinarySearchOptions *opts)
+{
+    opts->scope_start = 0;
+    opts->scope_end = subject_size;
+    opts->insert_replaced = term_nil();
+    opts->global = 0;
+    opts->trim = 0;
+    opts->trim_all = 0;
+
+    term global_a = context_make_atom(ctx, global_atom);
+    term trim_a = context_make_atom(ctx, trim_atom);
+    term trim_all_a = context_make_atom(ctx, trim_all_atom);
+    term scope_a = context_make_atom(ctx, scope_atom);
+    term insert_replaced_a = context_make_atom(ctx, insert_replaced_atom);
+
+    while (term_is_nonempty_list(options)) {
+        term option = term_get_list_head(options);
+
+        if (option == global_a) {
+            opts->global = 1;
+
+        } else if (option == trim_a) {
+            opts->trim = 1;
+
+        } else if (option == trim_all_a) {
+            opts->trim_all = 1;
+
+        } else if (term_is_tuple(option) && (term_get_tuple_arity(option) == 2)) {
+            term key = term_get_tuple_element(option, 0);
+            term value = term_get_tuple_element(option, 1);
+
+            if ((key == scope_a) && term_is_tuple(value) && (term_get_tuple_arity(value) == 2)) {
+                size_t scope_len;
+                if (UNLIKELY(!binary_get_part(term_get_tuple_element(value, 0), term_get_tuple_element(value, 1),
+                        subject_size, &opts->scope_start, &scope_len))) {
+                    return 0;
+                }
+                opts->scope_end = opts->scope_start + scope_len;
+
+            } else if (key == insert_replaced_a) {
+                opts->insert_replaced = value;
+
+            } else {
+                return 0;
+            }
+
+        } else {
+            return 0;
+        }
+
+        options = term_get_list_tail(options);
+    }
+
+    return term_is_nil(options);
+}
+
+static void *binary_compile_pattern(term pattern, size_t *compiled_size)
+{
+    int needles_count;
+    if (term_is_binary(pattern)) {
+        needles_count = 1;
+    } else if (term_is_nonempty_list(pattern)) {
+        needles_count = term_list_length(pattern);
+    } else {
+        return NULL;
+    }
+
+    struct BytePatternNeedle *needles = malloc(needles_count * sizeof(struct BytePatternNeedle));
+    if (IS_NULL_PTR(needles)) {
+        return NULL;
+    }
+
+    term t = pattern;
+    for (int i = 0; i < needles_count; i++) {
+        term needle = t;
+        if (term_is_nonempty_list(t)) {
+            needle = term_get_list_head(t);
+            t = term_get_list_tail(t);
+        }
+        if (UNLIKELY(!term_is_binary(needle) || (term_binary_size(needle) == 0))) {
+            free(needles);
+            return NULL;
+        }
+        needles[i].data = (const uint8_t *) term_binary_data(needle);
+        needles[i].len = term_binary_size(needle);
+    }
+
+    void *compiled = bytepattern_compile(needles, needles_count, compiled_size);
+    free(needles);
+
+    return compiled;
+}
+
+// Returns either a pattern compiled with binary:compile_pattern/1 or compiles it on the fly, in that case
+// to_free is set and it must be freed by the caller.
+static const void *binary_get_compiled_pattern(Context *ctx, term pattern, void **to_free)
+{
+    *to_free = NULL;
+
+    if (term_is_tuple(pattern)) {
+        if (UNLIKELY((term_get_tuple_arity(pattern) != 2) || !term_is_reference(term_get_tuple_element(pattern, 1)))) {
+            return NULL;
+        }
+
+        return bytepattern_lookup(ctx, term_to_ref_ticks(term_get_tuple_element(pattern, 1)));
+    }
+
+    size_t compiled_size;
+    *to_free = binary_compile_pattern(pattern, &compiled_size);
+
+    return *to_free;
+}
+
+// Finds non overlapping matches in [start, end), matches are stored as position and length pairs.
+// Only the first match is searched unless global is set.
+static int binary_find_matches(const void *compiled, const uint8_t *data, size_t start, size_t end, int global,
+    size_t **matches, size_t *matches_count)
+{
+    size_t capacity = 0;
+    size_t count = 0;
+    size_t *found = NULL;
+
+    size_t pos = start;
+    while (pos < end) {
+        size_t match_pos;
+        size_t match_len;
+        if (!bytepattern_find(compiled, data + pos, end - pos, &match_pos, &match_len)) {
+            break;
+        }
+
+        if (count == capacity) {
+            size_t new_capacity = capacity ? capacity * 2 : 4;
+            size_t *new_found = malloc(new_capacity * 2 * sizeof(size_t));
+            if (IS_NULL_PTR(new_found)) {
+                free(found);
+                return 0;
+            }
+            if (found) {
+                memcpy(new_found, found, count * 2 * sizeof(size_t));
+                free(found);
+            }
+            found = new_found;
+            capacity = new_capacity;
+        }
+        found[count * 2] = pos + match_pos;
+        found[count * 2 + 1] = match_len;
+        count++;
+
+        pos += match_pos + match_len;
+        if (!global) {
+            break;
+        }
+    }
+
+    *matches = found;
+    *matches_count = count;
+
+    return 1;
+}
+
+static term binary_search(Context *ctx, int argc, term argv[], int all_matches)
+{
+    VALIDATE_VALUE(argv[0], term_is_binary);
+
+    struct BinarySearchOptions opts;
+    if (UNLIKELY(!binary_parse_search_options(ctx, (argc == 3) ? argv[2] : term_nil(), term_binary_size(argv[0]), &opts))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    void *to_free;
+    const void *compiled = binary_get_compiled_pattern(ctx, argv[1], &to_free);
+    if (UNLIKELY(!compiled)) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    size_t *matches;
+    size_t matches_count;
+    int ok = binary_find_matches(compiled, (const uint8_t *) term_binary_data(argv[0]), opts.scope_start, opts.scope_end,
+        all_matches, &matches, &matches_count);
+    free(to_free);
+    if (UNLIKELY(!ok)) {
+        RAISE_ERROR(out_of_memory_atom);
+    }
+
+    term result;
+    if (!all_matches) {
+        if (matches_count == 0) {
+            result = context_make_atom(ctx, nomatch_atom);
+        } else {
+            memory_ensure_free(ctx, 3);
+            result = term_alloc_tuple(2, ctx);
+            term_put_tuple_element(result, 0, term_from_int32(matches[0]));
+            term_put_tuple_element(result, 1, term_from_int32(matches[1]));
+        }
+
+    } else {
+        memory_ensure_free(ctx, matches_count * (3 + 2));
+        result = term_nil();
+        for (int i = matches_count - 1; i >= 0; i--) {
+            term match = term_alloc_tuple(2, ctx);
+            term_put_tuple_element(match, 0, term_from_int32(matches[i * 2]));
+            term_put_tuple_element(match, 1, term_from_int32(matches[i * 2 + 1]));
+            result = term_list_prepend(match, result, ctx);
+        }
+    }
+
+    free(matches);
+
+    return result;
+}
+
+static term nif_binary_match(Context *ctx, int argc, term argv[])
+{
+    return binary_search(ctx, argc, argv, 0);
 }
 
-static void process_console_mailbox(Context *ctx)
+static term nif_binary_matches(Context *ctx, int argc, term argv[])
 {
-    Message *message = mailbox_dequeue(ctx);
-    term msg = message->message;
+    return binary_search(ctx, argc, argv, 1);
+}
 
-    if (port_is_standard_port_command(msg)) {
-        CContext ccontext;
-        CContext *cc = &ccontext;
-        ccontext_init(cc, ctx);
+static term nif_binary_split(Context *ctx, int argc, term argv[])
+{
+    VALIDATE_VALUE(argv[0], term_is_binary);
 
-        term_ref pid = ccontext_make_term_ref(cc, term_get_tuple_element(msg, 0));
-        term_ref ref = ccontext_make_term_ref(cc, term_get_tuple_element(msg, 1));
-        term cmd = term_get_tuple_element(msg, 2);
+    size_t subject_size = term_binary_size(argv[0]);
 
-        if (term_is_atom(cmd) && cmd == context_make_atom(ctx, flush_a)) {
-            fflush(stdout);
-            port_send_reply(cc, pid, ref, port_make_ok_atom(cc));
-        } else if (term_is_tuple(cmd) && term_get_tuple_arity(cmd) == 2) {
-            term cmd_name = term_get_tuple_element(cmd, 0);
-            if (cmd_name == context_make_atom(ctx, puts_a)) {
-                char *str = interop_term_to_string(term_get_tuple_element(cmd, 1));
-                if (IS_NULL_PTR(str)) {
-                    term_ref error = port_create_error_tuple(cc, "Unable to convert term to string");
-                    port_send_reply(cc, pid, ref, error);
-                } else {
-                    printf("%s", str);
-                    port_send_reply(cc, pid, ref, port_make_ok_atom(cc));
-                }
-                free(str);
-            } else {
-                term_ref error = port_create_error_tuple(cc, "Expected puts command");
-                port_send_reply(cc, pid, ref, error);
-            }
-        } else {
-            port_send_reply(cc, pid, ref, port_create_error_tuple(cc, "unrecognized command"));
+    struct BinarySearchOptions opts;
+    if (UNLIKELY(!binary_parse_search_options(ctx, (argc == 3) ? argv[2] : term_nil(), subject_size, &opts))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    void *to_free;
+    const void *compiled = binary_get_compiled_pattern(ctx, argv[1], &to_free);
+    if (UNLIKELY(!compiled)) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    size_t *matches;
+    size_t matches_count;
+    int ok = binary_find_matches(compiled, (const uint8_t *) term_binary_data(argv[0]), opts.scope_start, opts.scope_end,
+        opts.global, &matches, &matches_count);
+    free(to_free);
+    if (UNLIKELY(!ok)) {
+        RAISE_ERROR(out_of_memory_atom);
+    }
+
+    // parts are between matches, the last part starts after the last match
+    size_t parts_count = matches_count + 1;
+    size_t last_kept_part = parts_count;
+    int required_memory = 0;
+    for (size_t i = 0; i < parts_count; i++) {
+        size_t part_start = (i == 0) ? 0 : matches[(i - 1) * 2] + matches[(i - 1) * 2 + 1];
+        size_t part_end = (i == matches_count) ? subject_size : matches[i * 2];
+        if (part_end > part_start) {
+            last_kept_part = i;
         }
+        required_memory += term_sub_binary_heap_size(part_end - part_start) + 2;
+    }
 
-        ccontext_release_all_refs(cc);
+    memory_ensure_free(ctx, required_memory);
+
+    // GC might have changed all pointers
+    term subject = argv[0];
+    term result = term_nil();
+    for (int i = parts_count - 1; i >= 0; i--) {
+        size_t part_start = (i == 0) ? 0 : matches[(i - 1) * 2] + matches[(i - 1) * 2 + 1];
+        size_t part_end = ((size_t) i == matches_count) ? subject_size : matches[i * 2];
+        size_t part_len = part_end - part_start;
+
+        if ((part_len == 0) && (opts.trim_all || (opts.trim && ((size_t) i > last_kept_part || last_kept_part == parts_count)))) {
+            continue;
+        }
+
+        term part = term_maybe_create_sub_binary(subject, part_start, part_len, ctx);
+        result = term_list_prepend(part, result, ctx);
+    }
+
+    free(matches);
+
+    return result;
+}
+
+static int binary_parse_insert_replaced(term insert_replaced, size_t replacement_size, size_t **positions, size_t *positions_count)
+{
+    *positions = NULL;
+    *positions_count = 0;
+
+    if (term_is_nil(insert_replaced)) {
+        return 1;
+    }
+
+    size_t count = term_is_integer(insert_replaced) ? 1 : term_list_length(insert_replaced);
+    size_t *found = malloc(count * sizeof(size_t));
+    if (IS_NULL_PTR(found)) {
+        return 0;
+    }
+
+    term t = insert_replaced;
+    for (size_t i = 0; i < count; i++) {
+        term pos_term = t;
+        if (term_is_nonempty_list(t)) {
+            pos_term = term_get_list_head(t);
+            t = term_get_list_tail(t);
+        }
+        if (UNLIKELY(!term_is_integer(pos_term) || (term_to_int64(pos_term) < 0)
+                || ((uint64_t) term_to_int64(pos_term) > replacement_size))) {
+            free(found);
+            return 0;
+        }
+
+        // keep positions sorted, lists are expected to be short
+        size_t pos = term_to_int64(pos_term);
+        size_t j = i;
+        while ((j > 0) && (found[j - 1] > pos)) {
+            found[j] = found[j - 1];
+            j--;
+        }
+        found[j] = pos;
+    }
+
+    *positions = found;
+    *positions_count = count;
+
+    return 1;
+}
+
+static term nif_binary_replace(Context *ctx, int argc, term argv[])
+{
+    VALIDATE_VALUE(argv[0], term_is_binary);
+    VALIDATE_VALUE(argv[2], term_is_binary);
+
+    size_t subject_size = term_binary_size(argv[0]);
+    size_t replacement_size = term_binary_size(argv[2]);
+
+    struct BinarySearchOptions opts;
+    if (UNLIKELY(!binary_parse_search_options(ctx, (argc == 4) ? argv[3] : term_nil(), subject_size, &opts))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    size_t *insert_positions;
+    size_t insert_positions_count;
+    if (UNLIKELY(!binary_parse_insert_replaced(opts.insert_replaced, replacement_size, &insert_positions, &insert_positions_count))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    void *to_free;
+    const void *compiled = binary_get_compiled_pattern(ctx, argv[1], &to_free);
+    if (UNLIKELY(!compiled)) {
+        free(insert_positions);
+        RAISE_ERROR(badarg_atom);
+    }
+
+    size_t *matches;
+    size_t matches_count;
+    int ok = binary_find_matches(compiled, (const uint8_t *) term_binary_data(argv[0]), opts.scope_start, opts.scope_end,
+        opts.global, &matches, &matches_count);
+    free(to_free);
+    if (UNLIKELY(!ok)) {
+        free(insert_positions);
+        RAISE_ERROR(out_of_memory_atom);
+    }
+
+    size_t result_size = subject_size;
+    for (size_t i = 0; i < matches_count; i++) {
+        result_size += replacement_size + (insert_positions_count - 1) * matches[i * 2 + 1];
+    }
+
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(result_size) + 2);
+    term result = term_create_uninitialized_binary(result_size, ctx);
+
+    // GC might have changed all pointers
+    const uint8_t *subject = (const uint8_t *) term_binary_data(argv[0]);
+    const uint8_t *replacement = (const uint8_t *) term_binary_data(argv[2]);
+    uint8_t *out = (uint8_t *) term_binary_data(result);
+
+    size_t subject_pos = 0;
+    for (size_t i = 0; i < matches_count; i++) {
+        size_t match_pos = matches[i * 2];
+        size_t match_len = matches[i * 2 + 1];
+
+        memcpy(out, subject + subject_pos, match_pos - subject_pos);
+        out += match_pos - subject_pos;
+
+        size_t replacement_pos = 0;
+        for (size_t j = 0; j < insert_positions_count; j++) {
+            memcpy(out, replacement + replacement_pos, insert_positions[j] - replacement_pos);
+            out += insert_positions[j] - replacement_pos;
+            memcpy(out, subject + match_pos, match_len);
+            out += match_len;
+            replacement_pos = insert_positions[j];
+        }
+        memcpy(out, replacement + replacement_pos, replacement_size - replacement_pos);
+        out += replacement_size - replacement_pos;
+
+        subject_pos = match_pos + match_len;
+    }
+    memcpy(out, subject + subject_pos, subject_size - subject_pos);
+
+    free(matches);
+    free(insert_positions);
+
+    return result;
+}
+
+static term nif_binary_part(Context *ctx, int argc, term argv[])
+{
+    VALIDATE_VALUE(argv[0], term_is_binary);
+
+    term pos_term;
+    term len_term;
+    if (argc == 2) {
+        if (UNLIKELY(!term_is_tuple(argv[1]) || (term_get_tuple_arity(argv[1]) != 2))) {
+            RAISE_ERROR(badarg_atom);
+        }
+        pos_term = term_get_tuple_element(argv[1], 0);
+        len_term = term_get_tuple_element(argv[1], 1);
     } else {
-        fprintf(stderr, "WARNING: Invalid port command.  Unable to send reply");
+        pos_term = argv[1];
+        len_term = argv[2];
+    }
+
+    size_t part_start;
+    size_t part_len;
+    if (UNLIKELY(!binary_get_part(pos_term, len_term, term_binary_size(argv[0]), &part_start, &part_len))) {
+        RAISE_ERROR(badarg_atom);
     }
 
-    free(message);
+    memory_ensure_free(ctx, term_sub_binary_heap_size(part_len));
+
+    // GC might have changed all pointers
+    return term_maybe_create_sub_binary(argv[0], part_start, part_len, ctx);
 }
 
-static term nif_erlang_spawn_3(Context *ctx, int argc, term argv[])
+static term nif_binary_copy(Context *ctx, int argc, term argv[])
+{
+    VALIDATE_VALUE(argv[0], term_is_binary);
+
+    int64_t count = 1;
+    size_t size = term_binary_size(argv[0]);
+    if (argc == 2) {
+        VALIDATE_VALUE(argv[1], term_is_integer);
+        count = term_to_int64(argv[1]);
+        if (UNLIKELY((count < 0) || (size && ((uint64_t) count > SIZE_MAX / size)))) {
+            RAISE_ERROR(badarg_atom);
+        }
+    }
+
+    size_t result_size = size * count;
+
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(result_size) + 2);
+    term result = term_create_uninitialized_binary(result_size, ctx);
+
+    // GC might have changed all pointers
+    const char *data = term_binary_data(argv[0]);
+    char *out = (char *) term_binary_data(result);
+    for (int64_t i = 0; i < count; i++) {
+        memcpy(out + i * size, data, size);
+    }
+
+    return result;
+}
+
+static term nif_binary_at(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    term module_term = argv[0];
-    term function_term = argv[1];
-    term args_term = argv[2];
-    VALIDATE_VALUE(module_term, term_is_atom);
-    VALIDATE_VALUE(function_term, term_is_atom);
-    VALIDATE_VALUE(args_term, term_is_list);
+    VALIDATE_VALUE(argv[0], term_is_binary);
+    VALIDATE_VALUE(argv[1], term_is_integer);
 
-    Context *new_ctx = context_new(ctx->global);
+    int64_t pos = term_to_int64(argv[1]);
+    if (UNLIKELY((pos < 0) || ((uint64_t) pos >= term_binary_size(argv[0])))) {
+        RAISE_ERROR(badarg_atom);
+    }
 
-    AtomString module_string = globalcontext_atomstring_from_term(ctx->global, argv[0]);
-    AtomString function_string = globalcontext_atomstring_from_term(ctx->global, argv[1]);
+    return term_from_int11((uint8_t) term_binary_data(argv[0])[pos]);
+}
 
-    Module *found_module = globalcontext_get_module(ctx->global, module_string);
-    if (UNLIKELY(!found_module)) {
-        int undefined_index = globalcontext_insert_atom(ctx->global, undefined_atom);
-        if (undefined_index < 0) {
-            abort();
-        }
-        return term_from_atom_index(undefined_index);
+static term nif_binary_compile_pattern(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    size_t compiled_size;
+    void *compiled = binary_compile_pattern(argv[0], &compiled_size);
+    if (UNLIKELY(!compiled)) {
+        RAISE_ERROR(badarg_atom);
     }
+    int is_multiple = term_is_nonempty_list(argv[0]) && !term_is_nil(term_get_list_tail(argv[0]));
 
-    int label = module_search_exported_function(found_module, function_string, term_list_length(argv[2]));
-    //TODO: fail here if no function has been found
-    new_ctx->saved_module = found_module;
-    new_ctx->saved_ip = found_module->labels[label];
-    new_ctx->cp = module_address(found_module->module_index, found_module->end_instruction_ii);
+    uint64_t ref_ticks = globalcontext_get_ref_ticks(ctx->global);
+    if (UNLIKELY(!bytepattern_store(ctx, ref_ticks, compiled))) {
+        free(compiled);
+        RAISE_ERROR(out_of_memory_atom);
+    }
 
-    //TODO: check available registers count
-    int reg_index = 0;
-    term t = argv[2];
-    memory_ensure_free(new_ctx, memory_estimate_usage(t));
-    while (!term_is_nil(t)) {
-        term *t_ptr = term_get_list_ptr(t);
-        new_ctx->x[reg_index] = memory_copy_term_tree(&new_ctx->heap_ptr, t_ptr[1]);
-        t = *t_ptr;
-        reg_index++;
+    memory_ensure_free(ctx, 3 + TERM_BOXED_REF_SIZE);
+    term result = term_alloc_tuple(2, ctx);
+    term_put_tuple_element(result, 0, context_make_atom(ctx, is_multiple ? ac_atom : bm_atom));
+    term_put_tuple_element(result, 1, term_from_ref_ticks(ref_ticks, ctx));
+
+    return result;
+}
+
+static void crc32_iolist_chunk(const uint8_t *data, unsigned long len, void *accum)
+{
+    uint32_t *crc = (uint32_t *) accum;
+    *crc = checksum_crc32(*crc, data, len);
+}
+
+static void adler32_iolist_chunk(const uint8_t *data, unsigned long len, void *accum)
+{
+    uint32_t *adler = (uint32_t *) accum;
+    *adler = checksum_adler32(*adler, data, len);
+}
+
+static void digest_iolist_chunk(const uint8_t *data, unsigned long len, void *accum)
+{
+    digest_update((struct DigestContext *) accum, data, len);
+}
+
+// erlang:crc32/2 and erlang:adler32/2 take the checksum of previous data as first argument
+static int checksum_get_args(int argc, term argv[], uint32_t init, uint32_t *checksum, term *data)
+{
+    if (argc == 1) {
+        *checksum = init;
+        *data = argv[0];
+        return 1;
     }
 
-    return term_from_local_process_id(new_ctx->process_id);
+    if (UNLIKELY(!term_is_integer(argv[0]))) {
+        return 0;
+    }
+    int64_t previous = term_to_int64(argv[0]);
+    if (UNLIKELY((previous < 0) || (previous > 0xFFFFFFFF))) {
+        return 0;
+    }
+    *checksum = previous;
+    *data = argv[1];
+
+    return 1;
 }
-static term nif_erlang_send_2(Context *ctx, int argc, term argv[])
+
+static term make_uint32(Context *ctx, uint32_t value)
+{
+#if TERM_BITS == 32
+    if (UNLIKELY(value > TERM_MAX_SMALL_INT)) {
+        // overflow error is not standard, but we need it since big integers are not supported yet
+        RAISE_ERROR(overflow_atom);
+    }
+#else
+    UNUSED(ctx);
+#endif
+
+    return term_from_int64(value);
+}
+
+static term nif_erlang_crc32(Context *ctx, int argc, term argv[])
+{
+    uint32_t crc;
+    term data;
+
+    if (UNLIKELY(!checksum_get_args(argc, argv, CHECKSUM_CRC32_INIT, &crc, &data)
+            || !interop_iolist_foreach_chunk(data, crc32_iolist_chunk, &crc))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    return make_uint32(ctx, crc);
+}
+
+static term nif_erlang_adler32(Context *ctx, int argc, term argv[])
+{
+    uint32_t adler;
+    term data;
+
+    if (UNLIKELY(!checksum_get_args(argc, argv, CHECKSUM_ADLER32_INIT, &adler, &data)
+            || !interop_iolist_foreach_chunk(data, adler32_iolist_chunk, &adler))) {
+        RAISE_ERROR(badarg_atom);
+    }
+
+    return make_uint32(ctx, adler);
+}
+
+static enum DigestType digest_type_from_atom(Context *ctx, term type)
+{
+    if (type == context_make_atom(ctx, md5_atom)) {
+        return DigestMD5;
+    } else if (type == context_make_atom(ctx, sha_atom)) {
+        return DigestSHA1;
+    } else if (type == context_make_atom(ctx, sha256_atom)) {
+        return DigestSHA256;
+    } else {
+        return 0;
+    }
+}
+
+// hash states are binaries that contain a copy of a DigestContext, so they can be updated many times
+static int digest_get_state(term state, struct DigestContext *digest_ctx)
+{
+    if (UNLIKELY(!term_is_binary(state) || (term_binary_size(state) != sizeof(struct DigestContext)))) {
+        return 0;
+    }
+    memcpy(digest_ctx, term_binary_data(state), sizeof(struct DigestContext));
+
+    return digest_is_valid(digest_ctx);
+}
+
+static term nif_crypto_hash_2(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    term pid_term = argv[0];
-    VALIDATE_VALUE(pid_term, term_is_pid);
+    enum DigestType type = digest_type_from_atom(ctx, argv[0]);
+    if (UNLIKELY(!type)) {
+        RAISE_ERROR(badarg_atom);
+    }
 
-    int local_process_id = term_to_local_process_id(pid_term);
-    Context *target = globalcontext_get_process(ctx->global, local_process_id);
+    struct DigestContext digest_ctx;
+    digest_init(&digest_ctx, type);
+    if (UNLIKELY(!interop_iolist_foreach_chunk(argv[1], digest_iolist_chunk, &digest_ctx))) {
+        RAISE_ERROR(badarg_atom);
+    }
 
-    mailbox_send(target, argv[1]);
+    uint8_t digest[DIGEST_MAX_SIZE];
+    digest_final(&digest_ctx, digest);
 
-    return argv[1];
+    size_t size = digest_size(type);
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(size) + 2);
+    return term_from_literal_binary(digest, size, ctx);
 }
 
-static term nif_erlang_is_process_alive_1(Context *ctx, int argc, term argv[])
+static term nif_crypto_hash_init_1(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    int local_process_id = term_to_local_process_id(argv[0]);
-    Context *target = globalcontext_get_process(ctx->global, local_process_id);
-    if (target) {
-        int true_i = globalcontext_insert_atom(ctx->global, true_atom);
-        return term_from_atom_index(true_i);
-    } else {
-        int false_i = globalcontext_insert_atom(ctx->global, false_atom);
-        return term_from_atom_index(false_i);
+    enum DigestType type = digest_type_from_atom(ctx, argv[0]);
+    if (UNLIKELY(!type)) {
+        RAISE_ERROR(badarg_atom);
     }
+
+    struct DigestContext digest_ctx;
+    digest_init(&digest_ctx, type);
+
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(sizeof(struct DigestContext)) + 2);
+    return term_from_literal_binary(&digest_ctx, sizeof(struct DigestContext), ctx);
 }
 
-static term nif_erlang_concat_2(Context *ctx, int argc, term argv[])
+static term nif_crypto_hash_update_2(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    term prepend_list = argv[0];
+    struct DigestContext digest_ctx;
+    if (UNLIKELY(!digest_get_state(argv[0], &digest_ctx)
+            || !interop_iolist_foreach_chunk(argv[1], digest_iolist_chunk, &digest_ctx))) {
+        RAISE_ERROR(badarg_atom);
+    }
 
-    if (UNLIKELY(!term_is_nonempty_list(prepend_list))) {
-        if (term_is_nil(prepend_list)) {
-            return argv[1];
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(sizeof(struct DigestContext)) + 2);
+    return term_from_literal_binary(&digest_ctx, sizeof(struct DigestContext), ctx);
+}
 
-        } else {
-            RAISE_ERROR(badarg_atom);
-        }
+static term nif_crypto_hash_final_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    struct DigestContext digest_ctx;
+    if (UNLIKELY(!digest_get_state(argv[0], &digest_ctx))) {
+        RAISE_ERROR(badarg_atom);
     }
 
-    int len = term_list_length(prepend_list);
-    memory_ensure_free(ctx, len * 2);
+    size_t size = digest_size(digest_ctx.type);
+    uint8_t digest[DIGEST_MAX_SIZE];
+    digest_final(&digest_ctx, digest);
 
-    // GC might have changed all pointers
-    prepend_list = argv[0];
-    term append_list = argv[1];
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(size) + 2);
+    return term_from_literal_binary(digest, size, ctx);
+}
 
-    term t = prepend_list;
-    term list_begin = term_nil();
-    term *prev_term = NULL;
+// Timers are kept on the global timers queue, the message is copied when the timer is started and it is
+// delivered by the scheduler when the timer expires.
+static term start_timer(Context *ctx, term argv[], int wrap_message)
+{
+    if (UNLIKELY(!term_is_integer(argv[0]) || !(term_is_pid(argv[1]) || term_is_atom(argv[1])))) {
+        RAISE_ERROR(badarg_atom);
+    }
+    int64_t timeout = term_to_int64(argv[0]);
+    if (UNLIKELY((timeout < 0) || (timeout > INT32_MAX))) {
+        RAISE_ERROR(badarg_atom);
+    }
 
-    // TODO: handle impropers list
-    while (!term_is_nil(t)) {
-        term head = term_get_list_head(t);
+    memory_ensure_free(ctx, TERM_BOXED_REF_SIZE + 4);
 
-        term *new_list_item = term_list_alloc(ctx);
+    uint64_t ref_ticks = globalcontext_get_ref_ticks(ctx->global);
+    term ref = term_from_ref_ticks(ref_ticks, ctx);
+
+    term message = argv[2];
+    if (wrap_message) {
+        message = term_alloc_tuple(3, ctx);
+        term_put_tuple_element(message, 0, context_make_atom(ctx, timeout_atom));
+        term_put_tuple_element(message, 1, ref);
+        term_put_tuple_element(message, 2, argv[2]);
+    }
 
-        if (prev_term) {
-            prev_term[0] = term_list_from_list_ptr(new_list_item);
-        } else {
-            list_begin = term_list_from_list_ptr(new_list_item);
-        }
+    struct Timer *timer = malloc(sizeof(struct Timer));
+    if (IS_NULL_PTR(timer)) {
+        RAISE_ERROR(out_of_memory_atom);
+    }
+    timer->data = mailbox_message_create(message);
+    if (IS_NULL_PTR(timer->data)) {
+        free(timer);
+        RAISE_ERROR(out_of_memory_atom);
+    }
+    sys_set_timestamp_from_relative_to_abs(&timer->expiral_timestamp, timeout);
+    timer->ref_ticks = ref_ticks;
+    timer->dest = argv[1];
+
+    if (UNLIKELY(!timerqueue_insert(&ctx->global->timers, timer))) {
+        mailbox_message_destroy(timer->data);
+        free(timer);
+        RAISE_ERROR(out_of_memory_atom);
+    }
 
-        prev_term = new_list_item;
-        new_list_item[1] = head;
+    return ref;
+}
 
-        t = term_get_list_tail(t);
+// returns remaining milliseconds or false when the timer has already expired or it has been cancelled
+static term timer_remaining_time(Context *ctx, term timer_ref, int cancel)
+{
+    if (UNLIKELY(!term_is_reference(timer_ref))) {
+        RAISE_ERROR(badarg_atom);
     }
 
-    if (prev_term) {
-        prev_term[0] = append_list;
+    struct TimerQueue *timers = &ctx->global->timers;
+    struct Timer *timer = timerqueue_find(timers, term_to_ref_ticks(timer_ref));
+    if (!timer) {
+        return context_make_atom(ctx, false_atom);
     }
 
-    return list_begin;
+    struct timespec now;
+    sys_set_timestamp_from_relative_to_abs(&now, 0);
+    int64_t remaining = (int64_t) (timer->expiral_timestamp.tv_sec - now.tv_sec) * 1000
+        + (timer->expiral_timestamp.tv_nsec - now.tv_nsec) / 1000000;
+    if (remaining < 0) {
+        remaining = 0;
+    }
+
+    if (cancel) {
+        timerqueue_remove(timers, timer);
+        mailbox_message_destroy(timer->data);
+        free(timer);
+    }
+
+    return term_from_int64(remaining);
 }
 
-term nif_erlang_make_ref_0(Context *ctx, int argc, term argv[])
+static term nif_erlang_send_after_3(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
-    UNUSED(argv);
 
-    uint64_t ref_ticks = globalcontext_get_ref_ticks(ctx->global);
+    return start_timer(ctx, argv, 0);
+}
 
-    return term_from_ref_ticks(ref_ticks, ctx);
+static term nif_erlang_start_timer(Context *ctx, int argc, term argv[])
+{
+    // erlang:start_timer/4 options are ignored, only relative timeouts are supported
+    UNUSED(argc);
+
+    return start_timer(ctx, argv, 1);
 }
 
-term nif_erlang_system_time_1(Context *ctx, int argc, term argv[])
+static term nif_erlang_cancel_timer_1(Context *ctx, int argc, term argv[])
 {
-    UNUSED(ctx);
     UNUSED(argc);
 
-    struct timespec ts;
-    sys_time(&ts);
+    return timer_remaining_time(ctx, argv[0], 1);
+}
 
-    term minute_atom = context_make_atom(ctx, "\x6" "minute");
-    if (argv[0] == minute_atom) {
-        // FIXME: This is not standard, however we cannot hold seconds since 1970 in just 27 bits.
-        return term_from_int32(ts.tv_sec / 60);
+static term nif_erlang_read_timer_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    return timer_remaining_time(ctx, argv[0], 0);
+}
 
+static uint32_t logger_level_bit(Context *ctx, term level)
+{
+    if (level == context_make_atom(ctx, debug_atom)) {
+        return LOGGER_LEVEL_DEBUG;
+    } else if (level == context_make_atom(ctx, info_atom)) {
+        return LOGGER_LEVEL_INFO;
+    } else if (level == context_make_atom(ctx, warning_atom)) {
+        return LOGGER_LEVEL_WARNING;
+    } else if (level == context_make_atom(ctx, error_atom)) {
+        return LOGGER_LEVEL_ERROR;
     } else {
-        RAISE_ERROR(badarg_atom);
+        return 0;
     }
 }
 
-term nif_erlang_universaltime_0(Context *ctx, int argc, term argv[])
+static term nif_logger_allow_2(Context *ctx, int argc, term argv[])
 {
-    UNUSED(ctx);
     UNUSED(argc);
-    UNUSED(argv);
 
-    // 4 = size of date/time tuple, 3 size of date time tuple
-    memory_ensure_free(ctx, 3 + 4 + 4);
-    term date_tuple = term_alloc_tuple(3, ctx);
-    term time_tuple = term_alloc_tuple(3, ctx);
-    term date_time_tuple = term_alloc_tuple(2, ctx);
+    GlobalContext *glb = ctx->global;
 
-    struct timespec ts;
-    sys_time(&ts);
+    if (!(glb->logger_levels & logger_level_bit(ctx, argv[0]))) {
+        return context_make_atom(ctx, false_atom);
+    }
 
-    struct tm broken_down_time;
-    gmtime_r(&ts.tv_sec, &broken_down_time);
+    if (glb->logger_filter_len) {
+        for (int i = 0; i < glb->logger_filter_len; i++) {
+            if (glb->logger_filter[i] == argv[1]) {
+                return context_make_atom(ctx, true_atom);
+            }
+        }
+        return context_make_atom(ctx, false_atom);
+    }
 
-    term_put_tuple_element(date_tuple, 0, term_from_int32(1900 + broken_down_time.tm_year));
-    term_put_tuple_element(date_tuple, 1, term_from_int32(broken_down_time.tm_mon + 1));
-    term_put_tuple_element(date_tuple, 2, term_from_int32(broken_down_time.tm_mday));
+    return context_make_atom(ctx, true_atom);
+}
 
-    term_put_tuple_element(time_tuple, 0, term_from_int32(broken_down_time.tm_hour));
-    term_put_tuple_element(time_tuple, 1, term_from_int32(broken_down_time.tm_min));
-    term_put_tuple_element(time_tuple, 2, term_from_int32(broken_down_time.tm_sec));
+static term nif_logger_set_allowed_levels_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
 
-    term_put_tuple_element(date_time_tuple, 0, date_tuple);
-    term_put_tuple_element(date_time_tuple, 1, time_tuple);
+    uint32_t levels = 0;
 
-    return date_time_tuple;
+    term t = argv[0];
+    while (term_is_nonempty_list(t)) {
+        term level = term_get_list_head(t);
+        VALIDATE_VALUE(level, term_is_atom);
+        levels |= logger_level_bit(ctx, level);
+        t = term_get_list_tail(t);
+    }
+    VALIDATE_VALUE(t, term_is_nil);
+
+    ctx->global->logger_levels = levels;
+
+    return context_make_atom(ctx, ok_atom);
 }
 
-term nif_erlang_timestamp_0(Context *ctx, int argc, term argv[])
+static term nif_logger_set_allowed_modules_1(Context *ctx, int argc, term argv[])
 {
-    UNUSED(ctx);
     UNUSED(argc);
-    UNUSED(argv);
 
-    memory_ensure_free(ctx, 4);
-    term timestamp_tuple = term_alloc_tuple(3, ctx);
+    int len = 0;
+    term t = argv[0];
+    while (term_is_nonempty_list(t)) {
+        VALIDATE_VALUE(term_get_list_head(t), term_is_atom);
+        len++;
+        t = term_get_list_tail(t);
+    }
+    VALIDATE_VALUE(t, term_is_nil);
 
-    struct timespec ts;
-    sys_time(&ts);
+    term *filter = NULL;
+    if (len) {
+        filter = malloc(len * sizeof(term));
+        if (IS_NULL_PTR(filter)) {
+            RAISE_ERROR(out_of_memory_atom);
+        }
+    }
 
-    term_put_tuple_element(timestamp_tuple, 0, term_from_int32(ts.tv_sec / 1000000));
-    term_put_tuple_element(timestamp_tuple, 1, term_from_int32(ts.tv_sec % 1000000));
-    term_put_tuple_element(timestamp_tuple, 2, term_from_int32(ts.tv_nsec / 1000));
+    t = argv[0];
+    for (int i = 0; i < len; i++) {
+        filter[i] = term_get_list_head(t);
+        t = term_get_list_tail(t);
+    }
 
-    return timestamp_tuple;
+    GlobalContext *glb = ctx->global;
+    free(glb->logger_filter);
+    glb->logger_filter = filter;
+    glb->logger_filter_len = len;
+
+    return context_make_atom(ctx, ok_atom);
 }
 
-static term nif_erlang_make_tuple_2(Context *ctx, int argc, term argv[])
+static term nif_erlang_phash2(Context *ctx, int argc, term argv[])
 {
-    UNUSED(argc);
+    uint32_t hash = termhash_phash2(argv[0], ctx->global);
 
-    VALIDATE_VALUE(argv[0], term_is_integer);
-
-    int count_elem = term_to_int32(argv[0]);
+    if (argc == 1) {
+        return term_from_int32(hash & ((1 << 27) - 1));
+    }
 
-    if (UNLIKELY(count_elem < 0)) {
+    VALIDATE_VALUE(argv[1], term_is_integer);
+    int64_t range = term_to_int64(argv[1]);
+    if (UNLIKELY((range < 1) || (range > 0x100000000LL))) {
         RAISE_ERROR(badarg_atom);
     }
 
-    memory_ensure_free(ctx, count_elem + 1);
-    term new_tuple = term_alloc_tuple(count_elem, ctx);
+    if (range != 0x100000000LL) {
+        hash %= (uint32_t) range;
+    }
 
-    term element = argv[1];
+    return make_uint32(ctx, hash);
+}
 
-    for (int i = 0; i < count_elem; i++) {
-        term_put_tuple_element(new_tuple, i, element);
+static term dictionary_value_or_undefined(Context *ctx, term value)
+{
+    if (term_is_invalid_term(value)) {
+        return context_make_atom(ctx, undefined_atom);
     }
 
-    return new_tuple;
+    return value;
 }
 
-static term nif_erlang_insert_element_3(Context *ctx, int argc, term argv[])
+// returns a list of {Key, Value} tuples, or only keys when values is 0
+static term dictionary_to_list(Context *ctx, int values)
+{
+    struct Dictionary *dict = &ctx->dictionary;
+    memory_ensure_free(ctx, dict->count * (values ? 2 + 3 : 2));
+
+    term result = term_nil();
+    for (int i = 0; i < dict->capacity; i++) {
+        const struct DictionaryEntry *entry = &dict->entries[i];
+        if (dictionary_entry_is_used(entry)) {
+            term elem = entry->key;
+            if (values) {
+                elem = term_alloc_tuple(2, ctx);
+                term_put_tuple_element(elem, 0, entry->key);
+                term_put_tuple_element(elem, 1, entry->value);
+            }
+            result = term_list_prepend(elem, result, ctx);
+        }
+    }
+
+    return result;
+}
+
+static term nif_erlang_put_2(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    VALIDATE_VALUE(argv[0], term_is_integer);
-    VALIDATE_VALUE(argv[1], term_is_tuple);
+    term old_value;
+    if (UNLIKELY(!dictionary_put(&ctx->dictionary, argv[0], argv[1], &old_value, ctx->global))) {
+        RAISE_ERROR(out_of_memory_atom);
+    }
 
-    // indexes are 1 based
-    int insert_index = term_to_int32(argv[0]) - 1;
+    return dictionary_value_or_undefined(ctx, old_value);
+}
 
-    int old_tuple_size = term_get_tuple_arity(argv[1]);
+static term nif_erlang_get(Context *ctx, int argc, term argv[])
+{
+    if (argc == 0) {
+        return dictionary_to_list(ctx, 1);
+    }
 
-    if (UNLIKELY((insert_index > old_tuple_size) || (insert_index < 0))) {
-        RAISE_ERROR(badarg_atom);
+    return dictionary_value_or_undefined(ctx, dictionary_get(&ctx->dictionary, argv[0], ctx->global));
+}
+
+static term nif_erlang_erase(Context *ctx, int argc, term argv[])
+{
+    if (argc == 0) {
+        term result = dictionary_to_list(ctx, 1);
+        dictionary_destroy(&ctx->dictionary);
+        return result;
     }
 
-    int new_tuple_size = old_tuple_size + 1;
-    memory_ensure_free(ctx, new_tuple_size + 1);
-    term new_tuple = term_alloc_tuple(new_tuple_size, ctx);
+    return dictionary_value_or_undefined(ctx, dictionary_erase(&ctx->dictionary, argv[0], ctx->global));
+}
 
-    term old_tuple = argv[1];
-    term new_element = argv[2];
+static term nif_erlang_get_keys(Context *ctx, int argc, term argv[])
+{
+    if (argc == 0) {
+        return dictionary_to_list(ctx, 0);
+    }
 
-    int src_elements_shift = 0;
-    for (int i = 0; i < new_tuple_size; i++) {
-        if (i == insert_index) {
-            src_elements_shift = 1;
-            term_put_tuple_element(new_tuple, i, new_element);
-        } else {
-            term_put_tuple_element(new_tuple, i, term_get_tuple_element(old_tuple, i - src_elements_shift));
+    struct Dictionary *dict = &ctx->dictionary;
+    int matches = 0;
+    for (int i = 0; i < dict->capacity; i++) {
+        const struct DictionaryEntry *entry = &dict->entries[i];
+        if (dictionary_entry_is_used(entry) && termhash_equals(entry->value, argv[0])) {
+            matches++;
         }
     }
+    memory_ensure_free(ctx, matches * 2);
 
-    return new_tuple;
-}
+    term result = term_nil();
+    for (int i = 0; i < dict->capacity; i++) {
+        const struct DictionaryEntry *entry = &dict->entries[i];
+        if (dictionary_entry_is_used(entry) && termhash_equals(entry->value, argv[0])) {
+            result = term_list_prepend(entry->key, result, ctx);
+        }
+    }
 
+    return result;
+}
 
-static term nif_erlang_delete_element_2(Context *ctx, int argc, term argv[])
+// binaries are used in place, any other iodata is flattened to a malloc-ed buffer that is returned in buf
+static int base64_get_input(term t, uint8_t **buf, size_t *len)
 {
-    UNUSED(argc);
-
-    VALIDATE_VALUE(argv[0], term_is_integer);
-    VALIDATE_VALUE(argv[1], term_is_tuple);
-
-    // indexes are 1 based
-    int delete_index = term_to_int32(argv[0]) - 1;
+    *buf = NULL;
 
-    int old_tuple_size = term_get_tuple_arity(argv[1]);
+    if (term_is_binary(t)) {
+        *len = term_binary_size(t);
+        return 1;
+    }
 
-    if (UNLIKELY((delete_index > old_tuple_size) || (delete_index < 0))) {
-        RAISE_ERROR(badarg_atom);
+    int ok;
+    *len = interop_iolist_size(t, &ok);
+    if (UNLIKELY(!ok)) {
+        return 0;
     }
+    *buf = malloc(*len ? *len : 1);
+    if (IS_NULL_PTR(*buf)) {
+        return 0;
+    }
+    interop_write_iolist(t, (char *) *buf);
 
-    int new_tuple_size = old_tuple_size - 1;
-    memory_ensure_free(ctx, new_tuple_size + 1);
-    term new_tuple = term_alloc_tuple(new_tuple_size, ctx);
+    return 1;
+}
 
-    term old_tuple = argv[1];
+// GC might have changed all pointers, so binary data is fetched again after any allocation
+static inline const uint8_t *base64_input_data(term t, const uint8_t *buf)
+{
+    return buf ? buf : (const uint8_t *) term_binary_data(t);
+}
 
-    int src_elements_shift = 0;
-    for (int i = 0; i < new_tuple_size; i++) {
-        if (i == delete_index) {
-            src_elements_shift = 1;
-        }
-        term_put_tuple_element(new_tuple, i, term_get_tuple_element(old_tuple, i + src_elements_shift));
+static term nif_base64_encode_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    uint8_t *buf;
+    size_t len;
+    if (UNLIKELY(!base64_get_input(argv[0], &buf, &len))) {
+        RAISE_ERROR(badarg_atom);
     }
 
-    return new_tuple;
+    size_t encoded_size = base64_encoded_size(len);
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(encoded_size) + 2);
+    term result = term_create_uninitialized_binary(encoded_size, ctx);
+    base64_encode(base64_input_data(argv[0], buf), len, (uint8_t *) term_binary_data(result));
+    free(buf);
+
+    return result;
 }
 
-static term nif_erlang_setelement_3(Context *ctx, int argc, term argv[])
+static term nif_base64_encode_to_string_1(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    VALIDATE_VALUE(argv[0], term_is_integer);
-    VALIDATE_VALUE(argv[1], term_is_tuple);
+    uint8_t *buf;
+    size_t len;
+    if (UNLIKELY(!base64_get_input(argv[0], &buf, &len))) {
+        RAISE_ERROR(badarg_atom);
+    }
 
-    // indexes are 1 based
-    int replace_index = term_to_int32(argv[0]) - 1;
+    size_t encoded_size = base64_encoded_size(len);
+    uint8_t *encoded = malloc(encoded_size ? encoded_size : 1);
+    if (IS_NULL_PTR(encoded)) {
+        free(buf);
+        RAISE_ERROR(out_of_memory_atom);
+    }
+    base64_encode(base64_input_data(argv[0], buf), len, encoded);
+    free(buf);
 
-    int tuple_size = term_get_tuple_arity(argv[1]);
+    memory_ensure_free(ctx, encoded_size * 2);
+    term result = term_nil();
+    for (size_t i = encoded_size; i > 0; i--) {
+        result = term_list_prepend(term_from_int11(encoded[i - 1]), result, ctx);
+    }
+    free(encoded);
 
-    if (UNLIKELY((replace_index >= tuple_size) || (replace_index < 0))) {
+    return result;
+}
+
+static term base64_decode_term(Context *ctx, term argv[], int mime)
+{
+    uint8_t *buf;
+    size_t len;
+    if (UNLIKELY(!base64_get_input(argv[0], &buf, &len))) {
         RAISE_ERROR(badarg_atom);
     }
 
-    memory_ensure_free(ctx, tuple_size + 1);
-    term new_tuple = term_alloc_tuple(tuple_size, ctx);
-
-    term old_tuple = argv[1];
-    for (int i = 0; i < tuple_size; i++) {
-        term_put_tuple_element(new_tuple, i, term_get_tuple_element(old_tuple, i));
+    // well formed input is decoded without validating it first
+    if (!mime && (len % 4 == 0)) {
+        const uint8_t *src = base64_input_data(argv[0], buf);
+        size_t decoded_size = len / 4 * 3;
+        if (len && (src[len - 1] == '=')) {
+            decoded_size -= (src[len - 2] == '=') ? 2 : 1;
+        }
+        memory_ensure_free(ctx, term_binary_data_size_in_terms(decoded_size) + 2);
+        term result = term_create_uninitialized_binary(decoded_size, ctx);
+        if (base64_decode_strict(base64_input_data(argv[0], buf), len, (uint8_t *) term_binary_data(result))) {
+            free(buf);
+            return result;
+        }
     }
 
-    term value = argv[2];
-    term_put_tuple_element(new_tuple, replace_index, value);
+    long decoded_size = base64_decoded_size(base64_input_data(argv[0], buf), len, mime);
+    if (UNLIKELY(decoded_size < 0)) {
+        free(buf);
+        RAISE_ERROR(badarg_atom);
+    }
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(decoded_size) + 2);
+    term result = term_create_uninitialized_binary(decoded_size, ctx);
+    base64_decode(base64_input_data(argv[0], buf), len, (uint8_t *) term_binary_data(result));
+    free(buf);
 
-    return new_tuple;
+    return result;
 }
 
-static term nif_erlang_tuple_to_list_1(Context *ctx, int argc, term argv[])
+static term nif_base64_decode_1(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    VALIDATE_VALUE(argv[0], term_is_tuple);
-
-    int tuple_size = term_get_tuple_arity(argv[0]);
+    return base64_decode_term(ctx, argv, 0);
+}
 
-    memory_ensure_free(ctx, tuple_size * 2);
+static term nif_base64_mime_decode_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
 
-    term tuple = argv[0];
-    term prev = term_nil();
+    return base64_decode_term(ctx, argv, 1);
+}
 
-    for (int i = tuple_size - 1; i >= 0; i--) {
-        prev = term_list_prepend(term_get_tuple_element(tuple, i), prev, ctx);
+static term json_result_to_term(Context *ctx, enum JsonResult json_result, term result)
+{
+    switch (json_result) {
+        case JsonOk:
+            return result;
+        case JsonOverflow:
+            // overflow error is not standard, but we need it since big integers are not supported yet
+            RAISE_ERROR(overflow_atom);
+        case JsonOutOfMemory:
+            RAISE_ERROR(out_of_memory_atom);
+        default:
+            RAISE_ERROR(badarg_atom);
     }
-
-    return prev;
 }
 
-static term nif_erlang_binary_to_atom_2(Context *ctx, int argc, term argv[])
+static term nif_json_decode_1(Context *ctx, int argc, term argv[])
 {
-    return binary_to_atom(ctx, argc, argv, 1);
+    UNUSED(argc);
+
+    term result = term_nil();
+    enum JsonResult json_result = json_decode(ctx, &argv[0], &result);
+
+    return json_result_to_term(ctx, json_result, result);
 }
 
-static term nif_erlang_binary_to_existing_atom_2(Context *ctx, int argc, term argv[])
+static term nif_json_encode_1(Context *ctx, int argc, term argv[])
 {
-    return binary_to_atom(ctx, argc, argv, 0);
+    UNUSED(argc);
+
+    term result = term_nil();
+    enum JsonResult json_result = json_encode(ctx, &argv[0], &result);
+
+    return json_result_to_term(ctx, json_result, result);
 }
 
-static term binary_to_atom(Context *ctx, int argc, term argv[], int create_new)
+static term nif_io_lib_format_2(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    term a_binary = argv[0];
-    VALIDATE_VALUE(a_binary, term_is_binary);
+    struct FormatBuffer buf;
+    format_buffer_init(&buf);
+    enum FormatResult format_result = format_io_lib(&buf, argv[0], argv[1], ctx);
+    if (UNLIKELY(format_result != FormatOk)) {
+        format_buffer_destroy(&buf);
+        RAISE_ERROR(format_result == FormatOutOfMemory ? out_of_memory_atom : badarg_atom);
+    }
 
-    if (UNLIKELY(argv[1] != context_make_atom(ctx, latin1_atom))) {
-        RAISE_ERROR(badarg_atom);
+    // the formatted text doesn't reference any term, so the heap can be safely grown here
+    memory_ensure_free(ctx, buf.len * 2);
+
+    term result = term_nil();
+    for (size_t i = buf.len; i > 0; i--) {
+        result = term_list_prepend(term_from_int11((uint8_t) buf.data[i - 1]), result, ctx);
     }
+    format_buffer_destroy(&buf);
+
+    return result;
+}
 
-    char *atom_string = interop_binary_to_string(a_binary);
-    if (IS_NULL_PTR(atom_string)) {
-        fprintf(stderr, "Failed to alloc temporary string\n");
-        abort();
+static term nif_io_format(Context *ctx, int argc, term argv[])
+{
+    struct FormatBuffer buf;
+    format_buffer_init(&buf);
+    enum FormatResult format_result = format_io_lib(&buf, argv[0], argc == 2 ? argv[1] : term_nil(), ctx);
+    if (UNLIKELY(format_result != FormatOk)) {
+        format_buffer_destroy(&buf);
+        RAISE_ERROR(format_result == FormatOutOfMemory ? out_of_memory_atom : badarg_atom);
     }
-    int atom_string_len = strlen(atom_string);
-    if (UNLIKELY(atom_string_len > 255)) {
-        free(atom_string);
-        RAISE_ERROR(system_limit_atom);
+
+    if (buf.len) {
+        fwrite(buf.data, 1, buf.len, stdout);
     }
+    format_buffer_destroy(&buf);
 
-    AtomString atom = malloc(atom_string_len + 1);
-    ((uint8_t *) atom)[0] = atom_string_len;
-    memcpy(((char *) atom) + 1, atom_string, atom_string_len);
+    return context_make_atom(ctx, ok_atom);
+}
 
-    unsigned long global_atom_index = atomshashtable_get_value(ctx->global->atoms_table, atom, ULONG_MAX);
-    int has_atom = (global_atom_index != ULONG_MAX);
+#ifdef WITH_ZLIB
 
-    if (create_new || has_atom) {
-        if (!has_atom) {
-            global_atom_index = globalcontext_insert_atom(ctx->global, atom);
-        } else {
-            free((void *) atom);
-        }
-        return term_from_atom_index(global_atom_index);
+struct ZlibFeed
+{
+    z_stream *zs;
+    enum ZlibStreamMode mode;
+    struct ZlibBuffer *out;
+    int ret;
+};
 
-    } else {
-        free((void *) atom);
-        RAISE_ERROR(badarg_atom);
+static void zlib_feed_chunk(const uint8_t *data, unsigned long len, void *accum)
+{
+    struct ZlibFeed *feed = (struct ZlibFeed *) accum;
+    if (feed->ret == Z_OK) {
+        feed->ret = zlibstream_process(feed->zs, feed->mode, data, len, Z_NO_FLUSH, feed->out);
     }
 }
 
-term nif_erlang_list_to_atom_1(Context *ctx, int argc, term argv[])
+// returns 0 if data is not valid iodata, zlib result is stored in ret
+static int zlib_run(z_stream *zs, enum ZlibStreamMode mode, term data, int flush, struct ZlibBuffer *out, int *ret)
 {
-    return list_to_atom(ctx, argc, argv, 1);
+    struct ZlibFeed feed = {
+        .zs = zs,
+        .mode = mode,
+        .out = out,
+        .ret = Z_OK
+    };
+    if (UNLIKELY(!interop_iolist_foreach_chunk(data, zlib_feed_chunk, &feed))) {
+        return 0;
+    }
+    if ((feed.ret == Z_OK) && (flush != Z_NO_FLUSH)) {
+        feed.ret = zlibstream_process(zs, mode, NULL, 0, flush, out);
+    }
+    *ret = feed.ret;
+
+    return 1;
 }
 
-term nif_erlang_list_to_existing_atom_1(Context *ctx, int argc, term argv[])
+// output buffer is freed, result is a binary or an iolist when as_iolist is set
+static term zlib_make_output(Context *ctx, struct ZlibBuffer *out, int as_iolist)
 {
-    return list_to_atom(ctx, argc, argv, 0);
+    if (as_iolist && (out->len == 0)) {
+        free(out->data);
+        return term_nil();
+    }
+
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(out->len) + 2 + (as_iolist ? 2 : 0));
+    term binary = term_from_literal_binary(out->data, out->len, ctx);
+    free(out->data);
+
+    if (as_iolist) {
+        return term_list_prepend(binary, term_nil(), ctx);
+    }
+
+    return binary;
 }
 
-term list_to_atom(Context *ctx, int argc, term argv[], int create_new)
+static term zlib_oneshot(Context *ctx, term data, enum ZlibStreamMode mode, int window_bits)
 {
-    UNUSED(argc);
-
-    term a_list = argv[0];
-    VALIDATE_VALUE(a_list, term_is_list);
+    z_stream zs;
+    memset(&zs, 0, sizeof(z_stream));
 
-    char *atom_string = interop_list_to_string(a_list);
-    if (IS_NULL_PTR(atom_string)) {
-        fprintf(stderr, "Failed to alloc temporary string\n");
-        abort();
+    int ret;
+    if (mode == ZlibStreamDeflate) {
+        ret = deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY);
+    } else {
+        ret = inflateInit2(&zs, window_bits);
     }
-    int atom_string_len = strlen(atom_string);
-    if (UNLIKELY(atom_string_len > 255)) {
-        free(atom_string);
-        RAISE_ERROR(system_limit_atom);
+    if (UNLIKELY(ret != Z_OK)) {
+        RAISE_ERROR(out_of_memory_atom);
     }
 
-    AtomString atom = malloc(atom_string_len + 1);
-    ((uint8_t *) atom)[0] = atom_string_len;
-    memcpy(((char *) atom) + 1, atom_string, atom_string_len);
+    struct ZlibBuffer out = { NULL, 0, 0 };
+    int flush = (mode == ZlibStreamDeflate) ? Z_FINISH : Z_NO_FLUSH;
+    int valid = zlib_run(&zs, mode, data, flush, &out, &ret);
 
-    unsigned long global_atom_index = atomshashtable_get_value(ctx->global->atoms_table, atom, ULONG_MAX);
-    int has_atom = (global_atom_index != ULONG_MAX);
+    if (mode == ZlibStreamDeflate) {
+        deflateEnd(&zs);
+    } else {
+        inflateEnd(&zs);
+    }
 
-    if (create_new || has_atom) {
-        if (!has_atom) {
-            global_atom_index = globalcontext_insert_atom(ctx->global, atom);
+    if (UNLIKELY(!valid || (ret != Z_STREAM_END))) {
+        free(out.data);
+        if (!valid) {
+            RAISE_ERROR(badarg_atom);
+        } else if (ret == Z_MEM_ERROR) {
+            RAISE_ERROR(out_of_memory_atom);
         } else {
-            free((void *) atom);
+            RAISE_ERROR(data_error_atom);
         }
-        return term_from_atom_index(global_atom_index);
-
-    } else {
-        free((void *) atom);
-        RAISE_ERROR(badarg_atom);
     }
+
+    return zlib_make_output(ctx, &out, 0);
 }
 
-static term nif_erlang_atom_to_list_1(Context *ctx, int argc, term argv[])
+static term nif_zlib_compress_1(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    term atom_term = argv[0];
-    VALIDATE_VALUE(atom_term, term_is_atom);
-
-    int atom_index = term_to_atom_index(atom_term);
-    AtomString atom_string = (AtomString) valueshashtable_get_value(ctx->global->atoms_ids_table, atom_index, (unsigned long) NULL);
+    return zlib_oneshot(ctx, argv[0], ZlibStreamDeflate, ZLIBSTREAM_ZLIB_WINDOW_BITS);
+}
 
-    int atom_len = atom_string_len(atom_string);
+static term nif_zlib_uncompress_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
 
-    memory_ensure_free(ctx, atom_len * 2);
+    return zlib_oneshot(ctx, argv[0], ZlibStreamInflate, ZLIBSTREAM_ZLIB_WINDOW_BITS);
+}
 
-    term prev = term_nil();
-    for (int i = atom_len - 1; i >= 0; i--) {
-        char c = ((const char *) atom_string_data(atom_string))[i];
-        prev = term_list_prepend(term_from_int11(c), prev, ctx);
-    }
+static term nif_zlib_gzip_1(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
 
-    return prev;
+    return zlib_oneshot(ctx, argv[0], ZlibStreamDeflate, ZLIBSTREAM_GZIP_WINDOW_BITS);
 }
 
-static term nif_erlang_integer_to_list_1(Context *ctx, int argc, term argv[])
+static term nif_zlib_gunzip_1(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    term value = argv[0];
-    VALIDATE_VALUE(value, term_is_integer);
+    return zlib_oneshot(ctx, argv[0], ZlibStreamInflate, ZLIBSTREAM_GZIP_WINDOW_BITS);
+}
 
-    int32_t int_value = term_to_int32(value);
-    char integer_string[24];
+static struct ZlibStream *zlib_get_stream(Context *ctx, term handle, enum ZlibStreamMode mode)
+{
+    if (!term_is_reference(handle)) {
+        return NULL;
+    }
+    struct ZlibStream *stream = zlibstream_find(ctx, term_to_ref_ticks(handle));
+    if (IS_NULL_PTR(stream) || (stream->mode != mode)) {
+        return NULL;
+    }
 
-    snprintf(integer_string, 24, "%i", int_value);
-    int integer_string_len = strlen(integer_string);
+    return stream;
+}
 
-    memory_ensure_free(ctx, integer_string_len * 2);
+static term nif_zlib_open_0(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+    UNUSED(argv);
 
-    term prev = term_nil();
-    for (int i = integer_string_len - 1; i >= 0; i--) {
-        prev = term_list_prepend(term_from_int11(integer_string[i]), prev, ctx);
+    uint64_t ref_ticks = globalcontext_get_ref_ticks(ctx->global);
+    if (UNLIKELY(!zlibstream_new(ctx, ref_ticks))) {
+        RAISE_ERROR(out_of_memory_atom);
     }
 
-    return prev;
+    memory_ensure_free(ctx, TERM_BOXED_REF_SIZE);
+    return term_from_ref_ticks(ref_ticks, ctx);
 }
 
-static term nif_erlang_list_to_integer_1(Context *ctx, int argc, term argv[])
+static term nif_zlib_close_1(Context *ctx, int argc, term argv[])
 {
     UNUSED(argc);
 
-    term t = argv[0];
-    int32_t acc = 0;
-    int digits = 0;
-
-    VALIDATE_VALUE(t, term_is_nonempty_list);
-
-    int negative = 0;
-    term first_digit = term_get_list_head(t);
-    if (first_digit == term_from_int11('-')) {
-        negative = 1;
-        t = term_get_list_tail(t);
-    } else if (first_digit == term_from_int11('+')) {
-        t = term_get_list_tail(t);
+    VALIDATE_VALUE(argv[0], term_is_reference);
+    struct ZlibStream *stream = zlibstream_find(ctx, term_to_ref_ticks(argv[0]));
+    if (UNLIKELY(!stream)) {
+        RAISE_ERROR(badarg_atom);
     }
+    zlibstream_destroy(stream);
 
-    while (!term_is_nil(t)) {
-        term head = term_get_list_head(t);
-
-        VALIDATE_VALUE(head, term_is_integer);
+    return context_make_atom(ctx, ok_atom);
+}
 
-        int32_t c = term_to_int32(head);
+static term nif_zlib_deflate_init(Context *ctx, int argc, term argv[])
+{
+    struct ZlibStream *stream = zlib_get_stream(ctx, argv[0], ZlibStreamIdle);
+    if (UNLIKELY(!stream)) {
+        RAISE_ERROR(badarg_atom);
+    }
 
-        if (UNLIKELY((c < '0') || (c > '9'))) {
+    int level = Z_DEFAULT_COMPRESSION;
+    if (argc == 2) {
+        term level_term = argv[1];
+        if (level_term == context_make_atom(ctx, default_atom)) {
+            level = Z_DEFAULT_COMPRESSION;
+        } else if (level_term == context_make_atom(ctx, none_atom)) {
+            level = Z_NO_COMPRESSION;
+        } else if (level_term == context_make_atom(ctx, best_speed_atom)) {
+            level = Z_BEST_SPEED;
+        } else if (level_term == context_make_atom(ctx, best_compression_atom)) {
+            level = Z_BEST_COMPRESSION;
+        } else if (term_is_integer(level_term) && (term_to_int32(level_term) >= 0) && (term_to_int32(level_term) <= 9)) {
+            level = term_to_int32(level_term);
+        } else {
             RAISE_ERROR(badarg_atom);
         }
+    }
 
-        if (acc > INT32_MAX / 10) {
-            // overflow error is not standard, but we need it since we are running on an embedded device
-            RAISE_ERROR(overflow_atom);
-        }
+    memset(&stream->zs, 0, sizeof(z_stream));
+    if (UNLIKELY(deflateInit2(&stream->zs, level, Z_DEFLATED, ZLIBSTREAM_ZLIB_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)) {
+        RAISE_ERROR(out_of_memory_atom);
+    }
+    stream->mode = ZlibStreamDeflate;
 
-        acc = (acc * 10) + (c - '0');
-        digits++;
-        t = term_get_list_tail(t);
+    return context_make_atom(ctx, ok_atom);
+}
+
+static term nif_zlib_deflate(Context *ctx, int argc, term argv[])
+{
+    struct ZlibStream *stream = zlib_get_stream(ctx, argv[0], ZlibStreamDeflate);
+    if (UNLIKELY(!stream)) {
+        RAISE_ERROR(badarg_atom);
     }
 
-    if (negative) {
-        acc = -acc;
+    int flush = Z_NO_FLUSH;
+    if (argc == 3) {
+        term flush_term = argv[2];
+        if (flush_term == context_make_atom(ctx, none_atom)) {
+            flush = Z_NO_FLUSH;
+        } else if (flush_term == context_make_atom(ctx, sync_atom)) {
+            flush = Z_SYNC_FLUSH;
+        } else if (flush_term == context_make_atom(ctx, full_atom)) {
+            flush = Z_FULL_FLUSH;
+        } else if (flush_term == context_make_atom(ctx, finish_atom)) {
+            flush = Z_FINISH;
+        } else {
+            RAISE_ERROR(badarg_atom);
+        }
     }
 
-    if (UNLIKELY(digits == 0)) {
+    struct ZlibBuffer out = { NULL, 0, 0 };
+    int ret;
+    if (UNLIKELY(!zlib_run(&stream->zs, ZlibStreamDeflate, argv[1], flush, &out, &ret))) {
+        free(out.data);
         RAISE_ERROR(badarg_atom);
     }
+    if (UNLIKELY((ret != Z_OK) && (ret != Z_STREAM_END))) {
+        free(out.data);
+        RAISE_ERROR((ret == Z_MEM_ERROR) ? out_of_memory_atom : badarg_atom);
+    }
 
-    return term_from_int32(acc);
+    return zlib_make_output(ctx, &out, 1);
 }
 
-static term nif_erlang_display_1(Context *ctx, int argc, term argv[])
+static term nif_zlib_deflate_end_1(Context *ctx, int argc, term argv[])
 {
-    UNUSED(ctx);
     UNUSED(argc);
 
-    term_display(argv[0], ctx);
-    printf("\n");
+    struct ZlibStream *stream = zlib_get_stream(ctx, argv[0], ZlibStreamDeflate);
+    if (UNLIKELY(!stream)) {
+        RAISE_ERROR(badarg_atom);
+    }
+    zlibstream_end(stream);
 
-    return term_nil();
+    return context_make_atom(ctx, ok_atom);
 }
 
-static term nifs_erlang_process_flag(Context *ctx, int argc, term argv[])
+static term nif_zlib_inflate_init(Context *ctx, int argc, term argv[])
 {
-    UNUSED(argc);
+    struct ZlibStream *stream = zlib_get_stream(ctx, argv[0], ZlibStreamIdle);
+    if (UNLIKELY(!stream)) {
+        RAISE_ERROR(badarg_atom);
+    }
 
-#ifdef ENABLE_ADVANCED_TRACE
-    term pid = argv[0];
-    term flag = argv[1];
-    term value = argv[2];
+    int window_bits = ZLIBSTREAM_ZLIB_WINDOW_BITS;
+    if (argc == 2) {
+        VALIDATE_VALUE(argv[1], term_is_integer);
+        window_bits = term_to_int32(argv[1]);
+    }
 
-    int local_process_id = term_to_local_process_id(pid);
-    Context *target = globalcontext_get_process(ctx->global, local_process_id);
+    memset(&stream->zs, 0, sizeof(z_stream));
+    int ret = inflateInit2(&stream->zs, window_bits);
+    if (UNLIKELY(ret != Z_OK)) {
+        RAISE_ERROR((ret == Z_MEM_ERROR) ? out_of_memory_atom : badarg_atom);
+    }
+    stream->mode = ZlibStreamInflate;
 
-    term true_term = context_make_atom(ctx, true_atom);
-    term false_term = context_make_atom(ctx, false_atom);
-    term ok_term = context_make_atom(ctx, ok_atom);
+    return context_make_atom(ctx, ok_atom);
+}
 
-    if (flag == context_make_atom(target, trace_calls_atom)) {
-        if (value == true_term) {
-            target->trace_calls = 1;
-            return ok_term;
-        } else if (value == false_term) {
-            target->trace_calls = 0;
-            return ok_term;
-        }
-    } else if (flag == context_make_atom(target, trace_call_args_atom)) {
-        if (value == true_term) {
-            target->trace_call_args = 1;
-            return ok_term;
-        } else if (value == false_term) {
-            target->trace_call_args = 0;
-            return ok_term;
-        }
-    } else if (flag == context_make_atom(target, trace_returns_atom)) {
-        if (value == true_term) {
-            target->trace_returns = 1;
-            return ok_term;
-        } else if (value == false_term) {
-            target->trace_returns = 0;
-            return ok_term;
-        }
-    } else if (flag == context_make_atom(target, trace_send_atom)) {
-        if (value == true_term) {
-            target->trace_send = 1;
-            return ok_term;
-        } else if (value == false_term) {
-            target->trace_send = 0;
-            return ok_term;
-        }
-    } else if (flag == context_make_atom(target, trace_receive_atom)) {
-        if (value == true_term) {
-            target->trace_receive = 1;
-            return ok_term;
-        } else if (value == false_term) {
-            target->trace_receive = 0;
-            return ok_term;
-        }
+static term nif_zlib_inflate_2(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+
+    struct ZlibStream *stream = zlib_get_stream(ctx, argv[0], ZlibStreamInflate);
+    if (UNLIKELY(!stream)) {
+        RAISE_ERROR(badarg_atom);
     }
-#else
-    UNUSED(ctx);
-    UNUSED(argv);
-#endif
 
-    RAISE_ERROR(badarg_atom);
+    struct ZlibBuffer out = { NULL, 0, 0 };
+    int ret;
+    if (UNLIKELY(!zlib_run(&stream->zs, ZlibStreamInflate, argv[1], Z_NO_FLUSH, &out, &ret))) {
+        free(out.data);
+        RAISE_ERROR(badarg_atom);
+    }
+    if (UNLIKELY((ret != Z_OK) && (ret != Z_STREAM_END))) {
+        free(out.data);
+        RAISE_ERROR((ret == Z_MEM_ERROR) ? out_of_memory_atom : data_error_atom);
+    }
+
+    return zlib_make_output(ctx, &out, 1);
 }
 
-static term nif_erts_debug_flat_size(Context *ctx, int argc, term argv[])
+static term nif_zlib_inflate_end_1(Context *ctx, int argc, term argv[])
 {
-    UNUSED(ctx);
     UNUSED(argc);
 
-    unsigned long terms_count;
+    struct ZlibStream *stream = zlib_get_stream(ctx, argv[0], ZlibStreamInflate);
+    if (UNLIKELY(!stream)) {
+        RAISE_ERROR(badarg_atom);
+    }
+    zlibstream_end(stream);
 
-    terms_count = memory_estimate_usage(argv[0]);
+    return context_make_atom(ctx, ok_atom);
+}
 
-    return term_from_int32(terms_count);
+#else
+
+static term nif_zlib_not_available(Context *ctx, int argc, term argv[])
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    RAISE_ERROR(undef_atom);
 }
+
+#endif
@@ -22,6 +22,8 @@
 #include <assert.h>
 #include <string.h>
 
+#include "bridge.h"
+#include "dist.h"
 #include "debug.h"
 #include "exportedfunction.h"
 #include "utils.h"
@@ -30,6 +32,8 @@
 #include "opcodes.h"
 
 #ifdef IMPL_EXECUTE_LOOP
+    #include "bif.h"
+    #include "format.h"
     #include "mailbox.h"
 #endif
 
@@ -319,6 +323,7 @@
 
 #define SCHEDULE_NEXT(restore_mod, restore_to) \
     {                                                                                             \
+        KILL_IF_PENDING();                                                                        \
         ctx->saved_ip = restore_to;                                                               \
         ctx->jump_to_on_restore = NULL;                                                           \
         ctx->saved_module = restore_mod;                                                          \
@@ -341,16 +346,55 @@
 #define POINTER_TO_II(instruction_pointer) \
     (((uint8_t *) (instruction_pointer)) - code)
 
+// Ends the current process and jumps to the next runnable one, the execution loop returns
+// when there is nothing left to run.
+#define TERMINATE_PROCESS() \
+    ctx = scheduler_exit(ctx->global, ctx); \
+    if (!ctx) { \
+        return 0; \
+    } \
+    mod = ctx->saved_module; \
+    code = mod->code->code; \
+    remaining_reductions = DEFAULT_REDUCTIONS_AMOUNT; \
+    JUMP_TO_ADDRESS(ctx->saved_ip);
+
+// A process that exceeded a memory limit is killed when it yields, instead of the allocation failing.
+#define KILL_IF_PENDING() \
+    if (UNLIKELY(ctx->kill_pending)) { \
+        ctx->exit_reason = context_make_atom(ctx, killed_atom); \
+        TERMINATE_PROCESS(); \
+        continue; \
+    }
+
+// An uncaught exception terminates the process with its reason, it is fatal only for the leader.
 #define RAISE_EXCEPTION() \
     int target_label = get_catch_label_and_change_module(ctx, &mod); \
     if (target_label) { \
         JUMP_TO_ADDRESS(mod->labels[target_label]); \
         break; \
+    } else if (!ctx->leader) { \
+        report_uncaught_exception(ctx); \
+        ctx->exit_reason = ctx->x[1]; \
+        TERMINATE_PROCESS(); \
+        break; \
     } else { \
         fprintf(stderr, "exception.\n"); \
         abort(); \
     }
 
+// erlang:hibernate/3 sets up the process continuation, that is restarted once a message is received.
+#define HIBERNATE(nif, arity) \
+    if (UNLIKELY(term_is_invalid_term((nif)->nif_ptr(ctx, arity, ctx->x)))) { \
+        RAISE_EXCEPTION(); \
+    } \
+    KILL_IF_PENDING(); \
+    if (!ctx->mailbox) { \
+        ctx = scheduler_wait(ctx->global, ctx); \
+    } \
+    mod = ctx->saved_module; \
+    code = mod->code->code; \
+    JUMP_TO_ADDRESS(ctx->saved_ip);
+
 static const char *const true_atom = "\x04" "true";
 static const char *const false_atom = "\x05" "false";
 static const char *const function_clause_atom = "\x0F" "function_clause";
@@ -358,32 +402,50 @@ static const char *const badarity_atom = "\x08" "badarity";
 static const char *const badfun_atom = "\x06" "badfun";
 
 #ifdef IMPL_EXECUTE_LOOP
+static const char *const normal_atom = "\x06" "normal";
+static const char *const killed_atom = "\x06" "killed";
+
 struct Int24
 {
     int32_t val24 : 24;
 };
 
-static int get_catch_label_and_change_module(Context *ctx, Module **mod)
+static void report_uncaught_exception(Context *ctx)
 {
-    term *ct = ctx->e;
-    term *last_frame = ctx->e;
-
-    while (ct != ctx->stack_base) {
-        if (term_is_catch_label(*ct)) {
-            int target_module;
-            int target_label = term_to_catch_label_and_module(*ct, &target_module);
-            TRACE("- found catch: label: %i, module: %i\n", target_label, target_module);
-            *mod = ctx->global->modules_by_index[target_module];
+    struct FormatBuffer buf;
+    format_buffer_init(&buf);
+    format_term(&buf, ctx->x[0], ctx, 1);
+    format_buffer_append(&buf, ":", 1);
+    format_term(&buf, ctx->x[1], ctx, 1);
+
+    if (!buf.out_of_memory) {
+        fprintf(stderr, "Process <0.%i.0> terminated with an uncaught exception: %.*s\n",
+            ctx->process_id, (int) buf.len, buf.data);
+    }
+    format_buffer_destroy(&buf);
+}
 
-            ctx->e = last_frame;
+static int get_catch_label_and_change_module(Context *ctx, Module **mod)
+{
+    while (ctx->catch_frames_count > 0) {
+        struct CatchFrame *frame = &ctx->catch_frames[ctx->catch_frames_count - 1];
+        term *catch_slot = ctx->stack_base - frame->slot_offset;
+
+        //the frame owning this catch has already been deallocated or the catch has been cleared
+        if (UNLIKELY((catch_slot < ctx->e) || !term_is_catch_label(*catch_slot))) {
+            ctx->catch_frames_count--;
+            continue;
+        }
 
-            return target_label;
+        int target_module;
+        int target_label = term_to_catch_label_and_module(*catch_slot, &target_module);
+        TRACE("- found catch: label: %i, module: %i\n", target_label, target_module);
+        *mod = ctx->global->modules_by_index[target_module];
 
-        } else if (term_is_cp(*ct)) {
-            last_frame = ct - 1;
-        }
+        ctx->e = ctx->stack_base - frame->frame_offset;
+        frame->raised = 1;
 
-        ct++;
+        return target_label;
     }
 
     return 0;
@@ -422,20 +484,27 @@ static int64_t large_integer_to_int64(uint8_t *compact_term, int *next_operand_o
 
 term make_fun(Context *ctx, const Module *mod, int fun_index)
 {
-    uint32_t n_freeze = module_get_fun_freeze(mod, fun_index);
+    const struct ModuleFun *fun = module_get_fun_entry(mod, fun_index);
+    uint32_t n_freeze = fun->n_freeze;
 
     int size = 2 + n_freeze;
     term *boxed_func = memory_heap_alloc(ctx, size + 1);
 
     boxed_func[0] = (size << 6) | TERM_BOXED_FUN;
-    boxed_func[1] = (term) mod;
+#ifdef AVM_COMPACT_TERMS
+    // module and fun table entry are stored as indexes, since a pointer does not fit a term
+    boxed_func[1] = mod->module_index;
     boxed_func[2] = fun_index;
+#else
+    boxed_func[1] = (term) mod;
+    boxed_func[2] = (term) fun;
+#endif
 
     for (uint32_t i = 3; i < n_freeze + 3; i++) {
         boxed_func[i] = ctx->x[i - 3];
     }
 
-    return ((term) boxed_func) | TERM_BOXED_VALUE_TAG;
+    return term_from_term_ptr(boxed_func) | TERM_BOXED_VALUE_TAG;
 }
 
 #ifdef ENABLE_ADVANCED_TRACE
@@ -535,7 +604,14 @@ term make_fun(Context *ctx, const Module *mod, int fun_index)
 
 #ifdef IMPL_EXECUTE_LOOP
 static const char *const error_atom = "\x5" "error";
+static const char *const badarg_atom = "\x6" "badarg";
 static const char *const try_clause_atom = "\xA" "try_clause";
+static const char *const badmatch_atom = "\x8" "badmatch";
+static const char *const case_clause_atom = "\xB" "case_clause";
+static const char *const if_clause_atom = "\x9" "if_clause";
+static const char *const throw_atom = "\x5" "throw";
+static const char *const exit_upper_atom = "\x4" "EXIT";
+static const char *const system_limit_atom = "\xC" "system_limit";
 #endif
 
 #pragma GCC diagnostic push
@@ -647,6 +723,7 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
             #ifdef IMPL_EXECUTE_LOOP
                 TRACE("-- Code execution finished for %i--\n", ctx->process_id);
+                ctx->exit_reason = context_make_atom(ctx, normal_atom);
                 if (schudule_processes_count(ctx->global) == 1) {
                     scheduler_terminate(ctx);
                     return 0;
@@ -654,19 +731,8 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
                 TRACE("WARNING: some processes are still running.\n");
 
-                Context *scheduled_context = scheduler_next(ctx->global, ctx);
-                if (scheduled_context == ctx) {
-                    TRACE("There are no more runnable processes\n");
-                    return 0;
-                }
-
-                scheduler_terminate(ctx);
-
-                ctx = scheduled_context;
-                mod = ctx->saved_module;
-                code = mod->code->code;
-                remaining_reductions = DEFAULT_REDUCTIONS_AMOUNT;
-                JUMP_TO_ADDRESS(scheduled_context->saved_ip);
+                // terminating may kill linked processes, so the next one is picked afterwards
+                TERMINATE_PROCESS();
 
                 break;
             #endif
@@ -811,6 +877,10 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                             ctx->x[0] = return_value;
                             break;
                         }
+                        case HibernateNIFFunctionType: {
+                            HIBERNATE(EXPORTED_FUNCTION_TO_NIF(func), arity);
+                            break;
+                        }
                         case ModuleFunction: {
                             const struct ModuleFunction *jump = EXPORTED_FUNCTION_TO_MODULE_FUNCTION(func);
 
@@ -876,6 +946,10 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
                             break;
                         }
+                        case HibernateNIFFunctionType: {
+                            HIBERNATE(EXPORTED_FUNCTION_TO_NIF(func), arity);
+                            break;
+                        }
                         case ModuleFunction: {
                             const struct ModuleFunction *jump = EXPORTED_FUNCTION_TO_MODULE_FUNCTION(func);
 
@@ -984,11 +1058,17 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                 #endif
 
                 #ifdef IMPL_EXECUTE_LOOP
-                    BifImpl2 func = (BifImpl2) mod->imported_funcs[bif].bif;
-                    DEBUG_FAIL_NULL(func);
-                    term ret = func(ctx, arg1, arg2);
+                    term ret = term_invalid_term();
+                    if (mod->inline_bifs[bif]) {
+                        ret = bif_inline_2(ctx, mod->inline_bifs[bif], arg1, arg2);
+                    }
                     if (UNLIKELY(term_is_invalid_term(ret))) {
-                        RAISE_EXCEPTION();
+                        BifImpl2 func = (BifImpl2) mod->imported_funcs[bif].bif;
+                        DEBUG_FAIL_NULL(func);
+                        ret = func(ctx, arg1, arg2);
+                        if (UNLIKELY(term_is_invalid_term(ret))) {
+                            RAISE_EXCEPTION();
+                        }
                     }
 
                     WRITE_REGISTER(dreg_type, dreg, ret);
@@ -1016,9 +1096,7 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
                     context_clean_registers(ctx, live);
 
-                    if (ctx->heap_ptr > ctx->e - (stack_need + 1)) {
-                        memory_ensure_free(ctx, stack_need + 1);
-                    }
+                    context_ensure_free_stack_and_heap(ctx, stack_need + 1, 0);
                     ctx->e -= stack_need + 1;
                     ctx->e[stack_need] = ctx->cp;
                 #endif
@@ -1048,9 +1126,7 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
                     context_clean_registers(ctx, live);
 
-                    if ((ctx->heap_ptr + heap_need) > ctx->e - (stack_need + 1)) {
-                        memory_ensure_free(ctx, heap_need + stack_need + 1);
-                    }
+                    context_ensure_free_stack_and_heap(ctx, stack_need + 1, heap_need);
                     ctx->e -= stack_need + 1;
                     ctx->e[stack_need] = ctx->cp;
                 #endif
@@ -1077,9 +1153,7 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
                     context_clean_registers(ctx, live);
 
-                    if (ctx->heap_ptr > ctx->e - (stack_need + 1)) {
-                        memory_ensure_free(ctx, stack_need + 1);
-                    }
+                    context_ensure_free_stack_and_heap(ctx, stack_need + 1, 0);
 
                     ctx->e -= stack_need + 1;
                     for (int s = 0; s < stack_need; s++) {
@@ -1113,9 +1187,7 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
                     context_clean_registers(ctx, live);
 
-                    if ((ctx->heap_ptr + heap_need) > ctx->e - (stack_need + 1)) {
-                        memory_ensure_free(ctx, heap_need + stack_need + 1);
-                    }
+                    context_ensure_free_stack_and_heap(ctx, stack_need + 1, heap_need);
                     ctx->e -= stack_need + 1;
                     for (int s = 0; s < stack_need; s++) {
                         ctx->e[s] = term_nil();
@@ -1139,17 +1211,34 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                 USED_BY_TRACE(live_registers);
 
                 #ifdef IMPL_EXECUTE_LOOP
+                    // large heaps are collected while the process is suspended, it is resumed after this instruction
+                    int collecting = 0;
                     if (context_avail_free_memory(ctx) < heap_need) {
                         context_clean_registers(ctx, live_registers);
-                        memory_ensure_free(ctx, heap_need);
+                        collecting = memory_ensure_free_deferred(ctx, heap_need);
                     } else if (context_avail_free_memory(ctx) > heap_need * HEAP_NEED_GC_SHRINK_THRESHOLD_COEFF) {
                         context_clean_registers(ctx, live_registers);
                         int used_size = context_memory_size(ctx) - context_avail_free_memory(ctx);
-                        memory_ensure_free(ctx, used_size + heap_need * (HEAP_NEED_GC_SHRINK_THRESHOLD_COEFF / 2));
+                        collecting = memory_ensure_free_deferred(ctx, used_size + heap_need * (HEAP_NEED_GC_SHRINK_THRESHOLD_COEFF / 2));
                     }
                 #endif
 
                 NEXT_INSTRUCTION(next_offset);
+
+                #ifdef IMPL_EXECUTE_LOOP
+                    if (collecting) {
+                        KILL_IF_PENDING();
+                        ctx->saved_ip = INSTRUCTION_POINTER();
+                        ctx->jump_to_on_restore = NULL;
+                        ctx->saved_module = mod;
+                        ctx = scheduler_wait(ctx->global, ctx);
+                        mod = ctx->saved_module;
+                        code = mod->code->code;
+                        remaining_reductions = DEFAULT_REDUCTIONS_AMOUNT;
+                        JUMP_TO_ADDRESS(ctx->saved_ip);
+                    }
+                #endif
+
                 break;
             }
 
@@ -1215,12 +1304,50 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                 #endif
 
                 #ifdef IMPL_EXECUTE_LOOP
+                    // {Name, Node} destinations are processes registered on a node, {Name, Instance} on another instance
+                    if (term_is_tuple(ctx->x[0])) {
+                        TRACE_SEND(ctx, ctx->x[0], ctx->x[1]);
+                        int sent;
+                        if (dist_is_node_destination(ctx->x[0])) {
+                            sent = dist_send_registered(ctx, ctx->x[0], ctx->x[1]);
+                        } else {
+                            sent = bridge_send(ctx->global, ctx->x[0], ctx->x[1]) != BridgeSendBadArg;
+                        }
+                        if (UNLIKELY(!sent)) {
+                            ctx->x[0] = context_make_atom(ctx, error_atom);
+                            ctx->x[1] = context_make_atom(ctx, badarg_atom);
+                            RAISE_EXCEPTION();
+                        }
+                        ctx->x[0] = ctx->x[1];
+                        NEXT_INSTRUCTION(1);
+                        break;
+                    }
+
                     int local_process_id = term_to_local_process_id(ctx->x[0]);
                     TRACE("send/0 target_pid=%i\n", local_process_id);
                     TRACE_SEND(ctx, ctx->x[0], ctx->x[1]);
                     Context *target = globalcontext_get_process(ctx->global, local_process_id);
-
-                    mailbox_send(target, ctx->x[1]);
+                    // the result of send is the message, that is kept in x0
+                    ctx->x[0] = ctx->x[1];
+
+                    // messages sent to a dead process are silently dropped
+                    if (target) {
+                        mailbox_send(target, ctx->x[1]);
+
+                        // backpressure: the sender waits until the receiver drains its mailbox
+                        if (UNLIKELY(mailbox_block_sender(target, ctx))) {
+                            KILL_IF_PENDING();
+                            NEXT_INSTRUCTION(1);
+                            ctx->saved_ip = INSTRUCTION_POINTER();
+                            ctx->jump_to_on_restore = NULL;
+                            ctx->saved_module = mod;
+                            ctx = scheduler_wait(ctx->global, ctx);
+                            mod = ctx->saved_module;
+                            code = mod->code->code;
+                            JUMP_TO_ADDRESS(ctx->saved_ip);
+                            continue;
+                        }
+                    }
                 #endif
 
                 NEXT_INSTRUCTION(1);
@@ -1305,6 +1432,7 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                 TRACE("wait/1\n");
 
                 #ifdef IMPL_EXECUTE_LOOP
+                    KILL_IF_PENDING();
                     ctx->saved_ip = mod->labels[label];
                     ctx->jump_to_on_restore = NULL;
                     ctx->saved_module = mod;
@@ -1349,6 +1477,7 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                     }
 
                     if (needs_to_wait) {
+                        KILL_IF_PENDING();
                         Context *scheduled_context = scheduler_wait(ctx->global, ctx);
                         ctx = scheduled_context;
                         mod = ctx->saved_module;
@@ -2004,6 +2133,68 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                 break;
             }
 
+            case OP_CATCH: {
+                int next_off = 1;
+                int dreg;
+                uint8_t dreg_type;
+                DECODE_DEST_REGISTER(dreg, dreg_type, code, i, next_off, next_off);
+                int label;
+                DECODE_LABEL(label, code, i, next_off, next_off)
+
+                TRACE("catch/2, label=%i, reg=%c%i\n", label, reg_type_c(dreg_type), dreg);
+
+                #ifdef IMPL_EXECUTE_LOOP
+                    term catch_term = term_from_catch_label(mod->module_index, label);
+                    WRITE_REGISTER(dreg_type, dreg, catch_term);
+                    if (UNLIKELY(!context_push_catch_frame(ctx, ctx->e + dreg))) {
+                        ctx->x[0] = context_make_atom(ctx, error_atom);
+                        ctx->x[1] = context_make_atom(ctx, system_limit_atom);
+                        RAISE_EXCEPTION();
+                    }
+                #endif
+
+                NEXT_INSTRUCTION(next_off);
+                break;
+            }
+
+            case OP_CATCH_END: {
+                int next_off = 1;
+                int dreg;
+                uint8_t dreg_type;
+                DECODE_DEST_REGISTER(dreg, dreg_type, code, i, next_off, next_off);
+
+                TRACE("catch_end/1, reg=%c%i\n", reg_type_c(dreg_type), dreg);
+
+                #ifdef IMPL_EXECUTE_LOOP
+                    // stale frames are popped first, so the flag is the one of the frame stored in dreg
+                    int raised = context_pop_catch_frame(ctx, ctx->e + dreg);
+                    WRITE_REGISTER(dreg_type, dreg, term_nil());
+
+                    if (raised) {
+                        if (ctx->x[0] == context_make_atom(ctx, throw_atom)) {
+                            ctx->x[0] = ctx->x[1];
+
+                        } else {
+                            memory_ensure_free(ctx, 6);
+                            term reason = ctx->x[1];
+                            if (ctx->x[0] == context_make_atom(ctx, error_atom)) {
+                                term reason_tuple = term_alloc_tuple(2, ctx);
+                                term_put_tuple_element(reason_tuple, 0, reason);
+                                term_put_tuple_element(reason_tuple, 1, term_nil());
+                                reason = reason_tuple;
+                            }
+                            term exit_tuple = term_alloc_tuple(2, ctx);
+                            term_put_tuple_element(exit_tuple, 0, context_make_atom(ctx, exit_upper_atom));
+                            term_put_tuple_element(exit_tuple, 1, reason);
+                            ctx->x[0] = exit_tuple;
+                        }
+                    }
+                #endif
+
+                NEXT_INSTRUCTION(next_off);
+                break;
+            }
+
             case OP_MOVE: {
                 int next_off = 1;
                 term src_value;
@@ -2187,6 +2378,10 @@ static const char *const try_clause_atom = "\xA" "try_clause";
             }
 
             case OP_BADMATCH: {
+                #ifdef IMPL_EXECUTE_LOOP
+                    memory_ensure_free(ctx, 3);
+                #endif
+
                 int next_off = 1;
                 term arg1;
                 DECODE_COMPACT_TERM(arg1, code, i, next_off, next_off)
@@ -2202,9 +2397,14 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                     int target_label = get_catch_label_and_change_module(ctx, &mod);
 
                     if (target_label) {
+                        term new_error_tuple = term_alloc_tuple(2, ctx);
+                        term_put_tuple_element(new_error_tuple, 0, context_make_atom(ctx, badmatch_atom));
+                        term_put_tuple_element(new_error_tuple, 1, arg1);
+                        ctx->x[0] = context_make_atom(ctx, error_atom);
+                        ctx->x[1] = new_error_tuple;
                         JUMP_TO_ADDRESS(mod->labels[target_label]);
                     } else {
-                        fprintf(stderr, "No target label for OP_BADMATCH.  arg1=0x%lx\n", arg1);
+                        fprintf(stderr, "No target label for OP_BADMATCH.  arg1=0x%lx\n", (unsigned long) arg1);
                         abort();
                     }
                 #endif
@@ -2223,6 +2423,8 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                     int target_label = get_catch_label_and_change_module(ctx, &mod);
 
                     if (target_label) {
+                        ctx->x[0] = context_make_atom(ctx, error_atom);
+                        ctx->x[1] = context_make_atom(ctx, if_clause_atom);
                         JUMP_TO_ADDRESS(mod->labels[target_label]);
                     } else {
                         fprintf(stderr, "No target label for OP_IF_END\n");
@@ -2238,6 +2440,10 @@ static const char *const try_clause_atom = "\xA" "try_clause";
             }
 
             case OP_CASE_END: {
+                #ifdef IMPL_EXECUTE_LOOP
+                    memory_ensure_free(ctx, 3);
+                #endif
+
                 int next_off = 1;
                 term arg1;
                 DECODE_COMPACT_TERM(arg1, code, i, next_off, next_off)
@@ -2253,9 +2459,14 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                     int target_label = get_catch_label_and_change_module(ctx, &mod);
 
                     if (target_label) {
+                        term new_error_tuple = term_alloc_tuple(2, ctx);
+                        term_put_tuple_element(new_error_tuple, 0, context_make_atom(ctx, case_clause_atom));
+                        term_put_tuple_element(new_error_tuple, 1, arg1);
+                        ctx->x[0] = context_make_atom(ctx, error_atom);
+                        ctx->x[1] = new_error_tuple;
                         JUMP_TO_ADDRESS(mod->labels[target_label]);
                     } else {
-                        fprintf(stderr, "No target label for OP_CASE_END.  arg1=0x%lx\n", arg1);
+                        fprintf(stderr, "No target label for OP_CASE_END.  arg1=0x%lx\n", (unsigned long) arg1);
                         abort();
                     }
                 #endif
@@ -2296,15 +2507,18 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
                     const term *boxed_value = term_to_const_term_ptr(fun);
 
+                    #ifdef AVM_COMPACT_TERMS
+                    Module *fun_module = ctx->global->modules_by_index[boxed_value[1]];
+                    const struct ModuleFun *fun_entry = module_get_fun_entry(fun_module, boxed_value[2]);
+                    #else
                     Module *fun_module = (Module *) boxed_value[1];
-                    uint32_t fun_index = boxed_value[2];
+                    const struct ModuleFun *fun_entry = (const struct ModuleFun *) boxed_value[2];
+                    #endif
 
-                    uint32_t label;
-                    uint32_t arity;
-                    uint32_t n_freeze;
-                    module_get_fun(fun_module, fun_index, &label, &arity, &n_freeze);
+                    uint32_t arity = fun_entry->arity;
+                    uint32_t n_freeze = fun_entry->n_freeze;
 
-                    TRACE_CALL(ctx, mod, "call_fun", label, args_count);
+                    TRACE_CALL(ctx, mod, "call_fun", fun_entry->label, args_count);
 
                     if (UNLIKELY(args_count != arity - n_freeze)) {
                         int target_label = get_catch_label_and_change_module(ctx, &mod);
@@ -2319,7 +2533,7 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                         }
                     }
 
-                    for (unsigned int j = arity - n_freeze; j < arity + n_freeze; j++) {
+                    for (unsigned int j = arity - n_freeze; j < arity; j++) {
                         ctx->x[j] = boxed_value[j - (arity - n_freeze) + 3];
                     }
 
@@ -2331,9 +2545,9 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
                     remaining_reductions--;
                     if (LIKELY(remaining_reductions)) {
-                        JUMP_TO_ADDRESS(mod->labels[label]);
+                        JUMP_TO_ADDRESS(fun_entry->entry);
                     } else {
-                        SCHEDULE_NEXT(mod, mod->labels[label]);
+                        SCHEDULE_NEXT(mod, fun_entry->entry);
                     }
 
                 #endif
@@ -2418,6 +2632,10 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
                             break;
                         }
+                        case HibernateNIFFunctionType: {
+                            HIBERNATE(EXPORTED_FUNCTION_TO_NIF(func), arity);
+                            break;
+                        }
                         case ModuleFunction: {
                             const struct ModuleFunction *jump = EXPORTED_FUNCTION_TO_MODULE_FUNCTION(func);
 
@@ -2466,6 +2684,11 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                     term catch_term = term_from_catch_label(mod->module_index, label);
                     //TODO: here just write to y registers is enough
                     WRITE_REGISTER(dreg_type, dreg, catch_term);
+                    if (UNLIKELY(!context_push_catch_frame(ctx, ctx->e + dreg))) {
+                        ctx->x[0] = context_make_atom(ctx, error_atom);
+                        ctx->x[1] = context_make_atom(ctx, system_limit_atom);
+                        RAISE_EXCEPTION();
+                    }
                 #endif
 
                 NEXT_INSTRUCTION(next_off);
@@ -2483,13 +2706,13 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                 #ifdef IMPL_EXECUTE_LOOP
                     //TODO: here just write to y registers is enough
                     WRITE_REGISTER(dreg_type, dreg, term_nil());
+                    context_pop_catch_frame(ctx, ctx->e + dreg);
                 #endif
 
                 NEXT_INSTRUCTION(next_off);
                 break;
             }
 
-            //TODO: implement
             case OP_TRY_CASE: {
                 int next_off = 1;
                 int dreg;
@@ -2498,6 +2721,11 @@ static const char *const try_clause_atom = "\xA" "try_clause";
 
                 TRACE("try_case/1, reg=%c%i\n", reg_type_c(dreg_type), dreg);
 
+                #ifdef IMPL_EXECUTE_LOOP
+                    WRITE_REGISTER(dreg_type, dreg, term_nil());
+                    context_pop_catch_frame(ctx, ctx->e + dreg);
+                #endif
+
                 NEXT_INSTRUCTION(next_off);
                 break;
             }
@@ -2559,7 +2787,9 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                 TRACE_APPLY(ctx, "apply", module_name, function_name, arity);
 
                 struct Nif *nif = (struct Nif *) nifs_get(module_name, function_name, arity);
-                if (!IS_NULL_PTR(nif)) {
+                if (!IS_NULL_PTR(nif) && (nif->base.type == HibernateNIFFunctionType)) {
+                    HIBERNATE(nif, arity);
+                } else if (!IS_NULL_PTR(nif)) {
                     term return_value = nif->nif_ptr(ctx, arity, ctx->x);
                     if (UNLIKELY(term_is_invalid_term(return_value))) {
                         RAISE_EXCEPTION();
@@ -2613,7 +2843,9 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                 TRACE_APPLY(ctx, "apply_last", module_name, function_name, arity);
 
                 struct Nif *nif = (struct Nif *) nifs_get(module_name, function_name, arity);
-                if (!IS_NULL_PTR(nif)) {
+                if (!IS_NULL_PTR(nif) && (nif->base.type == HibernateNIFFunctionType)) {
+                    HIBERNATE(nif, arity);
+                } else if (!IS_NULL_PTR(nif)) {
                     term return_value = nif->nif_ptr(ctx, arity, ctx->x);
                     if (UNLIKELY(term_is_invalid_term(return_value))) {
                         RAISE_EXCEPTION();
@@ -2689,16 +2921,14 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                     if (term_is_function(arg1)) {
                         const term *boxed_value = term_to_const_term_ptr(arg1);
 
-                        Module *fun_module = (Module *) boxed_value[1];
-                        uint32_t fun_index = boxed_value[2];
-
-                        uint32_t fun_label;
-                        uint32_t fun_arity;
-                        uint32_t fun_n_freeze;
-
-                        module_get_fun(fun_module, fun_index, &fun_label, &fun_arity, &fun_n_freeze);
+                        #ifdef AVM_COMPACT_TERMS
+                        const Module *fun_module = ctx->global->modules_by_index[boxed_value[1]];
+                        const struct ModuleFun *fun_entry = module_get_fun_entry(fun_module, boxed_value[2]);
+                        #else
+                        const struct ModuleFun *fun_entry = (const struct ModuleFun *) boxed_value[2];
+                        #endif
 
-                        if (arity == fun_arity - fun_n_freeze) {
+                        if (arity == fun_entry->arity - fun_entry->n_freeze) {
                             NEXT_INSTRUCTION(next_off);
                         } else {
                             i = POINTER_TO_II(mod->labels[label]);
@@ -2779,10 +3009,17 @@ static const char *const try_clause_atom = "\xA" "try_clause";
                 #ifdef IMPL_EXECUTE_LOOP
                     TRACE("gc_bif2/6 fail_lbl=%i, live=%i, bif=%i, arg1=0x%lx, arg2=0x%lx, dest=r%i\n", f_label, live, bif, arg1, arg2, dreg);
 
-                    GCBifImpl2 func = (GCBifImpl2) mod->imported_funcs[bif].bif;
-                    term ret = func(ctx, live, arg1, arg2);
+                    // arithmetic on small integers is done in place, the C BIF handles everything else
+                    term ret = term_invalid_term();
+                    if (mod->inline_bifs[bif]) {
+                        ret = bif_inline_2(ctx, mod->inline_bifs[bif], arg1, arg2);
+                    }
                     if (UNLIKELY(term_is_invalid_term(ret))) {
-                        RAISE_EXCEPTION();
+                        GCBifImpl2 func = (GCBifImpl2) mod->imported_funcs[bif].bif;
+                        ret = func(ctx, live, arg1, arg2);
+                        if (UNLIKELY(term_is_invalid_term(ret))) {
+                            RAISE_EXCEPTION();
+                        }
                     }
 
                     WRITE_REGISTER(dreg_type, dreg, ret);
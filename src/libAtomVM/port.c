@@ -77,6 +77,10 @@ void port_send_reply(CContext *cc, term_ref pid, term_ref ref, term_ref reply)
 {
     int local_process_id = term_to_local_process_id(ccontext_get_term(cc, pid));
     Context *target = globalcontext_get_process(cc->ctx->global, local_process_id);
+    if (!target) {
+        // the caller terminated while waiting for the reply
+        return;
+    }
     term_ref msg = port_create_tuple2(cc, ref, reply);
     mailbox_send(target, ccontext_get_term(cc, msg));
 }
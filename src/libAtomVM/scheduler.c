@@ -17,20 +17,28 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
  ***************************************************************************/
 
+#include "bridge.h"
 #include "debug.h"
 #include "list.h"
+#include "mailbox.h"
+#include "memory.h"
 #include "scheduler.h"
 #include "sys.h"
 #include "utils.h"
 
 #include "time.h"
 
+static Context *scheduler_wait_ready(GlobalContext *global);
 static void scheduler_timeout_callback(void *data);
 static void scheduler_execute_native_handlers(GlobalContext *global);
 static Context *scheduler_get_expired_before(const GlobalContext *global, const struct timespec *before_timestamp);
 static int scheduler_find_min_timeout(const GlobalContext *global, struct timespec *found_timeout);
 static inline int before_than(const struct timespec *a, const struct timespec *b);
 static int make_ready_expired_contexts(GlobalContext *global);
+static int scheduler_find_next_timeout(const GlobalContext *global, struct timespec *next_timeout);
+static void scheduler_send_expired_timers(GlobalContext *global, const struct timespec *now_timestamp);
+static void scheduler_collect_garbage(GlobalContext *global);
+static void scheduler_shrink_idle_process(GlobalContext *global);
 
 Context *scheduler_wait(GlobalContext *global, Context *c)
 {
@@ -39,31 +47,49 @@ Context *scheduler_wait(GlobalContext *global, Context *c)
     #endif
     scheduler_make_waiting(global, c);
 
+    return scheduler_wait_ready(global);
+}
+
+static Context *scheduler_wait_ready(GlobalContext *global)
+{
     sys_platform_periodic_tasks();
 
     do {
+        // pending collections are run instead of sleeping
+        int collecting = !list_is_empty(&global->deferred_gcs) || global->memory_shrink_pending;
+
+        if (bridge_has_messages(global)) {
+            bridge_deliver_messages(global);
+            if (!list_is_empty(&global->ready_processes)) {
+                break;
+            }
+        }
+
         struct timespec next_timeout;
-        next_timeout.tv_sec = global->next_timeout_at.tv_sec;
-        next_timeout.tv_nsec = global->next_timeout_at.tv_nsec;
 
-        if  (next_timeout.tv_sec | next_timeout.tv_nsec) {
+        if (scheduler_find_next_timeout(global, &next_timeout)) {
             struct timespec now_timestamp;
             sys_set_timestamp_from_relative_to_abs(&now_timestamp, 0);
 
             if (before_than(&next_timeout, &now_timestamp)) {
-
-                Context *expired_ctx = scheduler_get_expired_before(global, &now_timestamp);
-                if (UNLIKELY(!expired_ctx)) {
-                    fprintf(stderr, "Timeout without any expired context, aborting.\n");
-                    abort();
-                }
-                scheduler_make_ready(global, expired_ctx);
-                if (!scheduler_find_min_timeout(global, &global->next_timeout_at)) {
-                    global->next_timeout_at.tv_sec = 0;
-                    global->next_timeout_at.tv_nsec = 0;
+                scheduler_send_expired_timers(global, &now_timestamp);
+
+                if ((global->next_timeout_at.tv_sec | global->next_timeout_at.tv_nsec)
+                        && before_than(&global->next_timeout_at, &now_timestamp)) {
+
+                    Context *expired_ctx = scheduler_get_expired_before(global, &now_timestamp);
+                    if (UNLIKELY(!expired_ctx)) {
+                        fprintf(stderr, "Timeout without any expired context, aborting.\n");
+                        abort();
+                    }
+                    scheduler_make_ready(global, expired_ctx);
+                    if (!scheduler_find_min_timeout(global, &global->next_timeout_at)) {
+                        global->next_timeout_at.tv_sec = 0;
+                        global->next_timeout_at.tv_nsec = 0;
+                    }
                 }
 
-            } else if (list_is_empty(&global->ready_processes)) {
+            } else if (list_is_empty(&global->ready_processes) && !collecting) {
 
                 EventListener *listener = malloc(sizeof(EventListener));
                 if (IS_NULL_PTR(listener)) {
@@ -80,17 +106,22 @@ Context *scheduler_wait(GlobalContext *global, Context *c)
                 listener->data = global;
                 listener->handler = scheduler_timeout_callback;
 
-                sys_waitevents(global->listeners);
+                sys_waitevents(global);
             }
-        } else if (list_is_empty(&global->ready_processes)) {
-            if (LIKELY(global->listeners)) {
-                sys_waitevents(global->listeners);
+        } else if (list_is_empty(&global->ready_processes) && !collecting) {
+            // other instances may still send messages through the bridge
+            if (LIKELY(global->listeners || global->bridge)) {
+                sys_waitevents(global);
             } else {
                 fprintf(stderr, "Hang detected\n");
                 abort();
             }
         }
 
+        if (collecting) {
+            scheduler_collect_garbage(global);
+        }
+
         scheduler_execute_native_handlers(global);
     } while (list_is_empty(&global->ready_processes));
 
@@ -112,6 +143,20 @@ Context *scheduler_next(GlobalContext *global, Context *c)
         make_ready_expired_contexts(global);
     }
 
+    if (timerqueue_peek(&global->timers)) {
+        struct timespec now_timestamp;
+        sys_set_timestamp_from_relative_to_abs(&now_timestamp, 0);
+        scheduler_send_expired_timers(global, &now_timestamp);
+    }
+
+    if (bridge_has_messages(global)) {
+        bridge_deliver_messages(global);
+    }
+
+    if (!list_is_empty(&global->deferred_gcs) || global->memory_shrink_pending) {
+        scheduler_collect_garbage(global);
+    }
+
     //TODO: improve scheduling here
     struct ListHead *item;
     struct ListHead *tmp;
@@ -127,6 +172,12 @@ Context *scheduler_next(GlobalContext *global, Context *c)
 
 void scheduler_make_ready(GlobalContext *global, Context *c)
 {
+    // a process that is being collected is made ready when its collection completes
+    if (c->deferred_gc) {
+        c->deferred_gc->ready = 1;
+        return;
+    }
+
     list_remove(&c->processes_list_head);
     list_append(&global->ready_processes, &c->processes_list_head);
 }
@@ -139,10 +190,66 @@ void scheduler_make_waiting(GlobalContext *global, Context *c)
 
 void scheduler_terminate(Context *c)
 {
+    GlobalContext *global = c->global;
+
+    struct ListHead exiting;
+    list_init(&exiting);
+
+    c->exiting = 1;
     list_remove(&c->processes_list_head);
-    if (!c->leader) {
-        context_destroy(c);
+    list_append(&exiting, &c->processes_list_head);
+
+    // processes killed by exit signals are appended to the list while it is walked, they are destroyed
+    // only after all signals have been sent since their exit reasons may refer to each other heaps
+    struct ListHead *item;
+    LIST_FOR_EACH(item, &exiting) {
+        context_propagate_exit(GET_LIST_ENTRY(item, Context, processes_list_head), &exiting);
+    }
+
+    int had_timeout = 0;
+    struct ListHead *tmp;
+    MUTABLE_LIST_FOR_EACH(item, tmp, &exiting) {
+        Context *context = GET_LIST_ENTRY(item, Context, processes_list_head);
+        list_remove(item);
+
+        if (context->timeout_at.tv_sec | context->timeout_at.tv_nsec) {
+            had_timeout = 1;
+        }
+
+        if (context->leader) {
+            list_init(item);
+        } else {
+            context_destroy(context);
+        }
+    }
+
+    if (had_timeout && !scheduler_find_min_timeout(global, &global->next_timeout_at)) {
+        global->next_timeout_at.tv_sec = 0;
+        global->next_timeout_at.tv_nsec = 0;
+    }
+}
+
+Context *scheduler_exit(GlobalContext *global, Context *c)
+{
+    scheduler_terminate(c);
+
+    // the virtual machine runs until the leader terminates
+    if (list_is_empty(&global->ready_processes)) {
+        int leader_is_waiting = 0;
+        struct ListHead *item;
+        LIST_FOR_EACH(item, &global->waiting_processes) {
+            Context *context = GET_LIST_ENTRY(item, Context, processes_list_head);
+            if (context->leader) {
+                leader_is_waiting = 1;
+                break;
+            }
+        }
+        if (!leader_is_waiting) {
+            return NULL;
+        }
     }
+
+    return scheduler_wait_ready(global);
 }
 
 static int make_ready_expired_contexts(GlobalContext *global)
@@ -264,18 +371,125 @@ static int scheduler_find_min_timeout(const GlobalContext *global, struct timesp
     return found_first;
 }
 
-static void scheduler_execute_native_handlers(GlobalContext *global)
+// next timeout is the earliest between processes receive timeouts and VM timers
+static int scheduler_find_next_timeout(const GlobalContext *global, struct timespec *next_timeout)
 {
-    struct ListHead *item;
-    struct ListHead *tmp;
-    MUTABLE_LIST_FOR_EACH(item, tmp, &global->ready_processes) {
-        Context *context = GET_LIST_ENTRY(item, Context, processes_list_head);
+    int found = 0;
+
+    if (global->next_timeout_at.tv_sec | global->next_timeout_at.tv_nsec) {
+        next_timeout->tv_sec = global->next_timeout_at.tv_sec;
+        next_timeout->tv_nsec = global->next_timeout_at.tv_nsec;
+        found = 1;
+    }
+
+    const struct Timer *timer = timerqueue_peek(&global->timers);
+    if (timer && (!found || before_than(&timer->expiral_timestamp, next_timeout))) {
+        next_timeout->tv_sec = timer->expiral_timestamp.tv_sec;
+        next_timeout->tv_nsec = timer->expiral_timestamp.tv_nsec;
+        found = 1;
+    }
+
+    return found;
+}
+
+static void scheduler_send_expired_timers(GlobalContext *global, const struct timespec *now_timestamp)
+{
+    struct Timer *timer;
+
+    while ((timer = timerqueue_peek(&global->timers)) && before_than(&timer->expiral_timestamp, now_timestamp)) {
+        timerqueue_remove(&global->timers, timer);
+
+        // registered names are resolved when the timer expires
+        int local_process_id;
+        if (term_is_atom(timer->dest)) {
+            local_process_id = globalcontext_get_registered_process(global, term_to_atom_index(timer->dest));
+        } else {
+            local_process_id = term_to_local_process_id(timer->dest);
+        }
+        Context *target = local_process_id ? globalcontext_get_process(global, local_process_id) : NULL;
+
+        Message *message = (Message *) timer->data;
+        if (target) {
+            mailbox_enqueue_message(target, message);
+        } else {
+            mailbox_message_destroy(message);
+        }
+        free(timer);
+    }
+}
 
-        if (context->native_handler) {
-            context->native_handler(context);
-            scheduler_make_waiting(global, context);
+// a slice of each collection is run in turn, and a single idle process is shrunk at a time, so a large heap does
+// not stall other processes
+static void scheduler_collect_garbage(GlobalContext *global)
+{
+    if (!list_is_empty(&global->deferred_gcs)) {
+        struct ListHead *item = list_first(&global->deferred_gcs);
+        list_remove(item);
+        list_append(&global->deferred_gcs, item);
+
+        struct DeferredGC *gc = GET_LIST_ENTRY(item, struct DeferredGC, deferred_gcs_list_head);
+        memory_deferred_gc_slice(gc->ctx);
+    }
+
+    if (global->memory_shrink_pending) {
+        scheduler_shrink_idle_process(global);
+    }
+}
+
+// the largest waiting process is shrunk, until none is left or used memory is back below the watermarks
+static void scheduler_shrink_idle_process(GlobalContext *global)
+{
+    size_t target = SIZE_MAX;
+    if (global->memory_budget) {
+        target = global->memory_budget;
+    }
+    if (global->memory_soft_watermark && (global->memory_soft_watermark < target)) {
+        target = global->memory_soft_watermark;
+    }
+
+    // waiting processes are not running, ports are skipped since their drivers may keep terms outside of the heap
+    Context *largest = NULL;
+    if (global->used_memory > target) {
+        struct ListHead *item;
+        LIST_FOR_EACH(item, &global->waiting_processes) {
+            Context *candidate = GET_LIST_ENTRY(item, Context, processes_list_head);
+            // a shrunk process has no free memory left until it allocates again
+            if (!candidate->native_handler && !candidate->deferred_gc
+                    && (context_avail_free_memory(candidate) > MIN_FREE_SPACE_SIZE)
+                    && (!largest || (context_memory_size(candidate) > context_memory_size(largest)))) {
+                largest = candidate;
+            }
         }
     }
+
+    if (!largest) {
+        // a new pass starts only once used memory grows again
+        global->memory_shrink_pending = 0;
+        global->memory_relief_level = global->used_memory + global->memory_soft_watermark / MEMORY_RELIEF_STEP_COEFF;
+        return;
+    }
+
+    memory_gc_and_shrink(largest);
+}
+
+static void scheduler_execute_native_handlers(GlobalContext *global)
+{
+    // a handler may terminate other processes (such as dist proxies), so the list is walked again after each one
+    int executed;
+    do {
+        executed = 0;
+        struct ListHead *item;
+        LIST_FOR_EACH(item, &global->ready_processes) {
+            Context *context = GET_LIST_ENTRY(item, Context, processes_list_head);
+
+            if (context->native_handler) {
+                context->native_handler(context);
+                scheduler_make_waiting(global, context);
+                executed = 1;
+                break;
+            }
+        }
+    } while (executed);
 }
 
 int schudule_processes_count(GlobalContext *global)
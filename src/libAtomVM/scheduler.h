@@ -45,7 +45,8 @@ Context *scheduler_wait(GlobalContext *global, Context *c);
 /**
  * @brief make sure a process is on the ready queue
  *
- * @details make a process ready again by moving it to the ready queue.
+ * @details make a process ready again by moving it to the ready queue, a process that is being collected by the
+ *          scheduler is made ready once its collection completes.
  * @param global the global context.
  * @param c the process context.
  */
@@ -63,12 +64,24 @@ void scheduler_make_waiting(GlobalContext *global, Context *c);
 /**
  * @brief removes a process and terminates it from the scheduling queue
  *
- * @detail removes a process from the scheduling ready queue and destroys it if its not a leader process.
+ * @detail removes a process from the scheduling ready queue and destroys it if its not a leader process,
+ *         exit signals are sent to linked and monitoring processes and linked processes that are killed by them
+ *         are terminated as well.
  * @param global the global context.
  * @param c the process that is going to be terminated.
  */
 void scheduler_terminate(Context *c);
 
+/**
+ * @brief terminates a process and schedules the next one
+ *
+ * @detail terminates a process like scheduler_terminate and then waits until another process is ready.
+ * @param global the global context.
+ * @param c the process that is going to be terminated.
+ * @returns the next runnable process or NULL if no other process is ready and the leader has terminated.
+ */
+Context *scheduler_exit(GlobalContext *global, Context *c);
+
 /**
  * @brief the number of processes
  *
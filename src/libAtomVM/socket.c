@@ -104,14 +104,21 @@ static void socket_consume_mailbox(Context *ctx)
     }
 
     ccontext_release_all_refs(cc);
-    free(message);
+    mailbox_message_destroy(message);
     TRACE("END socket_consume_mailbox\n");
 }
 
+static void socket_destroy(Context *ctx)
+{
+    socket_driver_delete_data(ctx->platform_data);
+    ctx->platform_data = NULL;
+}
+
 void socket_init(Context *ctx, term opts)
 {
     UNUSED(opts);
     void *data = socket_driver_create_data();
     ctx->native_handler = socket_consume_mailbox;
+    ctx->destroy_handler = socket_destroy;
     ctx->platform_data = data;
 }
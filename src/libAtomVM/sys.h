@@ -52,10 +52,35 @@ typedef struct EventListener {
 /**
  * @brief waits platform events
  *
- * @details wait any of the specified events using a platform specific implementation, that might be poll on unix-like systems.
- * @param listeners_list a list of listeners that are waiting for some events, each listener waits an event and has a callback.
+ * @details wait any of the global context listeners events using a platform specific implementation, that might be poll on unix-like systems,
+ *          each listener waits an event and has a callback. Waiting is interrupted by sys_signal.
+ * @param global the global context.
+ */
+void sys_waitevents(GlobalContext *global);
+
+/**
+ * @brief wakes up an instance that is waiting for events
+ *
+ * @details makes sys_waitevents return as soon as possible, or the next time it is called. This function can be called from any thread.
+ * @param global the global context that should be woken up.
+ */
+void sys_signal(GlobalContext *global);
+
+/**
+ * @brief initializes platform specific data of an instance
+ *
+ * @details allocates platform resources that are owned by a global context, such as the ones used by sys_signal.
+ * @param global the global context.
+ * @returns 1 on success, 0 otherwise.
+ */
+int sys_init_platform(GlobalContext *global);
+
+/**
+ * @brief frees platform specific data of an instance
+ *
+ * @param global the global context.
  */
-void sys_waitevents(struct ListHead *listeners_list);
+void sys_free_platform(GlobalContext *global);
 
 /**
  * @brief sets the timestamp for a future event
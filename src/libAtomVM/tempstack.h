@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#ifndef _TEMPSTACK_H_
+#define _TEMPSTACK_H_
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "term_typedef.h"
+
+struct TempStack
+{
+    term *stack_end;
+    term *stack_pos;
+    int size;
+};
+
+static inline void temp_stack_init(struct TempStack *temp_stack)
+{
+    temp_stack->size = 8;
+    temp_stack->stack_end = ((term *) malloc(temp_stack->size * sizeof(term))) + temp_stack->size;
+    temp_stack->stack_pos = temp_stack->stack_end;
+}
+
+static inline void temp_stack_destory(struct TempStack *temp_stack)
+{
+    free(temp_stack->stack_end - temp_stack->size);
+}
+
+static inline void temp_stack_grow(struct TempStack *temp_stack)
+{
+    int old_used_size = temp_stack->stack_end - temp_stack->stack_pos;
+    int new_size = temp_stack->size * 2;
+    term *new_stack_end = ((term *) malloc(new_size * sizeof(term))) + new_size;
+    term *new_stack_pos = new_stack_end - old_used_size;
+    memcpy(new_stack_pos, temp_stack->stack_pos, old_used_size * sizeof(term));
+
+    free(temp_stack->stack_end - temp_stack->size);
+    temp_stack->stack_end = new_stack_end;
+    temp_stack->stack_pos = new_stack_pos;
+    temp_stack->size = new_size;
+}
+
+static inline int temp_stack_is_empty(const struct TempStack *temp_stack)
+{
+    return temp_stack->stack_end == temp_stack->stack_pos;
+}
+
+static inline void temp_stack_push(struct TempStack *temp_stack, term value)
+{
+    if (temp_stack->stack_end - temp_stack->stack_pos == temp_stack->size - 1) {
+        temp_stack_grow(temp_stack);
+    }
+
+    temp_stack->stack_pos--;
+    *temp_stack->stack_pos = value;
+}
+
+static inline term temp_stack_pop(struct TempStack *temp_stack)
+{
+    term value = *temp_stack->stack_pos;
+    temp_stack->stack_pos++;
+
+    return value;
+}
+
+#endif
@@ -44,8 +44,22 @@
 #define TERM_BOXED_TUPLE 0x0
 #define TERM_BOXED_REF 0x10
 #define TERM_BOXED_FUN 0x14
+#define TERM_BOXED_SUB_BINARY 0x20
 #define TERM_BOXED_HEAP_BINARY 0x24
 
+#define TERM_BOXED_REF_SIZE ((sizeof(uint64_t) / sizeof(term)) + 1)
+#define TERM_BOXED_SUB_BINARY_SIZE 4
+#define TERM_EXTERNAL_REF_MAX_IDS 5
+#define TERM_SUB_BINARY_MIN_SIZE (TERM_BYTES * 2)
+
+// small integers are stored in a term with a 4 bits tag, so they have TERM_BITS - 4 bits including the sign
+#if TERM_BITS == 32
+    #define TERM_MAX_SMALL_INT 134217727L
+#else
+    #define TERM_MAX_SMALL_INT 576460752303423487L
+#endif
+#define TERM_MIN_SMALL_INT (-TERM_MAX_SMALL_INT - 1)
+
 /**
  * @brief Gets a pointer to a term stored on the heap
  *
@@ -55,7 +69,11 @@
  */
 static inline term *term_to_term_ptr(term t)
 {
+#ifdef AVM_COMPACT_TERMS
+    return (term *) (memory_terms_base + (t & ~0x3U));
+#else
     return (term *) (t & ~0x3UL);
+#endif
 }
 
 /**
@@ -67,7 +85,28 @@ static inline term *term_to_term_ptr(term t)
  */
 static inline const term *term_to_const_term_ptr(term t)
 {
+#ifdef AVM_COMPACT_TERMS
+    return (const term *) (memory_terms_base + (t & ~0x3U));
+#else
     return (const term *) (t & ~0x3UL);
+#endif
+}
+
+/**
+ * @brief Gets an untagged term from a pointer to the heap
+ *
+ * @details Inverse of term_to_term_ptr, the caller adds the boxed or the list tag. Compact terms store the offset from
+ *          memory_terms_base, so ptr must point to memory allocated with memory_terms_alloc.
+ * @param ptr a pointer to a term stored on the heap, it must be aligned to 4 bytes.
+ * @return an untagged term.
+ */
+static inline term term_from_term_ptr(const term *ptr)
+{
+#ifdef AVM_COMPACT_TERMS
+    return (term) ((const char *) ptr - memory_terms_base);
+#else
+    return (term) ptr;
+#endif
 }
 
 /**
@@ -207,7 +246,7 @@ static inline int term_boxed_size(term t)
 /**
  * @brief Checks if a term is a binary
  *
- * @details Returns 1 if a term is a binary stored on the heap, otherwise 0.
+ * @details Returns 1 if a term is a binary stored on the heap or a sub-binary, otherwise 0.
  * @param t the term that will be checked.
  * @return 1 if check succedes, 0 otherwise.
  */
@@ -216,7 +255,28 @@ static inline int term_is_binary(term t)
     /* boxed: 10 */
     if ((t & 0x3) == 0x2) {
         const term *boxed_value = term_to_const_term_ptr(t);
-        if ((boxed_value[0] & 0x3F) == 0x24) {
+        int boxed_tag = boxed_value[0] & TERM_BOXED_TAG_MASK;
+        if ((boxed_tag == TERM_BOXED_HEAP_BINARY) || (boxed_tag == TERM_BOXED_SUB_BINARY)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Checks if a term is a sub-binary
+ *
+ * @details Returns 1 if a term is a sub-binary, that is a slice of another binary, otherwise 0.
+ * @param t the term that will be checked.
+ * @return 1 if check succedes, 0 otherwise.
+ */
+static inline int term_is_sub_binary(term t)
+{
+    /* boxed: 10 */
+    if ((t & 0x3) == 0x2) {
+        const term *boxed_value = term_to_const_term_ptr(t);
+        if ((boxed_value[0] & TERM_BOXED_TAG_MASK) == TERM_BOXED_SUB_BINARY) {
             return 1;
         }
     }
@@ -384,7 +444,30 @@ static inline int32_t term_to_int32(term t)
             return ((int32_t) t) >> 4;
 
         default:
-            printf("term is not an integer: %lx\n", t);
+            printf("term is not an integer: %lx\n", (unsigned long) t);
+            return 0;
+    }
+}
+
+/**
+ * @brief Term to int64
+ *
+ * @details Returns an int64 for a given term, it is the same as term_to_int32 when terms are 32 bits.
+ * @param t the term that will be converted to int64, term type is checked.
+ * @return a int64 value.
+ */
+static inline int64_t term_to_int64(term t)
+{
+    switch (t & 0xF) {
+        case 0xF:
+#if TERM_BITS == 32
+            return ((int32_t) t) >> 4;
+#else
+            return ((int64_t) t) >> 4;
+#endif
+
+        default:
+            printf("term is not an integer: %lx\n", (unsigned long) t);
             return 0;
     }
 }
@@ -409,7 +492,7 @@ static inline int32_t term_to_local_process_id(term t)
             return t >> 4;
 
         default:
-            printf("term is not a pid: %lx\n", t);
+            printf("term is not a pid: %lx\n", (unsigned long) t);
             return 0;
     }
 }
@@ -448,8 +531,7 @@ static inline term term_from_int11(int16_t value)
 static inline term term_from_int32(int32_t value)
 {
 #if TERM_BITS == 32
-    // 268435455 == 0x0FFFFFFF
-    if (UNLIKELY((value > 268435455) || (value < -268435455))) {
+    if (UNLIKELY((value > TERM_MAX_SMALL_INT) || (value < TERM_MIN_SMALL_INT))) {
         //TODO: unimplemented on heap integer value
         fprintf(stderr, "term_from_int32: unimplemented: term should be moved to heap.");
         abort();
@@ -469,8 +551,7 @@ static inline term term_from_int32(int32_t value)
 static inline term term_from_int64(int64_t value)
 {
 #if TERM_BITS == 32
-    // 268435455 == 0x0FFFFFFF
-    if (UNLIKELY((value > 268435455) || (value < -268435455))) {
+    if (UNLIKELY((value > TERM_MAX_SMALL_INT) || (value < TERM_MIN_SMALL_INT))) {
         //TODO: unimplemented on heap integer value
         fprintf(stderr, "term_from_int64: unimplemented: term should be moved to heap.");
         abort();
@@ -480,8 +561,7 @@ static inline term term_from_int64(int64_t value)
     }
 
 #elif TERM_BITS == 64
-    // 1152921504606846975 = 0x0FFFFFFFFFFFFFFF
-    if (UNLIKELY((value > 1152921504606846975) || (value < -1152921504606846975))) {
+    if (UNLIKELY((value > TERM_MAX_SMALL_INT) || (value < TERM_MIN_SMALL_INT))) {
         //TODO: unimplemented on heap integer value
         fprintf(stderr, "unimplemented: term should be moved to heap.");
         abort();
@@ -513,31 +593,62 @@ static inline term term_from_local_process_id(uint32_t local_process_id)
 }
 
 /**
- * @brief Term from binary data
+ * @brief Gets the number of terms needed to store binary data
  *
- * @details Allocates a binary on the heap, and returns a term pointing to it.
- * @param data binary data.
- * @param size size of binary data buffer.
- * @param ctx the context that owns the memory that will be allocated.
- * @return a term pointing to the boxed binary pointer.
+ * @details Returns the number of terms used to store size bytes of binary data, the binary header is not included.
+ * @param size binary data size in bytes.
+ * @return binary data size in terms.
  */
-static inline term term_from_literal_binary(void *data, uint32_t size, Context *ctx)
+static inline int term_binary_data_size_in_terms(uint32_t size)
 {
 #if TERM_BYTES == 4
-    int size_in_terms = ((size + 4 - 1) >> 2);
+    return ((size + 4 - 1) >> 2);
 #elif TERM_BYTES == 8
-    int size_in_terms = ((size + 8 - 1) >> 3);
+    return ((size + 8 - 1) >> 3);
 #else
     #error
 #endif
+}
+
+/**
+ * @brief Allocates an uninitialized binary
+ *
+ * @details Allocates a binary on the heap whose data must be filled by the caller, padding bytes are zeroed so
+ *          binaries can be compared word by word. memory_ensure_free(ctx, term_binary_data_size_in_terms(size) + 2)
+ *          must be called before.
+ * @param size size of binary data in bytes.
+ * @param ctx the context that owns the memory that will be allocated.
+ * @return a term pointing to the boxed binary pointer.
+ */
+static inline term term_create_uninitialized_binary(uint32_t size, Context *ctx)
+{
+    int size_in_terms = term_binary_data_size_in_terms(size);
 
     term *boxed_value = memory_heap_alloc(ctx, size_in_terms + 2);
-    boxed_value[0] = (size_in_terms << 6) | 0x24; // heap binary
+    boxed_value[0] = ((size_in_terms + 1) << 6) | TERM_BOXED_HEAP_BINARY; // heap binary, size is followed by data
     boxed_value[1] = size;
+    if (size_in_terms) {
+        boxed_value[size_in_terms + 1] = 0;
+    }
 
-    memcpy(boxed_value + 2, data, size);
+    return term_from_term_ptr(boxed_value) | TERM_BOXED_VALUE_TAG;
+}
+
+/**
+ * @brief Term from binary data
+ *
+ * @details Allocates a binary on the heap, and returns a term pointing to it.
+ * @param data binary data.
+ * @param size size of binary data buffer.
+ * @param ctx the context that owns the memory that will be allocated.
+ * @return a term pointing to the boxed binary pointer.
+ */
+static inline term term_from_literal_binary(const void *data, uint32_t size, Context *ctx)
+{
+    term binary = term_create_uninitialized_binary(size, ctx);
+    memcpy(term_to_term_ptr(binary) + 2, data, size);
 
-    return ((term) boxed_value) | TERM_BOXED_VALUE_TAG;
+    return binary;
 }
 
 /**
@@ -560,20 +671,73 @@ static inline term term_binary_size(term t)
 /**
  * @brief Gets binary data
  *
- * @details Returns a pointer to stored binary data.
+ * @details Returns a pointer to stored binary data, sub-binaries point inside their parent binary data.
  * @param t a term pointing to binary data. Fails if t is not a binary term.
  * @return a const char * pointing to binary internal data.
  */
 static inline const char *term_binary_data(term t)
 {
     const term *boxed_value = term_to_const_term_ptr(t);
-    if (boxed_value[0] & 0x3F) {
+    if ((boxed_value[0] & TERM_BOXED_TAG_MASK) == TERM_BOXED_SUB_BINARY) {
+        const term *parent_boxed_value = term_to_const_term_ptr(boxed_value[3]);
+        return ((const char *) (parent_boxed_value + 2)) + boxed_value[2];
+
+    } else if (boxed_value[0] & 0x3F) {
         return (const char *) (boxed_value + 2);
     } else {
         abort();
     }
 }
 
+/**
+ * @brief Gets the heap space required for a binary slice
+ *
+ * @details Returns the number of terms that term_maybe_create_sub_binary will allocate for a slice of given length.
+ * @param len slice length in bytes.
+ * @return required heap space in terms.
+ */
+static inline int term_sub_binary_heap_size(uint32_t len)
+{
+    if (len <= TERM_SUB_BINARY_MIN_SIZE) {
+        return term_binary_data_size_in_terms(len) + 2;
+    } else {
+        return TERM_BOXED_SUB_BINARY_SIZE;
+    }
+}
+
+/**
+ * @brief Creates a slice of a binary
+ *
+ * @details Creates a sub-binary that refers to the given binary, short slices are copied instead since a copy is
+ *          smaller than a sub-binary. Sub-binaries always refer to a heap binary, so slices of sub-binaries refer to
+ *          the original binary. memory_ensure_free(ctx, term_sub_binary_heap_size(len)) must be called before.
+ * @param binary the binary that will be sliced.
+ * @param offset slice offset in bytes.
+ * @param len slice length in bytes.
+ * @param ctx the context that owns the memory that will be allocated.
+ * @return a term pointing to the slice.
+ */
+static inline term term_maybe_create_sub_binary(term binary, uint32_t offset, uint32_t len, Context *ctx)
+{
+    if (len <= TERM_SUB_BINARY_MIN_SIZE) {
+        return term_from_literal_binary(term_binary_data(binary) + offset, len, ctx);
+    }
+
+    const term *boxed_value = term_to_const_term_ptr(binary);
+    if ((boxed_value[0] & TERM_BOXED_TAG_MASK) == TERM_BOXED_SUB_BINARY) {
+        offset += boxed_value[2];
+        binary = boxed_value[3];
+    }
+
+    term *sub_binary = memory_heap_alloc(ctx, TERM_BOXED_SUB_BINARY_SIZE);
+    sub_binary[0] = ((TERM_BOXED_SUB_BINARY_SIZE - 1) << 6) | TERM_BOXED_SUB_BINARY;
+    sub_binary[1] = len;
+    sub_binary[2] = offset;
+    sub_binary[3] = binary;
+
+    return term_from_term_ptr(sub_binary) | TERM_BOXED_VALUE_TAG;
+}
+
 /**
  * @brief Get a ref term from ref ticks
  *
@@ -592,14 +756,14 @@ static inline term term_from_ref_ticks(uint64_t ref_ticks, Context *ctx)
         boxed_value[1] = (term) ref_ticks;
 
     } else if (ref_size == 2) {
-        boxed_value[1] = (ref_ticks >> 4);
+        boxed_value[1] = (ref_ticks >> 32);
         boxed_value[2] = (ref_ticks & 0xFFFFFFFF);
 
     } else {
         abort();
     }
 
-    return ((term) boxed_value) | TERM_BOXED_VALUE_TAG;
+    return term_from_term_ptr(boxed_value) | TERM_BOXED_VALUE_TAG;
 }
 
 static inline uint64_t term_to_ref_ticks(term rt)
@@ -612,7 +776,7 @@ static inline uint64_t term_to_ref_ticks(term rt)
             return boxed_value[1];
 
         } else if (ref_size == 2) {
-            return (boxed_value[1] << 4) | boxed_value[2];
+            return (((uint64_t) boxed_value[1]) << 32) | boxed_value[2];
 
         } else {
             abort();
@@ -623,6 +787,110 @@ static inline uint64_t term_to_ref_ticks(term rt)
     }
 }
 
+/**
+ * @brief Gets the size of an external ref
+ *
+ * @details External refs are refs created by other nodes, they keep the node, the creation and all the ids,
+ *          so they can be sent back to their node. The first 2 ids are also stored as ref ticks.
+ * @param ids_count the number of 32 bits ids.
+ * @return the number of terms (including the boxed header) required for the ref.
+ */
+static inline int term_external_ref_size(int ids_count)
+{
+    return TERM_BOXED_REF_SIZE + 3 + ((ids_count > 2) ? (ids_count - 2) : 0);
+}
+
+/**
+ * @brief Get a ref term from a ref created by another node
+ *
+ * @param node the atom of the node that created the ref.
+ * @param creation the creation of the node that created the ref.
+ * @param ids the ref ids, as found in external term format.
+ * @param ids_count the number of ids, at most TERM_EXTERNAL_REF_MAX_IDS.
+ * @param ctx the context that owns the memory that will be allocated.
+ * @return an external ref term.
+ */
+static inline term term_from_external_ref(term node, uint32_t creation, const uint32_t *ids, int ids_count, Context *ctx)
+{
+    int ref_size = term_external_ref_size(ids_count) - 1;
+    int ticks_size = TERM_BOXED_REF_SIZE - 1;
+    uint64_t ref_ticks = ((ids_count > 1) ? (((uint64_t) ids[1]) << 32) : 0) | ids[0];
+
+    term *boxed_value = memory_heap_alloc(ctx, ref_size + 1);
+    boxed_value[0] = (ref_size << 6) | TERM_BOXED_REF;
+
+    if (ticks_size == 1) {
+        boxed_value[1] = (term) ref_ticks;
+
+    } else if (ticks_size == 2) {
+        boxed_value[1] = (ref_ticks >> 32);
+        boxed_value[2] = (ref_ticks & 0xFFFFFFFF);
+
+    } else {
+        abort();
+    }
+
+    boxed_value[ticks_size + 1] = node;
+    boxed_value[ticks_size + 2] = creation;
+    boxed_value[ticks_size + 3] = ids_count;
+    for (int i = 2; i < ids_count; i++) {
+        boxed_value[ticks_size + 2 + i] = ids[i];
+    }
+
+    return term_from_term_ptr(boxed_value) | TERM_BOXED_VALUE_TAG;
+}
+
+/**
+ * @brief Checks if a ref has been created by another node
+ *
+ * @param t a ref term.
+ * @return 1 if t is an external ref, 0 otherwise.
+ */
+static inline int term_is_external_reference(term t)
+{
+    return term_is_reference(t) && (term_boxed_size(t) > (int) (TERM_BOXED_REF_SIZE - 1));
+}
+
+/**
+ * @brief Gets the node and the creation of an external ref
+ *
+ * @param t an external ref term.
+ * @param creation will be set to the creation of the node.
+ * @return the atom of the node that created the ref.
+ */
+static inline term term_get_external_ref_node(term t, uint32_t *creation)
+{
+    const term *boxed_value = term_to_const_term_ptr(t);
+    int ticks_size = TERM_BOXED_REF_SIZE - 1;
+
+    *creation = boxed_value[ticks_size + 2];
+    return boxed_value[ticks_size + 1];
+}
+
+/**
+ * @brief Gets the ids of an external ref
+ *
+ * @param t an external ref term.
+ * @param ids an array of TERM_EXTERNAL_REF_MAX_IDS ids that will be filled.
+ * @return the number of ids.
+ */
+static inline int term_get_external_ref_ids(term t, uint32_t *ids)
+{
+    const term *boxed_value = term_to_const_term_ptr(t);
+    int ticks_size = TERM_BOXED_REF_SIZE - 1;
+
+    uint64_t ref_ticks = term_to_ref_ticks(t);
+    ids[0] = ref_ticks & 0xFFFFFFFF;
+    ids[1] = ref_ticks >> 32;
+
+    int ids_count = boxed_value[ticks_size + 3];
+    for (int i = 2; i < ids_count; i++) {
+        ids[i] = boxed_value[ticks_size + 2 + i];
+    }
+
+    return ids_count;
+}
+
 /**
  * @brief Allocates a tuple on the heap
  *
@@ -638,7 +906,7 @@ static inline term term_alloc_tuple(uint32_t size, Context *ctx)
     term *boxed_value = memory_heap_alloc(ctx, 1 + size);
     boxed_value[0] = (size << 6); //tuple
 
-    return ((term) boxed_value) | 0x2;
+    return term_from_term_ptr(boxed_value) | 0x2;
 }
 
 /**
@@ -721,12 +989,12 @@ static inline term term_from_string(const uint8_t *data, uint16_t size, Context
     //align constraints here
     term *list_cells = memory_heap_alloc(ctx, size * 2);
     for (int i = 0; i < size * 2; i += 2) {
-        list_cells[i] = (term) &list_cells[i + 2] | 0x1;
+        list_cells[i] = term_from_term_ptr(&list_cells[i + 2]) | 0x1;
         list_cells[i + 1] = term_from_int11(data[i / 2]);
     }
     list_cells[size * 2 - 2] = 0x3B;
 
-    return ((term) list_cells) | 0x1;
+    return term_from_term_ptr(list_cells) | 0x1;
 }
 
 /**
@@ -738,7 +1006,7 @@ static inline term term_from_string(const uint8_t *data, uint16_t size, Context
  */
 static inline term *term_get_list_ptr(term t)
 {
-    return (term *) (t & ~0x1);
+    return term_to_term_ptr(t);
 }
 
 /**
@@ -750,7 +1018,7 @@ static inline term *term_get_list_ptr(term t)
  */
 static inline term term_list_from_list_ptr(term *list_elem)
 {
-    return ((term) list_elem) | 0x1;
+    return term_from_term_ptr(list_elem) | 0x1;
 }
 
 /**
@@ -804,7 +1072,7 @@ static inline term term_list_init_prepend(term *list_elem, term head, term tail)
     list_elem[0] = tail;
     list_elem[1] = head;
 
-    return ((term) list_elem) | 0x1;
+    return term_from_term_ptr(list_elem) | 0x1;
 }
 
 /**
@@ -853,6 +1121,11 @@ static inline int term_exactly_equals(term a, term b)
     if (a == b) {
         return 1;
 
+    } else if (term_is_binary(a) && term_is_binary(b)) {
+        uint32_t a_size = term_binary_size(a);
+        return (a_size == term_binary_size(b))
+            && (memcmp(term_binary_data(a), term_binary_data(b), a_size) == 0);
+
     } else if (term_is_boxed(a) && term_is_boxed(b)) {
         const term *boxed_a = term_to_const_term_ptr(a);
         const term *boxed_b = term_to_const_term_ptr(b);
@@ -884,6 +1157,11 @@ static inline int term_equals(term a, term b)
     if (a == b) {
         return 1;
 
+    } else if (term_is_binary(a) && term_is_binary(b)) {
+        uint32_t a_size = term_binary_size(a);
+        return (a_size == term_binary_size(b))
+            && (memcmp(term_binary_data(a), term_binary_data(b), a_size) == 0);
+
     } else if (term_is_boxed(a) && term_is_boxed(b)) {
         const term *boxed_a = term_to_const_term_ptr(a);
         const term *boxed_b = term_to_const_term_ptr(b);
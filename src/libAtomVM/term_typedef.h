@@ -28,12 +28,36 @@
 #define _TERM_TYPEDEF_H_
 
 #include "limits.h"
+#include <stdint.h>
+
+#ifdef AVM_COMPACT_TERMS
+
+/**
+ * A value of any data type, types bigger than a machine word will require some additional space on heap.
+ * Compact terms are 32 bits also on 64 bits hosts, pointers to the heap are stored as offsets, see term_to_term_ptr.
+ */
+typedef uint32_t term;
+
+/**
+ * A term reinterpreted as a signed value, used to work on tagged integers.
+ */
+typedef int32_t signed_term;
+
+#define TERM_BITS 32
+#define TERM_BYTES 4
+
+#else
 
 /**
  * A value of any data type, types bigger than a machine word will require some additional space on heap.
  */
 typedef unsigned long term;
 
+/**
+ * A term reinterpreted as a signed value, used to work on tagged integers.
+ */
+typedef long signed_term;
+
 #if ULONG_MAX == 4294967295UL
     #define TERM_BITS 32
     #define TERM_BYTES 4
@@ -47,3 +71,5 @@ typedef unsigned long term;
 #endif
 
 #endif
+
+#endif
@@ -0,0 +1,318 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "termhash.h"
+
+#include "module.h"
+#include "tempstack.h"
+#include "utils.h"
+
+// golden ratio and its multiples (mod 2^32), as used by OTP make_hash2
+#define HCONST 0x9E3779B9U
+#define HCONST_2 0x3C6EF372U
+#define HCONST_3 0xDAA66D2BU
+#define HCONST_4 0x78DDE6E4U
+#define HCONST_5 0x1715609DU
+#define HCONST_7 0x5384540FU
+#define HCONST_9 0x8FF34781U
+#define HCONST_10 0x2E2AC13AU
+#define HCONST_11 0xCC623AF3U
+#define HCONST_13 0x08D12E65U
+
+// OTP tag_val_def value for nil
+#define NIL_DEF 0x2
+
+// hash of [] when it is the whole term
+#define NIL_HASH 3468870702U
+
+#define MIX(a, b, c)                  \
+    do {                              \
+        a -= b; a -= c; a ^= (c >> 13); \
+        b -= c; b -= a; b ^= (a << 8);  \
+        c -= a; c -= b; c ^= (b >> 13); \
+        a -= b; a -= c; a ^= (c >> 12); \
+        b -= c; b -= a; b ^= (a << 16); \
+        c -= a; c -= b; c ^= (b >> 5);  \
+        a -= b; a -= c; a ^= (c >> 3);  \
+        b -= c; b -= a; b ^= (a << 10); \
+        c -= a; c -= b; c ^= (b >> 15); \
+    } while (0)
+
+static inline uint32_t load_le32(const uint8_t *p)
+{
+    return p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline uint32_t hash_uint32_2(uint32_t hash, uint32_t v1, uint32_t v2, uint32_t aconst)
+{
+    uint32_t a = aconst + v1;
+    uint32_t b = aconst + v2;
+    MIX(a, b, hash);
+
+    return hash;
+}
+
+static inline uint32_t hash_uint32(uint32_t hash, uint32_t v, uint32_t aconst)
+{
+    return hash_uint32_2(hash, v, 0, aconst);
+}
+
+static uint32_t hash_integer(uint32_t hash, int64_t value)
+{
+    // OTP hashes integers that do not fit 28 bits as bignums
+    if ((value < -(1LL << 27)) || (value >= (1LL << 27))) {
+        uint64_t magnitude = (value < 0) ? -(uint64_t) value : (uint64_t) value;
+        uint32_t con = (value < 0) ? HCONST_10 : HCONST_11;
+        return hash_uint32_2(hash, (uint32_t) magnitude, (uint32_t) (magnitude >> 32), con);
+    }
+
+    int32_t y = (int32_t) value;
+    if (y < 0) {
+        // negative numbers are mixed twice, as OTP does
+        hash = hash_uint32(hash, (uint32_t) -y, HCONST);
+    }
+    return hash_uint32(hash, (uint32_t) y, HCONST);
+}
+
+uint32_t termhash_bytes(const uint8_t *data, size_t len, uint32_t initval)
+{
+    uint32_t a = HCONST;
+    uint32_t b = HCONST;
+    uint32_t c = initval;
+    size_t remaining = len;
+
+    while (remaining >= 12) {
+        a += load_le32(data);
+        b += load_le32(data + 4);
+        c += load_le32(data + 8);
+        MIX(a, b, c);
+        data += 12;
+        remaining -= 12;
+    }
+
+    c += (uint32_t) len;
+    switch (remaining) {
+        case 11: c += ((uint32_t) data[10] << 24); // fall through
+        case 10: c += ((uint32_t) data[9] << 16); // fall through
+        case 9: c += ((uint32_t) data[8] << 8); // fall through
+        case 8: b += ((uint32_t) data[7] << 24); // fall through
+        case 7: b += ((uint32_t) data[6] << 16); // fall through
+        case 6: b += ((uint32_t) data[5] << 8); // fall through
+        case 5: b += data[4]; // fall through
+        case 4: a += ((uint32_t) data[3] << 24); // fall through
+        case 3: a += ((uint32_t) data[2] << 16); // fall through
+        case 2: a += ((uint32_t) data[1] << 8); // fall through
+        case 1: a += data[0]; // fall through
+        default: break;
+    }
+    MIX(a, b, c);
+
+    return c;
+}
+
+uint32_t termhash_atom(AtomString atom_string)
+{
+    const uint8_t *p = (const uint8_t *) atom_string_data(atom_string);
+    int len = atom_string_len(atom_string);
+    uint32_t h = 0;
+
+    while (len--) {
+        uint8_t v = *p++;
+        // atoms are stored as UTF-8, latin1 characters are hashed as a single byte
+        if (len && ((v & 0xFE) == 0xC2) && ((*p & 0xC0) == 0x80)) {
+            v = (v << 6) | (*p & 0x3F);
+            p++;
+            len--;
+        }
+
+        // hashpjw
+        h = (h << 4) + v;
+        uint32_t g = h & 0xF0000000;
+        if (g) {
+            h ^= (g >> 24);
+            h ^= g;
+        }
+    }
+
+    return h;
+}
+
+uint32_t termhash_phash2(term t, GlobalContext *glb)
+{
+    // simple cases are not mixed and do not need a stack
+    if (term_is_atom(t)) {
+        return termhash_atom(globalcontext_atomstring_from_term(glb, t));
+    } else if (term_is_integer(t)) {
+        return hash_integer(0, term_to_int64(t));
+    }
+
+    struct TempStack temp_stack;
+    temp_stack_init(&temp_stack);
+
+    uint32_t hash = 0;
+
+    while (1) {
+        if (term_is_nonempty_list(t)) {
+            // strings are hashed 4 characters at a time
+            uint32_t sh = 0;
+            int c = 0;
+            term head = term_get_list_head(t);
+            while (term_is_integer(head) && (term_to_int64(head) >= 0) && (term_to_int64(head) <= 255)) {
+                sh = (sh << 8) + (uint32_t) term_to_int64(head);
+                if (c == 3) {
+                    hash = hash_uint32(hash, sh, HCONST_4);
+                    c = 0;
+                    sh = 0;
+                } else {
+                    c++;
+                }
+                t = term_get_list_tail(t);
+                if (!term_is_nonempty_list(t)) {
+                    break;
+                }
+                head = term_get_list_head(t);
+            }
+            if (c > 0) {
+                hash = hash_uint32(hash, sh, HCONST_4);
+            }
+            if (term_is_nonempty_list(t)) {
+                temp_stack_push(&temp_stack, term_get_list_tail(t));
+                t = term_get_list_head(t);
+            }
+            continue;
+
+        } else if (term_is_tuple(t)) {
+            int arity = term_get_tuple_arity(t);
+            hash = hash_uint32(hash, arity, HCONST_9);
+            if (arity > 0) {
+                for (int i = arity - 1; i > 0; i--) {
+                    temp_stack_push(&temp_stack, term_get_tuple_element(t, i));
+                }
+                t = term_get_tuple_element(t, 0);
+                continue;
+            }
+
+        } else if (term_is_function(t)) {
+            const term *boxed_value = term_to_const_term_ptr(t);
+            // module and fun table entry are followed by frozen values
+            uint32_t n_freeze = term_boxed_size(t) - 2;
+            // module name and uniq are not available, module index and fun index are used instead
+#ifdef AVM_COMPACT_TERMS
+            uint32_t module_index = boxed_value[1];
+            uint32_t fun_index = boxed_value[2];
+#else
+            const Module *fun_module = (const Module *) boxed_value[1];
+            uint32_t module_index = fun_module->module_index;
+            uint32_t fun_index = (const struct ModuleFun *) boxed_value[2] - fun_module->funs;
+#endif
+            hash = hash_uint32_2(hash, n_freeze, module_index, HCONST);
+            hash = hash_uint32_2(hash, fun_index, 0, HCONST);
+            if (n_freeze > 0) {
+                for (uint32_t i = n_freeze - 1; i > 0; i--) {
+                    temp_stack_push(&temp_stack, boxed_value[3 + i]);
+                }
+                t = boxed_value[3];
+                continue;
+            }
+
+        } else if (term_is_binary(t)) {
+            uint32_t con = HCONST_13 + hash;
+            int len = term_binary_size(t);
+            if (len == 0) {
+                hash = con;
+            } else {
+                hash = termhash_bytes((const uint8_t *) term_binary_data(t), len, con);
+            }
+
+        } else if (term_is_reference(t)) {
+            hash = hash_uint32(hash, (uint32_t) term_to_ref_ticks(t), HCONST_7);
+
+        } else if (term_is_pid(t)) {
+            hash = hash_uint32(hash, term_to_local_process_id(t), HCONST_5);
+
+        } else if (term_is_atom(t)) {
+            uint32_t atom_hash = termhash_atom(globalcontext_atomstring_from_term(glb, t));
+            hash = (hash == 0) ? atom_hash : hash_uint32(hash, atom_hash, HCONST_3);
+
+        } else if (term_is_nil(t)) {
+            hash = (hash == 0) ? NIL_HASH : hash_uint32(hash, NIL_DEF, HCONST_2);
+
+        } else if (term_is_integer(t)) {
+            hash = hash_integer(hash, term_to_int64(t));
+
+        } else {
+            abort();
+        }
+
+        if (temp_stack_is_empty(&temp_stack)) {
+            break;
+        }
+        t = temp_stack_pop(&temp_stack);
+    }
+
+    temp_stack_destory(&temp_stack);
+
+    return hash;
+}
+
+int termhash_equals(term a, term b)
+{
+    struct TempStack temp_stack;
+    temp_stack_init(&temp_stack);
+
+    int equals = 1;
+
+    while (1) {
+        if (a == b) {
+            // same immediate or same boxed value
+
+        } else if (term_is_nonempty_list(a) && term_is_nonempty_list(b)) {
+            temp_stack_push(&temp_stack, term_get_list_tail(a));
+            temp_stack_push(&temp_stack, term_get_list_tail(b));
+            a = term_get_list_head(a);
+            b = term_get_list_head(b);
+            continue;
+
+        } else if (term_is_tuple(a) && term_is_tuple(b)) {
+            int arity = term_get_tuple_arity(a);
+            if (arity != term_get_tuple_arity(b)) {
+                equals = 0;
+                break;
+            }
+            for (int i = 0; i < arity; i++) {
+                temp_stack_push(&temp_stack, term_get_tuple_element(a, i));
+                temp_stack_push(&temp_stack, term_get_tuple_element(b, i));
+            }
+
+        } else if (!term_exactly_equals(a, b)) {
+            equals = 0;
+            break;
+        }
+
+        if (temp_stack_is_empty(&temp_stack)) {
+            break;
+        }
+        b = temp_stack_pop(&temp_stack);
+        a = temp_stack_pop(&temp_stack);
+    }
+
+    temp_stack_destory(&temp_stack);
+
+    return equals;
+}
@@ -0,0 +1,81 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file termhash.h
+ * @brief Portable term hashing.
+ *
+ * @details Implements the same hashing used by erlang:phash2/1,2, so hash values match the ones
+ *          computed by OTP for integers, atoms, lists, tuples and binaries. Terms are walked
+ *          iteratively, so deep structures do not consume C stack. Any table keyed by terms
+ *          (maps, ETS-like tables, consistent hashing) should use these functions.
+ */
+
+#ifndef _TERMHASH_H_
+#define _TERMHASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "atom.h"
+#include "globalcontext.h"
+#include "term.h"
+
+/**
+ * @brief Hashes a block of bytes
+ *
+ * @details Bob Jenkins' lookup2 hash, it is used for binaries by termhash_phash2.
+ * @param data the bytes that will be hashed.
+ * @param len data length in bytes.
+ * @param initval previous hash value or any arbitrary value.
+ * @returns the hash of given bytes.
+ */
+uint32_t termhash_bytes(const uint8_t *data, size_t len, uint32_t initval);
+
+/**
+ * @brief Hashes an atom string
+ *
+ * @details Computes the same value that OTP atom table uses for given atom name.
+ * @param atom_string the atom string that will be hashed.
+ * @returns the hash of given atom name.
+ */
+uint32_t termhash_atom(AtomString atom_string);
+
+/**
+ * @brief Computes the portable hash of a term
+ *
+ * @details The returned value is the full 32 bits hash, erlang:phash2/1 keeps only the lower 27 bits.
+ * @param t the term that will be hashed.
+ * @param glb the global context, required to get atom names.
+ * @returns the 32 bits hash of given term.
+ */
+uint32_t termhash_phash2(term t, GlobalContext *glb);
+
+/**
+ * @brief Checks if two keys are exactly equal
+ *
+ * @details Unlike term_exactly_equals, lists and tuples are compared element by element, so this
+ *          function can be used together with termhash_phash2 as key equality of hashed tables.
+ * @param a first term
+ * @param b second term
+ * @returns 1 if given terms are exactly equal, 0 otherwise.
+ */
+int termhash_equals(term a, term b);
+
+#endif
@@ -0,0 +1,192 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "timerqueue.h"
+
+#include <stdlib.h>
+
+#include "utils.h"
+
+#define INITIAL_HEAP_CAPACITY 16
+#define INITIAL_BUCKETS_COUNT 16
+
+static inline int timer_before(const struct Timer *a, const struct Timer *b)
+{
+    if (a->expiral_timestamp.tv_sec != b->expiral_timestamp.tv_sec) {
+        return a->expiral_timestamp.tv_sec < b->expiral_timestamp.tv_sec;
+    }
+    if (a->expiral_timestamp.tv_nsec != b->expiral_timestamp.tv_nsec) {
+        return a->expiral_timestamp.tv_nsec < b->expiral_timestamp.tv_nsec;
+    }
+    // timers with the same timestamp expire in creation order
+    return a->ref_ticks < b->ref_ticks;
+}
+
+static inline int bucket_index(const struct TimerQueue *tq, uint64_t ref_ticks)
+{
+    return ref_ticks & (tq->buckets_count - 1);
+}
+
+static inline void heap_set(struct TimerQueue *tq, int index, struct Timer *timer)
+{
+    tq->heap[index] = timer;
+    timer->heap_index = index;
+}
+
+static void heap_sift_up(struct TimerQueue *tq, int index)
+{
+    struct Timer *timer = tq->heap[index];
+
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!timer_before(timer, tq->heap[parent])) {
+            break;
+        }
+        heap_set(tq, index, tq->heap[parent]);
+        index = parent;
+    }
+
+    heap_set(tq, index, timer);
+}
+
+static void heap_sift_down(struct TimerQueue *tq, int index)
+{
+    struct Timer *timer = tq->heap[index];
+
+    while (1) {
+        int child = index * 2 + 1;
+        if (child >= tq->count) {
+            break;
+        }
+        if ((child + 1 < tq->count) && timer_before(tq->heap[child + 1], tq->heap[child])) {
+            child++;
+        }
+        if (!timer_before(tq->heap[child], timer)) {
+            break;
+        }
+        heap_set(tq, index, tq->heap[child]);
+        index = child;
+    }
+
+    heap_set(tq, index, timer);
+}
+
+static int buckets_grow(struct TimerQueue *tq)
+{
+    int new_buckets_count = tq->buckets_count ? tq->buckets_count * 2 : INITIAL_BUCKETS_COUNT;
+    struct Timer **new_buckets = calloc(new_buckets_count, sizeof(struct Timer *));
+    if (IS_NULL_PTR(new_buckets)) {
+        return 0;
+    }
+
+    struct Timer **old_buckets = tq->buckets;
+    int old_buckets_count = tq->buckets_count;
+    tq->buckets = new_buckets;
+    tq->buckets_count = new_buckets_count;
+
+    for (int i = 0; i < old_buckets_count; i++) {
+        struct Timer *timer = old_buckets[i];
+        while (timer) {
+            struct Timer *next = timer->next_in_bucket;
+            int index = bucket_index(tq, timer->ref_ticks);
+            timer->next_in_bucket = new_buckets[index];
+            new_buckets[index] = timer;
+            timer = next;
+        }
+    }
+    free(old_buckets);
+
+    return 1;
+}
+
+void timerqueue_init(struct TimerQueue *tq)
+{
+    tq->heap = NULL;
+    tq->count = 0;
+    tq->capacity = 0;
+    tq->buckets = NULL;
+    tq->buckets_count = 0;
+}
+
+void timerqueue_destroy(struct TimerQueue *tq)
+{
+    free(tq->heap);
+    free(tq->buckets);
+    timerqueue_init(tq);
+}
+
+int timerqueue_insert(struct TimerQueue *tq, struct Timer *timer)
+{
+    if (tq->count == tq->capacity) {
+        int new_capacity = tq->capacity ? tq->capacity * 2 : INITIAL_HEAP_CAPACITY;
+        struct Timer **new_heap = realloc(tq->heap, new_capacity * sizeof(struct Timer *));
+        if (IS_NULL_PTR(new_heap)) {
+            return 0;
+        }
+        tq->heap = new_heap;
+        tq->capacity = new_capacity;
+    }
+    if ((tq->count >= tq->buckets_count) && !buckets_grow(tq)) {
+        return 0;
+    }
+
+    int index = bucket_index(tq, timer->ref_ticks);
+    timer->next_in_bucket = tq->buckets[index];
+    tq->buckets[index] = timer;
+
+    heap_set(tq, tq->count, timer);
+    tq->count++;
+    heap_sift_up(tq, tq->count - 1);
+
+    return 1;
+}
+
+struct Timer *timerqueue_find(const struct TimerQueue *tq, uint64_t ref_ticks)
+{
+    if (!tq->count) {
+        return NULL;
+    }
+
+    struct Timer *timer = tq->buckets[bucket_index(tq, ref_ticks)];
+    while (timer && (timer->ref_ticks != ref_ticks)) {
+        timer = timer->next_in_bucket;
+    }
+
+    return timer;
+}
+
+void timerqueue_remove(struct TimerQueue *tq, struct Timer *timer)
+{
+    struct Timer **bucket_ptr = &tq->buckets[bucket_index(tq, timer->ref_ticks)];
+    while (*bucket_ptr != timer) {
+        bucket_ptr = &(*bucket_ptr)->next_in_bucket;
+    }
+    *bucket_ptr = timer->next_in_bucket;
+
+    int index = timer->heap_index;
+    tq->count--;
+    if (index != tq->count) {
+        heap_set(tq, index, tq->heap[tq->count]);
+        if ((index > 0) && timer_before(tq->heap[index], tq->heap[(index - 1) / 2])) {
+            heap_sift_up(tq, index);
+        } else {
+            heap_sift_down(tq, index);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file timerqueue.h
+ * @brief VM timers queue.
+ *
+ * @details Timers are kept in a binary min-heap ordered by expiral timestamp, and they are also indexed by
+ *          their reference, so insertion, removal and lookup by reference are O(log n).
+ */
+
+#ifndef _TIMERQUEUE_H_
+#define _TIMERQUEUE_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include "term.h"
+
+struct Timer
+{
+    struct timespec expiral_timestamp;
+    uint64_t ref_ticks;
+    // timer destination, either a pid or a registered name (atom)
+    term dest;
+    // owned by the timer user, such as the message that will be sent
+    void *data;
+
+    int heap_index;
+    struct Timer *next_in_bucket;
+};
+
+struct TimerQueue
+{
+    struct Timer **heap;
+    int count;
+    int capacity;
+
+    struct Timer **buckets;
+    int buckets_count;
+};
+
+/**
+ * @brief Initializes an empty timers queue
+ *
+ * @param tq the timers queue that will be initialized.
+ */
+void timerqueue_init(struct TimerQueue *tq);
+
+/**
+ * @brief Frees timers queue memory
+ *
+ * @details Frees queue internal memory, timers that are still queued are not freed.
+ * @param tq the timers queue.
+ */
+void timerqueue_destroy(struct TimerQueue *tq);
+
+/**
+ * @brief Inserts a timer
+ *
+ * @details Inserts a timer, its expiral_timestamp and ref_ticks must be already set.
+ * @param tq the timers queue.
+ * @param timer the timer that will be inserted, it is owned by the queue until removed.
+ * @returns 1 on success, 0 if memory could not be allocated.
+ */
+int timerqueue_insert(struct TimerQueue *tq, struct Timer *timer);
+
+/**
+ * @brief Finds a timer by reference
+ *
+ * @param tq the timers queue.
+ * @param ref_ticks the timer reference ticks.
+ * @returns the timer or NULL if there is no such timer in the queue.
+ */
+struct Timer *timerqueue_find(const struct TimerQueue *tq, uint64_t ref_ticks);
+
+/**
+ * @brief Removes a timer
+ *
+ * @param tq the timers queue.
+ * @param timer a timer that is in the queue.
+ */
+void timerqueue_remove(struct TimerQueue *tq, struct Timer *timer);
+
+/**
+ * @brief Gets the timer that expires first
+ *
+ * @param tq the timers queue.
+ * @returns the timer with the smallest expiral timestamp or NULL if the queue is empty.
+ */
+static inline struct Timer *timerqueue_peek(const struct TimerQueue *tq)
+{
+    return tq->count ? tq->heap[0] : NULL;
+}
+
+#endif
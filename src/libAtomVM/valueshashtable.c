@@ -50,6 +50,47 @@ struct ValuesHashTable *valueshashtable_new()
     return htable;
 }
 
+void valueshashtable_destroy(struct ValuesHashTable *hash_table)
+{
+    for (int i = 0; i < hash_table->capacity; i++) {
+        struct HNode *node = hash_table->buckets[i];
+        while (node) {
+            struct HNode *next = node->next;
+            free(node);
+            node = next;
+        }
+    }
+
+    free(hash_table->buckets);
+    free(hash_table);
+}
+
+// buckets are doubled when they hold on average more than 2 nodes, so lookups stay O(1) as the table grows
+static void valueshashtable_grow(struct ValuesHashTable *hash_table)
+{
+    int new_capacity = hash_table->capacity * 2;
+    struct HNode **new_buckets = calloc(new_capacity, sizeof(struct HNode *));
+    if (IS_NULL_PTR(new_buckets)) {
+        // the table is still consistent, just slower
+        return;
+    }
+
+    for (int i = 0; i < hash_table->capacity; i++) {
+        struct HNode *node = hash_table->buckets[i];
+        while (node) {
+            struct HNode *next = node->next;
+            long index = node->key % new_capacity;
+            node->next = new_buckets[index];
+            new_buckets[index] = node;
+            node = next;
+        }
+    }
+
+    free(hash_table->buckets);
+    hash_table->buckets = new_buckets;
+    hash_table->capacity = new_capacity;
+}
+
 int valueshashtable_insert(struct ValuesHashTable *hash_table, unsigned long key, unsigned long value)
 {
     long index = key % hash_table->capacity;
@@ -85,9 +126,33 @@ int valueshashtable_insert(struct ValuesHashTable *hash_table, unsigned long key
     }
 
     hash_table->count++;
+    if (hash_table->count > hash_table->capacity * 2) {
+        valueshashtable_grow(hash_table);
+    }
+
     return 1;
 }
 
+int valueshashtable_remove(struct ValuesHashTable *hash_table, unsigned long key)
+{
+    long index = key % hash_table->capacity;
+
+    struct HNode **node_ptr = &hash_table->buckets[index];
+    while (*node_ptr) {
+        struct HNode *node = *node_ptr;
+        if (node->key == key) {
+            *node_ptr = node->next;
+            free(node);
+            hash_table->count--;
+            return 1;
+        }
+
+        node_ptr = &node->next;
+    }
+
+    return 0;
+}
+
 unsigned long valueshashtable_get_value(const struct ValuesHashTable *hash_table, unsigned long key, unsigned long default_value)
 {
     long index = key % hash_table->capacity;
@@ -119,3 +184,14 @@ int valueshashtable_has_key(const struct ValuesHashTable *hash_table, unsigned l
 
     return 0;
 }
+
+void valueshashtable_foreach(const struct ValuesHashTable *hash_table, valueshashtable_visitor visitor, void *data)
+{
+    for (int i = 0; i < hash_table->capacity; i++) {
+        const struct HNode *node = hash_table->buckets[i];
+        while (node) {
+            visitor(node->key, node->value, data);
+            node = node->next;
+        }
+    }
+}
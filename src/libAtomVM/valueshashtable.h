@@ -27,9 +27,14 @@ struct ValuesHashTable
     struct HNode **buckets;
 };
 
+typedef void (*valueshashtable_visitor)(unsigned long key, unsigned long value, void *data);
+
 struct ValuesHashTable *valueshashtable_new();
+void valueshashtable_destroy(struct ValuesHashTable *hash_table);
 int valueshashtable_insert(struct ValuesHashTable *hash_table, unsigned long key, unsigned long value);
+int valueshashtable_remove(struct ValuesHashTable *hash_table, unsigned long key);
 unsigned long valueshashtable_get_value(const struct ValuesHashTable *hash_table, unsigned long key, unsigned long default_value);
 int valueshashtable_has_key(const struct ValuesHashTable *hash_table, unsigned long key);
+void valueshashtable_foreach(const struct ValuesHashTable *hash_table, valueshashtable_visitor visitor, void *data);
 
 #endif
@@ -0,0 +1,151 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "zlibstream.h"
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "list.h"
+#include "utils.h"
+
+#define ZLIB_MIN_OUTPUT_SPACE 4096
+
+// zlib takes uInt lengths, so huge buffers are split
+#define ZLIB_MAX_CHUNK (UINT_MAX & ~0xFFFU)
+
+struct ZlibStream *zlibstream_new(Context *ctx, uint64_t ref_ticks)
+{
+    struct ZlibStream *stream = calloc(1, sizeof(struct ZlibStream));
+    if (IS_NULL_PTR(stream)) {
+        return NULL;
+    }
+    stream->ref_ticks = ref_ticks;
+    stream->mode = ZlibStreamIdle;
+    list_append(&ctx->zlib_streams, &stream->stream_list_head);
+
+    return stream;
+}
+
+struct ZlibStream *zlibstream_find(Context *ctx, uint64_t ref_ticks)
+{
+    struct ListHead *item;
+    LIST_FOR_EACH(item, &ctx->zlib_streams) {
+        struct ZlibStream *stream = GET_LIST_ENTRY(item, struct ZlibStream, stream_list_head);
+        if (stream->ref_ticks == ref_ticks) {
+            return stream;
+        }
+    }
+
+    return NULL;
+}
+
+void zlibstream_end(struct ZlibStream *stream)
+{
+    switch (stream->mode) {
+        case ZlibStreamDeflate:
+            deflateEnd(&stream->zs);
+            break;
+
+        case ZlibStreamInflate:
+            inflateEnd(&stream->zs);
+            break;
+
+        case ZlibStreamIdle:
+            break;
+    }
+    stream->mode = ZlibStreamIdle;
+}
+
+void zlibstream_destroy(struct ZlibStream *stream)
+{
+    zlibstream_end(stream);
+    list_remove(&stream->stream_list_head);
+    free(stream);
+}
+
+void zlibstream_destroy_all(Context *ctx)
+{
+    struct ListHead *item;
+    struct ListHead *tmp;
+    MUTABLE_LIST_FOR_EACH(item, tmp, &ctx->zlib_streams) {
+        zlibstream_destroy(GET_LIST_ENTRY(item, struct ZlibStream, stream_list_head));
+    }
+}
+
+static int zlibstream_reserve_output(struct ZlibBuffer *out)
+{
+    if (out->size - out->len >= ZLIB_MIN_OUTPUT_SPACE) {
+        return 1;
+    }
+
+    size_t new_size = out->size ? out->size * 2 : ZLIB_MIN_OUTPUT_SPACE * 2;
+    uint8_t *new_data = realloc(out->data, new_size);
+    if (IS_NULL_PTR(new_data)) {
+        return 0;
+    }
+    out->data = new_data;
+    out->size = new_size;
+
+    return 1;
+}
+
+int zlibstream_process(z_stream *zs, enum ZlibStreamMode mode, const uint8_t *data, size_t len, int flush, struct ZlibBuffer *out)
+{
+    int ret = Z_OK;
+
+    do {
+        size_t chunk_len = (len > ZLIB_MAX_CHUNK) ? ZLIB_MAX_CHUNK : len;
+        // partial flushes are done only once the whole input has been given
+        int chunk_flush = (chunk_len == len) ? flush : Z_NO_FLUSH;
+        zs->next_in = (Bytef *) data;
+        zs->avail_in = chunk_len;
+        data += chunk_len;
+        len -= chunk_len;
+
+        do {
+            if (UNLIKELY(!zlibstream_reserve_output(out))) {
+                return Z_MEM_ERROR;
+            }
+            size_t avail_out = out->size - out->len;
+            if (avail_out > ZLIB_MAX_CHUNK) {
+                avail_out = ZLIB_MAX_CHUNK;
+            }
+            zs->next_out = out->data + out->len;
+            zs->avail_out = avail_out;
+
+            ret = (mode == ZlibStreamDeflate) ? deflate(zs, chunk_flush) : inflate(zs, chunk_flush);
+            out->len += avail_out - zs->avail_out;
+
+            if (ret == Z_BUF_ERROR) {
+                // no progress was possible: all input is consumed and there is nothing left to flush
+                ret = Z_OK;
+                break;
+            } else if (ret != Z_OK) {
+                break;
+            }
+        } while ((zs->avail_in > 0) || (zs->avail_out == 0));
+
+        if ((ret != Z_OK) && (ret != Z_STREAM_END)) {
+            return ret;
+        }
+    } while (len > 0 && ret != Z_STREAM_END);
+
+    return ret;
+}
@@ -0,0 +1,121 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+/**
+ * @file zlibstream.h
+ * @brief zlib streams used by zlib module NIFs.
+ *
+ * @details A stream is owned by the process that opened it and it is identified by a reference.
+ *          Streams that have not been closed are freed when their owner is destroyed.
+ *          This file is built only when zlib is available (WITH_ZLIB).
+ */
+
+#ifndef _ZLIBSTREAM_H_
+#define _ZLIBSTREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zlib.h>
+
+#include "context.h"
+#include "linkedlist.h"
+
+// window bits for zlib:compress/1 and zlib:gzip/1 formats
+#define ZLIBSTREAM_ZLIB_WINDOW_BITS 15
+#define ZLIBSTREAM_GZIP_WINDOW_BITS (15 + 16)
+
+enum ZlibStreamMode
+{
+    ZlibStreamIdle,
+    ZlibStreamDeflate,
+    ZlibStreamInflate
+};
+
+struct ZlibStream
+{
+    struct ListHead stream_list_head;
+    uint64_t ref_ticks;
+    enum ZlibStreamMode mode;
+    z_stream zs;
+};
+
+/**
+ * @brief A malloc-ed output buffer, grown as needed.
+ */
+struct ZlibBuffer
+{
+    uint8_t *data;
+    size_t len;
+    size_t size;
+};
+
+/**
+ * @brief Creates a new idle stream owned by a process
+ *
+ * @param ctx the owner process.
+ * @param ref_ticks the reference that identifies the stream.
+ * @returns the new stream or NULL on allocation failure.
+ */
+struct ZlibStream *zlibstream_new(Context *ctx, uint64_t ref_ticks);
+
+/**
+ * @brief Finds a stream owned by a process
+ *
+ * @param ctx the owner process.
+ * @param ref_ticks the reference returned by zlib:open/0.
+ * @returns the stream or NULL if the process does not own such stream.
+ */
+struct ZlibStream *zlibstream_find(Context *ctx, uint64_t ref_ticks);
+
+/**
+ * @brief Ends deflate or inflate on a stream, the stream becomes idle.
+ *
+ * @param stream the stream.
+ */
+void zlibstream_end(struct ZlibStream *stream);
+
+/**
+ * @brief Ends and frees a stream.
+ *
+ * @param stream the stream that will be removed from its owner list and freed.
+ */
+void zlibstream_destroy(struct ZlibStream *stream);
+
+/**
+ * @brief Frees all the streams owned by a process.
+ *
+ * @param ctx the process that is going to be destroyed.
+ */
+void zlibstream_destroy_all(Context *ctx);
+
+/**
+ * @brief Runs deflate or inflate on given input
+ *
+ * @details All input is consumed and the output is appended to out, that is grown as needed.
+ * @param zs an initialized z_stream.
+ * @param mode either ZlibStreamDeflate or ZlibStreamInflate.
+ * @param data input bytes.
+ * @param len input length.
+ * @param flush zlib flush value.
+ * @param out the buffer where output is appended.
+ * @returns Z_OK or Z_STREAM_END on success, a zlib error code otherwise.
+ */
+int zlibstream_process(z_stream *zs, enum ZlibStreamMode mode, const uint8_t *data, size_t len, int flush, struct ZlibBuffer *out);
+
+#endif
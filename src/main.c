@@ -86,7 +86,7 @@ int main(int argc, char **argv)
     context_execute_loop(ctx, mod, "start", 0);
 
     term ret_value = ctx->x[0];
-    printf("Return value: %lx\n", ret_value);
+    printf("Return value: %lx\n", (unsigned long) ret_value);
 
     term ok_atom = context_make_atom(ctx, ok_a);
 
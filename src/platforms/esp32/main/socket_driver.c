@@ -57,13 +57,24 @@ typedef struct SocketDriverData
 void *socket_driver_create_data()
 {
     struct SocketDriverData *data = calloc(1, sizeof(struct SocketDriverData));
+    if (IS_NULL_PTR(data)) {
+        return NULL;
+    }
+    data->sockfd = -1;
     return (void *) data;
 }
 
 
 void socket_driver_delete_data(void *data)
 {
-    free(data);
+    SocketDriverData *socket_data = (SocketDriverData *) data;
+    if (!socket_data) {
+        return;
+    }
+    if (socket_data->sockfd != -1) {
+        close(socket_data->sockfd);
+    }
+    free(socket_data);
 }
 
 
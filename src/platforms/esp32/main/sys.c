@@ -27,6 +27,7 @@
 #include "network.h"
 
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "esp_system.h"
 #include "esp_event.h"
 #include "esp_event_loop.h"
@@ -45,39 +46,77 @@ static int32_t timespec_diff_to_ms(struct timespec *timespec1, struct timespec *
     return (timespec1->tv_sec - timespec2->tv_sec) * 1000 + (timespec1->tv_nsec - timespec2->tv_nsec) / 1000000;
 }
 
-extern void sys_waitevents(struct ListHead *listeners_list)
+struct ESP32PlatformData
 {
+    // given by sys_signal, so sys_waitevents stops waiting
+    SemaphoreHandle_t signal_semaphore;
+};
+
+int sys_init_platform(GlobalContext *global)
+{
+    struct ESP32PlatformData *platform = malloc(sizeof(struct ESP32PlatformData));
+    if (IS_NULL_PTR(platform)) {
+        return 0;
+    }
+    platform->signal_semaphore = xSemaphoreCreateBinary();
+    if (IS_NULL_PTR(platform->signal_semaphore)) {
+        free(platform);
+        return 0;
+    }
+    global->platform_data = platform;
+
+    return 1;
+}
+
+void sys_free_platform(GlobalContext *global)
+{
+    struct ESP32PlatformData *platform = global->platform_data;
+    vSemaphoreDelete(platform->signal_semaphore);
+    free(platform);
+}
+
+void sys_signal(GlobalContext *global)
+{
+    struct ESP32PlatformData *platform = global->platform_data;
+    xSemaphoreGive(platform->signal_semaphore);
+}
+
+extern void sys_waitevents(GlobalContext *global)
+{
+    struct ESP32PlatformData *platform = global->platform_data;
+    struct ListHead *listeners_list = global->listeners;
+
     struct timespec now;
     sys_clock_gettime(&now);
 
-    EventListener *listeners = GET_LIST_ENTRY(listeners_list, EventListener, listeners_list_head);
+    EventListener *listeners = NULL;
 
     int min_timeout = INT_MAX;
-    int count = 0;
-
-    //first: find maximum allowed sleep time, and count file descriptor listeners
-    EventListener *listener = listeners;
-    do {
-        if (listener->expires) {
-            int wait_ms = timespec_diff_to_ms(&listener->expiral_timestamp, &now);
-            if (wait_ms <= 0) {
-                min_timeout = 0;
-            } else if (min_timeout > wait_ms) {
-                min_timeout = wait_ms;
+
+    //first: find maximum allowed sleep time
+    if (listeners_list) {
+        listeners = GET_LIST_ENTRY(listeners_list, EventListener, listeners_list_head);
+
+        EventListener *listener = listeners;
+        do {
+            if (listener->expires) {
+                int wait_ms = timespec_diff_to_ms(&listener->expiral_timestamp, &now);
+                if (wait_ms <= 0) {
+                    min_timeout = 0;
+                } else if (min_timeout > wait_ms) {
+                    min_timeout = wait_ms;
+                }
             }
-        }
-        if (listener->fd >= 0) {
-            count++;
-        }
 
-        listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
-    } while (listener != listeners);
+            listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
+        } while (listener != listeners);
+    }
 
-    vTaskDelay(min_timeout / portTICK_PERIOD_MS);
+    xSemaphoreTake(platform->signal_semaphore, (min_timeout == INT_MAX) ? portMAX_DELAY : min_timeout / portTICK_PERIOD_MS);
 
     //second: execute handlers for expiered timers
-    if (min_timeout != INT_MAX) {
-        listener = listeners;
+    if (listeners && (min_timeout != INT_MAX)) {
+        EventListener *listener = listeners;
         sys_clock_gettime(&now);
         do {
             EventListener *next_listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
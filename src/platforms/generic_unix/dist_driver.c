@@ -0,0 +1,229 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include "dist_driver.h"
+
+#include "globalcontext.h"
+#include "linkedlist.h"
+#include "sys.h"
+#include "utils.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+//#define ENABLE_TRACE
+
+#include "trace.h"
+
+#define DIST_RECV_BUFSIZE 4096
+
+struct DistDriverSocket
+{
+    int fd;
+    EventListener listener;
+    GlobalContext *global;
+    // set for connection sockets, NULL for the listening one
+    struct DistConnection *connection;
+};
+
+static void accept_callback(void *data);
+static void recv_callback(void *data);
+
+static struct DistDriverSocket *dist_driver_socket_new(GlobalContext *glb, int fd, event_handler_t handler)
+{
+    struct DistDriverSocket *socket_data = malloc(sizeof(struct DistDriverSocket));
+    if (IS_NULL_PTR(socket_data)) {
+        fprintf(stderr, "Failed to allocate memory: %s:%i.\n", __FILE__, __LINE__);
+        return NULL;
+    }
+    socket_data->fd = fd;
+    socket_data->global = glb;
+    socket_data->connection = NULL;
+
+    EventListener *listener = &socket_data->listener;
+    listener->fd = fd;
+    listener->expires = 0;
+    listener->expiral_timestamp.tv_sec = 0;
+    listener->expiral_timestamp.tv_nsec = 0;
+    listener->one_shot = 0;
+    listener->data = socket_data;
+    listener->handler = handler;
+    linkedlist_append(&glb->listeners, &listener->listeners_list_head);
+
+    return socket_data;
+}
+
+static void dist_driver_socket_destroy(struct DistDriverSocket *socket_data)
+{
+    if (socket_data->listener.fd >= 0) {
+        linkedlist_remove(&socket_data->global->listeners, &socket_data->listener.listeners_list_head);
+    }
+    close(socket_data->fd);
+    free(socket_data);
+}
+
+static void setup_connection_socket(int fd)
+{
+    int flag = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+}
+
+int dist_driver_listen(struct Dist *dist, uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if ((bind(fd, (struct sockaddr *) &address, sizeof(address)) < 0) || (listen(fd, 8) < 0)) {
+        fprintf(stderr, "dist: cannot listen on port %i: %s\n", port, strerror(errno));
+        close(fd);
+        return 0;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    struct DistDriverSocket *socket_data = dist_driver_socket_new(dist->ctx->global, fd, accept_callback);
+    if (IS_NULL_PTR(socket_data)) {
+        close(fd);
+        return 0;
+    }
+    dist->driver_data = socket_data;
+
+    return 1;
+}
+
+void dist_driver_stop(struct Dist *dist)
+{
+    dist_driver_socket_destroy((struct DistDriverSocket *) dist->driver_data);
+    dist->driver_data = NULL;
+}
+
+static void accept_callback(void *data)
+{
+    EventListener *listener = (EventListener *) data;
+    struct DistDriverSocket *listening = (struct DistDriverSocket *) listener->data;
+    struct Dist *dist = listening->global->dist;
+
+    int fd = accept(listening->fd, NULL, NULL);
+    if (fd < 0) {
+        TRACE("dist: accept failed: %s\n", strerror(errno));
+        return;
+    }
+    setup_connection_socket(fd);
+
+    struct DistDriverSocket *socket_data = dist_driver_socket_new(listening->global, fd, recv_callback);
+    if (IS_NULL_PTR(socket_data)) {
+        close(fd);
+        return;
+    }
+    socket_data->connection = dist_connection_accepted(dist, socket_data);
+    if (IS_NULL_PTR(socket_data->connection)) {
+        dist_driver_socket_destroy(socket_data);
+    }
+}
+
+static void recv_callback(void *data)
+{
+    EventListener *listener = (EventListener *) data;
+    struct DistDriverSocket *socket_data = (struct DistDriverSocket *) listener->data;
+
+    uint8_t buf[DIST_RECV_BUFSIZE];
+    ssize_t len = recv(socket_data->fd, buf, sizeof(buf), 0);
+    if ((len < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))) {
+        return;
+    }
+    if (len <= 0) {
+        // the socket is not polled anymore, it is closed by dist_driver_close
+        linkedlist_remove(&socket_data->global->listeners, &listener->listeners_list_head);
+        listener->fd = -1;
+        dist_connection_lost(socket_data->connection);
+        return;
+    }
+
+    dist_connection_received(socket_data->connection, buf, len);
+}
+
+int dist_driver_connect(struct DistConnection *connection, uint32_t address, uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return 0;
+    }
+
+    // connect blocks, the socket is non blocking once connected
+    struct sockaddr_in peer;
+    memset(&peer, 0, sizeof(peer));
+    peer.sin_family = AF_INET;
+    peer.sin_addr.s_addr = htonl(address);
+    peer.sin_port = htons(port);
+    if (connect(fd, (struct sockaddr *) &peer, sizeof(peer)) < 0) {
+        TRACE("dist: connect failed: %s\n", strerror(errno));
+        close(fd);
+        return 0;
+    }
+    setup_connection_socket(fd);
+
+    struct DistDriverSocket *socket_data = dist_driver_socket_new(connection->dist->ctx->global, fd, recv_callback);
+    if (IS_NULL_PTR(socket_data)) {
+        close(fd);
+        return 0;
+    }
+    socket_data->connection = connection;
+    connection->driver_data = socket_data;
+
+    return 1;
+}
+
+int dist_driver_send(struct DistConnection *connection, const uint8_t *data, size_t len)
+{
+    struct DistDriverSocket *socket_data = (struct DistDriverSocket *) connection->driver_data;
+
+    ssize_t written = send(socket_data->fd, data, len, MSG_NOSIGNAL);
+    if (written < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+            return 0;
+        }
+        return -1;
+    }
+
+    return written;
+}
+
+void dist_driver_close(struct DistConnection *connection)
+{
+    dist_driver_socket_destroy((struct DistDriverSocket *) connection->driver_data);
+    connection->driver_data = NULL;
+}
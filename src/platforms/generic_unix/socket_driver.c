@@ -52,19 +52,41 @@ static const char *const proto_tcp_a = "\x3" "tcp";
 typedef struct SocketDriverData
 {
     int sockfd;
+
+    // pending recvfrom, it must be unregistered if the port goes away before any packet
+    GlobalContext *global;
+    EventListener *recvfrom_listener;
 } SocketDriverData;
 
 
 void *socket_driver_create_data()
 {
     struct SocketDriverData *data = calloc(1, sizeof(struct SocketDriverData));
+    if (IS_NULL_PTR(data)) {
+        return NULL;
+    }
+    data->sockfd = -1;
     return (void *) data;
 }
 
 
 void socket_driver_delete_data(void *data)
 {
-    free(data);
+    SocketDriverData *socket_data = (SocketDriverData *) data;
+    if (!socket_data) {
+        return;
+    }
+
+    EventListener *listener = socket_data->recvfrom_listener;
+    if (listener) {
+        linkedlist_remove(&socket_data->global->listeners, &listener->listeners_list_head);
+        free(listener->data);
+        free(listener);
+    }
+    if (socket_data->sockfd != -1) {
+        close(socket_data->sockfd);
+    }
+    free(socket_data);
 }
 
 
@@ -181,6 +203,7 @@ static void recvfrom_callback(void *data)
 
     GlobalContext *global = ctx->global;
     linkedlist_remove(&global->listeners, &listener->listeners_list_head);
+    socket_data->recvfrom_listener = NULL;
 
     struct sockaddr_in clientaddr;
     socklen_t clientlen = sizeof(clientaddr);
@@ -219,7 +242,6 @@ static void recvfrom_callback(void *data)
     ccontext_release_all_refs(cc);
     free(cc);
 
-    linkedlist_remove(&ctx->global->listeners, &listener->listeners_list_head);
     free(listener);
     free(recvfrom_data);
     free(buf);
@@ -246,6 +268,8 @@ void socket_driver_do_recvfrom(CContext *cc, term_ref pid, term_ref ref)
     data->ref_ticks = term_to_ref_ticks(ccontext_get_term(cc, ref));
 
     linkedlist_append(&ctx->global->listeners, &listener->listeners_list_head);
+    socket_data->global = ctx->global;
+    socket_data->recvfrom_listener = listener;
 
     listener->fd = socket_data->sockfd;
     listener->expires = 0;
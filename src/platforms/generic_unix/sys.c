@@ -23,11 +23,13 @@
 #include "iff.h"
 #include "mapped_file.h"
 #include "scheduler.h"
+#include "dist.h"
 #include "socket.h"
 #include "gpio_driver.h"
 #include "network.h"
 #include "utils.h"
 
+#include <fcntl.h>
 #include <limits.h>
 #include <poll.h>
 #include <stdint.h>
@@ -46,95 +48,150 @@
 
 static int32_t timespec_diff_to_ms(struct timespec *timespec1, struct timespec *timespec2);
 
-extern void sys_waitevents(struct ListHead *listeners_list)
+struct GenericUnixPlatformData
 {
+    // written by sys_signal, so poll in sys_waitevents returns
+    int signal_pipe[2];
+};
+
+int sys_init_platform(GlobalContext *global)
+{
+    struct GenericUnixPlatformData *platform = malloc(sizeof(struct GenericUnixPlatformData));
+    if (IS_NULL_PTR(platform)) {
+        return 0;
+    }
+    if (UNLIKELY(pipe(platform->signal_pipe))) {
+        free(platform);
+        return 0;
+    }
+    fcntl(platform->signal_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(platform->signal_pipe[1], F_SETFL, O_NONBLOCK);
+    global->platform_data = platform;
+
+    return 1;
+}
+
+void sys_free_platform(GlobalContext *global)
+{
+    struct GenericUnixPlatformData *platform = global->platform_data;
+    close(platform->signal_pipe[0]);
+    close(platform->signal_pipe[1]);
+    free(platform);
+}
+
+void sys_signal(GlobalContext *global)
+{
+    struct GenericUnixPlatformData *platform = global->platform_data;
+
+    // when the pipe is full the instance has already been signaled
+    char signal = 0;
+    if (write(platform->signal_pipe[1], &signal, 1) < 0) {
+        TRACE("sys_signal: pipe is full.\n");
+    }
+}
+
+extern void sys_waitevents(GlobalContext *global)
+{
+    struct GenericUnixPlatformData *platform = global->platform_data;
+    struct ListHead *listeners_list = global->listeners;
+
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
 
-    EventListener *listeners = GET_LIST_ENTRY(listeners_list, EventListener, listeners_list_head);
-    EventListener *last_listener = GET_LIST_ENTRY(listeners_list->prev, EventListener, listeners_list_head);
+    EventListener *listeners = NULL;
+    EventListener *last_listener = NULL;
 
     int min_timeout = INT_MAX;
-    int count = 0;
+    // signal pipe is always polled
+    int count = 1;
 
     //first: find maximum allowed sleep time, and count file descriptor listeners
-    EventListener *listener = listeners;
-    do {
-        if (listener->expires) {
-            int wait_ms = timespec_diff_to_ms(&listener->expiral_timestamp, &now);
-            if (wait_ms <= 0) {
-                min_timeout = 0;
-            } else if (min_timeout > wait_ms) {
-                min_timeout = wait_ms;
+    if (listeners_list) {
+        listeners = GET_LIST_ENTRY(listeners_list, EventListener, listeners_list_head);
+        last_listener = GET_LIST_ENTRY(listeners_list->prev, EventListener, listeners_list_head);
+
+        EventListener *listener = listeners;
+        do {
+            if (listener->expires) {
+                int wait_ms = timespec_diff_to_ms(&listener->expiral_timestamp, &now);
+                if (wait_ms <= 0) {
+                    min_timeout = 0;
+                } else if (min_timeout > wait_ms) {
+                    min_timeout = wait_ms;
+                }
+            }
+            if (listener->fd >= 0) {
+                count++;
             }
-        }
-        if (listener->fd >= 0) {
-            count++;
-        }
 
-        listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
-    } while (listener != listeners);
+            listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
+        } while (listener != listeners);
+    }
 
-    //second: use either poll or nanosleep
-    if (count > 0) {
-        struct pollfd *fds = calloc(count, sizeof(struct pollfd));
-        if (IS_NULL_PTR(fds)) {
-            fprintf(stderr, "Cannot allocate memory for pollfd, aborting.\n");
-            abort();
-        }
-        int poll_fd_index = 0;
+    //second: poll file descriptors until a timer expires
+    struct pollfd *fds = calloc(count, sizeof(struct pollfd));
+    if (IS_NULL_PTR(fds)) {
+        fprintf(stderr, "Cannot allocate memory for pollfd, aborting.\n");
+        abort();
+    }
+    fds[0].fd = platform->signal_pipe[0];
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    int poll_fd_index = 1;
 
-        //build pollfd array
-        EventListener *listener = listeners;
+    //build pollfd array
+    EventListener *listener = listeners;
+    if (listeners) {
         do {
             if (listener->fd >= 0) {
                 fds[poll_fd_index].fd = listener->fd;
                 fds[poll_fd_index].events = POLLIN;
                 fds[poll_fd_index].revents = 0;
+                poll_fd_index++;
             }
 
-            poll_fd_index++;
-
             listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
         } while (listener != listeners);
+    }
+
+    poll(fds, poll_fd_index, (min_timeout == INT_MAX) ? -1 : min_timeout);
 
-        poll(fds, poll_fd_index, min_timeout);
+    if (fds[0].revents & POLLIN) {
+        char signals[16];
+        while (read(platform->signal_pipe[0], signals, sizeof(signals)) > 0) {
+        }
+    }
 
-        //check which event happened
+    //check which event happened
+    //handlers may remove their own listener or add new ones, so the walk stops at the last listener that was polled
+    if (listeners && (poll_fd_index > 1)) {
         listener = listeners;
+        int is_last;
         do {
             EventListener *next_listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
-            for (int i = 0; i < poll_fd_index; i++) {
+            is_last = (listener == last_listener);
+            for (int i = 1; i < poll_fd_index; i++) {
                 if ((fds[i].fd == listener->fd) && (fds[i].revents & fds[i].events)) {
                     //it is completely safe to free a listener in the callback, we are going to not use it after this call
                     listener->handler(listener);
+                    break;
                 }
             }
 
             listener = next_listener;
-        } while (listener != listeners);
-
-        free(fds);
-
-    //just need to wait for a certain timespan
-    } else {
-        struct timespec t;
-        t.tv_sec = min_timeout / 1000;
-        t.tv_nsec = (min_timeout % 1000) * 1000000;
-
-        struct timespec rem;
-        int nanosleep_result = nanosleep(&t, &rem);
-        while (nanosleep_result == -1) {
-            nanosleep_result = nanosleep(&rem, &rem);
-        }
+        } while (!is_last);
     }
 
+    free(fds);
+
     //third: execute handlers for expiered timers
-    if (min_timeout != INT_MAX) {
+    if (listeners && (min_timeout != INT_MAX)) {
         listener = listeners;
         clock_gettime(CLOCK_MONOTONIC, &now);
+        int is_last;
         do {
             EventListener *next_listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
+            is_last = (listener == last_listener);
             if (listener->expires) {
                 int wait_ms = timespec_diff_to_ms(&listener->expiral_timestamp, &now);
                 if (wait_ms <= 0) {
@@ -145,7 +202,7 @@ extern void sys_waitevents(struct ListHead *listeners_list)
             }
 
             listener = next_listener;
-        } while (listener != last_listener);
+        } while (!is_last);
     }
 }
 
@@ -215,6 +272,11 @@ Context *sys_create_port(GlobalContext *glb, const char *driver_name, term opts)
         network_init(new_ctx, opts);
     } else if (!strcmp(driver_name, "gpio")) {
         gpiodriver_init(new_ctx);
+    } else if (!strcmp(driver_name, "dist")) {
+        if (!dist_init(new_ctx, opts)) {
+            context_destroy(new_ctx);
+            return NULL;
+        }
     } else {
         context_destroy(new_ctx);
         return NULL;
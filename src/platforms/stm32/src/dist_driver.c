@@ -0,0 +1,60 @@
+/***************************************************************************
+ *   Copyright 2026 by agent <agent@local>                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA .        *
+ ***************************************************************************/
+
+#include <dist_driver.h>
+
+#include <utils.h>
+
+// distribution is not supported on this platform yet: the dist port cannot be opened
+
+int dist_driver_listen(struct Dist *dist, uint16_t port)
+{
+    UNUSED(dist);
+    UNUSED(port);
+
+    return 0;
+}
+
+void dist_driver_stop(struct Dist *dist)
+{
+    UNUSED(dist);
+}
+
+int dist_driver_connect(struct DistConnection *connection, uint32_t address, uint16_t port)
+{
+    UNUSED(connection);
+    UNUSED(address);
+    UNUSED(port);
+
+    return 0;
+}
+
+int dist_driver_send(struct DistConnection *connection, const uint8_t *data, size_t len)
+{
+    UNUSED(connection);
+    UNUSED(data);
+    UNUSED(len);
+
+    return -1;
+}
+
+void dist_driver_close(struct DistConnection *connection)
+{
+    UNUSED(connection);
+}
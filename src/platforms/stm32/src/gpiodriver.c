@@ -111,7 +111,7 @@ static void consume_gpio_mailbox(Context *ctx)
         ret = context_make_atom(ctx, error_a);
     }
 
-    free(message);
+    mailbox_message_destroy(message);
 
     mailbox_send(target, ret);
 }
@@ -22,6 +22,8 @@
 #include <avmpack.h>
 #include <scheduler.h>
 
+#include <stdlib.h>
+
 // Monotonically increasing number of milliseconds from reset
 // Overflows every 49 days
 // TODO: use 64 bit (remember to take into account atomicity)
@@ -33,12 +35,19 @@ void sys_tick_handler()
     system_millis++;
 }
 
-// Sleep for delay milliseconds
-static void msleep(uint32_t delay)
+struct STM32PlatformData
+{
+    // set by sys_signal, so msleep returns early
+    volatile int signaled;
+};
+
+// Sleep for delay milliseconds, or until the instance is signaled
+static void msleep(struct STM32PlatformData *platform, uint32_t delay)
 {
     // TODO: use a smarter sleep instead of busy waiting
     uint32_t wake = system_millis + delay;
-    while (wake > system_millis);
+    while ((wake > system_millis) && !platform->signaled);
+    platform->signaled = 0;
 }
 
 static inline void sys_clock_gettime(struct timespec *t)
@@ -52,39 +61,64 @@ static int32_t timespec_diff_to_ms(struct timespec *timespec1, struct timespec *
     return (timespec1->tv_sec - timespec2->tv_sec) * 1000 + (timespec1->tv_nsec - timespec2->tv_nsec) / 1000000;
 }
 
-void sys_waitevents(struct ListHead *listeners_list)
+int sys_init_platform(GlobalContext *global)
+{
+    struct STM32PlatformData *platform = malloc(sizeof(struct STM32PlatformData));
+    if (IS_NULL_PTR(platform)) {
+        return 0;
+    }
+    platform->signaled = 0;
+    global->platform_data = platform;
+
+    return 1;
+}
+
+void sys_free_platform(GlobalContext *global)
+{
+    free(global->platform_data);
+}
+
+void sys_signal(GlobalContext *global)
+{
+    struct STM32PlatformData *platform = global->platform_data;
+    platform->signaled = 1;
+}
+
+void sys_waitevents(GlobalContext *global)
 {
+    struct ListHead *listeners_list = global->listeners;
+
     struct timespec now;
     sys_clock_gettime(&now);
 
-    EventListener *listeners = GET_LIST_ENTRY(listeners_list, EventListener, listeners_list_head);
+    EventListener *listeners = NULL;
 
     int min_timeout = INT_MAX;
-    int count = 0;
-
-    //first: find maximum allowed sleep time, and count file descriptor listeners
-    EventListener *listener = listeners;
-    do {
-        if (listener->expires) {
-            int wait_ms = timespec_diff_to_ms(&listener->expiral_timestamp, &now);
-            if (wait_ms <= 0) {
-                min_timeout = 0;
-            } else if (min_timeout > wait_ms) {
-                min_timeout = wait_ms;
+
+    //first: find maximum allowed sleep time
+    if (listeners_list) {
+        listeners = GET_LIST_ENTRY(listeners_list, EventListener, listeners_list_head);
+
+        EventListener *listener = listeners;
+        do {
+            if (listener->expires) {
+                int wait_ms = timespec_diff_to_ms(&listener->expiral_timestamp, &now);
+                if (wait_ms <= 0) {
+                    min_timeout = 0;
+                } else if (min_timeout > wait_ms) {
+                    min_timeout = wait_ms;
+                }
             }
-        }
-        if (listener->fd >= 0) {
-            count++;
-        }
 
-        listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
-    } while (listener != listeners);
+            listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
+        } while (listener != listeners);
+    }
 
-    msleep(min_timeout);
+    msleep(global->platform_data, min_timeout);
 
     //second: execute handlers for expiered timers
-    if (min_timeout != INT_MAX) {
-        listener = listeners;
+    if (listeners && (min_timeout != INT_MAX)) {
+        EventListener *listener = listeners;
         sys_clock_gettime(&now);
         do {
             EventListener *next_listener = GET_LIST_ENTRY(listener->listeners_list_head.next, EventListener, listeners_list_head);
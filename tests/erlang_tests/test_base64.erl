@@ -0,0 +1,18 @@
+-module(test_base64).
+-export([start/0]).
+
+start() ->
+    Data = <<"base64 payload wrapped inside a json document">>,
+    Encoded = base64:encode(Data),
+    Decoded = base64:decode(Encoded),
+    Decoded = Data,
+    Hello = base64:encode(<<"hello">>),
+    Hello = <<"aGVsbG8=">>,
+    HelloString = erlang:iolist_to_binary(base64:encode_to_string(["he", $l, <<"lo">>])),
+    HelloString = Hello,
+    CRLF = base64:decode("aGVs\r\nbG8="),
+    CRLF = <<"hello">>,
+    Mime = base64:mime_decode(<<"aGVs!bG8=ignored">>),
+    Mime = <<"hello">>,
+    {'EXIT', {badarg, _}} = (catch base64:decode(<<"aGVs!bG8=">>)),
+    byte_size(Encoded).
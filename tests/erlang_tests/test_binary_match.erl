@@ -0,0 +1,36 @@
+-module(test_binary_match).
+-export([start/0, bin/1, wide/1]).
+
+start() ->
+    Subject = bin(request),
+    Pattern = binary:compile_pattern([<<"Host">>, <<"ost:">>, <<"index">>]),
+    {24, 2} = binary:match(Subject, <<"\r\n">>),
+    {5, 5} = binary:match(Subject, Pattern),
+    [_First, {26, 4}] = binary:matches(Subject, Pattern),
+    nomatch = binary:match(Subject, <<"POST">>),
+    {7, 1} = binary:match(bin(hello), <<"o">>, [{scope, {5, 6}}]),
+    $G = binary:at(Subject, 0),
+    {'EXIT', {badarg, _}} = (catch binary:match(Subject, forged_pattern())),
+    % 32 bits builds cannot build integers that do not fit 32 bits, they raise overflow
+    case catch binary:at(Subject, wide(1)) of
+        {'EXIT', {badarg, _}} -> ok;
+        {'EXIT', {overflow, _}} -> ok
+    end,
+    length(binary:matches(Subject, <<"\r\n">>)).
+
+% compiled patterns are references to tables owned by the VM, so they cannot be forged
+forged_pattern() ->
+    {bm, _Ref} = binary:compile_pattern(bin(ab)),
+    {bm, make_ref()}.
+
+bin(request) ->
+    <<"GET /index.html HTTP/1.1\r\nHost: example.com\r\n\r\n">>;
+
+bin(hello) ->
+    <<"hello world">>;
+
+bin(ab) ->
+    <<"ab">>.
+
+wide(N) ->
+    (N bsl 32) + 1.
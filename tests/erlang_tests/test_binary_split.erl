@@ -0,0 +1,46 @@
+-module(test_binary_split).
+-export([start/0, bin/1]).
+
+start() ->
+    First = join(binary:split(bin(commas), <<",">>)),
+    First = <<"a|b,c|">>,
+    Global = binary:split(bin(trailing), <<",">>, [global]),
+    GlobalJoined = join(Global),
+    GlobalJoined = <<"a|b|c||">>,
+    Trimmed = join(binary:split(bin(trailing2), <<",">>, [global, trim])),
+    Trimmed = <<"a|b|c|">>,
+    TrimmedAll = join(binary:split(bin(leading), <<",">>, [global, trim_all])),
+    TrimmedAll = <<"a|c|">>,
+    Replaced = binary:replace(bin(dashes), <<"-">>, <<"[]">>, [global, {insert_replaced, 1}]),
+    Replaced = <<"a[-]b[-]c">>,
+    ReplacedFirst = binary:replace(bin(dashes), <<"-">>, <<"+">>),
+    ReplacedFirst = <<"a+b-c">>,
+    Part = binary:part(bin(alphabet), 10, 16),
+    Part = <<"klmnopqrstuvwxyz">>,
+    Copy = binary:copy(bin(ab), 2),
+    Copy = <<"abab">>,
+    length(Global).
+
+join(Parts) ->
+    iolist_to_binary([[Part, $|] || Part <- Parts]).
+
+bin(commas) ->
+    <<"a,b,c">>;
+
+bin(trailing) ->
+    <<"a,b,c,">>;
+
+bin(trailing2) ->
+    <<"a,b,c,,">>;
+
+bin(leading) ->
+    <<",a,,c">>;
+
+bin(dashes) ->
+    <<"a-b-c">>;
+
+bin(alphabet) ->
+    <<"abcdefghijklmnopqrstuvwxyz">>;
+
+bin(ab) ->
+    <<"ab">>.
@@ -0,0 +1,23 @@
+-module(test_binary_to_list).
+-export([start/0, bin/1]).
+
+start() ->
+    L = binary_to_list(bin(4)),
+    {1, 2, 3, 4} = list_to_tuple4(L),
+    [] = binary_to_list(bin(0)),
+    sum(L).
+
+list_to_tuple4([A, B, C, D]) ->
+    {A, B, C, D}.
+
+sum([]) ->
+    0;
+
+sum([H | T]) ->
+    H + sum(T).
+
+bin(4) ->
+    <<1, 2, 3, 4>>;
+
+bin(0) ->
+    <<>>.
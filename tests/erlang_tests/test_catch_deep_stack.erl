@@ -0,0 +1,32 @@
+-module(test_catch_deep_stack).
+-export([start/0, deep/2]).
+
+start() ->
+    try_loop(500, 200) + catch_loop(100) + badmatch_loop(50).
+
+try_loop(0, _Depth) ->
+    0;
+
+try_loop(N, Depth) ->
+    badarith = try deep(Depth, N) catch error:Reason -> Reason end,
+    try_loop(N - 1, Depth) + 1.
+
+catch_loop(0) ->
+    0;
+
+catch_loop(N) ->
+    {'EXIT', {badarith, _}} = (catch deep(50, N)),
+    catch_loop(N - 1) + 1.
+
+badmatch_loop(0) ->
+    0;
+
+badmatch_loop(N) ->
+    {'EXIT', {{badmatch, N}, _}} = (catch (ok = N)),
+    badmatch_loop(N - 1) + 1.
+
+deep(0, N) ->
+    N div (N - N);
+
+deep(D, N) ->
+    deep(D - 1, N) + 1.
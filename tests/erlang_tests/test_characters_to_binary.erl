@@ -0,0 +1,26 @@
+-module(test_characters_to_binary).
+-export([start/0, chars/1, wide/1]).
+
+start() ->
+    Bin = unicode:characters_to_binary(chars(mixed)),
+    Bin = <<97, 195, 168, 195, 188, 226, 130, 172>>,
+    {'EXIT', {badarg, _}} = (catch unicode:characters_to_binary(chars(invalid_utf8))),
+    {'EXIT', {badarg, _}} = (catch unicode:characters_to_binary(chars(surrogate))),
+    % 2^32 + 65 must not be taken for $A, 32 bits builds cannot even build it
+    case catch unicode:characters_to_binary(wide(1)) of
+        {'EXIT', {badarg, _}} -> ok;
+        {'EXIT', {overflow, _}} -> ok
+    end,
+    byte_size(Bin).
+
+chars(mixed) ->
+    [$a, 16#E8, <<195, 188>>, [16#20AC]];
+
+chars(invalid_utf8) ->
+    <<255>>;
+
+chars(surrogate) ->
+    [16#D800].
+
+wide(N) ->
+    [(N bsl 32) + 65].
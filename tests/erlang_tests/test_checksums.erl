@@ -0,0 +1,35 @@
+-module(test_checksums).
+-export([start/0, data/1, wide/1]).
+
+start() ->
+    Data = data(iolist),
+    State0 = crypto:hash_init(sha256),
+    State1 = crypto:hash_update(State0, <<"abc">>),
+    State2 = crypto:hash_update(State1, "defg"),
+    824863398 = erlang:crc32(Data),
+    824863398 = erlang:crc32(erlang:crc32(<<"abc">>), <<"defg">>),
+    182125245 = erlang:adler32(Data),
+    MD5 = crypto:hash(md5, Data),
+    MD5 = <<122, 198, 108, 15, 20, 141, 233, 81, 155, 139, 210, 100, 49, 44, 77, 100>>,
+    SHA256 = crypto:hash_final(State2),
+    SHA256 = crypto:hash(sha256, Data),
+    % crc32 of "k" is in [2^27, 2^28), it does not fit a small integer on 32 bits builds
+    case catch erlang:crc32(data(k)) of
+        140662621 -> ok;
+        {'EXIT', {overflow, _}} -> ok
+    end,
+    % 2^32 + 65 must not be taken for byte 65, 32 bits builds cannot even build it
+    case catch erlang:crc32(wide(1)) of
+        {'EXIT', {badarg, _}} -> ok;
+        {'EXIT', {overflow, _}} -> ok
+    end,
+    byte_size(crypto:hash(sha, Data)).
+
+data(iolist) ->
+    [<<"ab">>, [$c | <<"defg">>]];
+
+data(k) ->
+    <<"k">>.
+
+wide(N) ->
+    [(N bsl 32) + 65].
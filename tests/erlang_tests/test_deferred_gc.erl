@@ -0,0 +1,44 @@
+-module(test_deferred_gc).
+-export([start/0, builder/2]).
+
+start() ->
+    Builder = spawn(?MODULE, builder, [self(), 20000]),
+    2000 = count(2000, 0),
+    Expected = expected_sum(20000, 0),
+    receive
+        {Builder, Len, Expected} -> Len
+    end.
+
+builder(Parent, N) ->
+    List = build(N, []),
+    Parent ! {self(), len(List, 0), sum(List, 0)}.
+
+build(0, Acc) ->
+    Acc;
+
+build(N, Acc) ->
+    build(N - 1, [{N, [N rem 7]} | Acc]).
+
+len([], Acc) ->
+    Acc;
+
+len([_H | T], Acc) ->
+    len(T, Acc + 1).
+
+sum([], Acc) ->
+    Acc;
+
+sum([{_N, [R]} | T], Acc) ->
+    sum(T, Acc + R).
+
+expected_sum(0, Acc) ->
+    Acc;
+
+expected_sum(N, Acc) ->
+    expected_sum(N - 1, Acc + N rem 7).
+
+count(0, Acc) ->
+    Acc;
+
+count(N, Acc) ->
+    count(N - 1, Acc + 1).
@@ -0,0 +1,45 @@
+-module(test_dist_a).
+-export([start/0]).
+
+%% Node a of the dist loopback test: it pings b until b is reachable, then
+%% answers the greeting of b with its own pid and waits for b to reply on it.
+%% Atoms, pids and {Name, Node} destinations cross the connection both ways.
+%% It returns the number of messages received from b.
+start() ->
+    open_port({spawn, "dist"}, [{name, 'a@localhost'}, {port, 9321}, {cookie, secret},
+                                {nodes, [{'b@localhost', {{127, 0, 0, 1}, 9322}}]}]),
+    register(client, self()),
+    ping(),
+    Received = wait_messages(50, 0),
+    [Node] = nodes(),
+    'b@localhost' = Node,
+    Received.
+
+ping() ->
+    {server, 'b@localhost'} ! {self(), ping}.
+
+%% the pong and the greeting can be received in any order, so every message
+%% is matched as soon as it is at the head of the mailbox
+wait_messages(_Tries, 3) ->
+    3;
+
+wait_messages(0, Received) ->
+    exit({timeout, Received});
+
+wait_messages(Tries, Received) ->
+    receive
+        {pong, 'b@localhost'} ->
+            wait_messages(Tries, Received + 1);
+        {hello, BPid} ->
+            'b@localhost' = node(BPid),
+            BPid ! {ack, self()},
+            wait_messages(Tries, Received + 1);
+        done ->
+            wait_messages(Tries, Received + 1)
+    after 100 ->
+        case Received of
+            0 -> ping();
+            _ -> ok
+        end,
+        wait_messages(Tries - 1, Received)
+    end.
@@ -0,0 +1,36 @@
+-module(test_dist_b).
+-export([start/0]).
+
+%% Node b of the dist loopback test, see test_dist_a: it answers the first
+%% ping and greets a by name, then it replies on the pid that a sent back.
+%% It returns the number of messages sent to a.
+%% Timers are used instead of receive timeouts, that are not reset when a
+%% message is received.
+start() ->
+    open_port({spawn, "dist"}, [{name, 'b@localhost'}, {port, 9322}, {cookie, secret},
+                                {nodes, [{'a@localhost', {{127, 0, 0, 1}, 9321}}]}]),
+    register(server, self()),
+    erlang:send_after(10000, self(), timeout),
+    serve(0).
+
+serve(Sent) ->
+    receive
+        {From, ping} when Sent =:= 0 ->
+            From ! {pong, node()},
+            {client, 'a@localhost'} ! {hello, self()},
+            serve(2);
+        {_From, ping} ->
+            serve(Sent);
+        {ack, APid} ->
+            'a@localhost' = node(APid),
+            APid ! done,
+            [Node] = nodes(),
+            'a@localhost' = Node,
+            % done is written once the scheduler is idle
+            erlang:send_after(200, self(), flushed),
+            receive
+                _Any -> Sent + 1
+            end;
+        timeout ->
+            exit(timeout)
+    end.
@@ -0,0 +1,23 @@
+-module(test_dist_cookie).
+-export([start/0]).
+
+%% Node c has not the cookie of b (see test_dist_b), so b rejects it during
+%% the handshake: its pings are never delivered and it never connects.
+%% It returns the number of unanswered pings.
+start() ->
+    open_port({spawn, "dist"}, [{name, 'c@localhost'}, {port, 9323}, {cookie, wrong},
+                                {nodes, [{'b@localhost', {{127, 0, 0, 1}, 9322}}]}]),
+    Unanswered = ping(10),
+    [] = nodes(),
+    Unanswered.
+
+ping(0) ->
+    0;
+
+ping(Tries) ->
+    {server, 'b@localhost'} ! {self(), ping},
+    receive
+        {pong, _Node} = Pong -> exit({unexpected, Pong})
+    after 100 ->
+        ping(Tries - 1) + 1
+    end.
@@ -0,0 +1,16 @@
+-module(test_external_term).
+-export([start/0]).
+
+start() ->
+    Term = {hello, [1, -70000, 300], <<"payload">>, "string", {}, [a | b]},
+    Bin = term_to_binary(Term),
+    Decoded = binary_to_term(Bin),
+    Bin = term_to_binary(Decoded),
+    OkBin = term_to_binary(ok),
+    OkBin = <<131, 100, 0, 2, $o, $k>>,
+    nonode@nohost = node(),
+    [] = nodes(),
+    {'EXIT', {badarg, _}} = (catch binary_to_term(<<131, 104, 2, 100, 0, 2, $o>>)),
+    {'EXIT', {badarg, _}} = (catch binary_to_term(<<1, 2, 3>>)),
+    {'EXIT', {badarg, _}} = (catch term_to_binary(self())),
+    tuple_size(Decoded).
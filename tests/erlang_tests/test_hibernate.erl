@@ -0,0 +1,26 @@
+-module(test_hibernate).
+-export([start/0, sleeper/2, woke/1]).
+
+start() ->
+    Pid = spawn(?MODULE, sleeper, [self(), 2000]),
+    Before = receive
+        {ready, Size} -> Size
+    end,
+    {total_heap_size, After} = erlang:process_info(Pid, total_heap_size),
+    true = After < Before,
+    Pid ! {self(), 21},
+    receive
+        {woke, Value} -> Value
+    end.
+
+sleeper(Parent, Size) ->
+    Garbage = erlang:make_tuple(Size, 0),
+    Size = tuple_size(Garbage),
+    {total_heap_size, HeapSize} = erlang:process_info(self(), total_heap_size),
+    Parent ! {ready, HeapSize},
+    erlang:hibernate(?MODULE, woke, [Parent]).
+
+woke(Parent) ->
+    receive
+        {Parent, N} -> Parent ! {woke, N * 2}
+    end.
@@ -0,0 +1,21 @@
+-module(test_io_lib_format).
+-export([start/0]).
+
+start() ->
+    Term = format("~p ~w", [{'Abc', "hi"}, "hi"]),
+    Term = <<"{'Abc',\"hi\"} [104,105]">>,
+    Padded = format("~5w|~-5w|~3w", [42, x, 123456]),
+    Padded = <<"   42|x    |***">>,
+    Strings = format("~s ~5s ~.2s", [<<"bin">>, ab, ["x", <<"yz">>]]),
+    Strings = <<"bin    ab xy">>,
+    Numbers = format("~.16B ~8..0B ~.2f", [255, 77, 3]),
+    Numbers = <<"FF 00000077 3.00">>,
+    Chars = format("~c~3c~i~~~n", [$a, $b, ignored]),
+    Chars = <<"abbb~\n">>,
+    Nested = format("~p", [[<<"a">>, [1 | 2], <<1, 2>>]]),
+    Nested = <<"[<<\"a\">>,[1|2],<<1,2>>]">>,
+    {'EXIT', {badarg, _}} = (catch io_lib:format("~w ~w", [1])),
+    byte_size(Term).
+
+format(Format, Args) ->
+    erlang:iolist_to_binary(io_lib:format(Format, Args)).
@@ -0,0 +1,34 @@
+-module(test_iolist_to_binary).
+-export([start/0, iolist/1, wide/1]).
+
+start() ->
+    Bin = iolist_to_binary(iolist(hello)),
+    Bin = <<"hello world!">>,
+    0 = byte_size(list_to_binary(iolist(empty))),
+    5 = iolist_size(iolist(mixed)),
+    {'EXIT', {badarg, _}} = (catch iolist_to_binary(iolist(out_of_range))),
+    {'EXIT', {badarg, _}} = (catch iolist_to_binary(iolist(improper))),
+    % 2^32 + 65 must not be taken for byte 65, 32 bits builds cannot even build it
+    case catch iolist_to_binary(wide(1)) of
+        {'EXIT', {badarg, _}} -> ok;
+        {'EXIT', {overflow, _}} -> ok
+    end,
+    byte_size(Bin).
+
+iolist(hello) ->
+    [<<"he">>, $l, [$l, [<<"o">>]], " ", [[<<"world">>] | <<"!">>]];
+
+iolist(empty) ->
+    [[], [[]]];
+
+iolist(mixed) ->
+    [1, <<2, 3>>, [4 | <<5>>]];
+
+iolist(out_of_range) ->
+    [256];
+
+iolist(improper) ->
+    [1 | 2].
+
+wide(N) ->
+    [(N bsl 32) + 65].
@@ -0,0 +1,15 @@
+-module(test_json).
+-export([start/0]).
+
+start() ->
+    Doc = <<"{\"id\": 42, \"name\": \"sensor\\n1\", \"tags\": [true, null, -7], \"nested\": {}}">>,
+    {[{IdKey, Id}, {_, Name}, {_, [T, N, I]}, {_, Nested}]} = json:decode(Doc),
+    IdKey = <<"id">>,
+    Name = <<"sensor\n1">>,
+    {true, null, -7} = {T, N, I},
+    {[]} = Nested,
+    Encoded = json:encode({[{id, 42}, {<<"name">>, <<"a\"b">>}, {list, [1, false, {[]}]}]}),
+    Encoded = <<"{\"id\":42,\"name\":\"a\\\"b\",\"list\":[1,false,{}]}">>,
+    Encoded = json:encode(json:decode(Encoded)),
+    {'EXIT', {badarg, _}} = (catch json:decode(<<"[1,]">>)),
+    Id.
@@ -0,0 +1,81 @@
+-module(test_link_monitor).
+-export([start/0, worker/0, linked/1]).
+
+start() ->
+    test_trap_exit() +
+        test_monitor() +
+        test_demonitor_flush() +
+        test_monitor_noproc() +
+        test_linked_exit() +
+        test_unlink().
+
+test_trap_exit() ->
+    false = process_flag(trap_exit, true),
+    Pid = spawn_link(?MODULE, worker, []),
+    Pid ! {exit, boom},
+    receive
+        {'EXIT', Pid, boom} -> ok
+    end,
+    true = process_flag(trap_exit, false),
+    1.
+
+test_monitor() ->
+    Pid = spawn(?MODULE, worker, []),
+    Ref = monitor(process, Pid),
+    Pid ! {exit, crash},
+    receive
+        {'DOWN', Ref, process, Pid, crash} -> 1
+    end.
+
+test_demonitor_flush() ->
+    Pid = spawn(?MODULE, worker, []),
+    Ref = monitor(process, Pid),
+    Pid ! {exit, normal},
+    sleep(20),
+    true = demonitor(Ref, [flush]),
+    receive
+        {'DOWN', Ref, _, _, _} = Down -> exit({not_flushed, Down})
+    after 20 -> 0
+    end.
+
+test_monitor_noproc() ->
+    Pid = spawn(?MODULE, worker, []),
+    Pid ! {exit, normal},
+    sleep(20),
+    Ref = monitor(process, Pid),
+    receive
+        {'DOWN', Ref, process, Pid, noproc} -> 1
+    end.
+
+test_linked_exit() ->
+    Pid = spawn(?MODULE, linked, [chained]),
+    Ref = monitor(process, Pid),
+    receive
+        {'DOWN', Ref, process, Pid, chained} -> 1
+    end.
+
+test_unlink() ->
+    Pid = spawn(?MODULE, worker, []),
+    true = link(Pid),
+    true = unlink(Pid),
+    Pid ! {exit, unlinked},
+    sleep(20),
+    false = erlang:is_process_alive(Pid),
+    0.
+
+linked(Reason) ->
+    Pid = spawn_link(?MODULE, worker, []),
+    Pid ! {exit, Reason},
+    receive
+        never -> ok
+    end.
+
+worker() ->
+    receive
+        {exit, Reason} -> exit(Reason)
+    end.
+
+sleep(Ms) ->
+    receive
+    after Ms -> ok
+    end.
@@ -0,0 +1,34 @@
+-module(test_memory_pressure).
+-export([start/0, idle/1]).
+
+start() ->
+    Idle = spawn(?MODULE, idle, [self()]),
+    receive
+        ready -> ok
+    end,
+    {total_heap_size, Size} = erlang:process_info(Idle, total_heap_size),
+    infinity = erlang:system_flag(memory_soft_watermark, 1),
+    Len = length(build(3000, [])),
+    % idle processes are shrunk by the scheduler, so it must run once
+    receive
+    after 10 -> ok
+    end,
+    {total_heap_size, ShrunkSize} = erlang:process_info(Idle, total_heap_size),
+    1 = erlang:system_flag(memory_soft_watermark, infinity),
+    Idle ! stop,
+    true = ShrunkSize < Size,
+    {'EXIT', {badarg, _}} = (catch erlang:system_flag(memory_soft_watermark, 0)),
+    Len.
+
+idle(Parent) ->
+    3000 = length(build(3000, [])),
+    Parent ! ready,
+    receive
+        stop -> ok
+    end.
+
+build(0, Acc) ->
+    Acc;
+
+build(N, Acc) ->
+    build(N - 1, [N | Acc]).
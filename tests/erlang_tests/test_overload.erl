@@ -0,0 +1,91 @@
+-module(test_overload).
+-export([start/0, hog/0, slow/1]).
+
+start() ->
+    test_max_heap_size() +
+        test_drop_newest() +
+        test_drop_oldest() +
+        test_block() +
+        test_memory_budget().
+
+test_max_heap_size() ->
+    Pid = spawn(?MODULE, hog, []),
+    Ref = monitor(process, Pid),
+    receive
+        {'DOWN', Ref, process, Pid, killed} -> 1
+    end.
+
+test_drop_newest() ->
+    infinity = process_flag(message_queue_limit, [{messages, 3}, {policy, drop_newest}]),
+    send_all(self(), [1, 2, 3, 4, 5]),
+    [A, B, C] = flush([]),
+    {1, 2, 3} = {A, B, C},
+    [{messages, Messages}, {bytes, Bytes}, {policy, Policy}] = process_flag(message_queue_limit, infinity),
+    {3, 0, drop_newest} = {Messages, Bytes, Policy},
+    3.
+
+test_drop_oldest() ->
+    process_flag(message_queue_limit, [{messages, 3}, {policy, drop_oldest}]),
+    send_all(self(), [1, 2, 3, 4, 5]),
+    [A, B, C] = flush([]),
+    {3, 4, 5} = {A, B, C},
+    process_flag(message_queue_limit, infinity),
+    3.
+
+test_block() ->
+    Pid = spawn(?MODULE, slow, [self()]),
+    receive
+        ready -> ok
+    end,
+    send_all(Pid, [1, 2, 3, 4, 5, done]),
+    receive
+        {received, [A, B, C, D, E]} ->
+            {1, 2, 3, 4, 5} = {A, B, C, D, E},
+            5
+    end.
+
+test_memory_budget() ->
+    infinity = erlang:system_flag(memory_budget, 1000000000),
+    1000000000 = erlang:system_flag(memory_budget, infinity),
+    0.
+
+hog() ->
+    process_flag(max_heap_size, [{size, 512}, {error_logger, false}]),
+    grow([]).
+
+grow(Acc) ->
+    grow([Acc | Acc]).
+
+slow(Parent) ->
+    process_flag(message_queue_limit, [{messages, 2}, {policy, block}]),
+    Parent ! ready,
+    sleep(20),
+    Parent ! {received, collect([])}.
+
+collect(Acc) ->
+    receive
+        done -> reverse(Acc, []);
+        N -> collect([N | Acc])
+    end.
+
+send_all(_Pid, []) ->
+    ok;
+send_all(Pid, [H | T]) ->
+    Pid ! H,
+    send_all(Pid, T).
+
+flush(Acc) ->
+    receive
+        N -> flush([N | Acc])
+    after 0 -> reverse(Acc, [])
+    end.
+
+reverse([], Acc) ->
+    Acc;
+reverse([H | T], Acc) ->
+    reverse(T, [H | Acc]).
+
+sleep(Ms) ->
+    receive
+    after Ms -> ok
+    end.
@@ -0,0 +1,35 @@
+-module(test_phash2).
+-export([start/0, term/1]).
+
+start() ->
+    Term = term(tuple),
+    2614250 = erlang:phash2(term(one)),
+    113427502 = erlang:phash2(term(nil)),
+    TermHash = erlang:phash2(Term),
+    TermHash = erlang:phash2(term(same_tuple)),
+    0 = erlang:phash2(Term, 1),
+    true = erlang:phash2(Term, 16) < 16,
+    1 = erlang:phash2(term(binary), 7),
+    {'EXIT', {badarg, _}} = (catch erlang:phash2(Term, 0)),
+    erlang:phash2(term(atom)).
+
+term(one) ->
+    1;
+
+term(nil) ->
+    [];
+
+term(atom) ->
+    a;
+
+term(tuple) ->
+    {hello, [1, 2, 3], <<"world">>, "abc"};
+
+term(same_tuple) ->
+    {hello, [1, 2 | term(three)], <<"world">>, [$a, $b, $c]};
+
+term(three) ->
+    [3];
+
+term(binary) ->
+    <<"hello">>.
@@ -0,0 +1,22 @@
+-module(test_process_dictionary).
+-export([start/0, key/1]).
+
+start() ->
+    undefined = put(counter, 1),
+    1 = put(counter, 2),
+    undefined = put({request, key(abc)}, <<"ctx">>),
+    undefined = put(other, 2),
+    2 = get(counter),
+    Ctx = get({request, [$a, $b, $c]}),
+    Ctx = <<"ctx">>,
+    undefined = get(missing),
+    3 = length(get()),
+    2 = length(get_keys(2)),
+    2 = erase(counter),
+    undefined = get(counter),
+    Erased = erase(),
+    [] = get_keys(),
+    length(Erased).
+
+key(abc) ->
+    "abc".
@@ -0,0 +1,32 @@
+-module(test_process_exit).
+-export([start/0, worker/1]).
+
+start() ->
+    Pid = spawn(?MODULE, worker, [self()]),
+    receive
+        ready -> ok
+    end,
+    Pid = whereis(exit_worker),
+    Ref = monitor(process, Pid),
+    Pid ! {die, 42},
+    receive
+    after 50 -> ok
+    end,
+    undefined = whereis(exit_worker),
+    false = erlang:is_process_alive(Pid),
+    register(test_process_exit, self()),
+    true = unregister(test_process_exit),
+    undefined = whereis(test_process_exit),
+    receive
+        {'DOWN', Ref, process, Pid, {boom, Code}} -> Code
+    end.
+
+worker(Parent) ->
+    register(exit_worker, self()),
+    Parent ! ready,
+    receive
+        {die, Code} ->
+            % the mailbox is not empty when the process is destroyed
+            self() ! pending,
+            exit({boom, Code})
+    end.
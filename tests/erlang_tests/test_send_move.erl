@@ -0,0 +1,70 @@
+-module(test_send_move).
+-export([start/0, echo/0]).
+
+start() ->
+    Pid = spawn(?MODULE, echo, []),
+    test_moved(Pid) + test_kept(Pid) + test_nested(Pid) + test_send_result(Pid).
+
+test_moved(Pid) ->
+    ok = erlang:send(Pid, {self(), make_list(1000, [])}, [move]),
+    receive
+        List ->
+            500500 = sum(List, 0),
+            length(List)
+    end.
+
+% the list is still used by the sender after the first send, so it must not be moved away
+test_kept(Pid) ->
+    List = make_list(100, []),
+    ok = erlang:send(Pid, {self(), List}, [move]),
+    ok = erlang:send(Pid, {self(), List}, [move, nosuspend]),
+    [A, B] = receive_two(),
+    5050 = sum(A, 0),
+    5050 = sum(B, 0),
+    5050 = sum(List, 0),
+    length(A) + length(B).
+
+test_nested(Pid) ->
+    ok = erlang:send(Pid, {self(), {batch, make_list(10, []), <<"payload">>, fun(X) -> X + 1 end}}, [move]),
+    receive
+        {batch, List, Bin, Fun} ->
+            55 = sum(List, 0),
+            Bin = <<"payload">>,
+            2 = Fun(1),
+            length(List)
+    end.
+
+% the message is the result of send, so it is still valid after it
+test_send_result(Pid) ->
+    {_, Sent} = Pid ! {self(), make_list(20, [])},
+    210 = sum(Sent, 0),
+    receive
+        List ->
+            210 = sum(List, 0),
+            length(List)
+    end.
+
+echo() ->
+    receive
+        {Pid, Msg} ->
+            Pid ! Msg,
+            echo()
+    end.
+
+receive_two() ->
+    receive
+        A ->
+            receive
+                B -> [A, B]
+            end
+    end.
+
+make_list(0, Acc) ->
+    Acc;
+make_list(N, Acc) ->
+    make_list(N - 1, [N | Acc]).
+
+sum([], Acc) ->
+    Acc;
+sum([H | T], Acc) ->
+    sum(T, Acc + H).
@@ -0,0 +1,47 @@
+-module(test_small_int_arith).
+-export([start/0, arith/3]).
+
+start() ->
+    Max = arith('+', 100000000, 34217727),
+    134217727 = Max,
+    -134217728 = arith('-', -100000000, 34217728),
+    -21 = arith('*', -3, 7),
+    -4 = arith('bsr', -16, 2),
+    1 = arith('bsl', 3, -1),
+    2 = arith('band', -6, 3),
+    -5 = arith('bor', -8, 3),
+    true = arith('<', 3, 4),
+    true = arith('=:=', a, a),
+    false = arith('>=', 5, 6),
+    {'EXIT', {badarith, _}} = (catch arith('+', 1, a)),
+    Max.
+
+arith('+', A, B) ->
+    A + B;
+
+arith('-', A, B) ->
+    A - B;
+
+arith('*', A, B) ->
+    A * B;
+
+arith('bsr', A, B) ->
+    A bsr B;
+
+arith('bsl', A, B) ->
+    A bsl B;
+
+arith('band', A, B) ->
+    A band B;
+
+arith('bor', A, B) ->
+    A bor B;
+
+arith('<', A, B) ->
+    A < B;
+
+arith('=:=', A, B) ->
+    A =:= B;
+
+arith('>=', A, B) ->
+    A >= B.
@@ -0,0 +1,32 @@
+-module(test_timers).
+-export([start/0]).
+
+start() ->
+    Ref1 = erlang:start_timer(20, self(), hello),
+    erlang:send_after(10, self(), ping),
+    Ref3 = erlang:send_after(60000, self(), never),
+    Remaining = erlang:read_timer(Ref3),
+    true = Remaining > 0 andalso Remaining =< 60000,
+    Cancelled = erlang:cancel_timer(Ref3),
+    true = Cancelled > 0 andalso Cancelled =< Remaining,
+    false = erlang:cancel_timer(Ref3),
+    start_many(100),
+    receive_all(102, Ref1).
+
+start_many(0) ->
+    ok;
+
+start_many(N) ->
+    erlang:send_after(N rem 7, self(), {n, N}),
+    start_many(N - 1).
+
+% timers may fire in any order, so every message is accepted at the head of the mailbox
+receive_all(0, _Ref) ->
+    0;
+
+receive_all(Count, Ref) ->
+    receive
+        ping -> receive_all(Count - 1, Ref);
+        {timeout, Ref, hello} -> receive_all(Count - 1, Ref);
+        {n, N} -> receive_all(Count - 1, Ref) + N
+    end.
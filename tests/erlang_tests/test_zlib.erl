@@ -0,0 +1,24 @@
+-module(test_zlib).
+-export([start/0]).
+
+start() ->
+    Data = <<"telemetry telemetry telemetry telemetry telemetry">>,
+    Expected = erlang:iolist_to_binary([Data, "!"]),
+    Compressed = zlib:compress(Data),
+    true = byte_size(Compressed) < byte_size(Data),
+    Uncompressed = zlib:uncompress(Compressed),
+    Uncompressed = Data,
+    Gunzipped = zlib:gunzip(zlib:gzip([Data, "!"])),
+    Gunzipped = Expected,
+    Z = zlib:open(),
+    ok = zlib:deflateInit(Z, best_compression),
+    Part1 = zlib:deflate(Z, Data),
+    Part2 = zlib:deflate(Z, <<"!">>, finish),
+    ok = zlib:deflateEnd(Z),
+    ok = zlib:inflateInit(Z),
+    Inflated = erlang:iolist_to_binary(zlib:inflate(Z, [Part1, Part2])),
+    ok = zlib:inflateEnd(Z),
+    ok = zlib:close(Z),
+    Inflated = Expected,
+    {'EXIT', {data_error, _}} = (catch zlib:uncompress(Data)),
+    byte_size(Inflated).
@@ -49,6 +49,19 @@ test() ->
     ?ASSERT_MATCH(get_counter(error), 1),
     ?ASSERT_MATCH(get_counter(debug), 1),
 
+    ?ASSERT_MATCH(logger:allow(debug, ?MODULE), true),
+    ?ASSERT_MATCH(logger:allow(error, ?MODULE), false),
+
+    logger:set_filter([other_module]),
+    ?ASSERT_MATCH(logger:allow(info, ?MODULE), false),
+    ?ASSERT_MATCH(logger:allow(info, other_module), true),
+    ok = ?LOG_INFO(ok),
+    ?ASSERT_MATCH(get_counter(info), 2),
+
+    logger:set_filter([]),
+    ok = ?LOG_INFO(ok),
+    ?ASSERT_MATCH(get_counter(info), 3),
+
     ok.
 
 
@@ -14,6 +14,8 @@ test() ->
     ok = test_call(),
     ok = test_cast(),
     ok = test_info(),
+    ok = test_hibernate(),
+    ok = test_call_crash(),
     ok.
 
 test_call() ->
@@ -54,6 +56,25 @@ test_info() ->
     ?GEN_SERVER:stop(Pid),
     ok.
 
+test_hibernate() ->
+    {ok, Pid} = ?GEN_SERVER:start(?MODULE, [], [{hibernate_after, 10}]),
+
+    pong = ?GEN_SERVER:call(Pid, hibernate_ping),
+    pong = ?GEN_SERVER:call(Pid, ping),
+    ok = ?GEN_SERVER:cast(Pid, ping),
+    receive after 50 -> ok end,
+    1 = ?GEN_SERVER:call(Pid, get_num_casts),
+
+    ?GEN_SERVER:stop(Pid),
+    ok.
+
+test_call_crash() ->
+    {ok, Pid} = ?GEN_SERVER:start(?MODULE, [], []),
+
+    {error, crash} = ?GEN_SERVER:call(Pid, crash, infinity),
+    {error, noproc} = ?GEN_SERVER:call(Pid, ping, infinity),
+    ok.
+
 
 %%
 %% callbacks
@@ -64,6 +85,10 @@ init(_) ->
 
 handle_call(ping, _From, State) ->
     {reply, pong, State};
+handle_call(crash, _From, _State) ->
+    exit(crash);
+handle_call(hibernate_ping, _From, State) ->
+    {reply, pong, State, hibernate};
 handle_call(reply_ping, From, State) ->
     ?GEN_SERVER:reply(From, pong),
     {noreply, State};
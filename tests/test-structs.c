@@ -21,6 +21,12 @@
 #include <stdlib.h>
 
 #include "atomshashtable.h"
+#include "bridge.h"
+#include "bytepattern.h"
+#include "context.h"
+#include "externalterm.h"
+#include "json.h"
+#include "mailbox.h"
 #include "valueshashtable.h"
 #include "utils.h"
 
@@ -138,6 +144,244 @@ void test_valueshashtable()
     }
 }
 
+void test_externalterm()
+{
+    char atom_hello[] = {5, 'h', 'e', 'l', 'l', 'o'};
+
+    GlobalContext *glb = globalcontext_new();
+    Context *ctx = context_new(glb);
+
+    memory_ensure_free(ctx, 16);
+    term list = term_list_prepend(term_from_int32(-70000), term_nil(), ctx);
+    list = term_list_prepend(term_from_int32(1), list, ctx);
+    term t = term_alloc_tuple(3, ctx);
+    term_put_tuple_element(t, 0, context_make_atom(ctx, atom_hello));
+    term_put_tuple_element(t, 1, list);
+    term_put_tuple_element(t, 2, term_nil());
+
+    int size = externalterm_compute_external_size(t, glb);
+    assert(size > 0);
+    uint8_t *buf = malloc(size);
+    externalterm_serialize_term(buf, t, glb);
+
+    term decoded = externalterm_to_term(buf, ctx, 1);
+    assert(term_is_tuple(decoded) && (term_get_tuple_arity(decoded) == 3));
+    assert(term_get_tuple_element(decoded, 0) == context_make_atom(ctx, atom_hello));
+    term decoded_list = term_get_tuple_element(decoded, 1);
+    assert(term_get_list_head(decoded_list) == term_from_int32(1));
+    assert(term_get_list_head(term_get_list_tail(decoded_list)) == term_from_int32(-70000));
+    assert(term_is_nil(term_get_list_tail(term_get_list_tail(decoded_list))));
+    assert(term_is_nil(term_get_tuple_element(decoded, 2)));
+
+    // untrusted data: the same term is decoded by externalterm_decode, any truncated copy is rejected
+    size_t bytes_read;
+    decoded = externalterm_decode(buf + 1, size - 1, &bytes_read, NULL, ctx);
+    assert(bytes_read == (size_t) size - 1);
+    assert(term_get_tuple_element(decoded, 0) == context_make_atom(ctx, atom_hello));
+    for (int i = 0; i < size - 1; i++) {
+        assert(term_is_invalid_term(externalterm_decode(buf + 1, i, NULL, NULL, ctx)));
+    }
+
+    // messages are decoded to their own memory, not to a process heap
+    term *heap_ptr = ctx->heap_ptr;
+    Message *m = mailbox_message_decode(glb, buf + 1, size - 1, &bytes_read, NULL);
+    assert(m && (bytes_read == (size_t) size - 1));
+    assert(ctx->heap_ptr == heap_ptr);
+    assert(term_get_tuple_element(m->message, 0) == context_make_atom(ctx, atom_hello));
+    assert(term_get_list_head(term_get_list_tail(term_get_tuple_element(m->message, 1))) == term_from_int32(-70000));
+    mailbox_message_destroy(m);
+    assert(!mailbox_message_decode(glb, buf + 1, size - 2, NULL, NULL));
+    free(buf);
+
+    // pids cannot be sent to other instances
+    assert(externalterm_compute_external_size(term_from_local_process_id(ctx->process_id), glb) < 0);
+
+    context_destroy(ctx);
+    globalcontext_destroy(glb);
+}
+
+void test_bytepattern()
+{
+    const uint8_t data[] = "abcabdabe";
+    size_t match_pos;
+    size_t match_len;
+
+    struct BytePatternNeedle needle = { (const uint8_t *) "abd", 3 };
+    size_t bmh_size;
+    uint32_t *bmh = bytepattern_compile(&needle, 1, &bmh_size);
+    assert(bytepattern_find(bmh, data, sizeof(data) - 1, &match_pos, &match_len));
+    assert((match_pos == 3) && (match_len == 3));
+
+    struct BytePatternNeedle needles[] = { { (const uint8_t *) "abe", 3 }, { (const uint8_t *) "bd", 2 } };
+    size_t ac_size;
+    uint32_t *ac = bytepattern_compile(needles, 2, &ac_size);
+    assert(bytepattern_find(ac, data, sizeof(data) - 1, &match_pos, &match_len));
+    assert((match_pos == 4) && (match_len == 2));
+
+    // compiled patterns can be found only by the process that owns them, that frees them
+    GlobalContext *glb = globalcontext_new();
+    Context *ctx = context_new(glb);
+    Context *other = context_new(glb);
+    assert(bytepattern_store(ctx, 1, bmh));
+    assert(bytepattern_store(ctx, 2, ac));
+    assert(bytepattern_lookup(ctx, 1) == bmh);
+    assert(bytepattern_lookup(ctx, 2) == ac);
+    assert(!bytepattern_lookup(ctx, 3));
+    assert(!bytepattern_lookup(other, 1));
+    context_destroy(other);
+    context_destroy(ctx);
+    globalcontext_destroy(glb);
+}
+
+void test_json_integers()
+{
+    GlobalContext *glb = globalcontext_new();
+    Context *ctx = context_new(glb);
+
+    char doc[32];
+    term result;
+
+    // the largest small integer is decoded, the next one does not fit a term
+    snprintf(doc, sizeof(doc), "%lld", (long long) TERM_MAX_SMALL_INT);
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(strlen(doc)) + 2);
+    ctx->x[0] = term_from_literal_binary(doc, strlen(doc), ctx);
+    assert(json_decode(ctx, &ctx->x[0], &result) == JsonOk);
+    assert(term_to_int64(result) == TERM_MAX_SMALL_INT);
+
+    snprintf(doc, sizeof(doc), "%lld", (long long) TERM_MAX_SMALL_INT + 1);
+    memory_ensure_free(ctx, term_binary_data_size_in_terms(strlen(doc)) + 2);
+    ctx->x[0] = term_from_literal_binary(doc, strlen(doc), ctx);
+    assert(json_decode(ctx, &ctx->x[0], &result) == JsonOverflow);
+
+    context_destroy(ctx);
+    globalcontext_destroy(glb);
+}
+
+void test_terms_memory()
+{
+    GlobalContext *glb = globalcontext_new();
+    Context *ctx = context_new(glb);
+
+    // refs keep all the 64 bits of ref ticks, also when terms are 32 bits
+    memory_ensure_free(ctx, TERM_BOXED_REF_SIZE);
+    term ref = term_from_ref_ticks(0x123456789ABCDEFULL, ctx);
+    assert(term_to_ref_ticks(ref) == 0x123456789ABCDEFULL);
+
+    // blocks are reused once freed, also after being split and coalesced
+    term *blocks[64];
+    for (int i = 0; i < 64; i++) {
+        blocks[i] = memory_terms_alloc((i + 1) * 24);
+        assert(blocks[i] && !(((uintptr_t) blocks[i]) & 0x7));
+        memset(blocks[i], i, (i + 1) * 24);
+        memory_ensure_free(ctx, 2);
+        term list = term_list_prepend(term_nil(), term_nil(), ctx);
+        assert(term_get_list_ptr(list) == ctx->heap_ptr - 2);
+    }
+    for (int i = 0; i < 64; i += 2) {
+        memory_terms_free(blocks[i]);
+    }
+    for (int i = 1; i < 64; i += 2) {
+        assert(((uint8_t *) blocks[i])[(i + 1) * 24 - 1] == i);
+        memory_terms_free(blocks[i]);
+    }
+    term *large = memory_terms_calloc(64 * 65 / 2, 24);
+    assert(large && (large[0] == 0));
+    memory_terms_free(large);
+
+    context_destroy(ctx);
+    globalcontext_destroy(glb);
+}
+
+void test_bridge()
+{
+    char atom_receiver[] = {8, 'r', 'e', 'c', 'e', 'i', 'v', 'e', 'r'};
+    char atom_ciao[] = {4, 'c', 'i', 'a', 'o'};
+
+    struct Bridge *bridge = bridge_new();
+    GlobalContext *glb_a = globalcontext_new();
+    GlobalContext *glb_b = globalcontext_new();
+    assert(bridge_attach(bridge, glb_a) == 0);
+    assert(bridge_attach(bridge, glb_b) == 1);
+
+    Context *sender = context_new(glb_a);
+    Context *receiver = context_new(glb_b);
+    int receiver_atom_index = globalcontext_insert_atom(glb_b, atom_receiver);
+    globalcontext_register_process(glb_b, receiver_atom_index, receiver->process_id);
+
+    memory_ensure_free(sender, 3);
+    term destination = term_alloc_tuple(2, sender);
+    term_put_tuple_element(destination, 0, context_make_atom(sender, atom_receiver));
+    term_put_tuple_element(destination, 1, term_from_int32(1));
+    term message = context_make_atom(sender, atom_ciao);
+
+    assert(bridge_send(glb_a, destination, message) == BridgeSendOk);
+    assert(bridge_has_messages(glb_b));
+    assert(!bridge_has_messages(glb_a));
+
+    // atom ciao does not exist on the receiver instance until the message is delivered
+    assert(!receiver->mailbox);
+    term *receiver_heap_ptr = receiver->heap_ptr;
+    bridge_deliver_messages(glb_b);
+    assert(!bridge_has_messages(glb_b));
+    assert(receiver->mailbox);
+    assert(receiver->heap_ptr == receiver_heap_ptr);
+    Message *received = GET_LIST_ENTRY(receiver->mailbox, Message, mailbox_list_head);
+    assert(received->message == context_make_atom(receiver, atom_ciao));
+
+    // posted data comes from outside of the VM, truncated and malformed terms are dropped
+    const uint8_t small_int[] = { 131, 97, 42 };
+    const uint8_t truncated_tuple[] = { 131, 104, 2, 97 };
+    const uint8_t bad_tag[] = { 131, 255, 0 };
+    assert(bridge_post(bridge, 1, atom_receiver, small_int, sizeof(small_int) - 1) == BridgeSendOk);
+    assert(bridge_post(bridge, 1, atom_receiver, truncated_tuple, sizeof(truncated_tuple)) == BridgeSendOk);
+    assert(bridge_post(bridge, 1, atom_receiver, bad_tag, sizeof(bad_tag)) == BridgeSendOk);
+    assert(bridge_post(bridge, 1, atom_receiver, small_int + 1, sizeof(small_int) - 1) == BridgeSendOk);
+    assert(bridge_post(bridge, 1, atom_receiver, small_int, sizeof(small_int)) == BridgeSendOk);
+    bridge_deliver_messages(glb_b);
+    assert(receiver->message_queue_len == 2);
+    received = GET_LIST_ENTRY(receiver->mailbox->prev, Message, mailbox_list_head);
+    assert(received->message == term_from_int32(42));
+
+    term_put_tuple_element(destination, 1, term_from_int32(2));
+    assert(bridge_send(glb_a, destination, message) == BridgeSendBadArg);
+    term_put_tuple_element(destination, 1, term_from_int32(1));
+    assert(bridge_send(glb_a, destination, term_from_local_process_id(sender->process_id)) == BridgeSendBadArg);
+
+    context_destroy(sender);
+    context_destroy(receiver);
+    globalcontext_destroy(glb_a);
+    globalcontext_destroy(glb_b);
+    bridge_destroy(bridge);
+}
+
+void test_stack_growth()
+{
+    GlobalContext *glb = globalcontext_new();
+    Context *ctx = context_new(glb);
+
+    memory_ensure_free(ctx, 2);
+    ctx->x[0] = term_list_prepend(term_from_int32(42), term_nil(), ctx);
+
+    // terms in x registers are still valid after the stack has been grown
+    context_ensure_free_stack_and_heap(ctx, 1024, 0);
+#ifndef AVM_SEPARATE_STACK
+    assert(ctx->e - 1024 >= ctx->heap_ptr);
+#else
+    // the stack has its own block, so its pointers cannot be compared to heap ones
+    assert(ctx->e - 1024 >= ctx->stack_start);
+#endif
+    assert(term_to_int32(term_get_list_head(ctx->x[0])) == 42);
+#ifdef AVM_SEPARATE_STACK
+    term *heap_start = ctx->heap_start;
+    context_ensure_free_stack_and_heap(ctx, 4096, 0);
+    assert(ctx->heap_start == heap_start);
+    assert(ctx->e - 4096 >= ctx->stack_start);
+#endif
+
+    context_destroy(ctx);
+    globalcontext_destroy(glb);
+}
+
 int main(int argc, char **argv)
 {
     UNUSED(argc);
@@ -145,6 +389,12 @@ int main(int argc, char **argv)
 
     test_atomshashtable();
     test_valueshashtable();
+    test_bytepattern();
+    test_externalterm();
+    test_json_integers();
+    test_terms_memory();
+    test_bridge();
+    test_stack_growth();
 
     return EXIT_SUCCESS;
 }
@@ -23,6 +23,8 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -150,6 +152,7 @@ struct Test tests[] =
     {"prime_ext.beam", 1999},
     {"test_try_case_end.beam", 256},
     {"test_recursion_and_try_catch.beam", 3628800},
+    {"test_catch_deep_stack.beam", 650},
     {"test_func_info.beam", 89},
     {"test_func_info2.beam", 1},
     {"test_func_info3.beam", 120},
@@ -233,12 +236,108 @@ struct Test tests[] =
     {"test_apply_last.beam", 17},
     {"test_timestamp.beam", 1},
     {"test_set_tuple_element.beam", 0},
+    {"test_iolist_to_binary.beam", 12},
+    {"test_binary_to_list.beam", 10},
+    {"test_characters_to_binary.beam", 8},
+    {"test_binary_match.beam", 3},
+    {"test_binary_split.beam", 4},
+    {"test_checksums.beam", 20},
+    {"test_timers.beam", 5050},
+    {"test_phash2.beam", 97},
+    {"test_process_dictionary.beam", 2},
+    {"test_zlib.beam", 50},
+    {"test_base64.beam", 60},
+    {"test_json.beam", 42},
+    {"test_io_lib_format.beam", 22},
+    {"test_hibernate.beam", 42},
+    {"test_process_exit.beam", 42},
+    {"test_small_int_arith.beam", 134217727},
+    {"test_link_monitor.beam", 4},
+    {"test_overload.beam", 12},
+    {"test_send_move.beam", 1230},
+    {"test_external_term.beam", 6},
+    {"test_deferred_gc.beam", 20000},
+    {"test_memory_pressure.beam", 3000},
 
     //TEST CRASHES HERE: {"memlimit.beam", 0},
 
     {NULL, 0}
 };
 
+static int execute_test_module(const char *test_file, int32_t *value)
+{
+    MappedFile *beam_file = mapped_file_open_beam(test_file);
+    assert(beam_file != NULL);
+
+    GlobalContext *glb = globalcontext_new();
+    glb->avmpack_data = NULL;
+    glb->avmpack_platform_data = NULL;
+    Module *mod = module_new_from_iff_binary(glb, beam_file->mapped, beam_file->size);
+    if (IS_NULL_PTR(mod)) {
+        fprintf(stderr, "Cannot load startup module: %s\n", test_file);
+        return 0;
+    }
+    globalcontext_insert_module_with_filename(glb, mod, test_file);
+    Context *ctx = context_new(glb);
+    ctx->leader = 1;
+
+    context_execute_loop(ctx, mod, "start", 0);
+
+    *value = term_to_int32(ctx->x[0]);
+
+    context_destroy(ctx);
+    globalcontext_destroy(glb);
+    module_destroy(mod);
+    mapped_file_close(beam_file);
+
+    return 1;
+}
+
+// an instance can be a single node, so each node runs in its own process and returns its value as exit status
+static pid_t start_dist_test_node(const char *test_file)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int32_t value;
+        _exit(execute_test_module(test_file, &value) ? (value & 0xFF) : 0xFF);
+    }
+
+    return pid;
+}
+
+static int wait_dist_test_node(pid_t pid, const char *test_file, int32_t expected_value)
+{
+    int status;
+    if ((pid < 0) || (waitpid(pid, &status, 0) != pid) || !WIFEXITED(status)) {
+        fprintf(stderr, "\x1b[1;31mFailed test module %s, node did not exit\x1b[0m\n", test_file);
+        return 0;
+    }
+    if (WEXITSTATUS(status) != expected_value) {
+        fprintf(stderr, "\x1b[1;31mFailed test module %s, got value: %i\x1b[0m\n", test_file, WEXITSTATUS(status));
+        return 0;
+    }
+
+    return 1;
+}
+
+// Two nodes exchange messages over 127.0.0.1, while a third one that has a wrong cookie is rejected.
+int test_dist_loopback()
+{
+    printf("-- EXECUTING TEST: dist loopback\n");
+
+    int failed_tests = 0;
+
+    pid_t node_b = start_dist_test_node("test_dist_b.beam");
+    pid_t node_c = start_dist_test_node("test_dist_cookie.beam");
+    failed_tests += !wait_dist_test_node(node_c, "test_dist_cookie.beam", 10);
+    pid_t node_a = start_dist_test_node("test_dist_a.beam");
+    failed_tests += !wait_dist_test_node(node_a, "test_dist_a.beam", 3);
+    failed_tests += !wait_dist_test_node(node_b, "test_dist_b.beam", 3);
+
+    return failed_tests;
+}
+
 int test_modules_execution()
 {
     struct Test *test = tests;
@@ -251,38 +350,22 @@ int test_modules_execution()
 
     do {
         printf("-- EXECUTING TEST: %s\n", test->test_file);
-        MappedFile *beam_file = mapped_file_open_beam(test->test_file);
-        assert(beam_file != NULL);
-
-        GlobalContext *glb = globalcontext_new();
-        glb->avmpack_data = NULL;
-        glb->avmpack_platform_data = NULL;
-        Module *mod = module_new_from_iff_binary(glb, beam_file->mapped, beam_file->size);
-        if (IS_NULL_PTR(mod)) {
-            fprintf(stderr, "Cannot load startup module: %s\n", test->test_file);
+
+        int32_t value;
+        if (!execute_test_module(test->test_file, &value)) {
             test++;
             continue;
         }
-        globalcontext_insert_module_with_filename(glb, mod, test->test_file);
-        Context *ctx = context_new(glb);
-        ctx->leader = 1;
-
-        context_execute_loop(ctx, mod, "start", 0);
-
-        int32_t value = term_to_int32(ctx->x[0]);
         if (value != test->expected_value) {
             fprintf(stderr, "\x1b[1;31mFailed test module %s, got value: %i\x1b[0m\n", test->test_file, value);
             failed_tests++;
         }
 
-        context_destroy(ctx);
-        globalcontext_destroy(glb);
-        module_destroy(mod);
-        mapped_file_close(beam_file);
-
         test++;
     } while (test->test_file);
 
+    failed_tests += test_dist_loopback();
+
     if (failed_tests == 0) {
         fprintf(stderr, "Success.\n");
         return EXIT_SUCCESS;